@@ -23,37 +23,54 @@
 #include "util/oc_list.h"
 #include "util/oc_memb.h"
 
-OC_MEMB(oc_blockwise_request_states_s, oc_blockwise_request_state_t,
-        OC_MAX_NUM_CONCURRENT_REQUESTS);
-OC_MEMB(oc_blockwise_response_states_s, oc_blockwise_response_state_t,
-        OC_MAX_NUM_CONCURRENT_REQUESTS);
+OC_MEMB_CACHED(oc_blockwise_request_states_s, oc_blockwise_request_state_t,
+               OC_MAX_NUM_CONCURRENT_REQUESTS);
+OC_MEMB_CACHED(oc_blockwise_response_states_s, oc_blockwise_response_state_t,
+               OC_MAX_NUM_CONCURRENT_REQUESTS);
 OC_LIST(oc_blockwise_requests);
 OC_LIST(oc_blockwise_responses);
 
 static oc_blockwise_state_t *
 oc_blockwise_init_buffer(struct oc_memb *pool, const char *href, size_t href_len,
                          oc_endpoint_t *endpoint, oc_method_t method,
-                         oc_blockwise_role_t role)
+                         oc_blockwise_role_t role, bool in_arena)
 {
+#ifndef OC_REQUEST_ARENA
+  (void)in_arena;
+#endif /* !OC_REQUEST_ARENA */
   if (href_len == 0)
     return NULL;
 
   oc_blockwise_state_t *buffer = (oc_blockwise_state_t *)oc_memb_alloc(pool);
   if (buffer) {
+#ifdef OC_REQUEST_ARENA
+    if (in_arena) {
+      buffer->arena = oc_ri_request_arena();
+      buffer->buffer =
+        (uint8_t *)oc_arena_alloc(buffer->arena, OC_MAX_APP_DATA_SIZE);
+      if (!buffer->buffer ||
+          !oc_arena_new_string(buffer->arena, &buffer->href, href, href_len)) {
+        oc_memb_free(pool, buffer);
+        return NULL;
+      }
+    } else
+#endif /* OC_REQUEST_ARENA */
+    {
 #ifdef OC_DYNAMIC_ALLOCATION
-    buffer->buffer = (uint8_t *)malloc(OC_MAX_APP_DATA_SIZE);
-    if (!buffer->buffer) {
-      oc_memb_free(pool, buffer);
-      return NULL;
-    }
+      buffer->buffer = (uint8_t *)malloc(OC_MAX_APP_DATA_SIZE);
+      if (!buffer->buffer) {
+        oc_memb_free(pool, buffer);
+        return NULL;
+      }
 #endif /* OC_DYNAMIC_ALLOCATION */
+      oc_new_string(&buffer->href, href, href_len);
+    }
     buffer->next_block_offset = 0;
     buffer->payload_size = 0;
     buffer->ref_count = 1;
     buffer->method = method;
     buffer->role = role;
     memcpy(&buffer->endpoint, endpoint, sizeof(oc_endpoint_t));
-    oc_new_string(&buffer->href, href, href_len);
     buffer->next = NULL;
 #ifdef OC_CLIENT
     buffer->mid = 0;
@@ -75,14 +92,22 @@ oc_blockwise_free_buffer(oc_list_t list, struct oc_memb *pool,
     return;
   }
 
-  if (oc_string_len(buffer->uri_query))
-    oc_free_string(&buffer->uri_query);
-  oc_free_string(&buffer->href);
   oc_list_remove(list, buffer);
+#ifdef OC_REQUEST_ARENA
+  /* Storage borrowed from the request arena goes away with the arena. */
+  if (!buffer->arena)
+#endif /* OC_REQUEST_ARENA */
+  {
+    if (oc_string_len(buffer->uri_query))
+      oc_free_string(&buffer->uri_query);
+    oc_free_string(&buffer->href);
+#ifdef OC_DYNAMIC_ALLOCATION
+    free(buffer->buffer);
+#endif /* OC_DYNAMIC_ALLOCATION */
+  }
 #ifdef OC_DYNAMIC_ALLOCATION
-  free(buffer->buffer);
   buffer->buffer = NULL;
-#endif
+#endif /* OC_DYNAMIC_ALLOCATION */
   oc_memb_free(pool, buffer);
 }
 
@@ -102,14 +127,15 @@ oc_blockwise_response_timeout(void *data)
   return OC_EVENT_DONE;
 }
 
-oc_blockwise_state_t *
-oc_blockwise_alloc_request_buffer(const char *href, size_t href_len,
-                                  oc_endpoint_t *endpoint, oc_method_t method,
-                                  oc_blockwise_role_t role)
+static oc_blockwise_state_t *
+oc_blockwise_init_request_buffer(const char *href, size_t href_len,
+                                 oc_endpoint_t *endpoint, oc_method_t method,
+                                 oc_blockwise_role_t role, bool in_arena)
 {
   oc_blockwise_request_state_t *buffer =
     (oc_blockwise_request_state_t *)oc_blockwise_init_buffer(
-      &oc_blockwise_request_states_s, href, href_len, endpoint, method, role);
+      &oc_blockwise_request_states_s, href, href_len, endpoint, method, role,
+      in_arena);
   if (buffer) {
     oc_ri_add_timed_event_callback_seconds(buffer, oc_blockwise_request_timeout,
                                            OC_EXCHANGE_LIFETIME);
@@ -118,14 +144,15 @@ oc_blockwise_alloc_request_buffer(const char *href, size_t href_len,
   return (oc_blockwise_state_t *)buffer;
 }
 
-oc_blockwise_state_t *
-oc_blockwise_alloc_response_buffer(const char *href, size_t href_len,
-                                   oc_endpoint_t *endpoint, oc_method_t method,
-                                   oc_blockwise_role_t role)
+static oc_blockwise_state_t *
+oc_blockwise_init_response_buffer(const char *href, size_t href_len,
+                                  oc_endpoint_t *endpoint, oc_method_t method,
+                                  oc_blockwise_role_t role, bool in_arena)
 {
   oc_blockwise_response_state_t *buffer =
     (oc_blockwise_response_state_t *)oc_blockwise_init_buffer(
-      &oc_blockwise_response_states_s, href, href_len, endpoint, method, role);
+      &oc_blockwise_response_states_s, href, href_len, endpoint, method, role,
+      in_arena);
   if (buffer) {
     int i = COAP_ETAG_LEN;
     uint32_t r = oc_random_value();
@@ -144,6 +171,107 @@ oc_blockwise_alloc_response_buffer(const char *href, size_t href_len,
   return (oc_blockwise_state_t *)buffer;
 }
 
+oc_blockwise_state_t *
+oc_blockwise_alloc_request_buffer(const char *href, size_t href_len,
+                                  oc_endpoint_t *endpoint, oc_method_t method,
+                                  oc_blockwise_role_t role)
+{
+  return oc_blockwise_init_request_buffer(href, href_len, endpoint, method,
+                                          role, false);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_alloc_response_buffer(const char *href, size_t href_len,
+                                   oc_endpoint_t *endpoint, oc_method_t method,
+                                   oc_blockwise_role_t role)
+{
+  return oc_blockwise_init_response_buffer(href, href_len, endpoint, method,
+                                           role, false);
+}
+
+#ifdef OC_REQUEST_ARENA
+static oc_blockwise_state_t *
+oc_blockwise_set_arena_query(oc_blockwise_state_t *buffer, const char *query,
+                             size_t query_len,
+                             void (*free_buffer)(oc_blockwise_state_t *))
+{
+  if (buffer && query_len > 0 &&
+      !oc_arena_new_string(buffer->arena, &buffer->uri_query, query,
+                           query_len)) {
+    free_buffer(buffer);
+    return NULL;
+  }
+  return buffer;
+}
+
+oc_blockwise_state_t *
+oc_blockwise_alloc_request_buffer_arena(const char *href, size_t href_len,
+                                        const char *query, size_t query_len,
+                                        oc_endpoint_t *endpoint,
+                                        oc_method_t method,
+                                        oc_blockwise_role_t role)
+{
+  return oc_blockwise_set_arena_query(
+    oc_blockwise_init_request_buffer(href, href_len, endpoint, method, role,
+                                     true),
+    query, query_len, oc_blockwise_free_request_buffer);
+}
+
+oc_blockwise_state_t *
+oc_blockwise_alloc_response_buffer_arena(const char *href, size_t href_len,
+                                         const char *query, size_t query_len,
+                                         oc_endpoint_t *endpoint,
+                                         oc_method_t method,
+                                         oc_blockwise_role_t role)
+{
+  return oc_blockwise_set_arena_query(
+    oc_blockwise_init_response_buffer(href, href_len, endpoint, method, role,
+                                      true),
+    query, query_len, oc_blockwise_free_response_buffer);
+}
+
+static void
+oc_blockwise_detach_buffers(oc_list_t list, oc_arena_t *arena,
+                            void (*free_buffer)(oc_blockwise_state_t *))
+{
+  oc_blockwise_state_t *buffer = oc_list_head(list), *next;
+  while (buffer != NULL) {
+    next = buffer->next;
+    if (buffer->arena == arena) {
+      /* A transfer that spans several messages keeps its buffer, so copy it
+       * to storage of its own.
+       */
+      uint8_t *data = (uint8_t *)malloc(OC_MAX_APP_DATA_SIZE);
+      if (!data) {
+        OC_WRN("insufficient memory to keep block-wise buffer");
+        free_buffer(buffer);
+      } else {
+        memcpy(data, buffer->buffer, OC_MAX_APP_DATA_SIZE);
+        buffer->buffer = data;
+        oc_new_string(&buffer->href, oc_string(buffer->href),
+                      oc_string_len(buffer->href));
+        if (oc_string_len(buffer->uri_query) > 0) {
+          oc_new_string(&buffer->uri_query, oc_string(buffer->uri_query),
+                        oc_string_len(buffer->uri_query));
+        }
+        buffer->arena = NULL;
+      }
+    }
+    buffer = next;
+  }
+}
+
+void
+oc_blockwise_detach_arena_buffers(void)
+{
+  oc_arena_t *arena = oc_ri_request_arena();
+  oc_blockwise_detach_buffers(oc_blockwise_requests, arena,
+                              oc_blockwise_free_request_buffer);
+  oc_blockwise_detach_buffers(oc_blockwise_responses, arena,
+                              oc_blockwise_free_response_buffer);
+}
+#endif /* OC_REQUEST_ARENA */
+
 void
 oc_blockwise_free_request_buffer(oc_blockwise_state_t *buffer)
 {
@@ -158,6 +286,38 @@ oc_blockwise_free_response_buffer(oc_blockwise_state_t *buffer)
   oc_blockwise_response_timeout(buffer);
 }
 
+#ifdef OC_WORKER_THREADS
+void
+oc_blockwise_hold_request_buffer(oc_blockwise_state_t *buffer)
+{
+  oc_ri_remove_timed_event_callback(buffer, oc_blockwise_request_timeout);
+  buffer->ref_count++;
+}
+
+void
+oc_blockwise_release_request_buffer(oc_blockwise_state_t *buffer)
+{
+  buffer->ref_count--;
+  oc_ri_add_timed_event_callback_seconds(buffer, oc_blockwise_request_timeout,
+                                         OC_EXCHANGE_LIFETIME);
+}
+
+void
+oc_blockwise_hold_response_buffer(oc_blockwise_state_t *buffer)
+{
+  oc_ri_remove_timed_event_callback(buffer, oc_blockwise_response_timeout);
+  buffer->ref_count++;
+}
+
+void
+oc_blockwise_release_response_buffer(oc_blockwise_state_t *buffer)
+{
+  buffer->ref_count--;
+  oc_ri_add_timed_event_callback_seconds(buffer, oc_blockwise_response_timeout,
+                                         OC_EXCHANGE_LIFETIME);
+}
+#endif /* OC_WORKER_THREADS */
+
 #ifdef OC_CLIENT
 void
 oc_blockwise_scrub_buffers_for_client_cb(void *cb)
@@ -20,6 +20,7 @@
 #include "util/oc_memb.h"
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #ifdef OC_DYNAMIC_ALLOCATION
 #include <stdlib.h>
 #endif /* OC_DYNAMIC_ALLOCATION */
@@ -33,23 +34,192 @@
 #include "oc_events.h"
 
 OC_PROCESS(message_buffer_handler, "OC Message Buffer Handler");
-OC_MEMB(oc_incoming_buffers, oc_message_t, OC_MAX_NUM_CONCURRENT_REQUESTS);
-OC_MEMB(oc_outgoing_buffers, oc_message_t, OC_MAX_NUM_CONCURRENT_REQUESTS);
+OC_MEMB_CACHED(oc_incoming_buffers, oc_message_t,
+               OC_MAX_NUM_CONCURRENT_REQUESTS);
+OC_MEMB_CACHED(oc_outgoing_buffers, oc_message_t,
+               OC_MAX_NUM_CONCURRENT_REQUESTS);
 
-static oc_message_t *
-allocate_message(struct oc_memb *pool)
+#if defined(OC_LOCKFREE_NETWORK_EVENTS) && defined(OC_DYNAMIC_ALLOCATION) &&   \
+  !defined(OC_MEMORY_TRACE)
+#define OC_MESSAGE_CACHE
+#endif
+
+/* allocate_message() takes blocks off the same free lists under this lock */
+static void
+free_message_block(struct oc_memb *pool, oc_message_t *message)
 {
   oc_network_event_handler_mutex_lock();
-  oc_message_t *message = (oc_message_t *)oc_memb_alloc(pool);
+  oc_memb_free(pool, message);
   oc_network_event_handler_mutex_unlock();
+}
+
+#ifdef OC_MESSAGE_CACHE
+/* Receive buffers released by the stack are parked on free_messages instead
+ * of being freed. An allocating thread detaches the whole stack into a cache
+ * slot that only it pops from, so neither side takes a lock and no two
+ * threads ever pop from the same list. A thread gives its slot back when it
+ * exits, and oc_message_cache_free() invalidates every slot held so far.
+ */
+#define OC_MESSAGE_CACHE_SLOTS (8)
+#define OC_MESSAGE_CACHE_SIZE (64)
+
+static oc_message_t *free_messages;
+static int num_free_messages;
+static oc_message_t *cache_slots[OC_MESSAGE_CACHE_SLOTS];
+static bool cache_slot_taken[OC_MESSAGE_CACHE_SLOTS];
+static int cache_generation;
+/* 1-based index into cache_slots, 0 if the thread does not hold one */
+static OC_THREAD_LOCAL int cache_slot;
+static OC_THREAD_LOCAL int cache_slot_generation;
+
+static int
+claim_cache_slot(void)
+{
+  int i;
+  for (i = 0; i < OC_MESSAGE_CACHE_SLOTS; i++) {
+    if (!__atomic_load_n(&cache_slot_taken[i], __ATOMIC_RELAXED) &&
+        !__atomic_exchange_n(&cache_slot_taken[i], true, __ATOMIC_ACQUIRE)) {
+      return i + 1;
+    }
+  }
+  return 0;
+}
+
+static oc_message_t *
+take_cached_message(void)
+{
+  int generation = __atomic_load_n(&cache_generation, __ATOMIC_ACQUIRE);
+  if (cache_slot == 0 || cache_slot_generation != generation) {
+    cache_slot = claim_cache_slot();
+    cache_slot_generation = generation;
+  }
+  if (cache_slot == 0) {
+    return NULL;
+  }
+
+  oc_message_t **cache = &cache_slots[cache_slot - 1];
+  if (!*cache) {
+    *cache = __atomic_exchange_n(&free_messages, NULL, __ATOMIC_ACQUIRE);
+    int n = 0;
+    oc_message_t *m;
+    for (m = *cache; m != NULL; m = m->next) {
+      n++;
+    }
+    __atomic_fetch_sub(&num_free_messages, n, __ATOMIC_RELAXED);
+  }
+
+  oc_message_t *message = *cache;
   if (message) {
+    *cache = message->next;
+    uint8_t *data = message->data;
+    memset(message, 0, sizeof(oc_message_t));
+    message->data = data;
+  }
+  return message;
+}
+
+static bool
+cache_message(oc_message_t *message)
+{
+  if (__atomic_fetch_add(&num_free_messages, 1, __ATOMIC_RELAXED) >=
+      OC_MESSAGE_CACHE_SIZE) {
+    __atomic_fetch_sub(&num_free_messages, 1, __ATOMIC_RELAXED);
+    return false;
+  }
+  oc_message_t *top = __atomic_load_n(&free_messages, __ATOMIC_RELAXED);
+  do {
+    message->next = top;
+  } while (!__atomic_compare_exchange_n(&free_messages, &top, message, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+  return true;
+}
+
+static void
+free_cached_message(oc_message_t *message)
+{
+  free(message->data);
+  free_message_block(&oc_incoming_buffers, message);
+}
+
+static void
+free_message_list(oc_message_t *message)
+{
+  while (message != NULL) {
+    oc_message_t *next = message->next;
+    free_cached_message(message);
+    message = next;
+  }
+}
+#endif /* OC_MESSAGE_CACHE */
+
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+void
+oc_message_cache_thread_exit(void)
+{
+#ifdef OC_MESSAGE_CACHE
+  if (cache_slot > 0 &&
+      cache_slot_generation ==
+        __atomic_load_n(&cache_generation, __ATOMIC_ACQUIRE)) {
+    oc_message_t *message = cache_slots[cache_slot - 1];
+    cache_slots[cache_slot - 1] = NULL;
+    while (message != NULL) {
+      oc_message_t *next = message->next;
+      if (!cache_message(message)) {
+        free_cached_message(message);
+      }
+      message = next;
+    }
+    __atomic_store_n(&cache_slot_taken[cache_slot - 1], false,
+                     __ATOMIC_RELEASE);
+  }
+  cache_slot = 0;
+#endif /* OC_MESSAGE_CACHE */
+}
+
+void
+oc_message_cache_free(void)
+{
+#ifdef OC_MESSAGE_CACHE
+  free_message_list(__atomic_exchange_n(&free_messages, NULL, __ATOMIC_ACQUIRE));
+  __atomic_store_n(&num_free_messages, 0, __ATOMIC_RELAXED);
+  int i;
+  for (i = 0; i < OC_MESSAGE_CACHE_SLOTS; i++) {
+    free_message_list(cache_slots[i]);
+    cache_slots[i] = NULL;
+    __atomic_store_n(&cache_slot_taken[i], false, __ATOMIC_RELAXED);
+  }
+  /* Slots still recorded by surviving threads are stale from here on */
+  __atomic_fetch_add(&cache_generation, 1, __ATOMIC_RELEASE);
+#endif /* OC_MESSAGE_CACHE */
+}
+#endif /* OC_LOCKFREE_NETWORK_EVENTS */
+
+static oc_message_t *
+allocate_message(struct oc_memb *pool)
+{
+  oc_message_t *message = NULL;
+#ifdef OC_MESSAGE_CACHE
+  if (pool == &oc_incoming_buffers) {
+    message = take_cached_message();
+  }
+  if (!message) {
+#endif /* OC_MESSAGE_CACHE */
+    oc_network_event_handler_mutex_lock();
+    message = (oc_message_t *)oc_memb_alloc(pool);
+    oc_network_event_handler_mutex_unlock();
 #ifdef OC_DYNAMIC_ALLOCATION
-    message->data = malloc(OC_PDU_SIZE);
-    if (!message->data) {
-      oc_memb_free(pool, message);
-      return NULL;
+    if (message) {
+      message->data = malloc(OC_PDU_SIZE);
+      if (!message->data) {
+        free_message_block(pool, message);
+        return NULL;
+      }
     }
 #endif /* OC_DYNAMIC_ALLOCATION */
+#ifdef OC_MESSAGE_CACHE
+  }
+#endif /* OC_MESSAGE_CACHE */
+  if (message) {
     message->pool = pool;
     message->length = 0;
     message->next = 0;
@@ -105,17 +275,61 @@ oc_message_add_ref(oc_message_t *message)
     message->ref_count++;
 }
 
+#ifdef OC_SHARED_PAYLOADS
+oc_message_payload_t *
+oc_message_payload_new(const uint8_t *data, size_t length)
+{
+  oc_message_payload_t *payload =
+    (oc_message_payload_t *)malloc(sizeof(oc_message_payload_t) + length);
+  if (!payload) {
+    OC_WRN("buffer: out of memory allocating shared payload");
+    return NULL;
+  }
+  payload->ref_count = 1;
+  payload->length = length;
+  memcpy(payload->data, data, length);
+  return payload;
+}
+
+void
+oc_message_payload_unref(oc_message_payload_t *payload)
+{
+  if (payload && --payload->ref_count == 0) {
+    free(payload);
+  }
+}
+
+void
+oc_message_set_payload(oc_message_t *message, oc_message_payload_t *payload)
+{
+  oc_message_payload_unref(message->payload);
+  if (payload) {
+    payload->ref_count++;
+  }
+  message->payload = payload;
+}
+#endif /* OC_SHARED_PAYLOADS */
+
 void
 oc_message_unref(oc_message_t *message)
 {
   if (message) {
     message->ref_count--;
     if (message->ref_count <= 0) {
+#ifdef OC_SHARED_PAYLOADS
+      oc_message_set_payload(message, NULL);
+#endif /* OC_SHARED_PAYLOADS */
+#ifdef OC_MESSAGE_CACHE
+      if (message->pool == &oc_incoming_buffers &&
+          !oc_incoming_buffers.buffers_avail_cb && cache_message(message)) {
+        return;
+      }
+#endif /* OC_MESSAGE_CACHE */
 #ifdef OC_DYNAMIC_ALLOCATION
       free(message->data);
 #endif /* OC_DYNAMIC_ALLOCATION */
       struct oc_memb *pool = message->pool;
-      oc_memb_free(pool, message);
+      free_message_block(pool, message);
 #ifndef OC_DYNAMIC_ALLOCATION
       OC_DBG("buffer: freed TX/RX buffer; num free: %d", oc_memb_numfree(pool));
 #endif /* !OC_DYNAMIC_ALLOCATION */
@@ -191,7 +405,11 @@ OC_PROCESS_THREAD(message_buffer_handler, ev, data)
 #endif /* OC_SECURITY */
       {
         OC_DBG("Outbound network event: unicast message");
+#ifdef OC_SEND_BATCHING
+        oc_send_buffer_batched(message);
+#else  /* OC_SEND_BATCHING */
         oc_send_buffer(message);
+#endif /* !OC_SEND_BATCHING */
         oc_message_unref(message);
       }
     }
@@ -311,7 +311,7 @@ oc_stop_observe(const char *uri, oc_endpoint_t *endpoint)
   if (!cb)
     return false;
 
-  cb->mid = coap_get_mid();
+  oc_ri_set_client_cb_mid(cb, coap_get_mid());
   cb->observe_seq = 1;
 
   bool status = false;
@@ -379,8 +379,8 @@ oc_do_ipv4_discovery(const oc_client_cb_t *ipv6_cb,
   if (!cb)
     return false;
 
-  cb->mid = ipv6_cb->mid;
-  memcpy(cb->token, ipv6_cb->token, cb->token_len);
+  oc_ri_set_client_cb_mid(cb, ipv6_cb->mid);
+  oc_ri_set_client_cb_token(cb, ipv6_cb->token, ipv6_cb->token_len);
 
   cb->discovery = true;
   status = prepare_coap_request(cb);
@@ -408,8 +408,8 @@ oc_do_ipv4_multicast(oc_client_cb_t *ipv6_cb, oc_response_handler_t handler,
     return false;
   }
 
-  cb->mid = ipv6_cb->mid;
-  memcpy(cb->token, ipv6_cb->token, cb->token_len);
+  oc_ri_set_client_cb_mid(cb, ipv6_cb->mid);
+  oc_ri_set_client_cb_token(cb, ipv6_cb->token, ipv6_cb->token_len);
 
   cb->multicast = true;
 
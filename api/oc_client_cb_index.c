@@ -0,0 +1,263 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "oc_client_cb_index.h"
+
+#if defined(OC_CLIENT) && defined(OC_CLIENT_CB_INDEX)
+#include "port/oc_log.h"
+#include <string.h>
+#ifdef OC_DYNAMIC_ALLOCATION
+#include <stdlib.h>
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#define TOKEN_KEY (0)
+#define MID_KEY (1)
+#define URI_KEY (2)
+
+/* The chains of all keys that hash to a bucket. */
+typedef struct
+{
+  oc_client_cb_t *head[OC_CLIENT_CB_INDEX_KEYS];
+} oc_client_cb_bucket_t;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#define OC_CLIENT_CB_INDEX_MIN_BUCKETS (64)
+static oc_client_cb_bucket_t *buckets;
+static size_t num_buckets;
+#else /* OC_DYNAMIC_ALLOCATION */
+#if (OC_CLIENT_CB_INDEX_BUCKETS & (OC_CLIENT_CB_INDEX_BUCKETS - 1)) != 0
+#error "OC_CLIENT_CB_INDEX_BUCKETS must be a power of two"
+#endif /* OC_CLIENT_CB_INDEX_BUCKETS & (OC_CLIENT_CB_INDEX_BUCKETS - 1) */
+#define num_buckets (OC_CLIENT_CB_INDEX_BUCKETS)
+static oc_client_cb_bucket_t buckets[OC_CLIENT_CB_INDEX_BUCKETS];
+#endif /* !OC_DYNAMIC_ALLOCATION */
+static size_t num_cbs;
+
+static uint32_t
+hash_bytes(uint32_t hash, const uint8_t *data, size_t len)
+{
+  /* FNV-1a */
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t
+token_hash(const uint8_t *token, uint8_t token_len)
+{
+  return hash_bytes(2166136261u, token, token_len);
+}
+
+static uint32_t
+mid_hash(uint16_t mid)
+{
+  /* MIDs are handed out sequentially and spread over the buckets as is. */
+  return mid;
+}
+
+/* Covers the fields compared by oc_endpoint_compare(), so that callbacks for
+ * equal endpoints share a chain.
+ */
+static uint32_t
+uri_hash(const char *uri, size_t uri_len, const oc_endpoint_t *endpoint)
+{
+  uint32_t hash = hash_bytes(2166136261u, (const uint8_t *)uri, uri_len);
+  if (!endpoint) {
+    return hash;
+  }
+  if (endpoint->flags & IPV6) {
+    hash = hash_bytes(hash, endpoint->addr.ipv6.address, 16);
+    hash = hash_bytes(hash, (const uint8_t *)&endpoint->addr.ipv6.port,
+                      sizeof(endpoint->addr.ipv6.port));
+  }
+#ifdef OC_IPV4
+  else if (endpoint->flags & IPV4) {
+    hash = hash_bytes(hash, endpoint->addr.ipv4.address, 4);
+    hash = hash_bytes(hash, (const uint8_t *)&endpoint->addr.ipv4.port,
+                      sizeof(endpoint->addr.ipv4.port));
+  }
+#endif /* OC_IPV4 */
+  return hash_bytes(hash, (const uint8_t *)&endpoint->device,
+                    sizeof(endpoint->device));
+}
+
+static oc_client_cb_t **
+chain(int key, uint32_t hash)
+{
+  return &buckets[hash & (num_buckets - 1)].head[key];
+}
+
+static void
+append_cb(oc_client_cb_t **link, int key, oc_client_cb_t *cb)
+{
+  while (*link) {
+    link = &(*link)->index_next[key];
+  }
+  cb->index_next[key] = NULL;
+  *link = cb;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static void
+resize_buckets(size_t new_num_buckets)
+{
+  oc_client_cb_bucket_t *new_buckets = (oc_client_cb_bucket_t *)calloc(
+    new_num_buckets, sizeof(oc_client_cb_bucket_t));
+  if (!new_buckets) {
+    OC_WRN("insufficient memory to grow the client callback index");
+    return;
+  }
+  size_t i;
+  int key;
+  for (i = 0; i < num_buckets; i++) {
+    for (key = 0; key < OC_CLIENT_CB_INDEX_KEYS; key++) {
+      oc_client_cb_t *cb = buckets[i].head[key], *next;
+      while (cb) {
+        next = cb->index_next[key];
+        append_cb(&new_buckets[cb->index_hash[key] & (new_num_buckets - 1)]
+                     .head[key],
+                  key, cb);
+        cb = next;
+      }
+    }
+  }
+  free(buckets);
+  buckets = new_buckets;
+  num_buckets = new_num_buckets;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+bool
+oc_client_cb_index_add(oc_client_cb_t *cb)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (num_cbs >= num_buckets) {
+    resize_buckets(num_buckets ? num_buckets * 2
+                               : OC_CLIENT_CB_INDEX_MIN_BUCKETS);
+    if (!buckets) {
+      return false;
+    }
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+  /* The URI hash is kept for removal, as the endpoint that cb points to may
+   * change or go away while cb is alive.
+   */
+  cb->index_hash[TOKEN_KEY] = token_hash(cb->token, cb->token_len);
+  cb->index_hash[MID_KEY] = mid_hash(cb->mid);
+  cb->index_hash[URI_KEY] =
+    uri_hash(oc_string(cb->uri), oc_string_len(cb->uri), cb->endpoint);
+  int key;
+  for (key = 0; key < OC_CLIENT_CB_INDEX_KEYS; key++) {
+    append_cb(chain(key, cb->index_hash[key]), key, cb);
+  }
+  num_cbs++;
+  return true;
+}
+
+void
+oc_client_cb_index_remove(oc_client_cb_t *cb)
+{
+  if (num_cbs == 0) {
+    return;
+  }
+  bool found = false;
+  int key;
+  for (key = 0; key < OC_CLIENT_CB_INDEX_KEYS; key++) {
+    oc_client_cb_t **link = chain(key, cb->index_hash[key]);
+    while (*link && *link != cb) {
+      link = &(*link)->index_next[key];
+    }
+    if (*link) {
+      *link = cb->index_next[key];
+      cb->index_next[key] = NULL;
+      found = true;
+    }
+  }
+  if (!found) {
+    return;
+  }
+  num_cbs--;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (num_cbs == 0) {
+    free(buckets);
+    buckets = NULL;
+    num_buckets = 0;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+oc_client_cb_t *
+oc_client_cb_index_find_by_token(const uint8_t *token, uint8_t token_len)
+{
+  if (num_cbs == 0) {
+    return NULL;
+  }
+  uint32_t hash = token_hash(token, token_len);
+  oc_client_cb_t *cb = *chain(TOKEN_KEY, hash);
+  while (cb) {
+    if (cb->index_hash[TOKEN_KEY] == hash && cb->token_len == token_len &&
+        memcmp(cb->token, token, token_len) == 0) {
+      return cb;
+    }
+    cb = cb->index_next[TOKEN_KEY];
+  }
+  return NULL;
+}
+
+oc_client_cb_t *
+oc_client_cb_index_find_by_mid(uint16_t mid)
+{
+  if (num_cbs == 0) {
+    return NULL;
+  }
+  oc_client_cb_t *cb = *chain(MID_KEY, mid_hash(mid));
+  while (cb) {
+    if (cb->mid == mid) {
+      return cb;
+    }
+    cb = cb->index_next[MID_KEY];
+  }
+  return NULL;
+}
+
+oc_client_cb_t *
+oc_client_cb_index_next_by_uri(const char *uri, size_t uri_len,
+                               const oc_endpoint_t *endpoint,
+                               oc_client_cb_t *prev)
+{
+  if (num_cbs == 0) {
+    return NULL;
+  }
+  uint32_t hash = uri_hash(uri, uri_len, endpoint);
+  oc_client_cb_t *cb =
+    prev ? prev->index_next[URI_KEY] : *chain(URI_KEY, hash);
+  while (cb) {
+    if (cb->index_hash[URI_KEY] == hash &&
+        oc_string_len(cb->uri) == uri_len &&
+        memcmp(oc_string(cb->uri), uri, uri_len) == 0) {
+      return cb;
+    }
+    cb = cb->index_next[URI_KEY];
+  }
+  return NULL;
+}
+#else  /* OC_CLIENT && OC_CLIENT_CB_INDEX */
+typedef int dummy_declaration;
+#endif /* !OC_CLIENT || !OC_CLIENT_CB_INDEX */
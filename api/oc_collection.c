@@ -19,6 +19,11 @@
 #if defined(OC_COLLECTIONS) && defined(OC_SERVER)
 #include "oc_api.h"
 #include "oc_core_res.h"
+#include "oc_discovery.h"
+#include "oc_uri_index.h"
+#if defined(OC_SECURITY) && defined(OC_ACL_CACHE)
+#include "security/oc_acl.h"
+#endif /* OC_SECURITY && OC_ACL_CACHE */
 #include "util/oc_memb.h"
 
 OC_MEMB(oc_collections_s, oc_collection_t, OC_MAX_NUM_COLLECTIONS);
@@ -48,6 +53,15 @@ oc_collection_free(oc_collection_t *collection)
 {
   if (collection != NULL) {
     oc_list_remove(oc_collections, collection);
+#ifdef OC_URI_INDEX
+    oc_uri_index_remove((oc_resource_t *)collection);
+#endif /* OC_URI_INDEX */
+#ifdef OC_DISCOVERY_CACHE
+    oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
+#if defined(OC_SECURITY) && defined(OC_ACL_CACHE)
+    oc_sec_acl_cache_invalidate();
+#endif /* OC_SECURITY && OC_ACL_CACHE */
     oc_ri_free_resource_properties((oc_resource_t*)collection);
 
     oc_link_t *link;
@@ -198,7 +212,16 @@ oc_check_if_collection(oc_resource_t *resource)
 void
 oc_collection_add(oc_collection_t *collection)
 {
+#ifdef OC_URI_INDEX
+  if (!oc_uri_index_add((oc_resource_t *)collection,
+                        OC_URI_INDEX_COLLECTION)) {
+    return;
+  }
+#endif /* OC_URI_INDEX */
   oc_list_add(oc_collections, collection);
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 
 bool
@@ -20,6 +20,7 @@
 #include "oc_discovery.h"
 #include "oc_introspection.h"
 #include "oc_rep.h"
+#include "oc_uri_index.h"
 
 #ifdef OC_SECURITY
 #include "security/oc_doxm.h"
@@ -104,6 +105,15 @@ oc_core_shutdown(void)
 #ifdef OC_DYNAMIC_ALLOCATION
   if (core_resources) {
 #endif /* OC_DYNAMIC_ALLOCATION */
+#ifdef OC_URI_INDEX
+    size_t device;
+    int type;
+    for (device = 0; device < device_count; ++device) {
+      for (type = OCF_P + 1; type <= OCF_D; ++type) {
+        oc_uri_index_remove_core(type, device);
+      }
+    }
+#endif /* OC_URI_INDEX */
     for (i = 0; i < 1 + (OCF_D * device_count); ++i) {
       oc_resource_t *core_resource = &core_resources[i];
       oc_ri_free_resource_properties(core_resource);
@@ -464,6 +474,11 @@ oc_core_populate_resource(int core_resource, size_t device_index, const char *ur
   r->put_handler.cb = put;
   r->post_handler.cb = post;
   r->delete_handler.cb = delete;
+#ifdef OC_URI_INDEX
+  if (!oc_uri_index_add_core(core_resource, device_index)) {
+    oc_abort("Insufficient memory");
+  }
+#endif /* OC_URI_INDEX */
 }
 
 oc_uuid_t *
@@ -29,6 +29,172 @@
 #include "oc_core_res.h"
 #include "oc_endpoint.h"
 
+#ifdef OC_DISCOVERY_CACHE
+#ifndef OC_DYNAMIC_ALLOCATION
+#error "OC_DISCOVERY_CACHE requires OC_DYNAMIC_ALLOCATION"
+#endif /* !OC_DYNAMIC_ALLOCATION */
+#include "util/oc_list.h"
+#include <stdlib.h>
+
+/* Number of encoded responses that are kept, least recently used ones are
+   replaced first. */
+#ifndef OC_DISCOVERY_CACHE_ENTRIES
+#define OC_DISCOVERY_CACHE_ENTRIES (8)
+#endif /* OC_DISCOVERY_CACHE_ENTRIES */
+
+/* Responses to requests with longer query strings are not cached. */
+#ifndef OC_DISCOVERY_CACHE_MAX_QUERY
+#define OC_DISCOVERY_CACHE_MAX_QUERY (64)
+#endif /* OC_DISCOVERY_CACHE_MAX_QUERY */
+
+/* A response depends on the resources of the device, which invalidate the
+ * cache when they change, and on the endpoints and device IDs, which are
+ * summed up in a fingerprint that is checked on every lookup. The rest of the
+ * key describes the request.
+ */
+typedef struct discovery_cache_s
+{
+  struct discovery_cache_s *next;
+  size_t device;
+  oc_interface_mask_t iface_mask;
+  bool oic_1_1;
+  int ip_flags;
+  int interface_index;
+  uint32_t fingerprint;
+  int matches;
+  size_t query_len;
+  char query[OC_DISCOVERY_CACHE_MAX_QUERY];
+  uint16_t length;
+  uint8_t payload[];
+} discovery_cache_t;
+
+OC_LIST(discovery_cache);
+static int num_cached;
+
+static uint32_t
+hash_bytes(uint32_t hash, const void *data, size_t len)
+{
+  /* FNV-1a */
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t
+discovery_fingerprint(size_t first_device, size_t last_device)
+{
+  uint32_t hash = 2166136261u;
+  uint8_t con_announced = oc_get_con_res_announced() ? 1 : 0;
+  hash = hash_bytes(hash, &con_announced, 1);
+  size_t device;
+  for (device = first_device; device < last_device; device++) {
+    hash = hash_bytes(hash, oc_core_get_device_id(device)->id, 16);
+    oc_endpoint_t *eps = oc_connectivity_get_endpoints(device);
+    for (; eps; eps = eps->next) {
+      hash = hash_bytes(hash, &eps->flags, sizeof(eps->flags));
+      hash = hash_bytes(hash, &eps->interface_index,
+                        sizeof(eps->interface_index));
+      hash = hash_bytes(hash, &eps->addr, sizeof(eps->addr));
+    }
+  }
+  return hash;
+}
+
+static void
+discovery_cache_key(discovery_cache_t *key, oc_request_t *request,
+                    oc_interface_mask_t iface_mask)
+{
+  key->oic_1_1 = (request->origin->version == OIC_VER_1_1_0);
+  key->iface_mask = iface_mask;
+  key->interface_index = request->origin->interface_index;
+  if (key->oic_1_1) {
+    /* OIC 1.1 responses list the resources of all devices, with the ports of
+       the IP version of the request. */
+    key->device = 0;
+    key->ip_flags = request->origin->flags & (IPV4 | IPV6);
+    key->fingerprint = discovery_fingerprint(0, oc_core_get_num_devices());
+  } else {
+    key->device = request->resource->device;
+    key->ip_flags = 0;
+    key->fingerprint = discovery_fingerprint(key->device, key->device + 1);
+  }
+  key->query_len = request->query_len;
+  if (request->query_len > 0) {
+    memcpy(key->query, request->query, request->query_len);
+  }
+}
+
+static bool
+discovery_cache_key_equal(discovery_cache_t *a, discovery_cache_t *b)
+{
+  return a->device == b->device && a->iface_mask == b->iface_mask &&
+         a->oic_1_1 == b->oic_1_1 && a->ip_flags == b->ip_flags &&
+         a->interface_index == b->interface_index &&
+         a->fingerprint == b->fingerprint && a->query_len == b->query_len &&
+         memcmp(a->query, b->query, a->query_len) == 0;
+}
+
+static discovery_cache_t *
+discovery_cache_find(discovery_cache_t *key)
+{
+  discovery_cache_t *entry = oc_list_head(discovery_cache);
+  for (; entry; entry = entry->next) {
+    if (discovery_cache_key_equal(entry, key)) {
+      /* Keep the list in order of use. */
+      oc_list_remove(discovery_cache, entry);
+      oc_list_push(discovery_cache, entry);
+      return entry;
+    }
+  }
+  return NULL;
+}
+
+static void
+discovery_cache_store(discovery_cache_t *key, int matches,
+                      const uint8_t *payload, int length)
+{
+  if (length < 0) {
+    return;
+  }
+  if (!matches) {
+    length = 0;
+  }
+  if (num_cached >= OC_DISCOVERY_CACHE_ENTRIES) {
+    discovery_cache_t *last = oc_list_chop(discovery_cache);
+    if (last) {
+      free(last);
+      num_cached--;
+    }
+  }
+  discovery_cache_t *entry =
+    (discovery_cache_t *)malloc(sizeof(discovery_cache_t) + (size_t)length);
+  if (!entry) {
+    return;
+  }
+  memcpy(entry, key, sizeof(discovery_cache_t));
+  entry->matches = matches;
+  entry->length = (uint16_t)length;
+  if (length > 0) {
+    memcpy(entry->payload, payload, (size_t)length);
+  }
+  oc_list_push(discovery_cache, entry);
+  num_cached++;
+}
+
+void
+oc_discovery_cache_invalidate(void)
+{
+  discovery_cache_t *entry;
+  while ((entry = oc_list_pop(discovery_cache)) != NULL) {
+    free(entry);
+  }
+  num_cached = 0;
+}
+#endif /* OC_DISCOVERY_CACHE */
+
 static bool
 filter_resource(oc_resource_t *resource, oc_request_t *request,
                 const char *anchor, CborEncoder *links)
@@ -67,7 +233,7 @@ filter_resource(oc_resource_t *resource, oc_request_t *request,
   // p
   oc_rep_set_object(link, p);
   oc_rep_set_uint(p, bm,
-                  (uint8_t)(resource->properties & ~(OC_PERIODIC | OC_SECURE)));
+                  (uint8_t)(resource->properties & (OC_DISCOVERABLE | OC_OBSERVABLE)));
   oc_rep_close_object(link, p);
 
   // eps
@@ -230,7 +396,7 @@ filter_oic_1_1_resource(oc_resource_t *resource, oc_request_t *request,
   // p
   oc_rep_set_object(res, p);
   oc_rep_set_uint(p, bm,
-                  (uint8_t)(resource->properties & ~(OC_PERIODIC | OC_SECURE)));
+                  (uint8_t)(resource->properties & (OC_DISCOVERABLE | OC_OBSERVABLE)));
 
 #ifdef OC_SECURITY
   /** Tag all resources with sec=true for OIC 1.1 to pass the CTT script. */
@@ -394,11 +560,10 @@ process_oic_1_1_device_object(CborEncoder *device, oc_request_t *request,
   return matches;
 }
 
-static void
+static int
 oc_core_1_1_discovery_handler(oc_request_t *request,
-                              oc_interface_mask_t iface_mask, void *data)
+                              oc_interface_mask_t iface_mask)
 {
-  (void)data;
   int matches = 0;
   size_t device;
 
@@ -423,9 +588,13 @@ oc_core_1_1_discovery_handler(oc_request_t *request,
     break;
   }
 
-  int response_length = oc_rep_get_encoded_payload_size();
+  return matches;
+}
 
-  if (matches && response_length) {
+static void
+set_discovery_response(oc_request_t *request, int matches, int response_length)
+{
+  if (matches && response_length > 0) {
     request->response->response_buffer->response_length =
       (uint16_t)response_length;
     request->response->response_buffer->code = oc_status_code(OC_STATUS_OK);
@@ -443,47 +612,66 @@ oc_core_discovery_handler(oc_request_t *request, oc_interface_mask_t iface_mask,
 {
   (void)data;
 
-  if (request->origin && request->origin->version == OIC_VER_1_1_0) {
-    oc_core_1_1_discovery_handler(request, iface_mask, data);
-    return;
+#ifdef OC_DISCOVERY_CACHE
+  discovery_cache_t key;
+  bool cacheable = request->origin &&
+                   request->query_len <= OC_DISCOVERY_CACHE_MAX_QUERY &&
+                   (iface_mask == OC_IF_LL || iface_mask == OC_IF_BASELINE);
+  if (cacheable) {
+    discovery_cache_key(&key, request, iface_mask);
+    discovery_cache_t *entry = discovery_cache_find(&key);
+    if (entry &&
+        entry->length <= request->response->response_buffer->buffer_size) {
+      if (entry->length > 0) {
+        memcpy(request->response->response_buffer->buffer, entry->payload,
+               entry->length);
+      }
+      set_discovery_response(request, entry->matches, entry->length);
+      return;
+    }
+    /* An entry that does not fit this response buffer is kept as is. */
+    cacheable = (entry == NULL);
   }
+#endif /* OC_DISCOVERY_CACHE */
 
   int matches = 0;
   size_t device = request->resource->device;
 
-  switch (iface_mask) {
-  case OC_IF_LL: {
-    oc_rep_start_links_array();
-    matches += process_device_resources(oc_rep_array(links), request, device);
-    oc_rep_end_links_array();
-  } break;
-  case OC_IF_BASELINE: {
-    oc_rep_start_links_array();
-    oc_rep_start_object(*oc_rep_array(links), props);
-    memcpy(&root_map, &props_map, sizeof(CborEncoder));
-    oc_process_baseline_interface(
-      oc_core_get_resource_by_index(OCF_RES, device));
-    oc_rep_set_array(root, links);
-    matches += process_device_resources(oc_rep_array(links), request, device);
-    oc_rep_close_array(root, links);
-    memcpy(&props_map, &root_map, sizeof(CborEncoder));
-    oc_rep_end_object(*oc_rep_array(links), props);
-    oc_rep_end_links_array();
-  } break;
-  default:
-    break;
+  if (request->origin && request->origin->version == OIC_VER_1_1_0) {
+    matches = oc_core_1_1_discovery_handler(request, iface_mask);
+  } else {
+    switch (iface_mask) {
+    case OC_IF_LL: {
+      oc_rep_start_links_array();
+      matches += process_device_resources(oc_rep_array(links), request, device);
+      oc_rep_end_links_array();
+    } break;
+    case OC_IF_BASELINE: {
+      oc_rep_start_links_array();
+      oc_rep_start_object(*oc_rep_array(links), props);
+      memcpy(&root_map, &props_map, sizeof(CborEncoder));
+      oc_process_baseline_interface(
+        oc_core_get_resource_by_index(OCF_RES, device));
+      oc_rep_set_array(root, links);
+      matches += process_device_resources(oc_rep_array(links), request, device);
+      oc_rep_close_array(root, links);
+      memcpy(&props_map, &root_map, sizeof(CborEncoder));
+      oc_rep_end_object(*oc_rep_array(links), props);
+      oc_rep_end_links_array();
+    } break;
+    default:
+      break;
+    }
   }
   int response_length = oc_rep_get_encoded_payload_size();
-  if (matches && response_length > 0) {
-    request->response->response_buffer->response_length =
-      (uint16_t)response_length;
-    request->response->response_buffer->code = oc_status_code(OC_STATUS_OK);
-  } else if (request->origin && (request->origin->flags & MULTICAST) == 0) {
-    request->response->response_buffer->code =
-      oc_status_code(OC_STATUS_BAD_REQUEST);
-  } else {
-    request->response->response_buffer->code = OC_IGNORE;
+#ifdef OC_DISCOVERY_CACHE
+  if (cacheable) {
+    discovery_cache_store(&key, matches,
+                          request->response->response_buffer->buffer,
+                          response_length);
   }
+#endif /* OC_DISCOVERY_CACHE */
+  set_discovery_response(request, matches, response_length);
 }
 
 void
@@ -513,9 +701,9 @@ oc_ri_process_discovery_payload(uint8_t *payload, int len,
   memset(rep_objects_pool, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
   struct oc_memb rep_objects = { sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                                  rep_objects_alloc, (void *)rep_objects_pool,
-                                 0 };
+                                 0, 0, 0, 0, 0 };
 #else  /* !OC_DYNAMIC_ALLOCATION */
-  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0 };
+  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
 #endif /* OC_DYNAMIC_ALLOCATION */
   oc_rep_set_pool(&rep_objects);
 
@@ -33,7 +33,7 @@
 #define OC_IPV6_ADDRLEN (16)
 #define OC_IPV4_ADDRLEN (4)
 
-OC_MEMB(oc_endpoints_s, oc_endpoint_t, OC_MAX_NUM_ENDPOINTS);
+OC_MEMB_CACHED(oc_endpoints_s, oc_endpoint_t, OC_MAX_NUM_ENDPOINTS);
 
 oc_endpoint_t *
 oc_new_endpoint(void)
@@ -47,7 +47,9 @@ oc_new_endpoint(void)
 void
 oc_free_endpoint(oc_endpoint_t *endpoint)
 {
+  oc_network_event_handler_mutex_lock();
   oc_memb_free(&oc_endpoints_s, endpoint);
+  oc_network_event_handler_mutex_unlock();
 }
 
 void
@@ -20,9 +20,13 @@
 #include "port/oc_assert.h"
 #include "port/oc_clock.h"
 #include "port/oc_connectivity.h"
+#ifdef OC_WORKER_THREADS
+#include "port/oc_worker_pool.h"
+#endif /* OC_WORKER_THREADS */
 
 #include "util/oc_etimer.h"
 #include "util/oc_process.h"
+#include "util/oc_memb.h"
 
 #include "oc_api.h"
 #include "oc_core_res.h"
@@ -214,6 +218,12 @@ oc_main_init(const oc_handler_t *handler)
     app_callbacks->requests_entry();
 #endif
 
+#ifdef OC_WORKER_THREADS
+  if (oc_worker_pool_init() < 0) {
+    OC_WRN("oc_main: processing requests on the event loop thread");
+  }
+#endif /* OC_WORKER_THREADS */
+
   initialized = true;
   return 0;
 
@@ -225,19 +235,46 @@ err:
 oc_clock_time_t
 oc_main_poll(void)
 {
+#ifdef OC_WORKER_THREADS
+  oc_stack_mutex_lock();
+#endif /* OC_WORKER_THREADS */
   oc_clock_time_t ticks_until_next_event = oc_etimer_request_poll();
   while (oc_process_run()) {
     ticks_until_next_event = oc_etimer_request_poll();
   }
+#ifdef OC_SEND_BATCHING
+  oc_send_buffer_flush();
+#endif /* OC_SEND_BATCHING */
+#ifdef OC_WORKER_THREADS
+  oc_stack_mutex_unlock();
+#endif /* OC_WORKER_THREADS */
   return ticks_until_next_event;
 }
 
+#ifdef OC_WORKER_THREADS
+void
+oc_main_lock(void)
+{
+  oc_stack_mutex_lock();
+}
+
+void
+oc_main_unlock(void)
+{
+  oc_stack_mutex_unlock();
+}
+#endif /* OC_WORKER_THREADS */
+
 void
 oc_main_shutdown(void)
 {
   if (initialized == false)
     return;
 
+#ifdef OC_WORKER_THREADS
+  oc_worker_pool_shutdown();
+#endif /* OC_WORKER_THREADS */
+
   oc_ri_shutdown();
 
 #ifdef OC_SECURITY
@@ -252,8 +289,18 @@ oc_main_shutdown(void)
   oc_tls_shutdown();
 #endif /* OC_SECURITY */
 
+#ifdef OC_SEND_BATCHING
+  oc_send_buffer_flush();
+#endif /* OC_SEND_BATCHING */
+
   oc_shutdown_all_devices();
 
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  oc_message_cache_free();
+#endif /* OC_LOCKFREE_NETWORK_EVENTS */
+
+  oc_memb_free_cached();
+
   app_callbacks = NULL;
   initialized = false;
 
@@ -19,22 +19,71 @@
 #include "oc_events.h"
 #include "oc_signal_event_loop.h"
 #include "port/oc_connectivity.h"
+#ifdef OC_WORKER_THREADS
+#include "port/oc_worker_pool.h"
+#endif /* OC_WORKER_THREADS */
 #include "util/oc_list.h"
 
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+/* Adapter threads push onto this intrusive LIFO stack with a CAS. The event
+ * loop is its only consumer: it detaches the whole stack with one exchange
+ * and reverses it back into arrival order, so no ABA can arise.
+ */
+static oc_message_t *network_events;
+#else  /* OC_LOCKFREE_NETWORK_EVENTS */
 OC_LIST(network_events);
+#endif /* !OC_LOCKFREE_NETWORK_EVENTS */
 #ifdef OC_NETWORK_MONITOR
 static bool interface_up, interface_down;
 #endif /* OC_NETWORK_MONITOR */
 
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+/* first..last must be linked newest to oldest */
+static void
+push_network_events(oc_message_t *first, oc_message_t *last)
+{
+  oc_message_t *top = __atomic_load_n(&network_events, __ATOMIC_RELAXED);
+  do {
+    last->next = top;
+  } while (!__atomic_compare_exchange_n(&network_events, &top, first, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+}
+
 static void
 oc_process_network_event(void)
 {
-  oc_network_event_handler_mutex_lock();
-  oc_message_t *message = (oc_message_t *)oc_list_pop(network_events);
+  oc_message_t *message =
+    __atomic_exchange_n(&network_events, NULL, __ATOMIC_ACQUIRE);
+  oc_message_t *ordered = NULL;
   while (message != NULL) {
+    oc_message_t *next = message->next;
+    message->next = ordered;
+    ordered = message;
+    message = next;
+  }
+  while (ordered != NULL) {
+    message = ordered;
+    ordered = ordered->next;
+    message->next = NULL;
     oc_recv_message(message);
-    message = oc_list_pop(network_events);
   }
+#ifdef OC_NETWORK_MONITOR
+  if (__atomic_exchange_n(&interface_up, false, __ATOMIC_ACQ_REL)) {
+    oc_process_post(&oc_network_events, oc_events[INTERFACE_UP], NULL);
+  }
+  if (__atomic_exchange_n(&interface_down, false, __ATOMIC_ACQ_REL)) {
+    oc_process_post(&oc_network_events, oc_events[INTERFACE_DOWN], NULL);
+  }
+#endif /* OC_NETWORK_MONITOR */
+}
+#else  /* OC_LOCKFREE_NETWORK_EVENTS */
+static void
+oc_process_network_event(void)
+{
+  oc_network_event_handler_mutex_lock();
+  /* Messages are delivered after unlocking, as freeing one takes the lock */
+  oc_message_t *message = (oc_message_t *)oc_list_head(network_events);
+  oc_list_init(network_events);
 #ifdef OC_NETWORK_MONITOR
   if (interface_up) {
     oc_process_post(&oc_network_events, oc_events[INTERFACE_UP], NULL);
@@ -46,7 +95,15 @@ oc_process_network_event(void)
   }
 #endif /* OC_NETWORK_MONITOR */
   oc_network_event_handler_mutex_unlock();
+
+  while (message != NULL) {
+    oc_message_t *next = message->next;
+    message->next = NULL;
+    oc_recv_message(message);
+    message = next;
+  }
 }
+#endif /* !OC_LOCKFREE_NETWORK_EVENTS */
 
 OC_PROCESS(oc_network_events, "");
 OC_PROCESS_THREAD(oc_network_events, ev, data)
@@ -74,9 +131,73 @@ oc_network_event(oc_message_t *message)
     oc_message_unref(message);
     return;
   }
+#ifdef OC_WORKER_THREADS
+  if (oc_worker_pool_dispatch(message)) {
+    return;
+  }
+#endif /* OC_WORKER_THREADS */
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  push_network_events(message, message);
+#else  /* OC_LOCKFREE_NETWORK_EVENTS */
   oc_network_event_handler_mutex_lock();
   oc_list_add(network_events, message);
   oc_network_event_handler_mutex_unlock();
+#endif /* !OC_LOCKFREE_NETWORK_EVENTS */
+
+  oc_process_poll(&(oc_network_events));
+  _oc_signal_event_loop();
+}
+
+void
+oc_network_event_list(oc_message_t *messages)
+{
+  if (!oc_process_is_running(&(oc_network_events))) {
+    while (messages != NULL) {
+      oc_message_t *next = messages->next;
+      oc_message_unref(messages);
+      messages = next;
+    }
+    return;
+  }
+#ifdef OC_WORKER_THREADS
+  oc_message_t *head = NULL, *last = NULL;
+  while (messages != NULL) {
+    oc_message_t *next = messages->next;
+    messages->next = NULL;
+    if (!oc_worker_pool_dispatch(messages)) {
+      if (last) {
+        last->next = messages;
+      } else {
+        head = messages;
+      }
+      last = messages;
+    }
+    messages = next;
+  }
+  if (!head) {
+    return;
+  }
+  messages = head;
+#endif /* OC_WORKER_THREADS */
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  oc_message_t *oldest = messages, *newest = NULL;
+  while (messages != NULL) {
+    oc_message_t *next = messages->next;
+    messages->next = newest;
+    newest = messages;
+    messages = next;
+  }
+  push_network_events(newest, oldest);
+#else  /* OC_LOCKFREE_NETWORK_EVENTS */
+  oc_network_event_handler_mutex_lock();
+  oc_message_t *tail = (oc_message_t *)oc_list_tail(network_events);
+  if (tail) {
+    tail->next = messages;
+  } else {
+    *network_events = messages;
+  }
+  oc_network_event_handler_mutex_unlock();
+#endif /* !OC_LOCKFREE_NETWORK_EVENTS */
 
   oc_process_poll(&(oc_network_events));
   _oc_signal_event_loop();
@@ -90,6 +211,15 @@ oc_network_interface_event(oc_interface_event_t event)
     return;
   }
 
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  if (event == NETWORK_INTERFACE_DOWN) {
+    __atomic_store_n(&interface_down, true, __ATOMIC_RELEASE);
+  } else if (event == NETWORK_INTERFACE_UP) {
+    __atomic_store_n(&interface_up, true, __ATOMIC_RELEASE);
+  } else {
+    return;
+  }
+#else  /* OC_LOCKFREE_NETWORK_EVENTS */
   oc_network_event_handler_mutex_lock();
   if (event == NETWORK_INTERFACE_DOWN) {
     interface_down = true;
@@ -100,6 +230,7 @@ oc_network_interface_event(oc_interface_event_t event)
     return;
   }
   oc_network_event_handler_mutex_unlock();
+#endif /* !OC_LOCKFREE_NETWORK_EVENTS */
 
   oc_process_poll(&(oc_network_events));
   _oc_signal_event_loop();
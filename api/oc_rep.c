@@ -20,10 +20,25 @@
 #include "port/oc_log.h"
 #include "util/oc_memb.h"
 
+
+#ifdef OC_WORKER_THREADS
+/* Each request worker encodes into its own response buffer. */
+static OC_THREAD_LOCAL struct oc_memb *rep_objects;
+#ifdef OC_REP_ARENA
+static OC_THREAD_LOCAL oc_arena_t *rep_arena;
+#endif /* OC_REP_ARENA */
+static OC_THREAD_LOCAL uint8_t *g_buf;
+OC_THREAD_LOCAL CborEncoder g_encoder, root_map, links_array;
+OC_THREAD_LOCAL CborError g_err;
+#else  /* OC_WORKER_THREADS */
 static struct oc_memb *rep_objects;
+#ifdef OC_REP_ARENA
+static oc_arena_t *rep_arena;
+#endif /* OC_REP_ARENA */
 static uint8_t *g_buf;
 CborEncoder g_encoder, root_map, links_array;
 CborError g_err;
+#endif /* !OC_WORKER_THREADS */
 
 void
 oc_rep_set_pool(struct oc_memb *rep_objects_pool)
@@ -64,9 +79,137 @@ oc_rep_get_encoded_payload_size(void)
   return (int)size;
 }
 
+/* Appends encoded bytes the way tinycbor appends to its buffer: once the
+ * buffer is exhausted, end is cleared and data.bytes_needed counts the bytes
+ * that did not fit.
+ */
+static CborError
+encode_raw(CborEncoder *encoder, const uint8_t *data, size_t len)
+{
+  if (encoder->remaining) {
+    encoder->remaining--;
+  }
+  if (encoder->end && (size_t)(encoder->end - encoder->data.ptr) >= len) {
+    memcpy(encoder->data.ptr, data, len);
+    encoder->data.ptr += len;
+    return CborNoError;
+  }
+  if (encoder->end) {
+    len -= (size_t)(encoder->end - encoder->data.ptr);
+    encoder->end = NULL;
+    encoder->data.bytes_needed = 0;
+  }
+  encoder->data.bytes_needed += (ptrdiff_t)len;
+  return CborErrorOutOfMemory;
+}
+
+CborError
+oc_rep_encode_key(CborEncoder *object, const oc_rep_key_t *key)
+{
+  return encode_raw(object, &key->header, 1 + (size_t)(key->header & 0x1f));
+}
+
+CborError
+oc_rep_encode_schema(CborEncoder *object, const oc_rep_schema_field_t *fields,
+                     size_t num_fields, const void *data)
+{
+  CborError err = CborNoError;
+  size_t i;
+  for (i = 0; i < num_fields; i++) {
+    const uint8_t *value = (const uint8_t *)data + fields[i].offset;
+    switch (fields[i].type) {
+    case OC_REP_INT:
+      err |= oc_rep_encode_key(object, &fields[i].key);
+      err |= cbor_encode_int(object, *(const int *)value);
+      break;
+    case OC_REP_BOOL:
+      err |= oc_rep_encode_key(object, &fields[i].key);
+      err |= cbor_encode_boolean(object, *(const bool *)value);
+      break;
+    case OC_REP_DOUBLE:
+      err |= oc_rep_encode_key(object, &fields[i].key);
+      err |= cbor_encode_double(object, *(const double *)value);
+      break;
+    case OC_REP_STRING: {
+      const char *str = *(const char *const *)value;
+      if (str) {
+        err |= oc_rep_encode_key(object, &fields[i].key);
+        err |= cbor_encode_text_string(object, str, strlen(str));
+      }
+    } break;
+    default:
+      OC_ERR("unsupported type %d of property %.*s", fields[i].type,
+             (int)(fields[i].key.header & 0x1f), fields[i].key.name);
+      err |= CborErrorIllegalType;
+      break;
+    }
+  }
+  g_err |= err;
+  return err;
+}
+
+#ifdef OC_REP_ARENA
+/* Bytes taken by a typical representation per byte of its payload, to size
+ * the first block of an arena.
+ */
+#define OC_REP_ARENA_BYTES_PER_PAYLOAD_BYTE (8)
+#define OC_REP_ARENA_MIN_BLOCK_SIZE (256)
+
+static void *
+arena_alloc(size_t size)
+{
+  return oc_arena_alloc(rep_arena, size);
+}
+
+static void
+arena_new_array(oc_array_t *array, size_t size, size_t item_size)
+{
+  array->next = NULL;
+  array->ptr = arena_alloc(size * item_size);
+  array->size = array->ptr ? size : 0;
+}
+
+static void
+arena_new_string_array(oc_string_array_t *array, size_t size)
+{
+  arena_new_array(array, size * STRING_ARRAY_ITEM_MAX_LEN, 1);
+  size_t i;
+  for (i = 0; i < oc_string_array_get_allocated_size(*array); i++) {
+    oc_string_array_get_item(*array, i)[0] = '\0';
+  }
+}
+
+#define rep_new_int_array(array, size)                                         \
+  (rep_arena ? arena_new_array(array, size, sizeof(int))                       \
+             : oc_new_int_array(array, size))
+#define rep_new_bool_array(array, size)                                        \
+  (rep_arena ? arena_new_array(array, size, sizeof(bool))                      \
+             : oc_new_bool_array(array, size))
+#define rep_new_double_array(array, size)                                      \
+  (rep_arena ? arena_new_array(array, size, sizeof(double))                    \
+             : oc_new_double_array(array, size))
+#define rep_new_string_array(array, size)                                      \
+  (rep_arena ? arena_new_string_array(array, size)                             \
+             : oc_new_string_array(array, size))
+#else /* OC_REP_ARENA */
+#define rep_new_int_array(array, size) oc_new_int_array(array, size)
+#define rep_new_bool_array(array, size) oc_new_bool_array(array, size)
+#define rep_new_double_array(array, size) oc_new_double_array(array, size)
+#define rep_new_string_array(array, size) oc_new_string_array(array, size)
+#endif /* !OC_REP_ARENA */
+
 static oc_rep_t *
 _alloc_rep(void)
 {
+#ifdef OC_REP_ARENA
+  if (rep_arena) {
+    oc_rep_t *rep = (oc_rep_t *)arena_alloc(sizeof(oc_rep_t));
+    if (rep != NULL) {
+      memset(rep, 0, sizeof(oc_rep_t));
+    }
+    return rep;
+  }
+#endif /* OC_REP_ARENA */
   oc_rep_t *rep = oc_memb_alloc(rep_objects);
   if (rep != NULL) {
     rep->name.size = 0;
@@ -134,6 +277,68 @@ oc_free_rep(oc_rep_t *rep)
   the next pointer of the first object.
 */
 
+#ifdef OC_REP_KEY_INDEX
+static uint32_t
+key_hash(const char *key, size_t key_len)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < key_len; i++) {
+    hash = (hash ^ (uint8_t)key[i]) * 16777619u;
+  }
+  return hash;
+}
+#endif /* OC_REP_KEY_INDEX */
+
+static bool cursor_string(const CborValue *value, const uint8_t **data,
+                          size_t *size);
+
+/* Copies the string at value into str, with a terminating NUL. */
+static CborError
+copy_string(CborValue *value, oc_string_t *str)
+{
+  size_t len;
+#ifdef OC_REP_ARENA
+  if (rep_arena) {
+    const uint8_t *data;
+    /* Definite length strings are copied straight out of the payload. */
+    if (cursor_string(value, &data, &len)) {
+      str->next = NULL;
+      str->ptr = arena_alloc(len + 1);
+      if (!str->ptr) {
+        return CborErrorOutOfMemory;
+      }
+      str->size = len + 1;
+      memcpy(str->ptr, data, len);
+      oc_string(*str)[len] = '\0';
+      return CborNoError;
+    }
+  }
+#endif /* OC_REP_ARENA */
+  CborError err = cbor_value_calculate_string_length(value, &len);
+  len++;
+  if (err != CborNoError) {
+    return err;
+  }
+#ifdef OC_REP_ARENA
+  if (rep_arena) {
+    arena_new_array(str, len, 1);
+  } else
+#endif /* OC_REP_ARENA */
+  {
+    oc_alloc_string(str, len);
+  }
+  if (!oc_string(*str)) {
+    return CborErrorOutOfMemory;
+  }
+  if (cbor_value_is_text_string(value)) {
+    return cbor_value_copy_text_string(value, oc_string(*str), &len, NULL);
+  }
+  return cbor_value_copy_byte_string(value, oc_cast(*str, uint8_t), &len,
+                                     NULL);
+}
+
 /* Parse single property */
 static void
 oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
@@ -153,15 +358,12 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
     *err = CborErrorIllegalType;
     return;
   }
-  *err |= cbor_value_calculate_string_length(value, &len);
-  len++;
-  if (*err != CborNoError || len == 0)
-    return;
-  oc_alloc_string(&cur->name, len);
-  *err |= cbor_value_copy_text_string(value, (char *)oc_string(cur->name), &len,
-                                      NULL);
+  *err |= copy_string(value, &cur->name);
   if (*err != CborNoError)
     return;
+#ifdef OC_REP_KEY_INDEX
+  cur->name_hash = key_hash(oc_string(cur->name), oc_string_len(cur->name));
+#endif /* OC_REP_KEY_INDEX */
   *err |= cbor_value_advance(value);
   /* value */
   switch (value->type) {
@@ -178,23 +380,11 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
     cur->type = OC_REP_DOUBLE;
     break;
   case CborByteStringType:
-    *err |= cbor_value_calculate_string_length(value, &len);
-    len++;
-    if (*err != CborNoError || len == 0)
-      return;
-    oc_alloc_string(&cur->value.string, len);
-    *err |= cbor_value_copy_byte_string(
-      value, oc_cast(cur->value.string, uint8_t), &len, NULL);
+    *err |= copy_string(value, &cur->value.string);
     cur->type = OC_REP_BYTE_STRING;
     break;
   case CborTextStringType:
-    *err |= cbor_value_calculate_string_length(value, &len);
-    len++;
-    if (*err != CborNoError || len == 0)
-      return;
-    oc_alloc_string(&cur->value.string, len);
-    *err |= cbor_value_copy_text_string(value, oc_string(cur->value.string),
-                                        &len, NULL);
+    *err |= copy_string(value, &cur->value.string);
     cur->type = OC_REP_STRING;
     break;
   case CborMapType: {
@@ -228,7 +418,7 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
       switch (array.type) {
       case CborIntegerType:
         if (k == 0) {
-          oc_new_int_array(&cur->value.array, len);
+          rep_new_int_array(&cur->value.array, len);
           cur->type = OC_REP_INT | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_INT) != OC_REP_INT){
           *err |= CborErrorIllegalType;
@@ -239,7 +429,7 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
         break;
       case CborDoubleType:
         if (k == 0) {
-          oc_new_double_array(&cur->value.array, len);
+          rep_new_double_array(&cur->value.array, len);
           cur->type = OC_REP_DOUBLE | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_DOUBLE) != OC_REP_DOUBLE){
           *err |= CborErrorIllegalType;
@@ -251,7 +441,7 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
         break;
       case CborBooleanType:
         if (k == 0) {
-          oc_new_bool_array(&cur->value.array, len);
+          rep_new_bool_array(&cur->value.array, len);
           cur->type = OC_REP_BOOL | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_BOOL) != OC_REP_BOOL){
           *err |= CborErrorIllegalType;
@@ -263,7 +453,7 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
         break;
       case CborByteStringType: {
         if (k == 0) {
-          oc_new_byte_string_array(&cur->value.array, len);
+          rep_new_string_array(&cur->value.array, len);
           cur->type = OC_REP_BYTE_STRING | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_BYTE_STRING) != OC_REP_BYTE_STRING) {
           *err |= CborErrorIllegalType;
@@ -284,7 +474,7 @@ oc_parse_rep_value(CborValue *value, oc_rep_t **rep, CborError *err)
       } break;
       case CborTextStringType:
         if (k == 0) {
-          oc_new_string_array(&cur->value.array, len);
+          rep_new_string_array(&cur->value.array, len);
           cur->type = OC_REP_STRING | OC_REP_ARRAY;
         } else if ((cur->type & OC_REP_STRING) != OC_REP_STRING){
           *err |= CborErrorIllegalType;
@@ -399,6 +589,84 @@ oc_parse_rep(const uint8_t *in_payload, int payload_size, oc_rep_t **out_rep)
   return err;
 }
 
+#ifdef OC_REP_ARENA
+int
+oc_parse_rep_arena(oc_arena_t *arena, const uint8_t *in_payload,
+                   int payload_size, oc_rep_t **out_rep)
+{
+  *out_rep = 0;
+  if (!oc_arena_reserve(arena, (size_t)payload_size *
+                                   OC_REP_ARENA_BYTES_PER_PAYLOAD_BYTE +
+                                 OC_REP_ARENA_MIN_BLOCK_SIZE)) {
+    return CborErrorOutOfMemory;
+  }
+  rep_arena = arena;
+  int err = oc_parse_rep(in_payload, payload_size, out_rep);
+  rep_arena = NULL;
+  return err;
+}
+#endif /* OC_REP_ARENA */
+
+static bool
+rep_has_name(oc_rep_t *rep_value, const char *key, size_t key_len,
+             uint32_t hash)
+{
+  (void)hash;
+  return
+#ifdef OC_REP_KEY_INDEX
+    rep_value->name_hash == hash &&
+#endif /* OC_REP_KEY_INDEX */
+    oc_string_len(rep_value->name) == key_len &&
+    memcmp(key, oc_string(rep_value->name), key_len) == 0;
+}
+
+static bool
+rep_copy_value(oc_rep_t *rep_value, void **value, size_t *size)
+{
+  switch (rep_value->type) {
+  case OC_REP_INT:
+    **(int **)value = rep_value->value.integer;
+    break;
+  case OC_REP_BOOL:
+    **(bool **)value = rep_value->value.boolean;
+    break;
+  case OC_REP_DOUBLE:
+    **(double **)value = rep_value->value.double_p;
+    break;
+  case OC_REP_BYTE_STRING:
+  case OC_REP_STRING:
+    *value = oc_string(rep_value->value.string);
+    *size = oc_string_len(rep_value->value.string);
+    break;
+  case OC_REP_INT_ARRAY:
+    *value = oc_int_array(rep_value->value.array);
+    *size = (int)oc_int_array_size(rep_value->value.array);
+    break;
+  case OC_REP_BOOL_ARRAY:
+    *value = oc_bool_array(rep_value->value.array);
+    *size = (int)oc_bool_array_size(rep_value->value.array);
+    break;
+  case OC_REP_DOUBLE_ARRAY:
+    *value = oc_double_array(rep_value->value.array);
+    *size = (int)oc_double_array_size(rep_value->value.array);
+    break;
+  case OC_REP_BYTE_STRING_ARRAY:
+  case OC_REP_STRING_ARRAY:
+    **(oc_string_array_t **)value = rep_value->value.array;
+    *size = (int)oc_string_array_get_allocated_size(rep_value->value.array);
+    break;
+  case OC_REP_OBJECT:
+    *value = rep_value->value.object;
+    break;
+  case OC_REP_OBJECT_ARRAY:
+    *value = rep_value->value.object_array;
+    break;
+  default:
+    return false;
+  }
+  return true;
+}
+
 static bool
 oc_rep_get_value(oc_rep_t *rep, oc_rep_value_type_t type, const char *key,
                  void **value, size_t *size)
@@ -408,56 +676,17 @@ oc_rep_get_value(oc_rep_t *rep, oc_rep_value_type_t type, const char *key,
     return false;
   }
 
+  size_t key_len = strlen(key);
+  uint32_t hash = 0;
+#ifdef OC_REP_KEY_INDEX
+  hash = key_hash(key, key_len);
+#endif /* OC_REP_KEY_INDEX */
   oc_rep_t *rep_value = rep;
   while (rep_value != NULL) {
-    if ((oc_string_len(rep_value->name) == strlen(key)) &&
-        (strncmp(key, oc_string(rep_value->name),
-                oc_string_len(rep_value->name)) == 0) &&
+    if (rep_has_name(rep_value, key, key_len, hash) &&
         (rep_value->type == type)) {
       OC_DBG("Found the value with %s", key);
-      switch (rep_value->type) {
-      case OC_REP_INT:
-        **(int **)value = rep_value->value.integer;
-        break;
-      case OC_REP_BOOL:
-        **(bool **)value = rep_value->value.boolean;
-        break;
-      case OC_REP_DOUBLE:
-        **(double **)value = rep_value->value.double_p;
-        break;
-      case OC_REP_BYTE_STRING:
-      case OC_REP_STRING:
-        *value = oc_string(rep_value->value.string);
-        *size = oc_string_len(rep_value->value.string);
-        break;
-      case OC_REP_INT_ARRAY:
-        *value = oc_int_array(rep_value->value.array);
-        *size = (int)oc_int_array_size(rep_value->value.array);
-        break;
-      case OC_REP_BOOL_ARRAY:
-        *value = oc_bool_array(rep_value->value.array);
-        *size = (int)oc_bool_array_size(rep_value->value.array);
-        break;
-      case OC_REP_DOUBLE_ARRAY:
-        *value = oc_double_array(rep_value->value.array);
-        *size = (int)oc_double_array_size(rep_value->value.array);
-        break;
-      case OC_REP_BYTE_STRING_ARRAY:
-      case OC_REP_STRING_ARRAY:
-        **(oc_string_array_t **)value = rep_value->value.array;
-        *size = (int)oc_string_array_get_allocated_size(rep_value->value.array);
-        break;
-      case OC_REP_OBJECT:
-        *value = rep_value->value.object;
-        break;
-      case OC_REP_OBJECT_ARRAY:
-        *value = rep_value->value.object_array;
-        break;
-      default:
-        return false;
-      }
-
-      return true;
+      return rep_copy_value(rep_value, value, size);
     }
     rep_value = rep_value->next;
   }
@@ -576,3 +805,276 @@ oc_rep_get_object_array(oc_rep_t *rep, const char *key, oc_rep_t **value)
 {
   return oc_rep_get_value(rep, OC_REP_OBJECT_ARRAY, key, (void **)value, NULL);
 }
+
+int
+oc_rep_get_fields(oc_rep_t *rep, oc_rep_field_t *fields, size_t num_fields)
+{
+  if (!fields) {
+    OC_ERR("Error of input parameters");
+    return 0;
+  }
+
+  size_t i;
+  for (i = 0; i < num_fields; i++) {
+    fields[i].found = false;
+    fields[i].size = 0;
+    fields[i].key_len = fields[i].key ? strlen(fields[i].key) : 0;
+    fields[i].key_hash = 0;
+#ifdef OC_REP_KEY_INDEX
+    fields[i].key_hash = key_hash(fields[i].key, fields[i].key_len);
+#endif /* OC_REP_KEY_INDEX */
+  }
+
+  /* The search for each property starts at the field after the last match.
+   */
+  int found = 0;
+  size_t next = 0;
+  oc_rep_t *rep_value;
+  for (rep_value = rep; rep_value && num_fields > 0;
+       rep_value = rep_value->next) {
+    for (i = 0; i < num_fields; i++) {
+      oc_rep_field_t *field = &fields[(next + i) % num_fields];
+      if (field->found || !field->key || field->type != rep_value->type ||
+          !rep_has_name(rep_value, field->key, field->key_len,
+                        field->key_hash)) {
+        continue;
+      }
+      /* Scalars and string arrays are copied to where value points, and
+       * everything else is returned as a pointer stored there.
+       */
+      void *dest = field->value;
+      void **value = (void **)field->value;
+      switch (field->type) {
+      case OC_REP_INT:
+      case OC_REP_BOOL:
+      case OC_REP_DOUBLE:
+      case OC_REP_BYTE_STRING_ARRAY:
+      case OC_REP_STRING_ARRAY:
+        value = &dest;
+        break;
+      default:
+        break;
+      }
+      if (field->value && rep_copy_value(rep_value, value, &field->size)) {
+        field->found = true;
+        found++;
+      }
+      next = (next + i + 1) % num_fields;
+      break;
+    }
+  }
+  return found;
+}
+
+static void
+cursor_set(oc_rep_cursor_t *cursor, const CborValue *value)
+{
+  cursor->parser = *value->parser;
+  cursor->value = *value;
+  cursor->value.parser = &cursor->parser;
+}
+
+/* Locates the bytes of a definite length string within the payload. */
+static bool
+cursor_string(const CborValue *value, const uint8_t **data, size_t *size)
+{
+  size_t len, header;
+  if (!cbor_value_is_length_known(value) ||
+      cbor_value_get_string_length(value, &len) != CborNoError) {
+    return false;
+  }
+  switch (*value->ptr & 0x1f) {
+  case 24:
+    header = 2;
+    break;
+  case 25:
+    header = 3;
+    break;
+  case 26:
+    header = 5;
+    break;
+  case 27:
+    header = 9;
+    break;
+  default:
+    header = 1;
+    break;
+  }
+  if ((size_t)(value->parser->end - value->ptr) < header ||
+      (size_t)(value->parser->end - value->ptr) - header < len) {
+    return false;
+  }
+  *data = value->ptr + header;
+  *size = len;
+  return true;
+}
+
+static bool
+cursor_find(const oc_rep_cursor_t *object, const char *key, CborValue *value)
+{
+  if (!object || !key || !cbor_value_is_map(&object->value) ||
+      cbor_value_enter_container(&object->value, value) != CborNoError) {
+    return false;
+  }
+  size_t key_len = strlen(key);
+  while (!cbor_value_at_end(value)) {
+    const uint8_t *name;
+    size_t name_len;
+    if (!cbor_value_is_text_string(value) ||
+        !cursor_string(value, &name, &name_len) ||
+        cbor_value_advance(value) != CborNoError ||
+        cbor_value_at_end(value)) {
+      return false;
+    }
+    if (name_len == key_len && memcmp(name, key, key_len) == 0) {
+      return true;
+    }
+    if (cbor_value_advance(value) != CborNoError) {
+      return false;
+    }
+  }
+  return false;
+}
+
+bool
+oc_rep_cursor_init(oc_rep_cursor_t *cursor, const uint8_t *payload,
+                   size_t payload_size)
+{
+  if (!cursor || !payload ||
+      cbor_parser_init(payload, payload_size, 0, &cursor->parser,
+                       &cursor->value) != CborNoError) {
+    return false;
+  }
+  return cbor_value_is_map(&cursor->value);
+}
+
+bool
+oc_rep_cursor_read_int(const oc_rep_cursor_t *element, int *value)
+{
+  return element && value && cbor_value_is_integer(&element->value) &&
+         cbor_value_get_int(&element->value, value) == CborNoError;
+}
+
+bool
+oc_rep_cursor_read_bool(const oc_rep_cursor_t *element, bool *value)
+{
+  return element && value && cbor_value_is_boolean(&element->value) &&
+         cbor_value_get_boolean(&element->value, value) == CborNoError;
+}
+
+bool
+oc_rep_cursor_read_double(const oc_rep_cursor_t *element, double *value)
+{
+  return element && value && cbor_value_is_double(&element->value) &&
+         cbor_value_get_double(&element->value, value) == CborNoError;
+}
+
+bool
+oc_rep_cursor_read_string(const oc_rep_cursor_t *element, const char **value,
+                          size_t *size)
+{
+  return element && value && size &&
+         cbor_value_is_text_string(&element->value) &&
+         cursor_string(&element->value, (const uint8_t **)value, size);
+}
+
+bool
+oc_rep_cursor_read_byte_string(const oc_rep_cursor_t *element,
+                               const uint8_t **value, size_t *size)
+{
+  return element && value && size &&
+         cbor_value_is_byte_string(&element->value) &&
+         cursor_string(&element->value, value, size);
+}
+
+bool
+oc_rep_cursor_read_object(const oc_rep_cursor_t *element,
+                          oc_rep_cursor_t *object)
+{
+  if (!element || !object || !cbor_value_is_map(&element->value)) {
+    return false;
+  }
+  cursor_set(object, &element->value);
+  return true;
+}
+
+bool
+oc_rep_cursor_at_end(const oc_rep_cursor_t *array)
+{
+  return !array || cbor_value_at_end(&array->value);
+}
+
+bool
+oc_rep_cursor_next(oc_rep_cursor_t *array)
+{
+  return array && !cbor_value_at_end(&array->value) &&
+         cbor_value_advance(&array->value) == CborNoError;
+}
+
+bool
+oc_rep_cursor_get_int(const oc_rep_cursor_t *object, const char *key,
+                      int *value)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_int(&element, value);
+}
+
+bool
+oc_rep_cursor_get_bool(const oc_rep_cursor_t *object, const char *key,
+                       bool *value)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_bool(&element, value);
+}
+
+bool
+oc_rep_cursor_get_double(const oc_rep_cursor_t *object, const char *key,
+                         double *value)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_double(&element, value);
+}
+
+bool
+oc_rep_cursor_get_string(const oc_rep_cursor_t *object, const char *key,
+                         const char **value, size_t *size)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_string(&element, value, size);
+}
+
+bool
+oc_rep_cursor_get_byte_string(const oc_rep_cursor_t *object, const char *key,
+                              const uint8_t **value, size_t *size)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_byte_string(&element, value, size);
+}
+
+bool
+oc_rep_cursor_get_object(const oc_rep_cursor_t *object, const char *key,
+                         oc_rep_cursor_t *value)
+{
+  oc_rep_cursor_t element;
+  return cursor_find(object, key, &element.value) &&
+         oc_rep_cursor_read_object(&element, value);
+}
+
+bool
+oc_rep_cursor_get_array(const oc_rep_cursor_t *object, const char *key,
+                        oc_rep_cursor_t *array)
+{
+  CborValue value, elements;
+  if (!array || !cursor_find(object, key, &value) ||
+      !cbor_value_is_array(&value) ||
+      cbor_value_enter_container(&value, &elements) != CborNoError) {
+    return false;
+  }
+  cursor_set(array, &elements);
+  return true;
+}
@@ -24,6 +24,7 @@
 #include "util/oc_process.h"
 
 #include "messaging/coap/constants.h"
+#include "messaging/coap/dedup.h"
 #include "messaging/coap/engine.h"
 #include "messaging/coap/oc_coap.h"
 #ifdef OC_TCP
@@ -31,6 +32,9 @@
 #endif /* OC_TCP */
 
 #include "port/oc_random.h"
+#ifdef OC_WORKER_THREADS
+#include "port/oc_worker_pool.h"
+#endif /* OC_WORKER_THREADS */
 
 #include "oc_buffer.h"
 #include "oc_core_res.h"
@@ -42,6 +46,7 @@
 #endif /* OC_TCP */
 #include "oc_api.h"
 #include "oc_ri.h"
+#include "oc_uri_index.h"
 #include "oc_uuid.h"
 
 #ifdef OC_BLOCK_WISE
@@ -64,9 +69,11 @@ OC_MEMB(app_resources_s, oc_resource_t, OC_MAX_APP_RESOURCES);
 #endif /* OC_SERVER */
 
 #ifdef OC_CLIENT
+#include "oc_client_cb_index.h"
 #include "oc_client_state.h"
 OC_LIST(client_cbs);
-OC_MEMB(client_cbs_s, oc_client_cb_t, OC_MAX_NUM_CONCURRENT_REQUESTS + 1);
+OC_MEMB_CACHED(client_cbs_s, oc_client_cb_t,
+               OC_MAX_NUM_CONCURRENT_REQUESTS + 1);
 #endif /* OC_CLIENT */
 
 OC_LIST(timed_callbacks);
@@ -215,6 +222,24 @@ allocate_events(void)
   for (i = 0; i < __NUM_OC_EVENT_TYPES__; i++) {
     oc_events[i] = oc_process_alloc_event();
   }
+#ifdef OC_PROCESS_PRIORITIES
+  oc_process_set_event_class(oc_events[INBOUND_NETWORK_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_set_event_class(oc_events[UDP_TO_TLS_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_set_event_class(oc_events[INBOUND_RI_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_set_event_class(oc_events[TLS_READ_DECRYPTED_DATA],
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_set_event_class(oc_events[OUTBOUND_NETWORK_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_TX);
+  oc_process_set_event_class(oc_events[INIT_TLS_CONN_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_TX);
+  oc_process_set_event_class(oc_events[RI_TO_TLS_EVENT],
+                             OC_PROCESS_CLASS_NETWORK_TX);
+  oc_process_set_event_class(oc_events[TLS_WRITE_APPLICATION_DATA],
+                             OC_PROCESS_CLASS_NETWORK_TX);
+#endif /* OC_PROCESS_PRIORITIES */
 }
 
 static void
@@ -256,6 +281,10 @@ static void stop_processes(void) {
 oc_resource_t *
 oc_ri_get_app_resource_by_uri(const char *uri, size_t uri_len, size_t device)
 {
+#ifdef OC_URI_INDEX
+  return oc_uri_index_lookup(uri, uri_len, device,
+                             OC_URI_INDEX_APP | OC_URI_INDEX_COLLECTION, NULL);
+#else  /* OC_URI_INDEX */
   int skip = 0;
   if (uri[0] != '/')
     skip = 1;
@@ -275,6 +304,7 @@ oc_ri_get_app_resource_by_uri(const char *uri, size_t uri_len, size_t device)
 #endif /* OC_COLLECTIONS */
 
   return res;
+#endif /* !OC_URI_INDEX */
 }
 
 static void
@@ -288,6 +318,38 @@ oc_ri_delete_all_app_resources(void)
 }
 #endif /* OC_SERVER */
 
+#ifdef OC_REQUEST_ARENA
+#ifdef OC_WORKER_THREADS
+static OC_THREAD_LOCAL oc_arena_t request_arena;
+#else  /* OC_WORKER_THREADS */
+static oc_arena_t request_arena;
+#endif /* !OC_WORKER_THREADS */
+
+oc_arena_t *
+oc_ri_request_arena(void)
+{
+  return &request_arena;
+}
+
+void
+oc_ri_release_request_arena(void)
+{
+#ifdef OC_BLOCK_WISE
+  oc_blockwise_detach_arena_buffers();
+#endif /* OC_BLOCK_WISE */
+  oc_arena_reset(&request_arena);
+}
+
+void
+oc_ri_free_request_arena(void)
+{
+#ifdef OC_BLOCK_WISE
+  oc_blockwise_detach_arena_buffers();
+#endif /* OC_BLOCK_WISE */
+  oc_arena_free(&request_arena);
+}
+#endif /* OC_REQUEST_ARENA */
+
 void
 oc_ri_init(void)
 {
@@ -327,6 +389,15 @@ oc_ri_delete_resource(oc_resource_t *resource)
     coap_remove_observer_by_resource(resource);
   }
   oc_list_remove(app_resources, resource);
+#ifdef OC_URI_INDEX
+  oc_uri_index_remove(resource);
+#endif /* OC_URI_INDEX */
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
+#if defined(OC_SECURITY) && defined(OC_ACL_CACHE)
+  oc_sec_acl_cache_invalidate();
+#endif /* OC_SECURITY && OC_ACL_CACHE */
   oc_ri_free_resource_properties(resource);
   oc_memb_free(&app_resources_s, resource);
   return true;
@@ -348,8 +419,17 @@ oc_ri_add_resource(oc_resource_t *resource)
       resource->observe_period_seconds == 0)
     valid = false;
 
+#ifdef OC_URI_INDEX
+  if (valid) {
+    valid = oc_uri_index_add(resource, OC_URI_INDEX_APP);
+  }
+#endif /* OC_URI_INDEX */
+
   if (valid) {
     oc_list_add(app_resources, resource);
+#ifdef OC_DISCOVERY_CACHE
+    oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
   }
 
   return valid;
@@ -603,6 +683,31 @@ does_interface_support_method(oc_interface_mask_t iface_mask, oc_method_t method
   return supported;
 }
 
+static void
+invoke_request_handler(oc_resource_t *resource, oc_request_handler_t *handler,
+                       oc_request_t *request, oc_interface_mask_t iface_mask)
+{
+#ifdef OC_WORKER_THREADS
+  /* Concurrent handlers only touch the request, and the encoder state and
+   * request arena are per-thread, so the stack can be released while they
+   * run. The block-wise buffers that hold the payload and response are kept
+   * alive by the caller. The event loop may switch the current process in
+   * the meantime.
+   */
+  if (resource->properties & OC_CONCURRENT) {
+    struct oc_process *current = OC_PROCESS_CURRENT();
+    oc_stack_mutex_unlock();
+    handler->cb(request, iface_mask, handler->user_data);
+    oc_stack_mutex_lock();
+    oc_process_current = current;
+    return;
+  }
+#else  /* OC_WORKER_THREADS */
+  (void)resource;
+#endif /* !OC_WORKER_THREADS */
+  handler->cb(request, iface_mask, handler->user_data);
+}
+
 #ifdef OC_BLOCK_WISE
 bool
 oc_ri_invoke_coap_entity_handler(void *request, void *response,
@@ -668,6 +773,8 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
 
   request_obj.response = &response_obj;
   request_obj.request_payload = NULL;
+  request_obj._payload = NULL;
+  request_obj._payload_len = 0;
   request_obj.query = NULL;
   request_obj.query_len = 0;
   request_obj.resource = NULL;
@@ -715,42 +822,34 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
   memset(rep_objects_pool, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
   struct oc_memb rep_objects = { sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                                  rep_objects_alloc, (void *)rep_objects_pool,
-                                 0 };
+                                 0, 0, 0, 0, 0 };
 #else  /* !OC_DYNAMIC_ALLOCATION */
-  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0 };
+  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
 #endif /* OC_DYNAMIC_ALLOCATION */
   oc_rep_set_pool(&rep_objects);
+#if defined(OC_REP_ARENA) && !defined(OC_REQUEST_ARENA)
+  oc_arena_t rep_arena = { NULL };
+#endif /* OC_REP_ARENA && !OC_REQUEST_ARENA */
 
-  if (payload_len > 0) {
-    /* Attempt to parse request payload using tinyCBOR via oc_rep helper
-     * functions. The result of this parse is a tree of oc_rep_t structures
-     * which will reflect the schema of the payload.
-     * Any failures while parsing the payload is viewed as an erroneous
-     * request and results in a 4.00 response being sent.
-     */
-    int parse_error =
-      oc_parse_rep(payload, payload_len, &request_obj.request_payload);
-    if (parse_error != 0) {
-      OC_WRN("ocri: error parsing request payload; tinyCBOR error code:  %d",
-             parse_error);
-      if (parse_error == CborErrorUnexpectedEOF)
-        entity_too_large = true;
-      bad_request = true;
-    }
-
-#if defined(OC_BLOCK_WISE)
-    /* Free request_state cause it isn't used any more
-     */
-    oc_blockwise_free_request_buffer(*request_state);
-    *request_state = NULL;
-#endif
-  }
-
-  oc_resource_t *resource, *cur_resource = NULL;
+  oc_resource_t *cur_resource = NULL;
 
   /* If there were no errors thus far, attempt to locate the specific
    * resource object that will handle the request using the request uri.
    */
+#ifdef OC_URI_INDEX
+  if (!bad_request) {
+    oc_uri_index_kind_t kind;
+    request_obj.resource = cur_resource = oc_uri_index_lookup(
+      uri_path, uri_path_len, endpoint->device, OC_URI_INDEX_ALL, &kind);
+#if defined(OC_COLLECTIONS) && defined(OC_SERVER)
+    if (cur_resource && kind == OC_URI_INDEX_COLLECTION) {
+      resource_is_collection = true;
+    }
+#endif /* OC_COLLECTIONS && OC_SERVER */
+  }
+#else  /* OC_URI_INDEX */
+  oc_resource_t *resource;
+
   /* Check against list of declared core resources.
    */
   if (!bad_request) {
@@ -780,8 +879,55 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
 #endif /* OC_COLLECTIONS */
   }
 #endif /* OC_SERVER */
+#endif /* !OC_URI_INDEX */
+
+  if (payload_len > 0) {
+    if (cur_resource && (cur_resource->properties & OC_LAZY_PAYLOAD)
+#if defined(OC_COLLECTIONS) && defined(OC_SERVER)
+        && !resource_is_collection
+#endif /* OC_COLLECTIONS && OC_SERVER */
+        ) {
+      /* The resource's handlers read the payload in place through
+       * oc_get_request_payload(), so it is not parsed here.
+       */
+      request_obj._payload = payload;
+      request_obj._payload_len = (size_t)payload_len;
+    } else {
+      /* Attempt to parse request payload using tinyCBOR via oc_rep helper
+       * functions. The result of this parse is a tree of oc_rep_t structures
+       * which will reflect the schema of the payload.
+       * Any failures while parsing the payload is viewed as an erroneous
+       * request and results in a 4.00 response being sent.
+       */
+#if defined(OC_REQUEST_ARENA)
+      int parse_error =
+        oc_parse_rep_arena(oc_ri_request_arena(), payload, payload_len,
+                           &request_obj.request_payload);
+#elif defined(OC_REP_ARENA)
+      int parse_error = oc_parse_rep_arena(&rep_arena, payload, payload_len,
+                                           &request_obj.request_payload);
+#else  /* OC_REP_ARENA */
+      int parse_error =
+        oc_parse_rep(payload, payload_len, &request_obj.request_payload);
+#endif /* !OC_REP_ARENA */
+      if (parse_error != 0) {
+        OC_WRN("ocri: error parsing request payload; tinyCBOR error code:  %d",
+               parse_error);
+        if (parse_error == CborErrorUnexpectedEOF)
+          entity_too_large = true;
+        bad_request = true;
+      }
 
-  if (cur_resource) {
+#if defined(OC_BLOCK_WISE)
+      /* Free request_state cause it isn't used any more
+       */
+      oc_blockwise_free_request_buffer(*request_state);
+      *request_state = NULL;
+#endif
+    }
+  }
+
+  if (cur_resource && !bad_request) {
     /* If there was no interface selection, pick the "default interface". */
     if (iface_mask == 0)
       iface_mask = cur_resource->default_interface;
@@ -806,16 +952,21 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
   if (cur_resource && !bad_request) {
     if (!(*response_state)) {
       OC_DBG("creating new block-wise response state");
+#ifdef OC_REQUEST_ARENA
+      *response_state = oc_blockwise_alloc_response_buffer_arena(
+        uri_path, uri_path_len, uri_query, uri_query_len, endpoint, method,
+        OC_BLOCKWISE_SERVER);
+#else  /* OC_REQUEST_ARENA */
       *response_state = oc_blockwise_alloc_response_buffer(
         uri_path, uri_path_len, endpoint, method, OC_BLOCKWISE_SERVER);
+      if (*response_state && uri_query_len > 0) {
+        oc_new_string(&(*response_state)->uri_query, uri_query, uri_query_len);
+      }
+#endif /* !OC_REQUEST_ARENA */
       if (!(*response_state)) {
         OC_ERR("failure to alloc response state");
         bad_request = true;
       } else {
-        if (uri_query_len > 0) {
-          oc_new_string(&(*response_state)->uri_query, uri_query,
-                        uri_query_len);
-        }
         response_buffer.buffer = (*response_state)->buffer;
         response_buffer.buffer_size = (uint16_t)OC_MAX_APP_DATA_SIZE;
       }
@@ -846,6 +997,21 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
     } else
 #endif /* OC_SECURITY */
     {
+#if defined(OC_WORKER_THREADS) && defined(OC_BLOCK_WISE)
+      /* Concurrent handlers write the response into, and may read the
+       * payload from, block-wise buffers that the event loop could
+       * otherwise scrub or time out while the stack is unlocked.
+       */
+      bool hold_buffers = (cur_resource->properties & OC_CONCURRENT) != 0;
+      if (hold_buffers) {
+        if (*request_state) {
+          oc_blockwise_hold_request_buffer(*request_state);
+        }
+        if (*response_state) {
+          oc_blockwise_hold_response_buffer(*response_state);
+        }
+      }
+#endif /* OC_WORKER_THREADS && OC_BLOCK_WISE */
 /* If cur_resource is a collection resource, invoke the framework's
  * internal handler for collections.
  */
@@ -859,29 +1025,53 @@ oc_ri_invoke_coap_entity_handler(void *request, void *response, uint8_t *buffer,
          * implemented that method, then return a 4.05 response.
          */
         if (method == OC_GET && cur_resource->get_handler.cb) {
-        cur_resource->get_handler.cb(&request_obj, iface_mask,
-                                     cur_resource->get_handler.user_data);
+        invoke_request_handler(cur_resource, &cur_resource->get_handler,
+                               &request_obj, iface_mask);
       } else if (method == OC_POST && cur_resource->post_handler.cb) {
-        cur_resource->post_handler.cb(&request_obj, iface_mask,
-                                      cur_resource->post_handler.user_data);
+        invoke_request_handler(cur_resource, &cur_resource->post_handler,
+                               &request_obj, iface_mask);
       } else if (method == OC_PUT && cur_resource->put_handler.cb) {
-        cur_resource->put_handler.cb(&request_obj, iface_mask,
-                                     cur_resource->put_handler.user_data);
+        invoke_request_handler(cur_resource, &cur_resource->put_handler,
+                               &request_obj, iface_mask);
       } else if (method == OC_DELETE && cur_resource->delete_handler.cb) {
-        cur_resource->delete_handler.cb(&request_obj, iface_mask,
-                                        cur_resource->delete_handler.user_data);
+        invoke_request_handler(cur_resource, &cur_resource->delete_handler,
+                               &request_obj, iface_mask);
       } else {
         method_impl = false;
       }
+#if defined(OC_WORKER_THREADS) && defined(OC_BLOCK_WISE)
+      if (hold_buffers) {
+        if (*request_state) {
+          oc_blockwise_release_request_buffer(*request_state);
+        }
+        if (*response_state) {
+          oc_blockwise_release_response_buffer(*response_state);
+        }
+      }
+#endif /* OC_WORKER_THREADS && OC_BLOCK_WISE */
     }
   }
 
+#ifndef OC_REQUEST_ARENA
   if (payload_len) {
     /* To the extent that the request payload was parsed, free the
      * payload structure (and return its memory to the pool).
      */
+#ifdef OC_REP_ARENA
+    oc_arena_free(&rep_arena);
+#else  /* OC_REP_ARENA */
     oc_free_rep(request_obj.request_payload);
+#endif /* !OC_REP_ARENA */
   }
+#endif /* !OC_REQUEST_ARENA */
+
+#ifdef OC_BLOCK_WISE
+  if (request_obj._payload) {
+    /* The handler was reading the reassembled payload in place. */
+    oc_blockwise_free_request_buffer(*request_state);
+    *request_state = NULL;
+  }
+#endif /* OC_BLOCK_WISE */
 
   if (forbidden) {
     OC_WRN("ocri: Forbidden request");
@@ -1100,6 +1290,9 @@ free_client_cb(oc_client_cb_t *cb)
   oc_blockwise_scrub_buffers_for_client_cb(cb);
 #endif /* OC_BLOCK_WISE */
   oc_list_remove(client_cbs, cb);
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_index_remove(cb);
+#endif /* OC_CLIENT_CB_INDEX */
   oc_free_string(&cb->uri);
   if (oc_string_len(cb->query)) {
     oc_free_string(&cb->query);
@@ -1117,12 +1310,7 @@ oc_ri_remove_client_cb(void *data)
 bool
 oc_ri_remove_client_cb_by_mid(uint16_t mid)
 {
-  oc_client_cb_t *cb = (oc_client_cb_t *)oc_list_head(client_cbs);
-  while (cb != NULL) {
-    if (cb->mid == mid)
-      break;
-    cb = cb->next;
-  }
+  oc_client_cb_t *cb = oc_ri_find_client_cb_by_mid(mid);
   if (cb) {
     oc_ri_remove_timed_event_callback(cb, &oc_ri_remove_client_cb);
     free_client_cb(cb);
@@ -1134,6 +1322,9 @@ oc_ri_remove_client_cb_by_mid(uint16_t mid)
 oc_client_cb_t *
 oc_ri_find_client_cb_by_mid(uint16_t mid)
 {
+#ifdef OC_CLIENT_CB_INDEX
+  return oc_client_cb_index_find_by_mid(mid);
+#else  /* OC_CLIENT_CB_INDEX */
   oc_client_cb_t *cb = oc_list_head(client_cbs);
   while (cb) {
     if (cb->mid == mid)
@@ -1141,11 +1332,15 @@ oc_ri_find_client_cb_by_mid(uint16_t mid)
     cb = cb->next;
   }
   return cb;
+#endif /* !OC_CLIENT_CB_INDEX */
 }
 
 oc_client_cb_t *
 oc_ri_find_client_cb_by_token(uint8_t *token, uint8_t token_len)
 {
+#ifdef OC_CLIENT_CB_INDEX
+  return oc_client_cb_index_find_by_token(token, token_len);
+#else  /* OC_CLIENT_CB_INDEX */
   oc_client_cb_t *cb = oc_list_head(client_cbs);
   while (cb != NULL) {
     if (cb->token_len == token_len && memcmp(cb->token, token, token_len) == 0)
@@ -1153,6 +1348,33 @@ oc_ri_find_client_cb_by_token(uint8_t *token, uint8_t token_len)
     cb = cb->next;
   }
   return cb;
+#endif /* !OC_CLIENT_CB_INDEX */
+}
+
+void
+oc_ri_set_client_cb_mid(oc_client_cb_t *cb, uint16_t mid)
+{
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_index_remove(cb);
+#endif /* OC_CLIENT_CB_INDEX */
+  cb->mid = mid;
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_index_add(cb);
+#endif /* OC_CLIENT_CB_INDEX */
+}
+
+void
+oc_ri_set_client_cb_token(oc_client_cb_t *cb, const uint8_t *token,
+                          uint8_t token_len)
+{
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_index_remove(cb);
+#endif /* OC_CLIENT_CB_INDEX */
+  memcpy(cb->token, token, token_len);
+  cb->token_len = token_len;
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_index_add(cb);
+#endif /* OC_CLIENT_CB_INDEX */
 }
 
 #ifdef OC_BLOCK_WISE
@@ -1220,9 +1442,9 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
   memset(rep_objects_pool, 0, OC_MAX_NUM_REP_OBJECTS * sizeof(oc_rep_t));
   struct oc_memb rep_objects = { sizeof(oc_rep_t), OC_MAX_NUM_REP_OBJECTS,
                                  rep_objects_alloc, (void *)rep_objects_pool,
-                                 0 };
+                                 0, 0, 0, 0, 0 };
 #else  /* !OC_DYNAMIC_ALLOCATION */
-  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0 };
+  struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
 #endif /* OC_DYNAMIC_ALLOCATION */
   oc_rep_set_pool(&rep_objects);
 
@@ -1240,7 +1462,16 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
         return true;
       }
     } else {
+#if defined(OC_REQUEST_ARENA)
+      int err = oc_parse_rep_arena(oc_ri_request_arena(), payload, payload_len,
+                                   &client_response.payload);
+#elif defined(OC_REP_ARENA)
+      oc_arena_t rep_arena = { NULL };
+      int err = oc_parse_rep_arena(&rep_arena, payload, payload_len,
+                                   &client_response.payload);
+#else  /* OC_REP_ARENA */
       int err = oc_parse_rep(payload, payload_len, &client_response.payload);
+#endif /* !OC_REP_ARENA */
       if (err == 0) {
         oc_response_handler_t handler =
           (oc_response_handler_t)cb->handler.response;
@@ -1248,7 +1479,11 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
       } else {
         OC_WRN("Error parsing payload!");
       }
+#if defined(OC_REP_ARENA) && !defined(OC_REQUEST_ARENA)
+      oc_arena_free(&rep_arena);
+#elif !defined(OC_REP_ARENA)
       oc_free_rep(client_response.payload);
+#endif /* !OC_REP_ARENA */
     }
   } else {
     if (pkt->type == COAP_TYPE_ACK && pkt->code == 0) {
@@ -1285,8 +1520,13 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
 
     // Drop old observe callback and keep the last one.
     if (cb->observe_seq == 0) {
-      oc_client_cb_t *dup_cb = (oc_client_cb_t *)oc_list_head(client_cbs);
       size_t uri_len = oc_string_len(cb->uri);
+#ifdef OC_CLIENT_CB_INDEX
+      oc_client_cb_t *dup_cb = oc_client_cb_index_next_by_uri(
+        oc_string(cb->uri), uri_len, endpoint, NULL);
+#else  /* OC_CLIENT_CB_INDEX */
+      oc_client_cb_t *dup_cb = (oc_client_cb_t *)oc_list_head(client_cbs);
+#endif /* !OC_CLIENT_CB_INDEX */
 
       while (dup_cb != NULL) {
         if (dup_cb != cb && dup_cb->observe_seq != -1 &&
@@ -1299,7 +1539,12 @@ oc_ri_invoke_client_cb(void *response, oc_client_cb_t *cb,
           free_client_cb(dup_cb);
           break;
         }
+#ifdef OC_CLIENT_CB_INDEX
+        dup_cb = oc_client_cb_index_next_by_uri(oc_string(cb->uri), uri_len,
+                                                endpoint, dup_cb);
+#else  /* OC_CLIENT_CB_INDEX */
         dup_cb = dup_cb->next;
+#endif /* !OC_CLIENT_CB_INDEX */
       }
     }
   }
@@ -1311,6 +1556,17 @@ oc_client_cb_t *
 oc_ri_get_client_cb(const char *uri, oc_endpoint_t *endpoint,
                     oc_method_t method)
 {
+#ifdef OC_CLIENT_CB_INDEX
+  oc_client_cb_t *cb =
+    oc_client_cb_index_next_by_uri(uri, strlen(uri), endpoint, NULL);
+
+  while (cb != NULL) {
+    if (cb->endpoint == endpoint && cb->method == method)
+      return cb;
+
+    cb = oc_client_cb_index_next_by_uri(uri, strlen(uri), endpoint, cb);
+  }
+#else  /* OC_CLIENT_CB_INDEX */
   oc_client_cb_t *cb = (oc_client_cb_t *)oc_list_head(client_cbs);
 
   while (cb != NULL) {
@@ -1321,6 +1577,7 @@ oc_ri_get_client_cb(const char *uri, oc_endpoint_t *endpoint,
 
     cb = cb->next;
   }
+#endif /* !OC_CLIENT_CB_INDEX */
 
   return cb;
 }
@@ -1368,6 +1625,17 @@ oc_ri_alloc_client_cb(const char *uri, oc_endpoint_t *endpoint,
   if (query && strlen(query) > 0) {
     oc_new_string(&cb->query, query, strlen(query));
   }
+#ifdef OC_CLIENT_CB_INDEX
+  if (!oc_client_cb_index_add(cb)) {
+    OC_WRN("insufficient memory to index client callback");
+    oc_free_string(&cb->uri);
+    if (oc_string_len(cb->query)) {
+      oc_free_string(&cb->query);
+    }
+    oc_memb_free(&client_cbs_s, cb);
+    return NULL;
+  }
+#endif /* OC_CLIENT_CB_INDEX */
   oc_list_add(client_cbs, cb);
   return cb;
 }
@@ -1380,6 +1648,7 @@ oc_ri_shutdown(void)
   coap_free_all_observers();
 #endif /* OC_SERVER */
   coap_free_all_transactions();
+  coap_dedup_free_all();
   free_all_event_timers();
 #ifdef OC_CLIENT
   free_all_client_cbs();
@@ -1387,6 +1656,9 @@ oc_ri_shutdown(void)
 #ifdef OC_BLOCK_WISE
   oc_blockwise_scrub_buffers();
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_REQUEST_ARENA
+  oc_ri_free_request_arena();
+#endif /* OC_REQUEST_ARENA */
 
   while (oc_main_poll() != 0)
     ;
@@ -1407,6 +1679,9 @@ oc_ri_shutdown(void)
 
   oc_ri_delete_all_app_resources();
 #endif /* OC_SERVER */
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 
   oc_random_destroy();
 }
@@ -21,6 +21,7 @@
 
 #if defined(OC_COLLECTIONS) && defined(OC_SERVER)
 #include "oc_collection.h"
+#include "oc_discovery.h"
 #endif /* OC_COLLECTIONS && OC_SERVER */
 
 #ifdef OC_DYNAMIC_ALLOCATION
@@ -29,7 +30,11 @@
 
 #include "oc_core_res.h"
 
+#ifdef OC_WORKER_THREADS
+static OC_THREAD_LOCAL size_t query_iterator;
+#else  /* OC_WORKER_THREADS */
 static size_t query_iterator;
+#endif /* !OC_WORKER_THREADS */
 
 int
 oc_add_device(const char *uri, const char *rt, const char *name,
@@ -59,6 +64,14 @@ oc_get_query_value(oc_request_t *request, const char *key, char **value)
   return oc_ri_get_query_value(request->query, request->query_len, key, value);
 }
 
+bool
+oc_get_request_payload(oc_request_t *request, oc_rep_cursor_t *cursor)
+{
+  if (!request || !request->_payload)
+    return false;
+  return oc_rep_cursor_init(cursor, request->_payload, request->_payload_len);
+}
+
 static int
 response_length(void)
 {
@@ -223,6 +236,9 @@ void
 oc_resource_bind_resource_interface(oc_resource_t *resource, oc_interface_mask_t iface_mask)
 {
   resource->interfaces |= iface_mask;
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 
 void
@@ -236,6 +252,9 @@ void
 oc_resource_bind_resource_type(oc_resource_t *resource, const char *type)
 {
   oc_string_array_add_item(resource->types, (char *)type);
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 
 #ifdef OC_SECURITY
@@ -243,6 +262,9 @@ void
 oc_resource_make_public(oc_resource_t *resource)
 {
   resource->properties &= ~OC_SECURE;
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 #endif /* OC_SECURITY */
 
@@ -253,6 +275,9 @@ oc_resource_set_discoverable(oc_resource_t *resource, bool state)
     resource->properties |= OC_DISCOVERABLE;
   else
     resource->properties &= ~OC_DISCOVERABLE;
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 
 void
@@ -262,6 +287,9 @@ oc_resource_set_observable(oc_resource_t *resource, bool state)
     resource->properties |= OC_OBSERVABLE;
   else
     resource->properties &= ~(OC_OBSERVABLE | OC_PERIODIC);
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
 }
 
 void
@@ -269,6 +297,29 @@ oc_resource_set_periodic_observable(oc_resource_t *resource, uint16_t seconds)
 {
   resource->properties |= OC_OBSERVABLE | OC_PERIODIC;
   resource->observe_period_seconds = seconds;
+#ifdef OC_DISCOVERY_CACHE
+  oc_discovery_cache_invalidate();
+#endif /* OC_DISCOVERY_CACHE */
+}
+
+#ifdef OC_WORKER_THREADS
+void
+oc_resource_set_concurrent(oc_resource_t *resource, bool state)
+{
+  if (state)
+    resource->properties |= OC_CONCURRENT;
+  else
+    resource->properties &= ~OC_CONCURRENT;
+}
+#endif /* OC_WORKER_THREADS */
+
+void
+oc_resource_set_lazy_payload(oc_resource_t *resource, bool state)
+{
+  if (state)
+    resource->properties |= OC_LAZY_PAYLOAD;
+  else
+    resource->properties &= ~OC_LAZY_PAYLOAD;
 }
 
 void
@@ -34,19 +34,30 @@
 OC_LIST(session_start_events);
 OC_LIST(session_end_events);
 
+/* Runs on lists detached under the lock, as handling a session frees
+ * messages and endpoints, which takes the lock again.
+ */
+static void
+handle_session_events(oc_endpoint_t *session_event, oc_session_state_t state)
+{
+  while (session_event != NULL) {
+    oc_endpoint_t *next = session_event->next;
+    oc_handle_session(session_event, state);
+    oc_free_endpoint(session_event);
+    session_event = next;
+  }
+}
+
 static oc_event_callback_retval_t
 free_session_state_delayed(void *data)
 {
   (void)data;
   oc_network_event_handler_mutex_lock();
   oc_endpoint_t *session_event =
-    (oc_endpoint_t *)oc_list_pop(session_end_events);
-  while (session_event != NULL) {
-    oc_handle_session(session_event, OC_SESSION_DISCONNECTED);
-    oc_free_endpoint(session_event);
-    session_event = oc_list_pop(session_end_events);
-  }
+    (oc_endpoint_t *)oc_list_head(session_end_events);
+  oc_list_init(session_end_events);
   oc_network_event_handler_mutex_unlock();
+  handle_session_events(session_event, OC_SESSION_DISCONNECTED);
   return OC_EVENT_DONE;
 }
 
@@ -56,20 +67,18 @@ oc_process_session_event(void)
   oc_network_event_handler_mutex_lock();
 
   oc_endpoint_t *session_event =
-    (oc_endpoint_t *)oc_list_pop(session_start_events);
+    (oc_endpoint_t *)oc_list_head(session_start_events);
+  oc_list_init(session_start_events);
+  bool sessions_ended = oc_list_length(session_end_events) > 0;
 
-  while (session_event != NULL) {
-    oc_handle_session(session_event, OC_SESSION_CONNECTED);
-    oc_free_endpoint(session_event);
-    session_event = oc_list_pop(session_start_events);
-  }
+  oc_network_event_handler_mutex_unlock();
+
+  handle_session_events(session_event, OC_SESSION_CONNECTED);
 
-  if (oc_list_length(session_end_events) > 0) {
+  if (sessions_ended) {
     oc_set_delayed_callback(NULL, &free_session_state_delayed,
                             SESSION_STATE_FREE_DELAY_SECS);
   }
-
-  oc_network_event_handler_mutex_unlock();
 }
 
 OC_PROCESS(oc_session_events, "");
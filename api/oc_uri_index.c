@@ -0,0 +1,294 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "oc_uri_index.h"
+
+#ifdef OC_URI_INDEX
+#include "oc_core_res.h"
+#include "port/oc_log.h"
+#include "util/oc_memb.h"
+#include <string.h>
+#ifdef OC_DYNAMIC_ALLOCATION
+#include <stdlib.h>
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+typedef struct oc_uri_index_entry_s
+{
+  struct oc_uri_index_entry_s *next;
+  /* NULL for core resources, which are resolved through their type. */
+  oc_resource_t *resource;
+  size_t device;
+  uint32_t hash;
+  int core_resource;
+  oc_uri_index_kind_t kind;
+} oc_uri_index_entry_t;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#define OC_URI_INDEX_MIN_BUCKETS (64)
+static oc_uri_index_entry_t **buckets;
+static size_t num_buckets;
+#else /* OC_DYNAMIC_ALLOCATION */
+#if (OC_URI_INDEX_BUCKETS & (OC_URI_INDEX_BUCKETS - 1)) != 0
+#error "OC_URI_INDEX_BUCKETS must be a power of two"
+#endif /* OC_URI_INDEX_BUCKETS & (OC_URI_INDEX_BUCKETS - 1) */
+#define num_buckets (OC_URI_INDEX_BUCKETS)
+static oc_uri_index_entry_t *buckets[OC_URI_INDEX_BUCKETS];
+#endif /* !OC_DYNAMIC_ALLOCATION */
+static size_t num_entries;
+
+#ifdef OC_SERVER
+#ifdef OC_COLLECTIONS
+#define OC_URI_INDEX_APP_ENTRIES (OC_MAX_APP_RESOURCES + OC_MAX_NUM_COLLECTIONS)
+#else /* OC_COLLECTIONS */
+#define OC_URI_INDEX_APP_ENTRIES (OC_MAX_APP_RESOURCES)
+#endif /* !OC_COLLECTIONS */
+#else  /* OC_SERVER */
+#define OC_URI_INDEX_APP_ENTRIES (0)
+#endif /* !OC_SERVER */
+
+OC_MEMB(uri_index_entries_s, oc_uri_index_entry_t,
+        OC_URI_INDEX_APP_ENTRIES + OCF_D * OC_MAX_NUM_DEVICES);
+
+static void
+skip_leading_slashes(const char **uri, size_t *uri_len)
+{
+  while (*uri_len > 0 && (*uri)[0] == '/') {
+    (*uri)++;
+    (*uri_len)--;
+  }
+}
+
+static uint32_t
+uri_hash(const char *uri, size_t uri_len, size_t device)
+{
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < uri_len; i++) {
+    hash = (hash ^ (uint8_t)uri[i]) * 16777619u;
+  }
+  for (i = 0; i < sizeof(device); i++) {
+    hash = (hash ^ (uint8_t)(device >> (8 * i))) * 16777619u;
+  }
+  return hash;
+}
+
+static uint32_t
+resource_hash(oc_resource_t *resource)
+{
+  const char *uri = oc_string(resource->uri);
+  size_t uri_len = oc_string_len(resource->uri);
+  skip_leading_slashes(&uri, &uri_len);
+  return uri_hash(uri, uri_len, resource->device);
+}
+
+static oc_resource_t *
+entry_resource(oc_uri_index_entry_t *entry)
+{
+  if (entry->resource) {
+    return entry->resource;
+  }
+  return oc_core_get_resource_by_index(entry->core_resource, entry->device);
+}
+
+static void
+append_entry(oc_uri_index_entry_t **bucket, oc_uri_index_entry_t *entry)
+{
+  /* Entries keep their insertion order within a bucket so that duplicate
+   * URIs resolve the same way as the list walks.
+   */
+  entry->next = NULL;
+  while (*bucket) {
+    bucket = &(*bucket)->next;
+  }
+  *bucket = entry;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static void
+resize_buckets(size_t new_num_buckets)
+{
+  oc_uri_index_entry_t **new_buckets = (oc_uri_index_entry_t **)calloc(
+    new_num_buckets, sizeof(oc_uri_index_entry_t *));
+  if (!new_buckets) {
+    OC_WRN("insufficient memory to grow the URI index");
+    return;
+  }
+  size_t i;
+  for (i = 0; i < num_buckets; i++) {
+    oc_uri_index_entry_t *entry = buckets[i], *next;
+    while (entry) {
+      next = entry->next;
+      append_entry(&new_buckets[entry->hash & (new_num_buckets - 1)], entry);
+      entry = next;
+    }
+  }
+  free(buckets);
+  buckets = new_buckets;
+  num_buckets = new_num_buckets;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static bool
+insert_entry(oc_resource_t *resource, int core_resource, size_t device,
+             uint32_t hash, oc_uri_index_kind_t kind)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (num_entries >= num_buckets) {
+    resize_buckets(num_buckets ? num_buckets * 2 : OC_URI_INDEX_MIN_BUCKETS);
+    if (!buckets) {
+      return false;
+    }
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+  oc_uri_index_entry_t *entry =
+    (oc_uri_index_entry_t *)oc_memb_alloc(&uri_index_entries_s);
+  if (!entry) {
+    OC_ERR("insufficient memory to index resource");
+    return false;
+  }
+  entry->resource = resource;
+  entry->core_resource = core_resource;
+  entry->device = device;
+  entry->hash = hash;
+  entry->kind = kind;
+  append_entry(&buckets[hash & (num_buckets - 1)], entry);
+  num_entries++;
+  return true;
+}
+
+static void
+remove_entry(oc_resource_t *resource, int core_resource, size_t device,
+             uint32_t hash)
+{
+  if (num_entries == 0) {
+    return;
+  }
+  oc_uri_index_entry_t **entry = &buckets[hash & (num_buckets - 1)];
+  while (*entry) {
+    if ((*entry)->resource == resource && (*entry)->device == device &&
+        (resource || (*entry)->core_resource == core_resource)) {
+      oc_uri_index_entry_t *found = *entry;
+      *entry = found->next;
+      oc_memb_free(&uri_index_entries_s, found);
+      num_entries--;
+      break;
+    }
+    entry = &(*entry)->next;
+  }
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (num_entries == 0) {
+    free(buckets);
+    buckets = NULL;
+    num_buckets = 0;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+bool
+oc_uri_index_add(oc_resource_t *resource, oc_uri_index_kind_t kind)
+{
+  uint32_t hash = resource_hash(resource);
+  remove_entry(resource, 0, resource->device, hash);
+  return insert_entry(resource, 0, resource->device, hash, kind);
+}
+
+bool
+oc_uri_index_add_core(int core_resource, size_t device)
+{
+  /* The platform resource is shared by all devices and is matched directly
+   * in oc_uri_index_lookup().
+   */
+  if (core_resource == OCF_P) {
+    return true;
+  }
+  uint32_t hash =
+    resource_hash(oc_core_get_resource_by_index(core_resource, device));
+  remove_entry(NULL, core_resource, device, hash);
+  return insert_entry(NULL, core_resource, device, hash, OC_URI_INDEX_CORE);
+}
+
+void
+oc_uri_index_remove(oc_resource_t *resource)
+{
+  remove_entry(resource, 0, resource->device, resource_hash(resource));
+}
+
+void
+oc_uri_index_remove_core(int core_resource, size_t device)
+{
+  if (core_resource == OCF_P) {
+    return;
+  }
+  remove_entry(NULL, core_resource, device,
+               resource_hash(oc_core_get_resource_by_index(core_resource,
+                                                           device)));
+}
+
+static bool
+uri_matches(oc_resource_t *resource, const char *uri, size_t uri_len)
+{
+  return (oc_string_len(resource->uri) == (uri_len + 1) &&
+          memcmp(oc_string(resource->uri) + 1, uri, uri_len) == 0);
+}
+
+oc_resource_t *
+oc_uri_index_lookup(const char *uri, size_t uri_len, size_t device, int kinds,
+                    oc_uri_index_kind_t *kind)
+{
+  skip_leading_slashes(&uri, &uri_len);
+
+  if (kinds & OC_URI_INDEX_CORE) {
+    oc_resource_t *platform = oc_core_get_resource_by_index(OCF_P, device);
+    if (uri_matches(platform, uri, uri_len)) {
+      if (kind) {
+        *kind = OC_URI_INDEX_CORE;
+      }
+      return platform;
+    }
+  }
+
+  if (num_entries == 0) {
+    return NULL;
+  }
+
+  uint32_t hash = uri_hash(uri, uri_len, device);
+  oc_uri_index_entry_t *entry = buckets[hash & (num_buckets - 1)], *best = NULL;
+  while (entry) {
+    if (entry->hash == hash && entry->device == device &&
+        (entry->kind & kinds) != 0 && (!best || entry->kind < best->kind) &&
+        uri_matches(entry_resource(entry), uri, uri_len)) {
+      best = entry;
+      if (best->kind == OC_URI_INDEX_CORE) {
+        break;
+      }
+    }
+    entry = entry->next;
+  }
+
+  if (!best) {
+    return NULL;
+  }
+  if (kind) {
+    *kind = best->kind;
+  }
+  return entry_resource(best);
+}
+#else  /* OC_URI_INDEX */
+typedef int dummy_declaration;
+#endif /* !OC_URI_INDEX */
@@ -0,0 +1,133 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "port/linux/oc_config.h"
+#include "oc_api.h"
+#include "oc_client_state.h"
+#include "oc_ri.h"
+
+#define NUM_ENDPOINTS (50)
+#define NUM_OBSERVATIONS (5000)
+
+extern "C" oc_event_callback_retval_t oc_ri_remove_client_cb(void *data);
+
+class TestClientCb : public testing::Test
+{
+protected:
+  virtual void SetUp() { oc_ri_init(); }
+  virtual void TearDown() { oc_ri_shutdown(); }
+};
+
+static void
+onResponse(oc_client_response_t *response)
+{
+  (void)response;
+}
+
+static oc_client_cb_t *
+allocCallback(const char *uri, oc_endpoint_t *endpoint)
+{
+  oc_client_handler_t handler;
+  handler.response = onResponse;
+  return oc_ri_alloc_client_cb(uri, endpoint, OC_GET, NULL, handler, HIGH_QOS,
+                               NULL);
+}
+
+static void
+makeEndpoint(oc_endpoint_t *endpoint, int i)
+{
+  memset(endpoint, 0, sizeof(oc_endpoint_t));
+  endpoint->flags = IPV6;
+  endpoint->addr.ipv6.address[0] = 0xfe;
+  endpoint->addr.ipv6.address[1] = 0x80;
+  endpoint->addr.ipv6.address[15] = (uint8_t)i;
+  endpoint->addr.ipv6.port = 5683;
+}
+
+TEST_F(TestClientCb, FindByTokenAndMid_P)
+{
+  oc_endpoint_t endpoint;
+  makeEndpoint(&endpoint, 1);
+  oc_client_cb_t *cb = allocCallback("/a/light", &endpoint);
+  ASSERT_NE(nullptr, cb);
+
+  EXPECT_EQ(cb, oc_ri_find_client_cb_by_token(cb->token, cb->token_len));
+  EXPECT_EQ(cb, oc_ri_find_client_cb_by_mid(cb->mid));
+  EXPECT_EQ(cb, oc_ri_get_client_cb("/a/light", &endpoint, OC_GET));
+  EXPECT_EQ(nullptr, oc_ri_get_client_cb("/a/light", &endpoint, OC_POST));
+  EXPECT_EQ(nullptr, oc_ri_get_client_cb("/a/switch", &endpoint, OC_GET));
+
+  uint16_t mid = cb->mid;
+  oc_ri_set_client_cb_mid(cb, (uint16_t)(mid + 1000));
+  EXPECT_EQ(nullptr, oc_ri_find_client_cb_by_mid(mid));
+  EXPECT_EQ(cb, oc_ri_find_client_cb_by_mid((uint16_t)(mid + 1000)));
+
+  oc_ri_remove_client_cb(cb);
+  EXPECT_EQ(nullptr, oc_ri_find_client_cb_by_mid((uint16_t)(mid + 1000)));
+}
+
+TEST_F(TestClientCb, SharedTokenFindsFirstCallback_P)
+{
+  oc_endpoint_t endpoint;
+  makeEndpoint(&endpoint, 2);
+  oc_client_cb_t *first = allocCallback("/oic/res", &endpoint);
+  oc_client_cb_t *second = allocCallback("/oic/res", &endpoint);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+
+  oc_ri_set_client_cb_mid(second, first->mid);
+  oc_ri_set_client_cb_token(second, first->token, first->token_len);
+  EXPECT_EQ(first, oc_ri_find_client_cb_by_token(first->token,
+                                                 first->token_len));
+
+  EXPECT_TRUE(oc_ri_remove_client_cb_by_mid(first->mid));
+  EXPECT_EQ(second, oc_ri_find_client_cb_by_token(second->token,
+                                                  second->token_len));
+  EXPECT_TRUE(oc_ri_remove_client_cb_by_mid(second->mid));
+  EXPECT_FALSE(oc_ri_remove_client_cb_by_mid(second->mid));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+TEST_F(TestClientCb, ManyObservationsAreFound_P)
+{
+  std::vector<oc_endpoint_t> endpoints(NUM_ENDPOINTS);
+  std::vector<oc_client_cb_t *> cbs(NUM_OBSERVATIONS);
+  char uri[32];
+  int i;
+
+  for (i = 0; i < NUM_ENDPOINTS; i++) {
+    makeEndpoint(&endpoints[i], i);
+  }
+  for (i = 0; i < NUM_OBSERVATIONS; i++) {
+    snprintf(uri, sizeof(uri), "/a/%d", i / NUM_ENDPOINTS);
+    cbs[i] = allocCallback(uri, &endpoints[i % NUM_ENDPOINTS]);
+    ASSERT_NE(nullptr, cbs[i]);
+  }
+
+  for (i = 0; i < NUM_OBSERVATIONS; i++) {
+    oc_client_cb_t *cb = cbs[i];
+    ASSERT_EQ(cb, oc_ri_find_client_cb_by_token(cb->token, cb->token_len));
+    snprintf(uri, sizeof(uri), "/a/%d", i / NUM_ENDPOINTS);
+    ASSERT_EQ(cb, oc_ri_get_client_cb(uri, &endpoints[i % NUM_ENDPOINTS],
+                                      OC_GET));
+  }
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
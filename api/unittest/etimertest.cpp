@@ -0,0 +1,147 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "port/linux/oc_config.h"
+#include "oc_api.h"
+#include "oc_ri.h"
+#include "port/oc_clock.h"
+
+#define NUM_TIMERS (10000)
+#define MAX_DELAY_MS (200)
+
+struct timed_cb_t
+{
+  oc_clock_time_t deadline;
+  oc_clock_time_t fired_at;
+  int fired;
+};
+
+class TestEtimer : public testing::Test
+{
+protected:
+  virtual void SetUp() { oc_ri_init(); }
+  virtual void TearDown() { oc_ri_shutdown(); }
+};
+
+static int num_fired;
+
+static oc_event_callback_retval_t
+onTimeout(void *data)
+{
+  timed_cb_t *cb = (timed_cb_t *)data;
+  cb->fired_at = oc_clock_time();
+  cb->fired++;
+  num_fired++;
+  return OC_EVENT_DONE;
+}
+
+static void
+addCallback(timed_cb_t *cb, oc_clock_time_t ticks)
+{
+  cb->deadline = oc_clock_time() + ticks;
+  cb->fired = 0;
+  oc_ri_add_timed_event_callback_ticks(cb, onTimeout, ticks);
+}
+
+static void
+pollUntil(int expected, oc_clock_time_t timeout)
+{
+  oc_clock_time_t end = oc_clock_time() + timeout;
+  while (num_fired < expected && oc_clock_time() < end) {
+    oc_main_poll();
+  }
+  oc_main_poll();
+}
+
+TEST_F(TestEtimer, FiresNoEarlierThanDeadline_P)
+{
+  std::vector<timed_cb_t> cbs(50);
+  num_fired = 0;
+  size_t i;
+  for (i = 0; i < cbs.size(); i++) {
+    addCallback(&cbs[i], (i % 10) * OC_CLOCK_SECOND / 100);
+  }
+  pollUntil((int)cbs.size(), OC_CLOCK_SECOND);
+
+  for (i = 0; i < cbs.size(); i++) {
+    EXPECT_EQ(1, cbs[i].fired);
+    EXPECT_GE(cbs[i].fired_at, cbs[i].deadline);
+  }
+}
+
+TEST_F(TestEtimer, RemovedCallbackDoesNotFire_N)
+{
+  timed_cb_t kept, removed;
+  num_fired = 0;
+  addCallback(&kept, OC_CLOCK_SECOND / 50);
+  addCallback(&removed, OC_CLOCK_SECOND / 50);
+  oc_ri_remove_timed_event_callback(&removed, onTimeout);
+  pollUntil(2, OC_CLOCK_SECOND / 10);
+
+  EXPECT_EQ(1, kept.fired);
+  EXPECT_EQ(0, removed.fired);
+  EXPECT_FALSE(oc_etimer_pending());
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+TEST_F(TestEtimer, TimersBenchmark)
+{
+  std::vector<timed_cb_t> cbs(NUM_TIMERS);
+  num_fired = 0;
+  int i;
+
+  auto start = std::chrono::steady_clock::now();
+  for (i = 0; i < NUM_TIMERS; i++) {
+    addCallback(&cbs[i], (oc_clock_time_t)((i * 7919) % MAX_DELAY_MS + 1) *
+                           OC_CLOCK_SECOND / 1000);
+  }
+  auto added = std::chrono::steady_clock::now();
+  oc_clock_time_t next = 0;
+  for (i = 0; i < 1000; i++) {
+    next += oc_etimer_next_expiration_time() & 1;
+  }
+  auto looked_up = std::chrono::steady_clock::now();
+  EXPECT_TRUE(oc_etimer_pending());
+
+  pollUntil(NUM_TIMERS, 5 * OC_CLOCK_SECOND);
+  auto done = std::chrono::steady_clock::now();
+
+  EXPECT_EQ(NUM_TIMERS, num_fired);
+  for (i = 0; i < NUM_TIMERS; i++) {
+    ASSERT_EQ(1, cbs[i].fired);
+    ASSERT_GE(cbs[i].fired_at, cbs[i].deadline);
+  }
+
+  printf("%d timers: set in %lld us, 1000 next expiry lookups in %lld us, "
+         "all fired after %lld ms\n",
+         NUM_TIMERS,
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+           added - start)
+           .count(),
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+           looked_up - added)
+           .count(),
+         (long long)std::chrono::duration_cast<std::chrono::milliseconds>(
+           done - start)
+           .count());
+  (void)next;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
@@ -19,6 +19,8 @@
  ******************************************************************/
 
 
+#include <chrono>
+#include <cstdio>
 #include <stdlib.h>
 #include "gtest/gtest.h"
 
@@ -66,7 +68,7 @@ TEST(TestRep, OCRepSetGetDouble)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -107,7 +109,7 @@ TEST(TestRep, OCRepSetGetInt)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -171,7 +173,7 @@ TEST(TestRep, OCRepSetGetUint)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -218,7 +220,7 @@ TEST(TestRep, OCRepSetGetBool)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -272,7 +274,7 @@ TEST(TestRep, OCRepSetGetTextString)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -324,7 +326,7 @@ TEST(TestRep, OCRepSetGetByteString)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -369,7 +371,7 @@ TEST(TestRep, OCRepSetGetIntArray)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -412,7 +414,7 @@ TEST(TestRep, OCRepSetGetBoolArray)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -455,7 +457,7 @@ TEST(TestRep, OCRepSetGetDoubleArray)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -514,7 +516,7 @@ TEST(TestRep, OCRepSetGetObject)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -595,7 +597,7 @@ TEST(TestRep, OCRepSetGetObjectArray)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -679,7 +681,7 @@ TEST(TestRep, OCRepSetGetByteStringArray)
     const uint8_t *payload = oc_rep_get_encoder_buf();
     int payload_len = oc_rep_get_encoded_payload_size();
     EXPECT_NE(payload_len, -1);
-    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0 ,0 };
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
     oc_rep_set_pool(&rep_objects);
     oc_rep_t *rep = NULL;
     oc_parse_rep(payload, payload_len, &rep);
@@ -701,3 +703,342 @@ TEST(TestRep, OCRepSetGetByteStringArray)
     EXPECT_EQ(memcmp(ba4, oc_byte_string_array_get_item(barray_out, 3), oc_byte_string_array_get_item_size(barray_out, 3)), 0);
     oc_free_rep(rep);
 }
+
+TEST(TestRep, OCRepCursorGetValues)
+{
+    /*buffer for oc_rep_t */
+    uint8_t buf[1024];
+    oc_rep_new(&buf[0], 1024);
+
+    /*
+     * {
+     *   "power": 42,
+     *   "state": true,
+     *   "ratio": 0.5,
+     *   "name": "kitchen light",
+     *   "my_object": {
+     *     "a": 1
+     *   },
+     *   "levels": [1, 2, 3]
+     * }
+     */
+    int levels[3] = { 1, 2, 3 };
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, power, 42);
+    oc_rep_set_boolean(root, state, true);
+    oc_rep_set_double(root, ratio, 0.5);
+    oc_rep_set_text_string(root, name, "kitchen light");
+    oc_rep_set_object(root, my_object);
+    oc_rep_set_int(my_object, a, 1);
+    oc_rep_close_object(root, my_object);
+    oc_rep_set_int_array(root, levels, levels, 3);
+    oc_rep_end_root_object();
+    EXPECT_EQ(CborNoError, oc_rep_get_cbor_errno());
+
+    const uint8_t *payload = oc_rep_get_encoder_buf();
+    int payload_len = oc_rep_get_encoded_payload_size();
+    ASSERT_NE(payload_len, -1);
+
+    /* read the values in place, without building an oc_rep_t */
+    oc_rep_cursor_t root_cursor;
+    ASSERT_TRUE(oc_rep_cursor_init(&root_cursor, payload, payload_len));
+    int power_out = 0;
+    EXPECT_TRUE(oc_rep_cursor_get_int(&root_cursor, "power", &power_out));
+    EXPECT_EQ(42, power_out);
+    bool state_out = false;
+    EXPECT_TRUE(oc_rep_cursor_get_bool(&root_cursor, "state", &state_out));
+    EXPECT_TRUE(state_out);
+    double ratio_out = 0;
+    EXPECT_TRUE(oc_rep_cursor_get_double(&root_cursor, "ratio", &ratio_out));
+    EXPECT_EQ(0.5, ratio_out);
+
+    const char *name_out = NULL;
+    size_t name_out_size = 0;
+    EXPECT_TRUE(oc_rep_cursor_get_string(&root_cursor, "name", &name_out,
+                                         &name_out_size));
+    EXPECT_EQ(13, name_out_size);
+    EXPECT_EQ(0, memcmp("kitchen light", name_out, name_out_size));
+    /* the string points into the payload */
+    EXPECT_TRUE(name_out > (const char *)payload &&
+                name_out < (const char *)payload + payload_len);
+
+    oc_rep_cursor_t my_object_out;
+    EXPECT_TRUE(oc_rep_cursor_get_object(&root_cursor, "my_object",
+                                         &my_object_out));
+    int a_out = 0;
+    EXPECT_TRUE(oc_rep_cursor_get_int(&my_object_out, "a", &a_out));
+    EXPECT_EQ(1, a_out);
+
+    oc_rep_cursor_t levels_out;
+    EXPECT_TRUE(oc_rep_cursor_get_array(&root_cursor, "levels", &levels_out));
+    int i = 0, level;
+    while (!oc_rep_cursor_at_end(&levels_out)) {
+        ASSERT_LT(i, 3);
+        EXPECT_TRUE(oc_rep_cursor_read_int(&levels_out, &level));
+        EXPECT_EQ(levels[i++], level);
+        EXPECT_TRUE(oc_rep_cursor_next(&levels_out));
+    }
+    EXPECT_EQ(3, i);
+
+    /* error handling */
+    EXPECT_FALSE(oc_rep_cursor_get_int(&root_cursor, "no_a_key", &power_out));
+    EXPECT_FALSE(oc_rep_cursor_get_int(&root_cursor, "name", &power_out));
+    EXPECT_FALSE(oc_rep_cursor_get_string(&root_cursor, "power", &name_out,
+                                          &name_out_size));
+    EXPECT_FALSE(oc_rep_cursor_get_int(&root_cursor, NULL, &power_out));
+    EXPECT_FALSE(oc_rep_cursor_get_int(&root_cursor, "power", NULL));
+    EXPECT_FALSE(oc_rep_cursor_get_int(&levels_out, "a", &a_out));
+}
+
+TEST(TestRep, OCRepCursorTruncatedPayload_N)
+{
+    uint8_t buf[1024];
+    oc_rep_new(&buf[0], 1024);
+
+    oc_rep_start_root_object();
+    oc_rep_set_text_string(root, name, "kitchen light");
+    oc_rep_end_root_object();
+
+    const uint8_t *payload = oc_rep_get_encoder_buf();
+    int payload_len = oc_rep_get_encoded_payload_size();
+    ASSERT_NE(payload_len, -1);
+
+    oc_rep_cursor_t root_cursor;
+    ASSERT_TRUE(oc_rep_cursor_init(&root_cursor, payload, payload_len - 4));
+    const char *name_out = NULL;
+    size_t name_out_size = 0;
+    EXPECT_FALSE(oc_rep_cursor_get_string(&root_cursor, "name", &name_out,
+                                          &name_out_size));
+}
+
+#ifdef OC_REP_ARENA
+TEST(TestRep, OCRepParseArena)
+{
+    /*buffer for oc_rep_t */
+    uint8_t buf[1024];
+    oc_rep_new(&buf[0], 1024);
+
+    /*
+     * {
+     *   "name": "kitchen light",
+     *   "levels": [1, 2, 3],
+     *   "tags": ["a", "b"],
+     *   "my_object": {
+     *     "a": 1
+     *   }
+     * }
+     */
+    int levels[3] = { 1, 2, 3 };
+    oc_rep_start_root_object();
+    oc_rep_set_text_string(root, name, "kitchen light");
+    oc_rep_set_int_array(root, levels, levels, 3);
+    oc_rep_set_array(root, tags);
+    oc_rep_add_text_string(tags, "a");
+    oc_rep_add_text_string(tags, "b");
+    oc_rep_close_array(root, tags);
+    oc_rep_set_object(root, my_object);
+    oc_rep_set_int(my_object, a, 1);
+    oc_rep_close_object(root, my_object);
+    oc_rep_end_root_object();
+    EXPECT_EQ(CborNoError, oc_rep_get_cbor_errno());
+
+    const uint8_t *payload = oc_rep_get_encoder_buf();
+    int payload_len = oc_rep_get_encoded_payload_size();
+    ASSERT_NE(payload_len, -1);
+
+    oc_arena_t arena = { NULL };
+    oc_rep_t *rep = NULL;
+    ASSERT_EQ(CborNoError, oc_parse_rep_arena(&arena, payload, payload_len,
+                                              &rep));
+    ASSERT_TRUE(rep != NULL);
+
+    char *name_out = NULL;
+    size_t size;
+    EXPECT_TRUE(oc_rep_get_string(rep, "name", &name_out, &size));
+    EXPECT_STREQ("kitchen light", name_out);
+    EXPECT_EQ(13, size);
+    int *levels_out = NULL;
+    EXPECT_TRUE(oc_rep_get_int_array(rep, "levels", &levels_out, &size));
+    ASSERT_EQ(3, size);
+    EXPECT_EQ(0, memcmp(levels, levels_out, sizeof(levels)));
+    oc_string_array_t tags_out;
+    EXPECT_TRUE(oc_rep_get_string_array(rep, "tags", &tags_out, &size));
+    ASSERT_EQ(2, size);
+    EXPECT_STREQ("a", oc_string_array_get_item(tags_out, 0));
+    EXPECT_STREQ("b", oc_string_array_get_item(tags_out, 1));
+    oc_rep_t *my_object_out = NULL;
+    EXPECT_TRUE(oc_rep_get_object(rep, "my_object", &my_object_out));
+    int a_out = 0;
+    EXPECT_TRUE(oc_rep_get_int(my_object_out, "a", &a_out));
+    EXPECT_EQ(1, a_out);
+
+    oc_arena_free(&arena);
+    EXPECT_TRUE(arena.blocks == NULL);
+}
+#endif /* OC_REP_ARENA */
+
+static oc_rep_field_t
+makeField(const char *key, oc_rep_value_type_t type, void *value)
+{
+    oc_rep_field_t field;
+    memset(&field, 0, sizeof(field));
+    field.key = key;
+    field.type = type;
+    field.value = value;
+    return field;
+}
+
+TEST(TestRep, OCRepGetFields)
+{
+    /*buffer for oc_rep_t */
+    uint8_t buf[1024];
+    oc_rep_new(&buf[0], 1024);
+
+    /*
+     * {
+     *   "power": 42,
+     *   "state": true,
+     *   "name": "kitchen light",
+     *   "levels": [1, 2, 3]
+     * }
+     */
+    int levels[3] = { 1, 2, 3 };
+    oc_rep_start_root_object();
+    oc_rep_set_int(root, power, 42);
+    oc_rep_set_boolean(root, state, true);
+    oc_rep_set_text_string(root, name, "kitchen light");
+    oc_rep_set_int_array(root, levels, levels, 3);
+    oc_rep_end_root_object();
+    EXPECT_EQ(CborNoError, oc_rep_get_cbor_errno());
+
+    const uint8_t *payload = oc_rep_get_encoder_buf();
+    int payload_len = oc_rep_get_encoded_payload_size();
+    ASSERT_NE(payload_len, -1);
+    struct oc_memb rep_objects = { sizeof(oc_rep_t), 0, 0, 0, 0, 0, 0, 0, 0 };
+    oc_rep_set_pool(&rep_objects);
+    oc_rep_t *rep = NULL;
+    oc_parse_rep(payload, payload_len, &rep);
+    ASSERT_TRUE(rep != NULL);
+
+    int power_out = 0;
+    bool state_out = false;
+    char *name_out = NULL;
+    int *levels_out = NULL;
+    double ratio_out = 0;
+    /* listed out of payload order, with a missing and a mistyped field */
+    oc_rep_field_t fields[] = {
+        makeField("name", OC_REP_STRING, &name_out),
+        makeField("ratio", OC_REP_DOUBLE, &ratio_out),
+        makeField("power", OC_REP_INT, &power_out),
+        makeField("state", OC_REP_INT, &state_out),
+        makeField("levels", OC_REP_INT_ARRAY, &levels_out),
+    };
+    EXPECT_EQ(3, oc_rep_get_fields(rep, fields, 5));
+    EXPECT_TRUE(fields[0].found);
+    EXPECT_STREQ("kitchen light", name_out);
+    EXPECT_EQ(13, fields[0].size);
+    EXPECT_FALSE(fields[1].found);
+    EXPECT_TRUE(fields[2].found);
+    EXPECT_EQ(42, power_out);
+    EXPECT_FALSE(fields[3].found);
+    EXPECT_FALSE(state_out);
+    EXPECT_TRUE(fields[4].found);
+    ASSERT_EQ(3, fields[4].size);
+    EXPECT_EQ(0, memcmp(levels, levels_out, sizeof(levels)));
+
+    /* the single value lookups agree */
+    int power_get = 0;
+    EXPECT_TRUE(oc_rep_get_int(rep, "power", &power_get));
+    EXPECT_EQ(42, power_get);
+    EXPECT_FALSE(oc_rep_get_int(rep, "powe", &power_get));
+    oc_free_rep(rep);
+}
+
+#define NUM_ENCODINGS (100000)
+
+struct lock_state_t
+{
+    bool lockState;
+    int battery;
+    double temperature;
+    const char *name;
+    const char *owner;
+};
+
+static const oc_rep_schema_field_t lock_schema[] = {
+    OC_REP_SCHEMA_BOOL(lock_state_t, lockState),
+    OC_REP_SCHEMA_INT(lock_state_t, battery),
+    OC_REP_SCHEMA_DOUBLE(lock_state_t, temperature),
+    OC_REP_SCHEMA_STRING(lock_state_t, name),
+    OC_REP_SCHEMA_STRING(lock_state_t, owner),
+};
+
+static int
+encodeWithMacros(uint8_t *buf, size_t size, const lock_state_t *state)
+{
+    oc_rep_new(buf, (int)size);
+    oc_rep_start_root_object();
+    oc_rep_set_boolean(root, lockState, state->lockState);
+    oc_rep_set_int(root, battery, state->battery);
+    oc_rep_set_double(root, temperature, state->temperature);
+    oc_rep_set_text_string(root, name, state->name);
+    oc_rep_set_text_string(root, owner, state->owner);
+    oc_rep_end_root_object();
+    return oc_rep_get_encoded_payload_size();
+}
+
+static int
+encodeWithSchema(uint8_t *buf, size_t size, const lock_state_t *state)
+{
+    oc_rep_new(buf, (int)size);
+    oc_rep_start_root_object();
+    oc_rep_encode_schema(oc_rep_object(root), lock_schema,
+                         sizeof(lock_schema) / sizeof(lock_schema[0]), state);
+    oc_rep_end_root_object();
+    return oc_rep_get_encoded_payload_size();
+}
+
+TEST(TestRep, OCRepEncodeSchema)
+{
+    uint8_t by_macros[256], by_schema[256];
+    lock_state_t state = { true, 87, 21.5, "front door", NULL };
+
+    int macros_len = encodeWithMacros(by_macros, sizeof(by_macros), &state);
+    ASSERT_NE(-1, macros_len);
+    int schema_len = encodeWithSchema(by_schema, sizeof(by_schema), &state);
+    ASSERT_EQ(macros_len, schema_len);
+    EXPECT_EQ(0, memcmp(by_macros, by_schema, schema_len));
+
+    /* running out of space is reported as with the macros */
+    EXPECT_EQ(-1, encodeWithSchema(by_schema, 16, &state));
+    EXPECT_EQ(CborErrorOutOfMemory, oc_rep_get_cbor_errno());
+}
+
+TEST(TestRep, OCRepEncodeSchemaBenchmark)
+{
+    uint8_t buf[256];
+    lock_state_t state = { true, 87, 21.5, "front door", "alice" };
+    int i;
+
+    auto start = std::chrono::steady_clock::now();
+    for (i = 0; i < NUM_ENCODINGS; i++) {
+        state.battery = i;
+        ASSERT_NE(-1, encodeWithMacros(buf, sizeof(buf), &state));
+    }
+    auto by_macros = std::chrono::steady_clock::now();
+    for (i = 0; i < NUM_ENCODINGS; i++) {
+        state.battery = i;
+        ASSERT_NE(-1, encodeWithSchema(buf, sizeof(buf), &state));
+    }
+    auto by_schema = std::chrono::steady_clock::now();
+
+    printf("%d encodings: %lld us with oc_rep_set_*(), %lld us with "
+           "oc_rep_encode_schema()\n",
+           NUM_ENCODINGS,
+           (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+             by_macros - start)
+             .count(),
+           (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+             by_schema - by_macros)
+             .count());
+}
@@ -0,0 +1,180 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <string>
+#include <vector>
+
+#include "port/linux/oc_config.h"
+#include "oc_api.h"
+#include "oc_collection.h"
+#include "oc_ri.h"
+#include "oc_uri_index.h"
+
+#ifdef OC_URI_INDEX
+#define NUM_DEVICES (4)
+#define NUM_RESOURCES (3000)
+#define NUM_LOOKUPS (100000)
+
+class TestUriIndex : public testing::Test
+{
+protected:
+  virtual void SetUp() { oc_ri_init(); }
+  virtual void TearDown() { oc_ri_shutdown(); }
+};
+
+static void
+onGet(oc_request_t *request, oc_interface_mask_t iface_mask, void *user_data)
+{
+  (void)request;
+  (void)iface_mask;
+  (void)user_data;
+}
+
+static oc_resource_t *
+addResource(const char *uri, size_t device)
+{
+  oc_resource_t *res = oc_new_resource(NULL, uri, 1, device);
+  oc_resource_bind_resource_type(res, "oic.r.test");
+  oc_resource_set_request_handler(res, OC_GET, onGet, NULL);
+  EXPECT_TRUE(oc_ri_add_resource(res));
+  return res;
+}
+
+/* The list walk that the index replaces. */
+static oc_resource_t *
+walkAppResources(const char *uri, size_t uri_len, size_t device)
+{
+  oc_resource_t *res = oc_ri_get_app_resources();
+  while (res != NULL) {
+    if (oc_string_len(res->uri) == (uri_len + 1) &&
+        strncmp(uri, oc_string(res->uri) + 1, uri_len) == 0 &&
+        res->device == device)
+      return res;
+    res = res->next;
+  }
+  return NULL;
+}
+
+TEST_F(TestUriIndex, LookupWithAndWithoutSlash_P)
+{
+  oc_resource_t *res = addResource("/a/light", 0);
+
+  EXPECT_EQ(res, oc_ri_get_app_resource_by_uri("/a/light", 8, 0));
+  EXPECT_EQ(res, oc_ri_get_app_resource_by_uri("a/light", 7, 0));
+  oc_ri_delete_resource(res);
+}
+
+TEST_F(TestUriIndex, LookupOtherDevice_N)
+{
+  oc_resource_t *res = addResource("/a/light", 0);
+
+  EXPECT_EQ(NULL, oc_ri_get_app_resource_by_uri("/a/light", 8, 1));
+  EXPECT_EQ(NULL, oc_ri_get_app_resource_by_uri("/a/ligh", 7, 0));
+  oc_ri_delete_resource(res);
+}
+
+TEST_F(TestUriIndex, LookupAfterDelete_N)
+{
+  oc_resource_t *res = addResource("/a/light", 0);
+  oc_ri_delete_resource(res);
+
+  EXPECT_EQ(NULL, oc_ri_get_app_resource_by_uri("/a/light", 8, 0));
+}
+
+TEST_F(TestUriIndex, SameUriOnEachDevice_P)
+{
+  oc_resource_t *res[NUM_DEVICES];
+  size_t device;
+  for (device = 0; device < NUM_DEVICES; device++) {
+    res[device] = addResource("/a/light", device);
+  }
+  for (device = 0; device < NUM_DEVICES; device++) {
+    oc_uri_index_kind_t kind;
+    EXPECT_EQ(res[device], oc_uri_index_lookup("a/light", 7, device,
+                                               OC_URI_INDEX_ALL, &kind));
+    EXPECT_EQ(OC_URI_INDEX_APP, kind);
+  }
+  for (device = 0; device < NUM_DEVICES; device++) {
+    oc_ri_delete_resource(res[device]);
+  }
+}
+
+#ifdef OC_COLLECTIONS
+TEST_F(TestUriIndex, LookupCollection_P)
+{
+  oc_resource_t *col = oc_new_collection(NULL, "/lights", 1, 0, 0, 0);
+  oc_resource_bind_resource_type(col, "oic.wk.col");
+  oc_add_collection(col);
+
+  oc_uri_index_kind_t kind;
+  EXPECT_EQ(col, oc_uri_index_lookup("lights", 6, 0, OC_URI_INDEX_ALL, &kind));
+  EXPECT_EQ(OC_URI_INDEX_COLLECTION, kind);
+  EXPECT_EQ(col, oc_ri_get_app_resource_by_uri("/lights", 7, 0));
+
+  oc_delete_collection(col);
+  EXPECT_EQ(NULL, oc_ri_get_app_resource_by_uri("/lights", 7, 0));
+}
+#endif /* OC_COLLECTIONS */
+
+#ifdef OC_DYNAMIC_ALLOCATION
+TEST_F(TestUriIndex, LookupBenchmark)
+{
+  std::vector<std::string> uris;
+  std::vector<oc_resource_t *> resources;
+  int i;
+  for (i = 0; i < NUM_RESOURCES; i++) {
+    char uri[32];
+    snprintf(uri, sizeof(uri), "/bridge/%d/light", i / NUM_DEVICES);
+    uris.push_back(uri);
+    resources.push_back(addResource(uri, i % NUM_DEVICES));
+  }
+
+  oc_resource_t *found = NULL;
+  auto start = std::chrono::steady_clock::now();
+  for (i = 0; i < NUM_LOOKUPS; i++) {
+    const std::string &uri = uris[(i * 7919) % NUM_RESOURCES];
+    found = walkAppResources(uri.c_str() + 1, uri.length() - 1,
+                             ((i * 7919) % NUM_RESOURCES) % NUM_DEVICES);
+  }
+  auto walk = std::chrono::steady_clock::now() - start;
+  EXPECT_NE(nullptr, found);
+
+  start = std::chrono::steady_clock::now();
+  for (i = 0; i < NUM_LOOKUPS; i++) {
+    int r = (i * 7919) % NUM_RESOURCES;
+    found = oc_ri_get_app_resource_by_uri(
+      uris[r].c_str() + 1, uris[r].length() - 1, r % NUM_DEVICES);
+    ASSERT_EQ(resources[r], found);
+  }
+  auto index = std::chrono::steady_clock::now() - start;
+
+  printf("%d lookups over %d resources: list walk %lld us, index %lld us\n",
+         NUM_LOOKUPS, NUM_RESOURCES,
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(walk)
+           .count(),
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(index)
+           .count());
+
+  for (i = 0; i < NUM_RESOURCES; i++) {
+    oc_ri_delete_resource(resources[i]);
+  }
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+#endif /* OC_URI_INDEX */
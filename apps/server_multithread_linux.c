@@ -56,6 +56,16 @@ int power;
 oc_string_t name;
 static oc_separate_response_t sep_response;
 
+#ifdef OC_WORKER_THREADS
+/* Request handlers run concurrently on the stack's worker threads. */
+#define lock_state() pthread_mutex_lock(&app_mutex)
+#define unlock_state() pthread_mutex_unlock(&app_mutex)
+#else /* OC_WORKER_THREADS */
+/* Request handlers run inside oc_main_poll(), under app_mutex. */
+#define lock_state()
+#define unlock_state()
+#endif /* !OC_WORKER_THREADS */
+
 oc_define_interrupt_handler(observe)
 {
   oc_notify_observers(res);
@@ -79,11 +89,13 @@ handle_separate_response(void *data)
   if (sep_response.active) {
     oc_set_separate_response_buffer(&sep_response);
     printf("handle_separate_response:\n");
+    lock_state();
     oc_rep_start_root_object();
     oc_rep_set_boolean(root, state, state);
     oc_rep_set_int(root, power, power);
     oc_rep_set_text_string(root, name, oc_string(name));
     oc_rep_end_root_object();
+    unlock_state();
     oc_send_separate_response(&sep_response, OC_STATUS_OK);
   }
   return OC_EVENT_DONE;
@@ -97,11 +109,18 @@ get_handler(oc_request_t *request, oc_interface_mask_t iface_mask,
 
   printf("get_handler:\n");
   if (is_separate_response) {
+#ifdef OC_WORKER_THREADS
+    oc_main_lock();
+#endif /* OC_WORKER_THREADS */
     oc_indicate_separate_response(request, &sep_response);
     oc_set_delayed_callback(NULL, &handle_separate_response, 1);
+#ifdef OC_WORKER_THREADS
+    oc_main_unlock();
+#endif /* OC_WORKER_THREADS */
     return;
   }
 
+  lock_state();
   oc_rep_start_root_object();
   switch (iface_mask) {
   case OC_IF_BASELINE:
@@ -116,6 +135,7 @@ get_handler(oc_request_t *request, oc_interface_mask_t iface_mask,
     break;
   }
   oc_rep_end_root_object();
+  unlock_state();
   oc_send_response(request, OC_STATUS_OK);
 }
 
@@ -128,6 +148,7 @@ post_handler(oc_request_t *request, oc_interface_mask_t iface_mask,
   printf("post_handler:\n");
   printf("  Key : Value\n");
   oc_rep_t *rep = request->request_payload;
+  lock_state();
   while (rep != NULL) {
     printf("  %s :", oc_string(rep->name));
     switch (rep->type) {
@@ -145,12 +166,14 @@ post_handler(oc_request_t *request, oc_interface_mask_t iface_mask,
                     oc_string_len(rep->value.string));
       break;
     default:
+      unlock_state();
       oc_send_response(request, OC_STATUS_BAD_REQUEST);
       return;
       break;
     }
     rep = rep->next;
   }
+  unlock_state();
   oc_send_response(request, OC_STATUS_CHANGED);
 }
 
@@ -196,6 +219,9 @@ register_resources(void)
   oc_resource_set_request_handler(res, OC_GET, get_handler, NULL);
   oc_resource_set_request_handler(res, OC_PUT, put_handler, NULL);
   oc_resource_set_request_handler(res, OC_POST, post_handler, NULL);
+#ifdef OC_WORKER_THREADS
+  oc_resource_set_concurrent(res, true);
+#endif /* OC_WORKER_THREADS */
   oc_add_resource(res);
 }
 
@@ -222,9 +248,13 @@ process_func(void *data)
   oc_clock_time_t next_event;
 
   while (quit != 1) {
+#ifdef OC_WORKER_THREADS
+    next_event = oc_main_poll();
+#else  /* OC_WORKER_THREADS */
     pthread_mutex_lock(&app_mutex);
     next_event = oc_main_poll();
     pthread_mutex_unlock(&app_mutex);
+#endif /* !OC_WORKER_THREADS */
     pthread_mutex_lock(&mutex);
     if (next_event == 0) {
       pthread_cond_wait(&cv, &mutex);
@@ -61,6 +61,27 @@ int oc_main_init(const oc_handler_t *handler);
 oc_clock_time_t oc_main_poll(void);
 void oc_main_shutdown(void);
 
+#ifdef OC_WORKER_THREADS
+/**
+  @brief Acquires the stack lock.
+
+  With OC_WORKER_THREADS, inbound requests are processed on a pool of
+  worker threads that share the stack with the thread calling
+  \c oc_main_poll(). Application threads, and handlers of resources marked
+  with \c oc_resource_set_concurrent(), must hold the lock around any call
+  into the stack. All other callbacks are invoked with the lock already
+  held. The lock is recursive.
+  @see oc_main_unlock
+  @see oc_resource_set_concurrent
+*/
+void oc_main_lock(void);
+
+/**
+  @brief Releases the stack lock acquired with \c oc_main_lock().
+*/
+void oc_main_unlock(void);
+#endif /* OC_WORKER_THREADS */
+
 int oc_add_device(const char *uri, const char *rt, const char *name,
                   const char *spec_version, const char *data_model_version,
                   oc_add_device_cb_t add_device_cb, void *data);
@@ -253,6 +274,46 @@ void oc_resource_set_discoverable(oc_resource_t *resource, bool state);
 void oc_resource_set_observable(oc_resource_t *resource, bool state);
 void oc_resource_set_periodic_observable(oc_resource_t *resource,
                                          uint16_t seconds);
+#ifdef OC_WORKER_THREADS
+/**
+  @brief Lets the resource's request handlers run in parallel on the request
+  worker threads.
+
+  Handlers of a concurrent resource are invoked without the stack lock held,
+  so several of them (for requests from different peers) may run at the same
+  time. Such a handler:
+  - may freely use the request it was passed, the oc_rep_* encoding and
+    decoding helpers, \c oc_get_query_value(), \c oc_iterate_query(),
+    \c oc_process_baseline_interface(), \c oc_send_response() and
+    \c oc_ignore_request();
+  - must bracket every other call into the stack (e.g.
+    \c oc_indicate_separate_response(), \c oc_set_delayed_callback(),
+    \c oc_notify_observers()) with \c oc_main_lock() and
+    \c oc_main_unlock();
+  - must protect its own application state, as other handlers of the same
+    resource may be running;
+  - must not delete the resource it is serving.
+
+  Requests from a given peer are always processed in order by the same
+  worker.
+  @param resource the resource
+  @param state true to run its handlers concurrently
+  @see oc_main_lock
+*/
+void oc_resource_set_concurrent(oc_resource_t *resource, bool state);
+#endif /* OC_WORKER_THREADS */
+/**
+  @brief Leaves request payloads to the resource's handlers to read in place.
+
+  The payloads of requests to such a resource are not decoded into an
+  oc_rep_t tree, so \c request_payload is always NULL in its handlers.
+  Handlers read the payload instead with \c oc_get_request_payload() and the
+  oc_rep_cursor_* functions, without copying any strings out of it.
+  @param resource the resource
+  @param state true to let handlers read payloads in place
+  @see oc_get_request_payload
+*/
+void oc_resource_set_lazy_payload(oc_resource_t *resource, bool state);
 void oc_resource_set_request_handler(oc_resource_t *resource,
                                      oc_method_t method,
                                      oc_request_callback_t callback,
@@ -304,6 +365,15 @@ int oc_iterate_query(oc_request_t *request, char **key, size_t *key_len,
 bool oc_iterate_query_get_values(oc_request_t *request, const char *key,
                                  char **value, int *value_len);
 int oc_get_query_value(oc_request_t *request, const char *key, char **value);
+/**
+  @brief Positions cursor at the root object of the request payload.
+
+  Only available to handlers of resources set with
+  \c oc_resource_set_lazy_payload(). The cursor, and the strings read through
+  it, are valid until the handler returns.
+  @return false if there is no payload or it is not a CBOR map
+*/
+bool oc_get_request_payload(oc_request_t *request, oc_rep_cursor_t *cursor);
 
 void oc_send_response(oc_request_t *request, oc_status_t response_code);
 void oc_ignore_request(oc_request_t *request);
@@ -49,6 +49,10 @@ typedef struct oc_blockwise_state_s
   uint8_t buffer[OC_MAX_APP_DATA_SIZE];
 #endif /* !OC_DYNAMIC_ALLOCATION */
   oc_string_t uri_query;
+#ifdef OC_REQUEST_ARENA
+  /* The request arena that buffer, href and uri_query live in, if any */
+  oc_arena_t *arena;
+#endif /* OC_REQUEST_ARENA */
 #ifdef OC_CLIENT
   uint16_t mid;
   void *client_cb;
@@ -96,10 +100,43 @@ oc_blockwise_state_t *oc_blockwise_alloc_response_buffer(
   const char *href, size_t href_len, oc_endpoint_t *endpoint, oc_method_t method,
   oc_blockwise_role_t role);
 
+#ifdef OC_REQUEST_ARENA
+/*
+ * Allocate a buffer along with its href and query from the request arena, for
+ * a transfer that is expected to complete while the current message is
+ * processed. Buffers that are still alive when the calling thread releases
+ * its arena get moved out of it by oc_blockwise_detach_arena_buffers().
+ */
+oc_blockwise_state_t *oc_blockwise_alloc_request_buffer_arena(
+  const char *href, size_t href_len, const char *query, size_t query_len,
+  oc_endpoint_t *endpoint, oc_method_t method, oc_blockwise_role_t role);
+
+oc_blockwise_state_t *oc_blockwise_alloc_response_buffer_arena(
+  const char *href, size_t href_len, const char *query, size_t query_len,
+  oc_endpoint_t *endpoint, oc_method_t method, oc_blockwise_role_t role);
+
+void oc_blockwise_detach_arena_buffers(void);
+#endif /* OC_REQUEST_ARENA */
+
 void oc_blockwise_free_request_buffer(oc_blockwise_state_t *buffer);
 
 void oc_blockwise_free_response_buffer(oc_blockwise_state_t *buffer);
 
+#ifdef OC_WORKER_THREADS
+/*
+ * Keep a buffer alive while the stack is unlocked around a concurrent
+ * request handler: scrubbing skips it, and its exchange lifetime is stopped
+ * until it is released again.
+ */
+void oc_blockwise_hold_request_buffer(oc_blockwise_state_t *buffer);
+
+void oc_blockwise_release_request_buffer(oc_blockwise_state_t *buffer);
+
+void oc_blockwise_hold_response_buffer(oc_blockwise_state_t *buffer);
+
+void oc_blockwise_release_response_buffer(oc_blockwise_state_t *buffer);
+#endif /* OC_WORKER_THREADS */
+
 const void *oc_blockwise_dispatch_block(oc_blockwise_state_t *buffer,
                                         uint32_t block_offset,
                                         uint32_t requested_block_size,
@@ -29,6 +29,9 @@ extern "C"
 
 OC_PROCESS_NAME(message_buffer_handler);
 oc_message_t *oc_allocate_message(void);
+/* cb runs with the network event mutex held, so it must not allocate or
+ * free messages itself.
+ */
 void oc_set_buffers_avail_cb(oc_memb_buffers_avail_callback_t cb);
 
 oc_message_t *oc_allocate_message_from_pool(struct oc_memb *pool);
@@ -41,6 +44,29 @@ void oc_message_unref(oc_message_t *message);
 void oc_recv_message(oc_message_t *message);
 void oc_send_message(oc_message_t *message);
 
+#ifdef OC_SHARED_PAYLOADS
+/* Copies data into a new shared payload holding a single reference. */
+oc_message_payload_t *oc_message_payload_new(const uint8_t *data,
+                                             size_t length);
+void oc_message_payload_unref(oc_message_payload_t *payload);
+
+/* Appends payload to message, which takes its own reference to it. */
+void oc_message_set_payload(oc_message_t *message,
+                            oc_message_payload_t *payload);
+#endif /* OC_SHARED_PAYLOADS */
+
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+/* Hands the receive buffers cached by the calling thread back to the shared
+ * pool. Call from an adapter thread before it exits.
+ */
+void oc_message_cache_thread_exit(void);
+
+/* Releases the receive buffers held for reuse. Call once the adapter
+ * threads have stopped.
+ */
+void oc_message_cache_free(void);
+#endif /* OC_LOCKFREE_NETWORK_EVENTS */
+
 #ifdef __cplusplus
 }
 #endif
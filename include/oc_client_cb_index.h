@@ -0,0 +1,62 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef OC_CLIENT_CB_INDEX_H
+#define OC_CLIENT_CB_INDEX_H
+
+#include "oc_client_state.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef OC_CLIENT_CB_INDEX
+/*
+ * Hash indexes over the token, the MID and the (uri, endpoint) of all client
+ * callbacks. Callbacks sharing a key are found in the order in which they
+ * were indexed, as in the list walks these replace. The keys of an indexed
+ * callback must only be changed through oc_ri_set_client_cb_mid() and
+ * oc_ri_set_client_cb_token().
+ */
+#ifndef OC_DYNAMIC_ALLOCATION
+#ifndef OC_CLIENT_CB_INDEX_BUCKETS
+#define OC_CLIENT_CB_INDEX_BUCKETS (8)
+#endif /* !OC_CLIENT_CB_INDEX_BUCKETS */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+bool oc_client_cb_index_add(oc_client_cb_t *cb);
+void oc_client_cb_index_remove(oc_client_cb_t *cb);
+
+oc_client_cb_t *oc_client_cb_index_find_by_token(const uint8_t *token,
+                                                 uint8_t token_len);
+oc_client_cb_t *oc_client_cb_index_find_by_mid(uint16_t mid);
+
+/*
+ * Iterate over the callbacks for uri whose endpoint has the address and port
+ * of endpoint, starting with prev set to NULL. Callers still compare the
+ * endpoints, as distinct endpoints may share a hash.
+ */
+oc_client_cb_t *oc_client_cb_index_next_by_uri(const char *uri, size_t uri_len,
+                                               const oc_endpoint_t *endpoint,
+                                               oc_client_cb_t *prev);
+#endif /* OC_CLIENT_CB_INDEX */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_CLIENT_CB_INDEX_H */
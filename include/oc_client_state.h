@@ -59,9 +59,18 @@ typedef union oc_client_handler_s
   oc_discovery_handler_t discovery;
 } oc_client_handler_t;
 
+#ifdef OC_CLIENT_CB_INDEX
+/* Token, MID and (uri, endpoint), see oc_client_cb_index.h */
+#define OC_CLIENT_CB_INDEX_KEYS (3)
+#endif /* OC_CLIENT_CB_INDEX */
+
 typedef struct oc_client_cb_s
 {
   struct oc_client_cb_s *next;
+#ifdef OC_CLIENT_CB_INDEX
+  struct oc_client_cb_s *index_next[OC_CLIENT_CB_INDEX_KEYS];
+  uint32_t index_hash[OC_CLIENT_CB_INDEX_KEYS];
+#endif /* OC_CLIENT_CB_INDEX */
   oc_string_t uri;
   oc_string_t query;
   oc_endpoint_t *endpoint;
@@ -103,6 +112,11 @@ oc_client_cb_t *oc_ri_find_client_cb_by_mid(uint16_t mid);
 
 bool oc_ri_remove_client_cb_by_mid(uint16_t mid);
 
+/* Change the keys under which a callback is found for responses. */
+void oc_ri_set_client_cb_mid(oc_client_cb_t *cb, uint16_t mid);
+void oc_ri_set_client_cb_token(oc_client_cb_t *cb, const uint8_t *token,
+                               uint8_t token_len);
+
 oc_discovery_flags_t oc_ri_process_discovery_payload(
   uint8_t *payload, int len, oc_discovery_handler_t handler,
   oc_endpoint_t *endpoint, void *user_data);
@@ -24,6 +24,12 @@ extern "C"
 
 void oc_create_discovery_resource(int resource_idx, size_t device);
 
+#ifdef OC_DISCOVERY_CACHE
+/* Drop all cached discovery responses. To be called whenever a resource is
+   added or removed, or a property that is published in /oic/res changes. */
+void oc_discovery_cache_invalidate(void);
+#endif /* OC_DISCOVERY_CACHE */
+
 #ifdef __cplusplus
 }
 #endif
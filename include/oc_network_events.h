@@ -52,6 +52,13 @@ typedef struct oc_message_s oc_message_t;
 
 void oc_network_event(oc_message_t *message);
 
+/**
+  @brief Queues a chain of inbound messages, linked through their next
+    pointers, as a single network event.
+  @param messages  head of the chain.
+*/
+void oc_network_event_list(oc_message_t *messages);
+
 void oc_network_interface_event(oc_interface_event_t event);
 
 #ifdef __cplusplus
@@ -19,9 +19,11 @@
 
 #include "deps/tinycbor/src/cbor.h"
 #include "oc_helpers.h"
+#include "util/oc_arena.h"
 #include "util/oc_memb.h"
 #include <oc_config.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
@@ -29,8 +31,13 @@ extern "C"
 {
 #endif
 
+#ifdef OC_WORKER_THREADS
+extern OC_THREAD_LOCAL CborEncoder g_encoder, root_map, links_array;
+extern OC_THREAD_LOCAL int g_err;
+#else  /* OC_WORKER_THREADS */
 extern CborEncoder g_encoder, root_map, links_array;
 extern int g_err;
+#endif /* !OC_WORKER_THREADS */
 
 /**
  * Initialize the buffer used to hold the cbor encoded data
@@ -274,6 +281,9 @@ typedef struct oc_rep_s
   oc_rep_value_type_t type;
   struct oc_rep_s *next;
   oc_string_t name;
+#ifdef OC_REP_KEY_INDEX
+  uint32_t name_hash; /* hash of name, computed by oc_parse_rep() */
+#endif /* OC_REP_KEY_INDEX */
   union oc_rep_value
   {
     int integer;
@@ -286,6 +296,70 @@ typedef struct oc_rep_s
   } value;
 } oc_rep_t;
 
+/*
+ * A property name encoded as a CBOR text string at compile time, for names
+ * of at most 23 bytes, whose length fits in the initial byte. OC_REP_KEY()
+ * fails to compile, with a negative array size, for longer names.
+ */
+typedef struct
+{
+  uint8_t header;
+  char name[23];
+} oc_rep_key_t;
+
+#define OC_REP_KEY(key)                                                        \
+  {                                                                            \
+    (uint8_t)(0x60 + sizeof(#key) - 1 +                                        \
+              0 * sizeof(char[sizeof(#key) - 1 <= 23 ? 1 : -1])),              \
+      #key                                                                     \
+  }
+
+/*
+ * Describes a property of a resource whose value is a member of an
+ * application struct. A table of these is encoded by oc_rep_encode_schema(),
+ * which copies the encoded names and only encodes the values. Properties are
+ * named after the members they are read from.
+ */
+typedef struct
+{
+  oc_rep_key_t key;
+  oc_rep_value_type_t type;
+  size_t offset;
+} oc_rep_schema_field_t;
+
+/* int member */
+#define OC_REP_SCHEMA_INT(type, member)                                        \
+  {                                                                            \
+    OC_REP_KEY(member), OC_REP_INT, offsetof(type, member)                     \
+  }
+/* bool member */
+#define OC_REP_SCHEMA_BOOL(type, member)                                       \
+  {                                                                            \
+    OC_REP_KEY(member), OC_REP_BOOL, offsetof(type, member)                    \
+  }
+/* double member */
+#define OC_REP_SCHEMA_DOUBLE(type, member)                                     \
+  {                                                                            \
+    OC_REP_KEY(member), OC_REP_DOUBLE, offsetof(type, member)                  \
+  }
+/* const char * member, which is left out of the encoding when NULL */
+#define OC_REP_SCHEMA_STRING(type, member)                                     \
+  {                                                                            \
+    OC_REP_KEY(member), OC_REP_STRING, offsetof(type, member)                  \
+  }
+
+/* Encodes an encoded property name into object. */
+CborError oc_rep_encode_key(CborEncoder *object, const oc_rep_key_t *key);
+
+/*
+ * Encodes the members of data described by fields as properties of object,
+ * e.g. oc_rep_object(root). Errors are also accumulated in g_err, as with
+ * the oc_rep_set_*() macros.
+ */
+CborError oc_rep_encode_schema(CborEncoder *object,
+                               const oc_rep_schema_field_t *fields,
+                               size_t num_fields, const void *data);
+
 void oc_rep_set_pool(struct oc_memb *rep_objects_pool);
 
 int oc_parse_rep(const uint8_t *payload, int payload_size,
@@ -293,6 +367,16 @@ int oc_parse_rep(const uint8_t *payload, int payload_size,
 
 void oc_free_rep(oc_rep_t *rep);
 
+#ifdef OC_REP_ARENA
+/*
+ * A representation parsed with oc_parse_rep_arena() is carved out of arena,
+ * in blocks that are sized from the payload, and is released along with the
+ * rest of arena rather than with oc_free_rep().
+ */
+int oc_parse_rep_arena(oc_arena_t *arena, const uint8_t *payload,
+                       int payload_size, oc_rep_t **value_list);
+#endif /* OC_REP_ARENA */
+
 bool oc_rep_get_int(oc_rep_t *rep, const char *key, int *value);
 bool oc_rep_get_bool(oc_rep_t *rep, const char *key, bool *value);
 bool oc_rep_get_double(oc_rep_t *rep, const char *key, double *value);
@@ -306,6 +390,84 @@ bool oc_rep_get_string_array(oc_rep_t *rep, const char *key, oc_string_array_t *
 bool oc_rep_get_object(oc_rep_t *rep, const char *key, oc_rep_t **value);
 bool oc_rep_get_object_array(oc_rep_t *rep, const char *key, oc_rep_t **value);
 
+/*
+ * A property to be read by oc_rep_get_fields(). value points to where the
+ * value is stored, as with the oc_rep_get_*() function for type: an int for
+ * OC_REP_INT, a char * for OC_REP_STRING, an int * for OC_REP_INT_ARRAY, an
+ * oc_string_array_t for OC_REP_STRING_ARRAY, an oc_rep_t * for OC_REP_OBJECT,
+ * and so on.
+ */
+typedef struct
+{
+  const char *key;
+  oc_rep_value_type_t type;
+  void *value;
+  size_t size; /* length of a string or array that was found */
+  bool found;
+  /* Used by oc_rep_get_fields() */
+  size_t key_len;
+  uint32_t key_hash;
+} oc_rep_field_t;
+
+/*
+ * Reads the properties of rep that are described by fields in one pass over
+ * rep, and returns the number of fields that were found. Fields listed in
+ * the order of the properties in the payload are matched with a single
+ * comparison each.
+ */
+int oc_rep_get_fields(oc_rep_t *rep, oc_rep_field_t *fields,
+                      size_t num_fields);
+
+/*
+ * Read-only cursor over an encoded representation, for reading properties
+ * in place without building an oc_rep_t tree. Strings and byte strings
+ * point into the payload and are not NUL terminated, so they stay valid only
+ * as long as the payload buffer does.
+ *
+ * A cursor refers either to an object, whose properties are looked up by key
+ * with oc_rep_cursor_get_*(), or to the current element of an array, which
+ * is read with oc_rep_cursor_read_*() and moved with oc_rep_cursor_next().
+ */
+typedef struct
+{
+  CborParser parser;
+  CborValue value;
+} oc_rep_cursor_t;
+
+/* Positions cursor at the root object of payload. */
+bool oc_rep_cursor_init(oc_rep_cursor_t *cursor, const uint8_t *payload,
+                        size_t payload_size);
+
+bool oc_rep_cursor_get_int(const oc_rep_cursor_t *object, const char *key,
+                           int *value);
+bool oc_rep_cursor_get_bool(const oc_rep_cursor_t *object, const char *key,
+                            bool *value);
+bool oc_rep_cursor_get_double(const oc_rep_cursor_t *object, const char *key,
+                              double *value);
+bool oc_rep_cursor_get_string(const oc_rep_cursor_t *object, const char *key,
+                              const char **value, size_t *size);
+bool oc_rep_cursor_get_byte_string(const oc_rep_cursor_t *object,
+                                   const char *key, const uint8_t **value,
+                                   size_t *size);
+bool oc_rep_cursor_get_object(const oc_rep_cursor_t *object, const char *key,
+                              oc_rep_cursor_t *value);
+/* Positions array at the first element of the array property key. */
+bool oc_rep_cursor_get_array(const oc_rep_cursor_t *object, const char *key,
+                             oc_rep_cursor_t *array);
+
+bool oc_rep_cursor_at_end(const oc_rep_cursor_t *array);
+bool oc_rep_cursor_next(oc_rep_cursor_t *array);
+
+bool oc_rep_cursor_read_int(const oc_rep_cursor_t *element, int *value);
+bool oc_rep_cursor_read_bool(const oc_rep_cursor_t *element, bool *value);
+bool oc_rep_cursor_read_double(const oc_rep_cursor_t *element, double *value);
+bool oc_rep_cursor_read_string(const oc_rep_cursor_t *element,
+                               const char **value, size_t *size);
+bool oc_rep_cursor_read_byte_string(const oc_rep_cursor_t *element,
+                                    const uint8_t **value, size_t *size);
+bool oc_rep_cursor_read_object(const oc_rep_cursor_t *element,
+                               oc_rep_cursor_t *object);
+
 #ifdef __cplusplus
 }
 #endif
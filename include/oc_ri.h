@@ -35,6 +35,10 @@ typedef enum {
   OC_OBSERVABLE = (1 << 1),
   OC_SECURE = (1 << 4),
   OC_PERIODIC = (1 << 6),
+#ifdef OC_WORKER_THREADS
+  OC_CONCURRENT = (1 << 7),
+#endif /* OC_WORKER_THREADS */
+  OC_LAZY_PAYLOAD = (1 << 8)
 } oc_resource_properties_t;
 
 typedef enum {
@@ -119,6 +123,9 @@ typedef struct
   size_t query_len;
   oc_rep_t *request_payload;
   oc_response_t *response;
+  /* The encoded request payload, for resources with OC_LAZY_PAYLOAD. */
+  const uint8_t *_payload;
+  size_t _payload_len;
 } oc_request_t;
 
 typedef void (*oc_request_callback_t)(oc_request_t *, oc_interface_mask_t,
@@ -173,6 +180,21 @@ void oc_ri_init(void);
 
 void oc_ri_shutdown(void);
 
+#ifdef OC_REQUEST_ARENA
+/*
+ * The arena that the calling thread carves the parsed payload and the
+ * block-wise buffers of the message it is processing out of. The arena is
+ * reset by oc_ri_release_request_arena() once the message has been answered,
+ * after moving the block-wise buffers that are still in use out of it.
+ */
+oc_arena_t *oc_ri_request_arena(void);
+
+void oc_ri_release_request_arena(void);
+
+/* Give the memory of the calling thread's arena back to the system. */
+void oc_ri_free_request_arena(void);
+#endif /* OC_REQUEST_ARENA */
+
 void oc_ri_add_timed_event_callback_ticks(void *cb_data,
                                           oc_trigger_t event_callback,
                                           oc_clock_time_t ticks);
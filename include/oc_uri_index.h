@@ -0,0 +1,68 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef OC_URI_INDEX_H
+#define OC_URI_INDEX_H
+
+#include "oc_ri.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef OC_URI_INDEX
+/*
+ * Hash index over (device, uri) of all resources a request may be
+ * dispatched to. Core resources are indexed by their type so that the index
+ * survives the core resource array being reallocated as devices are added.
+ */
+typedef enum {
+  OC_URI_INDEX_CORE = (1 << 0),
+  OC_URI_INDEX_APP = (1 << 1),
+  OC_URI_INDEX_COLLECTION = (1 << 2)
+} oc_uri_index_kind_t;
+
+#define OC_URI_INDEX_ALL                                                       \
+  (OC_URI_INDEX_CORE | OC_URI_INDEX_APP | OC_URI_INDEX_COLLECTION)
+
+#ifndef OC_DYNAMIC_ALLOCATION
+#ifndef OC_URI_INDEX_BUCKETS
+#define OC_URI_INDEX_BUCKETS (16)
+#endif /* !OC_URI_INDEX_BUCKETS */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+bool oc_uri_index_add(oc_resource_t *resource, oc_uri_index_kind_t kind);
+bool oc_uri_index_add_core(int core_resource, size_t device);
+void oc_uri_index_remove(oc_resource_t *resource);
+void oc_uri_index_remove_core(int core_resource, size_t device);
+
+/*
+ * Look up uri, with or without its leading slash, among the resources of the
+ * kinds set in kinds. Core resources take precedence over application
+ * resources, which take precedence over collections, as in the list walk this
+ * replaces. The kind of the match is stored in kind if it is not NULL.
+ */
+oc_resource_t *oc_uri_index_lookup(const char *uri, size_t uri_len,
+                                   size_t device, int kinds,
+                                   oc_uri_index_kind_t *kind);
+#endif /* OC_URI_INDEX */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_URI_INDEX_H */
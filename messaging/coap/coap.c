@@ -64,7 +64,11 @@
 /*---------------------------------------------------------------------------*/
 static uint16_t current_mid = 0;
 
+#ifdef OC_WORKER_THREADS
+OC_THREAD_LOCAL coap_status_t coap_status_code = COAP_NO_ERROR;
+#else  /* OC_WORKER_THREADS */
 coap_status_t coap_status_code = COAP_NO_ERROR;
+#endif /* !OC_WORKER_THREADS */
 /*---------------------------------------------------------------------------*/
 /*- Local helper functions --------------------------------------------------*/
 /*---------------------------------------------------------------------------*/
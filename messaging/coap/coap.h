@@ -217,7 +217,11 @@ typedef struct
   }
 
 /* to store error code and human-readable payload */
+#ifdef OC_WORKER_THREADS
+extern OC_THREAD_LOCAL coap_status_t coap_status_code;
+#else  /* OC_WORKER_THREADS */
 extern coap_status_t coap_status_code;
+#endif /* !OC_WORKER_THREADS */
 extern char *coap_error_message;
 
 void coap_init_connection(void);
@@ -89,6 +89,35 @@ extern "C"
  * check client. */
 #define COAP_OBSERVE_REFRESH_INTERVAL 5
 
+/* Number of request MIDs remembered per peer for duplicate detection. */
+#ifndef COAP_DEDUP_PEER_SLOTS
+#ifdef OC_DYNAMIC_ALLOCATION
+#define COAP_DEDUP_PEER_SLOTS (32)
+#else /* OC_DYNAMIC_ALLOCATION */
+#define COAP_DEDUP_PEER_SLOTS (8)
+#endif /* !OC_DYNAMIC_ALLOCATION */
+#endif /* COAP_DEDUP_PEER_SLOTS */
+
+/* Number of hash buckets for peers in the duplicate detection cache; must be
+ * a power of two. */
+#ifndef COAP_DEDUP_PEER_BUCKETS
+#ifdef OC_DYNAMIC_ALLOCATION
+#define COAP_DEDUP_PEER_BUCKETS (256)
+#else /* OC_DYNAMIC_ALLOCATION */
+#define COAP_DEDUP_PEER_BUCKETS (8)
+#endif /* !OC_DYNAMIC_ALLOCATION */
+#endif /* COAP_DEDUP_PEER_BUCKETS */
+
+/* Number of peers tracked for duplicate detection without dynamic memory. */
+#ifndef COAP_DEDUP_MAX_PEERS
+#define COAP_DEDUP_MAX_PEERS (OC_MAX_NUM_CONCURRENT_REQUESTS + 1)
+#endif /* COAP_DEDUP_MAX_PEERS */
+
+/* Upper bound on the bytes of responses kept for answering duplicates. */
+#ifndef COAP_DEDUP_MAX_CACHED_BYTES
+#define COAP_DEDUP_MAX_CACHED_BYTES (1024 * 1024)
+#endif /* COAP_DEDUP_MAX_CACHED_BYTES */
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,350 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "dedup.h"
+#include "coap.h"
+#include "oc_buffer.h"
+#include "port/oc_clock.h"
+#include "port/oc_log.h"
+#include "util/oc_memb.h"
+#include <string.h>
+#ifdef OC_DYNAMIC_ALLOCATION
+#include <stdlib.h>
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#if (COAP_DEDUP_PEER_BUCKETS & (COAP_DEDUP_PEER_BUCKETS - 1)) != 0
+#error "COAP_DEDUP_PEER_BUCKETS must be a power of two"
+#endif /* COAP_DEDUP_PEER_BUCKETS & (COAP_DEDUP_PEER_BUCKETS - 1) */
+
+#define COAP_DEDUP_LIFETIME (OC_EXCHANGE_LIFETIME * OC_CLOCK_SECOND)
+
+typedef enum {
+  DEDUP_SLOT_FREE = 0,
+  DEDUP_SLOT_PENDING,
+  DEDUP_SLOT_ANSWERED,
+  DEDUP_SLOT_UNCACHED
+} dedup_slot_state_t;
+
+typedef struct
+{
+  oc_clock_time_t expiry;
+#ifdef OC_DYNAMIC_ALLOCATION
+  uint8_t *response;
+  size_t response_len;
+#endif /* OC_DYNAMIC_ALLOCATION */
+  uint16_t mid;
+  uint8_t state;
+} dedup_slot_t;
+
+typedef struct dedup_peer_s
+{
+  struct dedup_peer_s *next;
+  /* Peers ordered by their last request, least recent first. */
+  struct dedup_peer_s *lru_prev, *lru_next;
+  oc_endpoint_t endpoint;
+  uint32_t hash;
+  oc_clock_time_t last_seen;
+  dedup_slot_t slots[COAP_DEDUP_PEER_SLOTS];
+} dedup_peer_t;
+
+OC_MEMB(dedup_peers_s, dedup_peer_t, COAP_DEDUP_MAX_PEERS);
+static dedup_peer_t *peers[COAP_DEDUP_PEER_BUCKETS];
+static dedup_peer_t *lru_head, *lru_tail;
+#ifdef OC_DYNAMIC_ALLOCATION
+static size_t cached_bytes;
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+static uint32_t
+endpoint_hash(const oc_endpoint_t *endpoint)
+{
+  const uint8_t *address = endpoint->addr.ipv6.address;
+  size_t len = 16;
+  uint16_t port = endpoint->addr.ipv6.port;
+#ifdef OC_IPV4
+  if (endpoint->flags & IPV4) {
+    address = endpoint->addr.ipv4.address;
+    len = 4;
+    port = endpoint->addr.ipv4.port;
+  }
+#endif /* OC_IPV4 */
+
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ address[i]) * 16777619u;
+  }
+  hash = (hash ^ (port & 0xff)) * 16777619u;
+  hash = (hash ^ (port >> 8)) * 16777619u;
+  hash = (hash ^ (uint8_t)endpoint->device) * 16777619u;
+  return hash;
+}
+
+static void
+clear_slot(dedup_slot_t *slot)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (slot->response) {
+    cached_bytes -= slot->response_len;
+    free(slot->response);
+    slot->response = NULL;
+    slot->response_len = 0;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+  slot->state = DEDUP_SLOT_FREE;
+}
+
+static void
+lru_unlink(dedup_peer_t *peer)
+{
+  if (peer->lru_prev) {
+    peer->lru_prev->lru_next = peer->lru_next;
+  } else {
+    lru_head = peer->lru_next;
+  }
+  if (peer->lru_next) {
+    peer->lru_next->lru_prev = peer->lru_prev;
+  } else {
+    lru_tail = peer->lru_prev;
+  }
+  peer->lru_prev = peer->lru_next = NULL;
+}
+
+static void
+lru_append(dedup_peer_t *peer)
+{
+  peer->lru_prev = lru_tail;
+  peer->lru_next = NULL;
+  if (lru_tail) {
+    lru_tail->lru_next = peer;
+  } else {
+    lru_head = peer;
+  }
+  lru_tail = peer;
+}
+
+static void
+free_peer(dedup_peer_t *peer)
+{
+  dedup_peer_t **p = &peers[peer->hash & (COAP_DEDUP_PEER_BUCKETS - 1)];
+  while (*p && *p != peer) {
+    p = &(*p)->next;
+  }
+  if (*p) {
+    *p = peer->next;
+  }
+  lru_unlink(peer);
+
+  size_t i;
+  for (i = 0; i < COAP_DEDUP_PEER_SLOTS; i++) {
+    clear_slot(&peer->slots[i]);
+  }
+  oc_memb_free(&dedup_peers_s, peer);
+}
+
+/* Every slot of a peer expires by last_seen + COAP_DEDUP_LIFETIME, so peers
+ * idle for longer hold no state and are released from the front of the LRU
+ * list.
+ */
+static void
+purge_idle_peers(oc_clock_time_t now)
+{
+  int i;
+  for (i = 0; i < 2 && lru_head; i++) {
+    if (now - lru_head->last_seen < COAP_DEDUP_LIFETIME) {
+      break;
+    }
+    free_peer(lru_head);
+  }
+}
+
+static dedup_peer_t *
+find_peer(const oc_endpoint_t *endpoint, uint32_t hash)
+{
+  dedup_peer_t *peer = peers[hash & (COAP_DEDUP_PEER_BUCKETS - 1)];
+  while (peer) {
+    if (peer->hash == hash &&
+        oc_endpoint_compare(&peer->endpoint, endpoint) == 0) {
+      return peer;
+    }
+    peer = peer->next;
+  }
+  return NULL;
+}
+
+static dedup_peer_t *
+alloc_peer(const oc_endpoint_t *endpoint, uint32_t hash)
+{
+  dedup_peer_t *peer = (dedup_peer_t *)oc_memb_alloc(&dedup_peers_s);
+  if (!peer && lru_head) {
+    /* All peers are in use; the least recently active one loses its
+     * history.
+     */
+    free_peer(lru_head);
+    peer = (dedup_peer_t *)oc_memb_alloc(&dedup_peers_s);
+  }
+  if (!peer) {
+    OC_WRN("insufficient memory to track requests from peer");
+    return NULL;
+  }
+  memset(peer, 0, sizeof(dedup_peer_t));
+  memcpy(&peer->endpoint, endpoint, sizeof(oc_endpoint_t));
+  peer->hash = hash;
+  dedup_peer_t **bucket = &peers[hash & (COAP_DEDUP_PEER_BUCKETS - 1)];
+  peer->next = *bucket;
+  *bucket = peer;
+  lru_append(peer);
+  return peer;
+}
+
+static dedup_slot_t *
+find_slot(const oc_endpoint_t *endpoint, uint16_t mid)
+{
+  dedup_peer_t *peer = find_peer(endpoint, endpoint_hash(endpoint));
+  if (!peer) {
+    return NULL;
+  }
+  dedup_slot_t *slot = &peer->slots[mid % COAP_DEDUP_PEER_SLOTS];
+  if (slot->state == DEDUP_SLOT_FREE || slot->mid != mid) {
+    return NULL;
+  }
+  return slot;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static void
+resend_response(const oc_endpoint_t *endpoint, const uint8_t *data,
+                size_t length)
+{
+  oc_message_t *message = oc_internal_allocate_outgoing_message();
+  if (message) {
+    memcpy(&message->endpoint, endpoint, sizeof(*endpoint));
+    memcpy(message->data, data, length);
+    message->length = length;
+    coap_send_message(message);
+    if (message->ref_count == 0) {
+      oc_message_unref(message);
+    }
+  }
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+coap_dedup_status_t
+coap_dedup_receive(const oc_endpoint_t *endpoint, uint16_t mid,
+                   bool confirmable)
+{
+  oc_clock_time_t now = oc_clock_time();
+  purge_idle_peers(now);
+
+  uint32_t hash = endpoint_hash(endpoint);
+  dedup_peer_t *peer = find_peer(endpoint, hash);
+  if (!peer) {
+    peer = alloc_peer(endpoint, hash);
+    if (!peer) {
+      return COAP_DEDUP_NEW;
+    }
+  } else {
+    lru_unlink(peer);
+    lru_append(peer);
+  }
+  peer->last_seen = now;
+
+  /* MIDs from a peer are mostly sequential, so indexing by MID keeps its
+   * most recent COAP_DEDUP_PEER_SLOTS exchanges.
+   */
+  dedup_slot_t *slot = &peer->slots[mid % COAP_DEDUP_PEER_SLOTS];
+  if (slot->state != DEDUP_SLOT_FREE && slot->mid == mid &&
+      (oc_clock_time_t)(slot->expiry - now) <= COAP_DEDUP_LIFETIME) {
+    switch (slot->state) {
+#ifdef OC_DYNAMIC_ALLOCATION
+    case DEDUP_SLOT_ANSWERED:
+      OC_DBG("answering duplicate request %u from the cache", mid);
+      resend_response(endpoint, slot->response, slot->response_len);
+      return COAP_DEDUP_HANDLED;
+#endif /* OC_DYNAMIC_ALLOCATION */
+    case DEDUP_SLOT_UNCACHED:
+      if (confirmable) {
+        OC_DBG("reprocessing duplicate request %u", mid);
+        return COAP_DEDUP_REPROCESS;
+      }
+      break;
+    default:
+      break;
+    }
+    OC_DBG("dropping duplicate request %u", mid);
+    return COAP_DEDUP_HANDLED;
+  }
+
+  clear_slot(slot);
+  slot->mid = mid;
+  slot->expiry = now + COAP_DEDUP_LIFETIME;
+  slot->state = DEDUP_SLOT_PENDING;
+  return COAP_DEDUP_NEW;
+}
+
+void
+coap_dedup_set_response(const oc_endpoint_t *endpoint, uint16_t mid,
+                        const uint8_t *data, size_t length)
+{
+  dedup_slot_t *slot = find_slot(endpoint, mid);
+  if (!slot) {
+    return;
+  }
+  clear_slot(slot);
+  slot->state = DEDUP_SLOT_UNCACHED;
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (cached_bytes + length > COAP_DEDUP_MAX_CACHED_BYTES) {
+    return;
+  }
+  slot->response = (uint8_t *)malloc(length);
+  if (!slot->response) {
+    return;
+  }
+  memcpy(slot->response, data, length);
+  slot->response_len = length;
+  cached_bytes += length;
+  slot->state = DEDUP_SLOT_ANSWERED;
+#else  /* OC_DYNAMIC_ALLOCATION */
+  (void)data;
+  (void)length;
+#endif /* !OC_DYNAMIC_ALLOCATION */
+}
+
+void
+coap_dedup_request_done(const oc_endpoint_t *endpoint, uint16_t mid)
+{
+  dedup_slot_t *slot = find_slot(endpoint, mid);
+  if (slot && slot->state == DEDUP_SLOT_PENDING) {
+    slot->state = DEDUP_SLOT_UNCACHED;
+  }
+}
+
+void
+coap_dedup_remove(const oc_endpoint_t *endpoint, uint16_t mid)
+{
+  dedup_slot_t *slot = find_slot(endpoint, mid);
+  if (slot) {
+    clear_slot(slot);
+  }
+}
+
+void
+coap_dedup_free_all(void)
+{
+  while (lru_head) {
+    free_peer(lru_head);
+  }
+}
@@ -0,0 +1,66 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef DEDUP_H
+#define DEDUP_H
+
+#include "conf.h"
+#include "oc_endpoint.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/*
+ * Duplicate detection for requests received over UDP, keyed on
+ * (endpoint, MID) as in RFC 7252 section 4.5. A MID is remembered for
+ * OC_EXCHANGE_LIFETIME seconds in one of COAP_DEDUP_PEER_SLOTS slots of its
+ * peer, so a busy peer only ever evicts its own history. Responses are kept
+ * with the MID in dynamic builds, and duplicates are answered with them.
+ */
+typedef enum {
+  COAP_DEDUP_NEW,       /* first copy of the request; process it */
+  COAP_DEDUP_REPROCESS, /* confirmable duplicate whose response was not kept */
+  COAP_DEDUP_HANDLED    /* duplicate answered from the cache or dropped */
+} coap_dedup_status_t;
+
+coap_dedup_status_t coap_dedup_receive(const oc_endpoint_t *endpoint,
+                                       uint16_t mid, bool confirmable);
+
+/* Record the serialized response to the request (endpoint, mid). */
+void coap_dedup_set_response(const oc_endpoint_t *endpoint, uint16_t mid,
+                             const uint8_t *data, size_t length);
+
+/* Called once the request (endpoint, mid) has been processed. If no response
+ * was recorded for it (e.g. it was ignored or failed before one was built),
+ * a confirmable retransmission is processed again rather than dropped.
+ */
+void coap_dedup_request_done(const oc_endpoint_t *endpoint, uint16_t mid);
+
+/* Forget a request that could not be processed so that it may be retried. */
+void coap_dedup_remove(const oc_endpoint_t *endpoint, uint16_t mid);
+
+void coap_dedup_free_all(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DEDUP_H */
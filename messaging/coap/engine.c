@@ -46,6 +46,7 @@
  */
 
 #include "engine.h"
+#include "dedup.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -66,6 +67,10 @@
 #include "coap_signal.h"
 #endif
 
+#ifdef OC_WORKER_THREADS
+#include "port/oc_worker_pool.h"
+#endif /* OC_WORKER_THREADS */
+
 OC_PROCESS(coap_engine, "CoAP Engine");
 
 #ifdef OC_BLOCK_WISE
@@ -79,24 +84,6 @@ extern bool oc_ri_invoke_coap_entity_handler(void *request, void *response,
                                              oc_endpoint_t *endpoint);
 #endif /* !OC_BLOCK_WISE */
 
-#define OC_REQUEST_HISTORY_SIZE (250)
-static uint16_t history[OC_REQUEST_HISTORY_SIZE];
-static uint8_t history_dev[OC_REQUEST_HISTORY_SIZE];
-static uint8_t idx;
-
-static bool
-check_if_duplicate(uint16_t mid, uint8_t device)
-{
-  size_t i;
-  for (i = 0; i < OC_REQUEST_HISTORY_SIZE; i++) {
-    if (history[i] == mid && history_dev[i] == device) {
-      OC_DBG("dropping duplicate request");
-      return true;
-    }
-  }
-  return false;
-}
-
 static void
 coap_send_empty_ack(uint16_t mid, oc_endpoint_t *endpoint)
 {
@@ -129,12 +116,19 @@ coap_receive(oc_message_t *msg)
   OC_LOGipaddr(msg->endpoint);
   OC_LOGbytes(msg->data, msg->length);
 
+#ifdef OC_WORKER_THREADS
+  /* request workers may be inside coap_receive() at the same time */
+  coap_packet_t message[1];
+  coap_packet_t response[1];
+  coap_transaction_t *transaction = NULL;
+#else  /* OC_WORKER_THREADS */
   /* static declaration reduces stack peaks and program code size */
   static coap_packet_t
     message[1]; /* this way the packet can be treated as pointer as usual */
   static coap_packet_t response[1];
   static coap_transaction_t *transaction;
   transaction = NULL;
+#endif /* !OC_WORKER_THREADS */
 
   /* block options */
   uint32_t block1_num = 0, block1_offset = 0, block2_num = 0, block2_offset = 0;
@@ -146,6 +140,7 @@ coap_receive(oc_message_t *msg)
 #ifdef OC_BLOCK_WISE
   oc_blockwise_state_t *request_buffer = NULL, *response_buffer = NULL;
 #endif /* OC_BLOCK_WISE */
+  bool dedup_pending = false;
 
 #ifdef OC_TCP
   if (msg->endpoint.flags & TCP) {
@@ -206,6 +201,14 @@ coap_receive(oc_message_t *msg)
 #endif /* OC_TCP */
     {
       transaction = coap_get_transaction_by_mid(message->mid);
+#ifdef OC_WORKER_THREADS
+      /* A worker may be filling in a response on another peer's transaction
+       * that happens to share this MID.
+       */
+      if (transaction && oc_endpoint_compare(&transaction->message->endpoint,
+                                             &msg->endpoint) != 0)
+        transaction = NULL;
+#endif /* OC_WORKER_THREADS */
       if (transaction)
         coap_clear_transaction(transaction);
       transaction = NULL;
@@ -240,15 +243,15 @@ coap_receive(oc_message_t *msg)
       } else
 #endif /* OC_TCP */
       {
+        if (coap_dedup_receive(&msg->endpoint, message->mid,
+                               message->type == COAP_TYPE_CON) ==
+            COAP_DEDUP_HANDLED) {
+          return 0;
+        }
+        dedup_pending = true;
         if (message->type == COAP_TYPE_CON) {
           coap_udp_init_message(response, COAP_TYPE_ACK, CONTENT_2_05, message->mid);
         } else {
-          if (check_if_duplicate(message->mid, (uint8_t)msg->endpoint.device)) {
-            return 0;
-          }
-          history[idx] = message->mid;
-          history_dev[idx] = (uint8_t)msg->endpoint.device;
-          idx = (idx + 1) % OC_REQUEST_HISTORY_SIZE;
           coap_udp_init_message(response, COAP_TYPE_NON, CONTENT_2_05,
                             coap_get_mid());
         }
@@ -257,6 +260,16 @@ coap_receive(oc_message_t *msg)
       /* create transaction for response */
       transaction = coap_new_transaction(message->mid, &msg->endpoint);
 
+#ifdef OC_TCP
+      if (!transaction && !(msg->endpoint.flags & TCP))
+#else  /* OC_TCP */
+      if (!transaction)
+#endif /* !OC_TCP */
+      {
+        /* let a retransmission of the request through */
+        coap_dedup_remove(&msg->endpoint, message->mid);
+      }
+
       if (transaction) {
 #ifdef OC_BLOCK_WISE
         const char *href;
@@ -389,9 +402,19 @@ coap_receive(oc_message_t *msg)
 #endif /* !OC_TCP */
             if (incoming_block_len > 0) {
               OC_DBG("creating request buffer");
+#ifdef OC_REQUEST_ARENA
+              request_buffer = oc_blockwise_alloc_request_buffer_arena(
+                href, href_len, message->uri_query, message->uri_query_len,
+                &msg->endpoint, message->code, OC_BLOCKWISE_SERVER);
+#else  /* OC_REQUEST_ARENA */
               request_buffer = oc_blockwise_alloc_request_buffer(
                 href, href_len, &msg->endpoint, message->code,
                 OC_BLOCKWISE_SERVER);
+              if (request_buffer && message->uri_query_len > 0) {
+                oc_new_string(&request_buffer->uri_query, message->uri_query,
+                              message->uri_query_len);
+              }
+#endif /* !OC_REQUEST_ARENA */
 
               if (!(request_buffer &&
                     oc_blockwise_handle_block(request_buffer, 0, incoming_block,
@@ -399,10 +422,6 @@ coap_receive(oc_message_t *msg)
                 OC_ERR("could not create buffer to hold request payload");
                 goto init_reset_message;
               }
-              if (message->uri_query_len > 0) {
-                oc_new_string(&request_buffer->uri_query, message->uri_query,
-                              message->uri_query_len);
-              }
               request_buffer->payload_size = incoming_block_len;
               request_buffer->ref_count = 0;
             }
@@ -686,6 +705,16 @@ send_message:
       transaction->message->length =
         coap_serialize_message(response, transaction->message->data);
       if (transaction->message->length > 0) {
+#ifdef OC_TCP
+        if (!(msg->endpoint.flags & TCP))
+#endif /* OC_TCP */
+        {
+          if (message->code >= COAP_GET && message->code <= COAP_DELETE) {
+            coap_dedup_set_response(&msg->endpoint, message->mid,
+                                    transaction->message->data,
+                                    transaction->message->length);
+          }
+        }
         coap_send_transaction(transaction);
       } else {
         coap_clear_transaction(transaction);
@@ -695,13 +724,45 @@ send_message:
     coap_clear_transaction(transaction);
   }
 
+  if (dedup_pending) {
+    coap_dedup_request_done(&msg->endpoint, message->mid);
+  }
+
 #ifdef OC_BLOCK_WISE
   oc_blockwise_scrub_buffers();
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_REQUEST_ARENA
+  oc_ri_release_request_arena();
+#endif /* OC_REQUEST_ARENA */
 
   return coap_status_code;
 }
 /*---------------------------------------------------------------------------*/
+#ifdef OC_WORKER_THREADS
+void
+oc_worker_process_message(oc_message_t *message)
+{
+  oc_stack_mutex_lock();
+  if (oc_process_is_running(&coap_engine)) {
+    OC_PROCESS_CONTEXT_BEGIN(&coap_engine);
+    coap_receive(message);
+    OC_PROCESS_CONTEXT_END(&coap_engine);
+  }
+  oc_message_unref(message);
+  oc_stack_mutex_unlock();
+}
+
+void
+oc_worker_thread_exit(void)
+{
+#ifdef OC_REQUEST_ARENA
+  oc_stack_mutex_lock();
+  oc_ri_free_request_arena();
+  oc_stack_mutex_unlock();
+#endif /* OC_REQUEST_ARENA */
+}
+#endif /* OC_WORKER_THREADS */
+/*---------------------------------------------------------------------------*/
 void
 coap_init_engine(void)
 {
@@ -70,7 +70,7 @@
 int32_t observe_counter = 3;
 /*---------------------------------------------------------------------------*/
 OC_LIST(observers_list);
-OC_MEMB(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
+OC_MEMB_CACHED(observers_memb, coap_observer_t, COAP_MAX_OBSERVERS);
 
 /*---------------------------------------------------------------------------*/
 /*- Internal API ------------------------------------------------------------*/
@@ -437,6 +437,12 @@ coap_notify_observers(oc_resource_t *resource,
 #ifdef OC_BLOCK_WISE
     oc_blockwise_state_t *response_state = NULL;
 #endif /* OC_BLOCK_WISE */
+#ifdef OC_SHARED_PAYLOADS
+    /* The payload is copied once and then shared by the notifications to
+     * all plaintext UDP observers.
+     */
+    oc_message_payload_t *payload = NULL;
+#endif /* OC_SHARED_PAYLOADS */
 
 #ifndef OC_DYNAMIC_ALLOCATION
     uint8_t buffer[OC_MAX_APP_DATA_SIZE];
@@ -512,6 +518,9 @@ coap_notify_observers(oc_resource_t *resource,
         coap_transaction_t *transaction = NULL;
         if (response_buf) {
           coap_packet_t notification[1];
+#ifdef OC_SHARED_PAYLOADS
+          bool share_payload = false;
+#endif /* OC_SHARED_PAYLOADS */
 
 #ifdef OC_TCP
           if (obs->endpoint.flags & TCP) {
@@ -575,8 +584,21 @@ coap_notify_observers(oc_resource_t *resource,
                 "client liveness");
               notification->type = COAP_TYPE_CON;
             }
-            coap_set_payload(notification, response_buf->buffer,
-                             response_buf->response_length);
+#ifdef OC_SHARED_PAYLOADS
+            if (!(obs->endpoint.flags & (TCP | SECURED)) &&
+                response_buf->response_length > 0) {
+              if (!payload) {
+                payload = oc_message_payload_new(response_buf->buffer,
+                                                 response_buf->response_length);
+              }
+              share_payload = (payload != NULL);
+            }
+            if (!share_payload)
+#endif /* OC_SHARED_PAYLOADS */
+            {
+              coap_set_payload(notification, response_buf->buffer,
+                               response_buf->response_length);
+            }
           } //! blockwise transfer
 
           coap_set_status_code(notification, response_buf->code);
@@ -600,6 +622,14 @@ coap_notify_observers(oc_resource_t *resource,
             notification->mid = transaction->mid;
             transaction->message->length =
               coap_serialize_message(notification, transaction->message->data);
+#ifdef OC_SHARED_PAYLOADS
+            if (share_payload && transaction->message->length > 0) {
+              /* payload marker; the payload itself follows the header */
+              transaction->message->data[transaction->message->length++] =
+                0xFF;
+              oc_message_set_payload(transaction->message, payload);
+            }
+#endif /* OC_SHARED_PAYLOADS */
             if (transaction->message->length > 0) {
               coap_send_transaction(transaction);
             } else {
@@ -610,6 +640,9 @@ coap_notify_observers(oc_resource_t *resource,
       }     //! separate response
     }       // iterate over observers
   leave_notify_observers:
+#ifdef OC_SHARED_PAYLOADS
+    oc_message_payload_unref(payload);
+#endif /* OC_SHARED_PAYLOADS */
 #ifdef OC_DYNAMIC_ALLOCATION
     if (buffer) {
       free(buffer);
@@ -49,6 +49,7 @@
 
 #ifdef OC_SERVER
 
+#include "dedup.h"
 #include "oc_buffer.h"
 #include "separate.h"
 #include "transactions.h"
@@ -145,6 +146,9 @@ coap_separate_accept(void *request, oc_separate_response_t *separate_response,
       message->length = coap_serialize_message(ack, message->data);
       bool success = false;
       if (message->length > 0) {
+        /* A retransmission of the request is answered with the same ACK */
+        coap_dedup_set_response(endpoint, coap_req->mid, message->data,
+                                message->length);
         coap_send_message(message);
         success = true;
       }
@@ -65,7 +65,8 @@
 #endif
 
 /*---------------------------------------------------------------------------*/
-OC_MEMB(transactions_memb, coap_transaction_t, COAP_MAX_OPEN_TRANSACTIONS);
+OC_MEMB_CACHED(transactions_memb, coap_transaction_t,
+               COAP_MAX_OPEN_TRANSACTIONS);
 OC_LIST(transactions_list);
 
 static struct oc_process *transaction_handler_process = NULL;
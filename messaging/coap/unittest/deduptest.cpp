@@ -0,0 +1,70 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "dedup.h"
+
+#define MID (0x1234)
+
+class TestCoapDedup : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    memset(&endpoint, 0, sizeof(endpoint));
+    endpoint.flags = IPV6;
+    endpoint.addr.ipv6.address[15] = 1;
+    endpoint.addr.ipv6.port = 5683;
+  }
+
+  virtual void TearDown() { coap_dedup_free_all(); }
+
+  oc_endpoint_t endpoint;
+};
+
+TEST_F(TestCoapDedup, DuplicateWhileProcessingIsDropped_P)
+{
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID, true));
+  EXPECT_EQ(COAP_DEDUP_HANDLED, coap_dedup_receive(&endpoint, MID, true));
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID + 1, true));
+}
+
+TEST_F(TestCoapDedup, UnansweredRequestIsReprocessed_P)
+{
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID, true));
+  coap_dedup_request_done(&endpoint, MID);
+  EXPECT_EQ(COAP_DEDUP_REPROCESS, coap_dedup_receive(&endpoint, MID, true));
+  /* Non-confirmable duplicates are still dropped */
+  EXPECT_EQ(COAP_DEDUP_HANDLED, coap_dedup_receive(&endpoint, MID, false));
+}
+
+TEST_F(TestCoapDedup, OtherPeerIsNotADuplicate_P)
+{
+  oc_endpoint_t other;
+  memcpy(&other, &endpoint, sizeof(other));
+  other.addr.ipv6.port++;
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID, true));
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&other, MID, true));
+}
+
+TEST_F(TestCoapDedup, RemovedRequestIsNew_P)
+{
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID, true));
+  coap_dedup_remove(&endpoint, MID);
+  EXPECT_EQ(COAP_DEDUP_NEW, coap_dedup_receive(&endpoint, MID, true));
+}
@@ -33,11 +33,17 @@
 #include <linux/rtnetlink.h>
 #include <net/if.h>
 #include <netdb.h>
+#include <netinet/udp.h>
+#include <poll.h>
 #include <signal.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#ifdef OC_EPOLL
+#include <sys/epoll.h>
+#else  /* OC_EPOLL */
 #include <sys/select.h>
+#endif /* !OC_EPOLL */
 #include <sys/un.h>
 #include <unistd.h>
 
@@ -59,6 +65,16 @@ static const uint8_t ALL_OCF_NODES_SL[] = {
 };
 #define ALL_COAP_NODES_V4 0xe00001bb
 
+#ifdef OC_EPOLL
+/* Maximum number of ready sockets handled per epoll_wait() call */
+#define EPOLL_MAX_EVENTS (64)
+
+/* Maximum number of datagrams read from a UDP socket per recvmmsg() call */
+#ifndef UDP_RECV_BATCH_SIZE
+#define UDP_RECV_BATCH_SIZE (16)
+#endif /* !UDP_RECV_BATCH_SIZE */
+#endif /* OC_EPOLL */
+
 static pthread_mutex_t mutex;
 struct sockaddr_nl ifchange_nl;
 int ifchange_sock;
@@ -384,11 +400,12 @@ get_interface_addresses(ip_context_t *dev, unsigned char family, uint16_t port,
     return;
   }
 
-  fd_set rfds;
-  FD_ZERO(&rfds);
-  FD_SET(nl_sock, &rfds);
+  struct pollfd pfd;
+  pfd.fd = nl_sock;
+  pfd.events = POLLIN;
+  pfd.revents = 0;
 
-  if (select(FD_SETSIZE, &rfds, NULL, NULL, NULL) < 0) {
+  if (poll(&pfd, 1, -1) < 0) {
     close(nl_sock);
     return;
   }
@@ -650,45 +667,26 @@ static int process_interface_change_event(void) {
   return ret;
 }
 
+/* Fills in the endpoint of a datagram from its source address and the
+ * IPV6_PKTINFO/IP_PKTINFO ancillary data returned by recvmsg()/recvmmsg().
+ */
 static int
-recv_msg(int sock, uint8_t *recv_buf, int recv_buf_size,
-         oc_endpoint_t *endpoint, bool multicast)
+get_msg_endpoint(struct msghdr *msg, oc_endpoint_t *endpoint, bool multicast)
 {
-  struct sockaddr_storage client;
-  struct iovec iovec[1];
-  struct msghdr msg;
-  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
-
-  iovec[0].iov_base = recv_buf;
-  iovec[0].iov_len = (size_t)recv_buf_size;
-
-  msg.msg_name = &client;
-  msg.msg_namelen = sizeof(client);
-
-  msg.msg_iov = iovec;
-  msg.msg_iovlen = 1;
-
-  msg.msg_control = msg_control;
-  msg.msg_controllen = sizeof(msg_control);
-
-  msg.msg_flags = 0;
-
-  int ret = recvmsg(sock, &msg, 0);
-
-  if (ret < 0 || msg.msg_flags & MSG_TRUNC || msg.msg_flags & MSG_CTRUNC) {
-    OC_ERR("recvmsg returned with an error: %d", errno);
+  if (msg->msg_flags & MSG_TRUNC || msg->msg_flags & MSG_CTRUNC) {
+    OC_ERR("recvmsg returned a truncated datagram");
     return -1;
   }
 
   struct cmsghdr *cmsg;
-  for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != 0; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+  for (cmsg = CMSG_FIRSTHDR(msg); cmsg != 0; cmsg = CMSG_NXTHDR(msg, cmsg)) {
     if (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_PKTINFO) {
-      if (msg.msg_namelen != sizeof(struct sockaddr_in6)) {
+      if (msg->msg_namelen != sizeof(struct sockaddr_in6)) {
         OC_ERR("anciliary data contains invalid source address");
         return -1;
       }
       /* Set source address of packet in endpoint structure */
-      struct sockaddr_in6 *c6 = (struct sockaddr_in6 *)&client;
+      struct sockaddr_in6 *c6 = (struct sockaddr_in6 *)msg->msg_name;
       memcpy(endpoint->addr.ipv6.address, c6->sin6_addr.s6_addr,
              sizeof(c6->sin6_addr.s6_addr));
       endpoint->addr.ipv6.scope = c6->sin6_scope_id;
@@ -728,12 +726,12 @@ recv_msg(int sock, uint8_t *recv_buf, int recv_buf_size,
     }
 #ifdef OC_IPV4
     else if (cmsg->cmsg_level == SOL_IP && cmsg->cmsg_type == IP_PKTINFO) {
-      if (msg.msg_namelen != sizeof(struct sockaddr_in)) {
+      if (msg->msg_namelen != sizeof(struct sockaddr_in)) {
         OC_ERR("anciliary data contains invalid source address");
         return -1;
       }
       struct in_pktinfo *pktinfo = (struct in_pktinfo *)CMSG_DATA(cmsg);
-      struct sockaddr_in *c4 = (struct sockaddr_in *)&client;
+      struct sockaddr_in *c4 = (struct sockaddr_in *)msg->msg_name;
       memcpy(endpoint->addr.ipv4.address, &c4->sin_addr.s_addr,
              sizeof(c4->sin_addr.s_addr));
       endpoint->addr.ipv4.port = ntohs(c4->sin_port);
@@ -757,9 +755,349 @@ recv_msg(int sock, uint8_t *recv_buf, int recv_buf_size,
 #endif /* OC_IPV4 */
   }
 
+  return 0;
+}
+
+#ifndef OC_EPOLL
+static int
+recv_msg(int sock, uint8_t *recv_buf, int recv_buf_size,
+         oc_endpoint_t *endpoint, bool multicast)
+{
+  struct sockaddr_storage client;
+  struct iovec iovec[1];
+  struct msghdr msg;
+  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
+
+  iovec[0].iov_base = recv_buf;
+  iovec[0].iov_len = (size_t)recv_buf_size;
+
+  msg.msg_name = &client;
+  msg.msg_namelen = sizeof(client);
+
+  msg.msg_iov = iovec;
+  msg.msg_iovlen = 1;
+
+  msg.msg_control = msg_control;
+  msg.msg_controllen = sizeof(msg_control);
+
+  msg.msg_flags = 0;
+
+  int ret = recvmsg(sock, &msg, 0);
+
+  if (ret < 0) {
+    OC_ERR("recvmsg returned with an error: %d", errno);
+    return -1;
+  }
+
+  if (get_msg_endpoint(&msg, endpoint, multicast) < 0) {
+    return -1;
+  }
+
+  return ret;
+}
+#endif /* !OC_EPOLL */
+
+#ifdef OC_EPOLL
+static int
+add_event_source(ip_context_t *dev, ip_event_source_type_t type, int sock,
+                 enum transport_flags flags, bool edge_triggered)
+{
+  if (dev->num_event_sources >= IP_MAX_EVENT_SOURCES) {
+    OC_ERR("too many event sources for device %d", (int)dev->device);
+    return -1;
+  }
+
+  ip_event_source_t *source = &dev->event_sources[dev->num_event_sources++];
+  source->type = type;
+  source->sock = sock;
+  source->flags = flags;
+  source->data = NULL;
+
+  struct epoll_event event;
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events = EPOLLIN;
+  if (edge_triggered) {
+    event.events |= EPOLLET;
+  }
+  event.data.ptr = source;
+  if (epoll_ctl(dev->epoll_fd, EPOLL_CTL_ADD, sock, &event) == -1) {
+    OC_ERR("adding socket to epoll set %d", errno);
+    return -1;
+  }
+  return 0;
+}
+
+static int
+oc_udp_add_socks_to_epoll(ip_context_t *dev)
+{
+  int ret = 0;
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->server_sock, IPV6,
+                          true);
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->mcast_sock,
+                          IPV6 | MULTICAST, true);
+#ifdef OC_SECURITY
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->secure_sock,
+                          IPV6 | SECURED, true);
+#endif /* OC_SECURITY */
+
+#ifdef OC_IPV4
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->server4_sock, IPV4,
+                          true);
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->mcast4_sock,
+                          IPV4 | MULTICAST, true);
+#ifdef OC_SECURITY
+  ret += add_event_source(dev, IP_EVENT_SOURCE_UDP, dev->secure4_sock,
+                          IPV4 | SECURED, true);
+#endif /* OC_SECURITY */
+#endif /* OC_IPV4 */
   return ret;
 }
 
+static int
+init_epoll(ip_context_t *dev)
+{
+  dev->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+  if (dev->epoll_fd < 0) {
+    OC_ERR("creating epoll instance %d", errno);
+    return -1;
+  }
+  dev->num_event_sources = 0;
+
+  /* The shutdown pipe and the netlink socket are consumed one read at a
+   * time, so they stay level-triggered.
+   */
+  int ret = add_event_source(dev, IP_EVENT_SOURCE_SHUTDOWN,
+                             dev->shutdown_pipe[0], 0, false);
+  /* Monitor network interface changes on the platform from only the 0th
+   * logical device
+   */
+  if (dev->device == 0) {
+    ret += add_event_source(dev, IP_EVENT_SOURCE_IFCHANGE, ifchange_sock, 0,
+                            false);
+  }
+  ret += oc_udp_add_socks_to_epoll(dev);
+#ifdef OC_TCP
+  ret += oc_tcp_add_socks_to_epoll(dev);
+#endif /* OC_TCP */
+
+  if (ret < 0) {
+    close(dev->epoll_fd);
+    dev->epoll_fd = -1;
+  }
+  return ret;
+}
+
+static void
+print_incoming_message(oc_message_t *message)
+{
+#ifdef OC_DEBUG
+  PRINT("Incoming message of size %d bytes from ", message->length);
+  PRINTipaddr(message->endpoint);
+  PRINT("\n\n");
+#else  /* OC_DEBUG */
+  (void)message;
+#endif /* !OC_DEBUG */
+}
+
+/* Out of receive buffers: an edge-triggered socket will not be reported
+ * again for datagrams that are already queued, so drop them rather than
+ * leave the socket silent.
+ */
+static void
+drop_pending_datagrams(int sock)
+{
+  uint8_t buf[1];
+  int dropped = 0;
+  while (recv(sock, buf, sizeof(buf), MSG_DONTWAIT | MSG_TRUNC) >= 0) {
+    dropped++;
+  }
+  if (dropped > 0) {
+    OC_WRN("out of receive buffers, dropped %d datagrams", dropped);
+  }
+}
+
+/* Sockets are registered edge-triggered, so each one is drained until the
+ * kernel reports EAGAIN. Datagrams are read UDP_RECV_BATCH_SIZE at a time
+ * with recvmmsg() and each batch is handed over in one network event.
+ */
+static void
+udp_receive_messages(ip_context_t *dev, ip_event_source_t *source)
+{
+  oc_message_t *messages[UDP_RECV_BATCH_SIZE];
+  struct mmsghdr msgs[UDP_RECV_BATCH_SIZE];
+  struct iovec iovecs[UDP_RECV_BATCH_SIZE];
+  struct sockaddr_storage clients[UDP_RECV_BATCH_SIZE];
+  char msg_control[UDP_RECV_BATCH_SIZE]
+                  [CMSG_LEN(sizeof(struct sockaddr_storage))];
+  bool multicast = (source->flags & MULTICAST) != 0;
+  int i, n, count;
+
+  do {
+    for (count = 0; count < UDP_RECV_BATCH_SIZE; count++) {
+      messages[count] = oc_allocate_message();
+      if (!messages[count]) {
+        break;
+      }
+      iovecs[count].iov_base = messages[count]->data;
+      iovecs[count].iov_len = OC_PDU_SIZE;
+
+      memset(&msgs[count], 0, sizeof(struct mmsghdr));
+      msgs[count].msg_hdr.msg_name = &clients[count];
+      msgs[count].msg_hdr.msg_namelen = sizeof(struct sockaddr_storage);
+      msgs[count].msg_hdr.msg_iov = &iovecs[count];
+      msgs[count].msg_hdr.msg_iovlen = 1;
+      msgs[count].msg_hdr.msg_control = msg_control[count];
+      msgs[count].msg_hdr.msg_controllen = sizeof(msg_control[count]);
+    }
+
+    if (count == 0) {
+      drop_pending_datagrams(source->sock);
+      return;
+    }
+
+    n = recvmmsg(source->sock, msgs, (unsigned int)count, MSG_DONTWAIT, NULL);
+    if (n < 0) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        OC_ERR("recvmmsg returned with an error: %d", errno);
+      }
+      n = 0;
+    }
+
+    oc_message_t *head = NULL, *tail = NULL;
+    for (i = 0; i < count; i++) {
+      oc_message_t *message = messages[i];
+      if (i >= n) {
+        oc_message_unref(message);
+        continue;
+      }
+
+      message->endpoint.device = dev->device;
+      if (get_msg_endpoint(&msgs[i].msg_hdr, &message->endpoint, multicast) <
+          0) {
+        oc_message_unref(message);
+        continue;
+      }
+
+      message->length = msgs[i].msg_len;
+      message->endpoint.flags = source->flags;
+#ifdef OC_SECURITY
+      if (source->flags & SECURED) {
+        message->encrypted = 1;
+      }
+#endif /* OC_SECURITY */
+      print_incoming_message(message);
+
+      if (tail) {
+        tail->next = message;
+      } else {
+        head = message;
+      }
+      tail = message;
+    }
+
+    if (head) {
+      oc_network_event_list(head);
+    }
+
+    /* A short batch means the socket has been drained */
+  } while (n == count);
+}
+
+#ifdef OC_TCP
+/* Stream data cannot be dropped, so a TCP socket that could not be drained
+ * is re-armed instead. EPOLL_CTL_MOD makes epoll report it again on the
+ * next epoll_wait() if it is still readable.
+ */
+static void
+rearm_event_source(ip_context_t *dev, ip_event_source_t *source)
+{
+  struct epoll_event event;
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events = EPOLLIN | EPOLLET;
+  event.data.ptr = source;
+  if (epoll_ctl(dev->epoll_fd, EPOLL_CTL_MOD, source->sock, &event) == -1) {
+    OC_ERR("re-arming socket in epoll set %d", errno);
+  }
+}
+
+static void
+tcp_receive_messages(ip_context_t *dev, ip_event_source_t *source)
+{
+  adapter_receive_state_t state;
+  do {
+    oc_message_t *message = oc_allocate_message();
+    if (!message) {
+      rearm_event_source(dev, source);
+      return;
+    }
+
+    state = oc_tcp_receive_event(dev, source, message);
+    if (state == ADAPTER_STATUS_RECEIVE) {
+      print_incoming_message(message);
+      oc_network_event(message);
+    } else {
+      oc_message_unref(message);
+    }
+  } while (state == ADAPTER_STATUS_RECEIVE || state == ADAPTER_STATUS_ACCEPT);
+}
+#endif /* OC_TCP */
+
+static void *
+network_event_thread(void *data)
+{
+  ip_context_t *dev = (ip_context_t *)data;
+  struct epoll_event events[EPOLL_MAX_EVENTS];
+  int i, n;
+
+  while (dev->terminate != 1) {
+    n = epoll_wait(dev->epoll_fd, events, EPOLL_MAX_EVENTS, -1);
+    if (n < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      OC_ERR("epoll_wait returned with an error: %d", errno);
+      break;
+    }
+
+    for (i = 0; i < n && !dev->terminate; i++) {
+      ip_event_source_t *source = (ip_event_source_t *)events[i].data.ptr;
+      switch (source->type) {
+      case IP_EVENT_SOURCE_SHUTDOWN: {
+        char buf;
+        // write to pipe shall not block - so read the byte we wrote
+        if (read(source->sock, &buf, 1) < 0) {
+          // intentionally left blank
+        }
+      } break;
+      case IP_EVENT_SOURCE_IFCHANGE:
+        if (process_interface_change_event() < 0) {
+          OC_WRN("caught errors while handling a network interface change");
+        }
+        break;
+      case IP_EVENT_SOURCE_UDP:
+        udp_receive_messages(dev, source);
+        break;
+#ifdef OC_TCP
+      case IP_EVENT_SOURCE_TCP_LISTEN:
+      case IP_EVENT_SOURCE_TCP_SESSION:
+        tcp_receive_messages(dev, source);
+        break;
+#endif /* OC_TCP */
+      default:
+        break;
+      }
+    }
+
+#ifdef OC_TCP
+    oc_tcp_free_closed_sessions(dev);
+#endif /* OC_TCP */
+  }
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  oc_message_cache_thread_exit();
+#endif /* OC_LOCKFREE_NETWORK_EVENTS */
+  pthread_exit(NULL);
+}
+#else  /* OC_EPOLL */
 static void
 oc_udp_add_socks_to_fd_set(ip_context_t *dev)
 {
@@ -944,32 +1282,24 @@ network_event_thread(void *data)
       oc_network_event(message);
     }
   }
+#ifdef OC_LOCKFREE_NETWORK_EVENTS
+  oc_message_cache_thread_exit();
+#endif /* OC_LOCKFREE_NETWORK_EVENTS */
   pthread_exit(NULL);
 }
+#endif /* !OC_EPOLL */
 
 static int
-send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
+set_msg_pktinfo(struct msghdr *msg, oc_message_t *message)
 {
-  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
-  struct iovec iovec[1];
-  struct msghdr msg;
-
-  memset(&msg, 0, sizeof(struct msghdr));
-  msg.msg_name = (void *)receiver;
-  msg.msg_namelen = sizeof(struct sockaddr_storage);
-
-  msg.msg_iov = iovec;
-  msg.msg_iovlen = 1;
-
   if (message->endpoint.flags & IPV6) {
     struct cmsghdr *cmsg;
     struct in6_pktinfo *pktinfo;
 
-    msg.msg_control = msg_control;
-    msg.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
-    memset(msg.msg_control, 0, msg.msg_controllen);
+    msg->msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+    memset(msg->msg_control, 0, msg->msg_controllen);
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = CMSG_FIRSTHDR(msg);
     cmsg->cmsg_level = IPPROTO_IPV6;
     cmsg->cmsg_type = IPV6_PKTINFO;
     cmsg->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
@@ -989,11 +1319,10 @@ send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
     struct cmsghdr *cmsg;
     struct in_pktinfo *pktinfo;
 
-    msg.msg_control = msg_control;
-    msg.msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
-    memset(msg.msg_control, 0, msg.msg_controllen);
+    msg->msg_controllen = CMSG_SPACE(sizeof(struct in_pktinfo));
+    memset(msg->msg_control, 0, msg->msg_controllen);
 
-    cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg = CMSG_FIRSTHDR(msg);
     cmsg->cmsg_level = SOL_IP;
     cmsg->cmsg_type = IP_PKTINFO;
     cmsg->cmsg_len = CMSG_LEN(sizeof(struct in_pktinfo));
@@ -1004,6 +1333,8 @@ send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
     pktinfo->ipi_ifindex = message->endpoint.interface_index;
     memcpy(&pktinfo->ipi_spec_dst, message->endpoint.addr_local.ipv4.address,
            4);
+  } else {
+    msg->msg_controllen = 0;
   }
 #else  /* OC_IPV4 */
   else {
@@ -1011,17 +1342,77 @@ send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
     return -1;
   }
 #endif /* !OC_IPV4 */
+  return 0;
+}
+
+/* Points iovec at the bytes of message and returns the number of entries
+ * used, at most two.
+ */
+static size_t
+message_iovecs(oc_message_t *message, struct iovec *iovec)
+{
+  iovec[0].iov_base = message->data;
+  iovec[0].iov_len = message->length;
+#ifdef OC_SHARED_PAYLOADS
+  if (message->payload) {
+    iovec[1].iov_base = message->payload->data;
+    iovec[1].iov_len = message->payload->length;
+    return 2;
+  }
+#endif /* OC_SHARED_PAYLOADS */
+  return 1;
+}
+
+static size_t
+message_size(oc_message_t *message)
+{
+#ifdef OC_SHARED_PAYLOADS
+  if (message->payload) {
+    return message->length + message->payload->length;
+  }
+#endif /* OC_SHARED_PAYLOADS */
+  return message->length;
+}
+
+static int
+send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
+{
+  char msg_control[CMSG_LEN(sizeof(struct sockaddr_storage))];
+  struct iovec iovec[2];
+  struct msghdr msg;
+
+  memset(&msg, 0, sizeof(struct msghdr));
+  msg.msg_name = (void *)receiver;
+  msg.msg_namelen = sizeof(struct sockaddr_storage);
+
+  msg.msg_iov = iovec;
+  msg.msg_iovlen = message_iovecs(message, iovec);
+
+  msg.msg_control = msg_control;
+  if (set_msg_pktinfo(&msg, message) < 0) {
+    return -1;
+  }
 
   int bytes_sent = 0, x;
-  while (bytes_sent < (int)message->length) {
-    iovec[0].iov_base = message->data + bytes_sent;
-    iovec[0].iov_len = message->length - (size_t)bytes_sent;
+  if (msg.msg_iovlen > 1) {
+    /* a datagram is sent whole or not at all */
     x = sendmsg(sock, &msg, 0);
     if (x < 0) {
       OC_WRN("sendto() returned errno %d", errno);
-      break;
+    } else {
+      bytes_sent = x;
+    }
+  } else {
+    while (bytes_sent < (int)message->length) {
+      iovec[0].iov_base = message->data + bytes_sent;
+      iovec[0].iov_len = message->length - (size_t)bytes_sent;
+      x = sendmsg(sock, &msg, 0);
+      if (x < 0) {
+        OC_WRN("sendto() returned errno %d", errno);
+        break;
+      }
+      bytes_sent += x;
     }
-    bytes_sent += x;
   }
   OC_DBG("Sent %d bytes", bytes_sent);
 
@@ -1032,20 +1423,13 @@ send_msg(int sock, struct sockaddr_storage *receiver, oc_message_t *message)
   return bytes_sent;
 }
 
-int
-oc_send_buffer(oc_message_t *message)
+static void
+get_receiver(oc_message_t *message, struct sockaddr_storage *receiver)
 {
-#ifdef OC_DEBUG
-  PRINT("Outgoing message of size %d bytes to ", message->length);
-  PRINTipaddr(message->endpoint);
-  PRINT("\n\n");
-#endif /* OC_DEBUG */
-
-  struct sockaddr_storage receiver;
-  memset(&receiver, 0, sizeof(struct sockaddr_storage));
+  memset(receiver, 0, sizeof(struct sockaddr_storage));
 #ifdef OC_IPV4
   if (message->endpoint.flags & IPV4) {
-    struct sockaddr_in *r = (struct sockaddr_in *)&receiver;
+    struct sockaddr_in *r = (struct sockaddr_in *)receiver;
     memcpy(&r->sin_addr.s_addr, message->endpoint.addr.ipv4.address,
            sizeof(r->sin_addr.s_addr));
     r->sin_family = AF_INET;
@@ -1054,23 +1438,19 @@ oc_send_buffer(oc_message_t *message)
 #else
   {
 #endif
-    struct sockaddr_in6 *r = (struct sockaddr_in6 *)&receiver;
+    struct sockaddr_in6 *r = (struct sockaddr_in6 *)receiver;
     memcpy(r->sin6_addr.s6_addr, message->endpoint.addr.ipv6.address,
            sizeof(r->sin6_addr.s6_addr));
     r->sin6_family = AF_INET6;
     r->sin6_port = htons(message->endpoint.addr.ipv6.port);
     r->sin6_scope_id = message->endpoint.addr.ipv6.scope;
   }
-  int send_sock = -1;
-
-  ip_context_t *dev = get_ip_context_for_device(message->endpoint.device);
-
-#ifdef OC_TCP
-  if (message->endpoint.flags & TCP) {
-    return oc_tcp_send_buffer(dev, message, &receiver);
-  }
-#endif /* OC_TCP */
+}
 
+static int
+get_udp_send_sock(ip_context_t *dev, oc_message_t *message)
+{
+  int send_sock = -1;
 #ifdef OC_SECURITY
   if (message->endpoint.flags & SECURED) {
 #ifdef OC_IPV4
@@ -1092,12 +1472,266 @@ oc_send_buffer(oc_message_t *message)
   }
 #else  /* OC_IPV4 */
   {
+    (void)message;
     send_sock = dev->server_sock;
   }
 #endif /* !OC_IPV4 */
+  return send_sock;
+}
+
+int
+oc_send_buffer(oc_message_t *message)
+{
+#ifdef OC_DEBUG
+  PRINT("Outgoing message of size %d bytes to ", message->length);
+  PRINTipaddr(message->endpoint);
+  PRINT("\n\n");
+#endif /* OC_DEBUG */
+
+  struct sockaddr_storage receiver;
+  get_receiver(message, &receiver);
+
+  ip_context_t *dev = get_ip_context_for_device(message->endpoint.device);
+
+#ifdef OC_TCP
+  if (message->endpoint.flags & TCP) {
+    return oc_tcp_send_buffer(dev, message, &receiver);
+  }
+#endif /* OC_TCP */
+
+  return send_msg(get_udp_send_sock(dev, message), &receiver, message);
+}
+
+#ifdef OC_SEND_BATCHING
+/* Messages queued by oc_send_buffer_batched() are flushed once this many
+ * are pending, bounding both the queue and a single sendmmsg() call.
+ */
+#ifndef UDP_SEND_BATCH_SIZE
+#define UDP_SEND_BATCH_SIZE (32)
+#endif /* !UDP_SEND_BATCH_SIZE */
+
+#ifdef UDP_SEGMENT
+/* Kernel limit on the number of segments in one UDP GSO send */
+#define UDP_GSO_MAX_SEGMENTS (64)
+#define UDP_GSO_MAX_BYTES (65000)
+static bool udp_gso_disabled;
+
+/* Errors with which the kernel or device turns down UDP GSO as such, as
+ * opposed to EINVAL for a buffer it cannot segment, e.g. one with segments
+ * larger than the MTU.
+ */
+static bool
+is_gso_unsupported(int err)
+{
+  return err == EIO || err == ENOPROTOOPT || err == EOPNOTSUPP;
+}
+#endif /* UDP_SEGMENT */
+
+typedef struct
+{
+  oc_message_t *message;
+  int sock;
+  struct sockaddr_storage receiver;
+} udp_send_entry_t;
+
+static udp_send_entry_t send_queue[UDP_SEND_BATCH_SIZE];
+static size_t send_queue_len;
+static oc_send_batch_stats_t send_stats;
 
-  return send_msg(send_sock, &receiver, message);
+#ifdef UDP_SEGMENT
+/* Consecutive datagrams to the same destination over the same local
+ * address and interface may be handed to the kernel as one GSO buffer if
+ * all but the last are of equal size.
+ */
+static bool
+can_segment(udp_send_entry_t *first, udp_send_entry_t *next)
+{
+  oc_endpoint_t *a = &first->message->endpoint, *b = &next->message->endpoint;
+  return first->sock == next->sock &&
+         memcmp(&first->receiver, &next->receiver,
+                sizeof(struct sockaddr_storage)) == 0 &&
+         a->interface_index == b->interface_index &&
+         memcmp(&a->addr_local, &b->addr_local, sizeof(a->addr_local)) == 0 &&
+         message_size(next->message) <= message_size(first->message);
+}
+
+static void
+add_msg_segment_size(struct msghdr *msg, uint16_t segment_size)
+{
+  struct cmsghdr *cmsg =
+    (struct cmsghdr *)((uint8_t *)msg->msg_control + msg->msg_controllen);
+  msg->msg_controllen += CMSG_SPACE(sizeof(uint16_t));
+  memset(cmsg, 0, CMSG_SPACE(sizeof(uint16_t)));
+  cmsg->cmsg_level = SOL_UDP;
+  cmsg->cmsg_type = UDP_SEGMENT;
+  cmsg->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+  memcpy(CMSG_DATA(cmsg), &segment_size, sizeof(uint16_t));
 }
+#endif /* UDP_SEGMENT */
+
+/* Sends the queued entries [0, count) that share one socket, with as few
+ * sendmmsg() calls as possible. Datagrams are coalesced with UDP GSO only
+ * if segment is true.
+ */
+static void
+send_queue_run(udp_send_entry_t *entries, size_t count, bool segment)
+{
+  struct mmsghdr msgs[UDP_SEND_BATCH_SIZE];
+  struct iovec iovecs[2 * UDP_SEND_BATCH_SIZE];
+  size_t first_entry[UDP_SEND_BATCH_SIZE];
+  uint32_t num_datagrams[UDP_SEND_BATCH_SIZE];
+  char msg_control[UDP_SEND_BATCH_SIZE]
+                  [CMSG_LEN(sizeof(struct sockaddr_storage))];
+  size_t i = 0, num_msgs = 0, num_iovecs = 0;
+
+  while (i < count) {
+    struct msghdr *msg = &msgs[num_msgs].msg_hdr;
+    memset(&msgs[num_msgs], 0, sizeof(struct mmsghdr));
+    msg->msg_name = &entries[i].receiver;
+    msg->msg_namelen = sizeof(struct sockaddr_storage);
+    msg->msg_control = msg_control[num_msgs];
+    if (set_msg_pktinfo(msg, entries[i].message) < 0) {
+      i++;
+      continue;
+    }
+    first_entry[num_msgs] = i;
+    num_datagrams[num_msgs] = 1;
+
+    msg->msg_iov = &iovecs[num_iovecs];
+    msg->msg_iovlen = message_iovecs(entries[i].message, &iovecs[num_iovecs]);
+    num_iovecs += msg->msg_iovlen;
+    size_t segment_size = message_size(entries[i].message),
+           last_size = segment_size, total = segment_size;
+    i++;
+
+#ifdef UDP_SEGMENT
+    if (segment && !udp_gso_disabled) {
+      while (i < count && num_datagrams[num_msgs] < UDP_GSO_MAX_SEGMENTS &&
+             last_size == segment_size &&
+             total + message_size(entries[i].message) <= UDP_GSO_MAX_BYTES &&
+             can_segment(&entries[first_entry[num_msgs]], &entries[i])) {
+        size_t n = message_iovecs(entries[i].message, &iovecs[num_iovecs]);
+        num_iovecs += n;
+        msg->msg_iovlen += n;
+        last_size = message_size(entries[i].message);
+        total += last_size;
+        num_datagrams[num_msgs]++;
+        i++;
+      }
+      if (num_datagrams[num_msgs] > 1) {
+        add_msg_segment_size(msg, (uint16_t)segment_size);
+      }
+    }
+#else  /* UDP_SEGMENT */
+    (void)segment;
+#endif /* !UDP_SEGMENT */
+    num_msgs++;
+  }
+
+  size_t sent = 0;
+  while (sent < num_msgs) {
+    int ret = sendmmsg(entries[first_entry[sent]].sock, &msgs[sent],
+                       (unsigned int)(num_msgs - sent), 0);
+    send_stats.syscalls++;
+    if (ret < 0) {
+#ifdef UDP_SEGMENT
+      /* The rest of this run is sent without GSO. Only errors that rule out
+       * GSO altogether turn it off for later runs.
+       */
+      if (num_datagrams[sent] > 1 &&
+          (errno == EINVAL || is_gso_unsupported(errno))) {
+        if (is_gso_unsupported(errno)) {
+          OC_WRN("UDP GSO unavailable (%d), sending datagrams individually",
+                 errno);
+          udp_gso_disabled = true;
+        } else {
+          OC_WRN("UDP GSO send rejected (%d), sending batch individually",
+                 errno);
+        }
+        send_queue_run(&entries[first_entry[sent]], count - first_entry[sent],
+                       false);
+        return;
+      }
+#endif /* UDP_SEGMENT */
+      OC_WRN("sendmmsg() returned errno %d", errno);
+      ret = 1;
+    } else {
+      size_t j;
+      for (j = sent; j < sent + (size_t)ret; j++) {
+        send_stats.messages += num_datagrams[j];
+        if (num_datagrams[j] > 1) {
+          send_stats.segmented += num_datagrams[j];
+        }
+      }
+    }
+    sent += (size_t)ret;
+  }
+}
+
+void
+oc_send_buffer_flush(void)
+{
+  if (send_queue_len == 0) {
+    return;
+  }
+  send_stats.flushes++;
+
+  size_t i = 0, j;
+  while (i < send_queue_len) {
+    for (j = i + 1; j < send_queue_len && send_queue[j].sock == send_queue[i].sock;
+         j++)
+      ;
+    send_queue_run(&send_queue[i], j - i, true);
+    i = j;
+  }
+
+  for (i = 0; i < send_queue_len; i++) {
+    oc_message_unref(send_queue[i].message);
+  }
+  send_queue_len = 0;
+}
+
+int
+oc_send_buffer_batched(oc_message_t *message)
+{
+#ifdef OC_TCP
+  if (message->endpoint.flags & TCP) {
+    return oc_send_buffer(message);
+  }
+#endif /* OC_TCP */
+
+#ifdef OC_DEBUG
+  PRINT("Queued outgoing message of size %d bytes to ", message->length);
+  PRINTipaddr(message->endpoint);
+  PRINT("\n\n");
+#endif /* OC_DEBUG */
+
+  ip_context_t *dev = get_ip_context_for_device(message->endpoint.device);
+  if (!dev) {
+    return -1;
+  }
+
+  udp_send_entry_t *entry = &send_queue[send_queue_len++];
+  oc_message_add_ref(message);
+  entry->message = message;
+  entry->sock = get_udp_send_sock(dev, message);
+  get_receiver(message, &entry->receiver);
+
+  if (send_queue_len == UDP_SEND_BATCH_SIZE) {
+    oc_send_buffer_flush();
+  }
+
+  return (int)message->length;
+}
+
+void
+oc_send_buffer_batch_stats(oc_send_batch_stats_t *stats)
+{
+  if (stats) {
+    memcpy(stats, &send_stats, sizeof(oc_send_batch_stats_t));
+  }
+}
+#endif /* OC_SEND_BATCHING */
 
 #ifdef OC_CLIENT
 void
@@ -1564,9 +2198,20 @@ int oc_connectivity_init(size_t device) {
     ifchange_initialized = true;
   }
 
+#ifdef OC_EPOLL
+  if (init_epoll(dev) < 0) {
+    OC_ERR("setting up epoll for the network event thread");
+    return -1;
+  }
+#endif /* OC_EPOLL */
+
   if (pthread_create(&dev->event_thread, NULL, &network_event_thread, dev) !=
       0) {
     OC_ERR("creating network polling thread");
+#ifdef OC_EPOLL
+    close(dev->epoll_fd);
+    dev->epoll_fd = -1;
+#endif /* OC_EPOLL */
     return -1;
   }
 
@@ -1605,6 +2250,9 @@ oc_connectivity_shutdown(size_t device)
 
   pthread_join(dev->event_thread, NULL);
 
+#ifdef OC_EPOLL
+  close(dev->epoll_fd);
+#endif /* OC_EPOLL */
   close(dev->shutdown_pipe[1]);
   close(dev->shutdown_pipe[0]);
 
@@ -37,6 +37,33 @@ typedef enum {
   ADAPTER_STATUS_ERROR     /* Error */
 } adapter_receive_state_t;
 
+#ifdef OC_EPOLL
+typedef enum {
+  IP_EVENT_SOURCE_SHUTDOWN = 0, /* Shutdown pipe of the network thread */
+  IP_EVENT_SOURCE_IFCHANGE,     /* Netlink socket for interface changes */
+  IP_EVENT_SOURCE_UDP,          /* UDP unicast/multicast/secure socket */
+  IP_EVENT_SOURCE_TCP_LISTEN,   /* TCP listening socket */
+  IP_EVENT_SOURCE_TCP_SESSION   /* Connected TCP session socket */
+} ip_event_source_type_t;
+
+/* Registered as the epoll data pointer of every monitored socket so that
+ * the network event thread can dispatch straight to its owner.
+ */
+typedef struct ip_event_source_t
+{
+  ip_event_source_type_t type;
+  int sock;
+  enum transport_flags flags;
+  void *data;
+} ip_event_source_t;
+
+/* Maximum number of sockets owned by an ip_context_t (not counting TCP
+ * sessions): shutdown pipe, netlink and the three UDP sockets for each of
+ * IPv6 and IPv4.
+ */
+#define IP_MAX_EVENT_SOURCES (8)
+#endif /* OC_EPOLL */
+
 #ifdef OC_TCP
 typedef struct tcp_context_t
 {
@@ -60,6 +87,10 @@ typedef struct tcp_context_t
 #endif /* OC_IPV4 */
   int connect_pipe[2];
   pthread_mutex_t mutex;
+#ifdef OC_EPOLL
+  ip_event_source_t listen_sources[4];
+  int num_listen_sources;
+#endif /* OC_EPOLL */
 } tcp_context_t;
 #endif
 
@@ -94,7 +125,13 @@ typedef struct ip_context_t {
   pthread_t event_thread;
   int terminate;
   size_t device;
+#ifdef OC_EPOLL
+  int epoll_fd;
+  ip_event_source_t event_sources[IP_MAX_EVENT_SOURCES];
+  int num_event_sources;
+#else  /* OC_EPOLL */
   fd_set rfds;
+#endif /* !OC_EPOLL */
   int shutdown_pipe[2];
 } ip_context_t;
 
@@ -24,6 +24,48 @@ typedef uint64_t oc_clock_time_t;
 /* Add support for passing TCP/TLS/DTLS session connection events to the app */
 #define OC_SESSION_EVENTS
 
+/* Coalesce outgoing UDP messages and send them with sendmmsg() */
+#define OC_SEND_BATCHING
+
+/* Hand inbound messages to the event loop through a lock-free queue and
+   recycle receive buffers through per-thread caches */
+#define OC_LOCKFREE_NETWORK_EVENTS
+
+/* Dispatch requests through a hash index of resource URIs */
+#define OC_URI_INDEX
+
+/* Match responses to client callbacks through hash indexes */
+#define OC_CLIENT_CB_INDEX
+
+/* Look up (D)TLS peers through a hash table keyed on their endpoint */
+#define OC_TLS_PEER_INDEX
+
+/* Keep event timers in a hierarchical timing wheel */
+#define OC_ETIMER_WHEEL
+
+/* Remember access control decisions per peer and index ACEs by subject */
+#define OC_ACL_CACHE
+
+/* Compare property names of parsed representations by hash first */
+#define OC_REP_KEY_INDEX
+
+/* Queue events by class and drain every class within a time budget on each
+   oc_process_run() */
+#define OC_PROCESS_PRIORITIES
+
+/* Storage class for per-thread state */
+#define OC_THREAD_LOCAL __thread
+
+#if defined(OC_WORKER_THREADS) && !defined(OC_DYNAMIC_ALLOCATION)
+#error "OC_WORKER_THREADS requires OC_DYNAMIC_ALLOCATION"
+#endif /* OC_WORKER_THREADS && !OC_DYNAMIC_ALLOCATION */
+#if defined(OC_REQUEST_ARENA) && !defined(OC_REP_ARENA)
+#error "OC_REQUEST_ARENA requires OC_REP_ARENA"
+#endif /* OC_REQUEST_ARENA && !OC_REP_ARENA */
+#if defined(OC_TLS_HANDSHAKE_OFFLOAD) && !defined(OC_WORKER_THREADS)
+#error "OC_TLS_HANDSHAKE_OFFLOAD requires OC_WORKER_THREADS"
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD && !OC_WORKER_THREADS */
+
 /* Add support for dns lookup to the endpoint */
 #define OC_DNS_LOOKUP
 #define OC_DNS_LOOKUP_IPV6
@@ -33,6 +75,21 @@ typedef uint64_t oc_clock_time_t;
 #define OC_COLLECTIONS
 #define OC_BLOCK_WISE
 
+/* Encode observe notifications once and send the payload from a buffer
+   shared by all observers */
+#define OC_SHARED_PAYLOADS
+
+/* Keep encoded /oic/res responses and answer repeated discovery requests
+   from them */
+#define OC_DISCOVERY_CACHE
+
+/* Parse request and response payloads into an arena that is freed at once */
+#define OC_REP_ARENA
+
+/* Carve the parsed payload and the block-wise buffers of each request out of
+   an arena that is reset once the request has been answered */
+#define OC_REQUEST_ARENA
+
 #else /* OC_DYNAMIC_ALLOCATION */
 /* List of constraints below for a build that does not employ dynamic
    memory allocation
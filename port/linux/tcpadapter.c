@@ -31,8 +31,12 @@
 #include <fcntl.h>
 #include <ifaddrs.h>
 #include <net/if.h>
+#include <poll.h>
 #include <stdlib.h>
 #include <unistd.h>
+#ifdef OC_EPOLL
+#include <sys/epoll.h>
+#endif /* OC_EPOLL */
 
 #ifdef OC_TCP
 
@@ -54,11 +58,36 @@ typedef struct tcp_session
   oc_endpoint_t endpoint;
   int sock;
   tcp_csm_state_t csm_state;
+#ifdef OC_EPOLL
+  ip_event_source_t source;
+#endif /* OC_EPOLL */
 } tcp_session_t;
 
 OC_LIST(session_list);
 OC_MEMB(tcp_session_s, tcp_session_t, OC_MAX_TCP_PEERS);
 
+#ifdef OC_EPOLL
+/* Sessions closed while an epoll_wait() batch could still refer to them.
+ * They are released by the network event thread once it is done with the
+ * batch, see oc_tcp_free_closed_sessions().
+ */
+OC_LIST(closed_session_list);
+
+static int
+add_source_to_epoll(ip_context_t *dev, ip_event_source_t *source)
+{
+  struct epoll_event event;
+  memset(&event, 0, sizeof(struct epoll_event));
+  event.events = EPOLLIN | EPOLLET;
+  event.data.ptr = source;
+  if (epoll_ctl(dev->epoll_fd, EPOLL_CTL_ADD, source->sock, &event) == -1) {
+    OC_ERR("adding socket to epoll set %d", errno);
+    return -1;
+  }
+  return 0;
+}
+#endif /* OC_EPOLL */
+
 static int
 configure_tcp_socket(int sock, struct sockaddr_storage *sock_info)
 {
@@ -139,6 +168,52 @@ get_interface_index(int sock)
   return interface_index;
 }
 
+#ifdef OC_EPOLL
+static int
+add_listen_sock_to_epoll(ip_context_t *dev, int sock, enum transport_flags flags)
+{
+  /* Accepted sockets do not inherit O_NONBLOCK, only the listening socket
+   * needs it so that accept() can be drained until EAGAIN.
+   */
+  int fl = fcntl(sock, F_GETFL, 0);
+  if (fl < 0 || fcntl(sock, F_SETFL, fl | O_NONBLOCK) < 0) {
+    OC_ERR("setting listening socket to non-blocking %d", errno);
+    return -1;
+  }
+
+  ip_event_source_t *source =
+    &dev->tcp.listen_sources[dev->tcp.num_listen_sources++];
+  source->type = IP_EVENT_SOURCE_TCP_LISTEN;
+  source->sock = sock;
+  source->flags = flags;
+  source->data = NULL;
+
+  return add_source_to_epoll(dev, source);
+}
+
+int
+oc_tcp_add_socks_to_epoll(ip_context_t *dev)
+{
+  int ret = 0;
+  dev->tcp.num_listen_sources = 0;
+
+  ret += add_listen_sock_to_epoll(dev, dev->tcp.server_sock, IPV6 | TCP);
+#ifdef OC_SECURITY
+  ret += add_listen_sock_to_epoll(dev, dev->tcp.secure_sock,
+                                  IPV6 | SECURED | TCP);
+#endif /* OC_SECURITY */
+
+#ifdef OC_IPV4
+  ret += add_listen_sock_to_epoll(dev, dev->tcp.server4_sock, IPV4 | TCP);
+#ifdef OC_SECURITY
+  ret += add_listen_sock_to_epoll(dev, dev->tcp.secure4_sock,
+                                  IPV4 | SECURED | TCP);
+#endif /* OC_SECURITY */
+#endif /* OC_IPV4 */
+
+  return ret;
+}
+#else  /* OC_EPOLL */
 void
 oc_tcp_add_socks_to_fd_set(ip_context_t *dev)
 {
@@ -155,12 +230,21 @@ oc_tcp_add_socks_to_fd_set(ip_context_t *dev)
 #endif /* OC_IPV4 */
   FD_SET(dev->tcp.connect_pipe[0], &dev->rfds);
 }
+#endif /* !OC_EPOLL */
 
 static void
 free_tcp_session(tcp_session_t *session)
 {
   oc_session_end_event(&session->endpoint);
 
+#ifdef OC_EPOLL
+  epoll_ctl(session->dev->epoll_fd, EPOLL_CTL_DEL, session->sock, NULL);
+  close(session->sock);
+  session->sock = -1;
+
+  oc_list_remove(session_list, session);
+  oc_list_add(closed_session_list, session);
+#else  /* OC_EPOLL */
   FD_CLR(session->sock, &session->dev->rfds);
 
   ssize_t len = 0;
@@ -173,10 +257,30 @@ free_tcp_session(tcp_session_t *session)
 
   oc_list_remove(session_list, session);
   oc_memb_free(&tcp_session_s, session);
+#endif /* !OC_EPOLL */
 
   OC_DBG("freed TCP session");
 }
 
+#ifdef OC_EPOLL
+void
+oc_tcp_free_closed_sessions(ip_context_t *dev)
+{
+  pthread_mutex_lock(&dev->tcp.mutex);
+  tcp_session_t *session = (tcp_session_t *)oc_list_head(closed_session_list),
+                *next;
+  while (session != NULL) {
+    next = session->next;
+    if (session->dev == dev) {
+      oc_list_remove(closed_session_list, session);
+      oc_memb_free(&tcp_session_s, session);
+    }
+    session = next;
+  }
+  pthread_mutex_unlock(&dev->tcp.mutex);
+}
+#endif /* OC_EPOLL */
+
 static int
 add_new_session(int sock, ip_context_t *dev, oc_endpoint_t *endpoint,
                 tcp_csm_state_t state)
@@ -195,6 +299,17 @@ add_new_session(int sock, ip_context_t *dev, oc_endpoint_t *endpoint,
   session->sock = sock;
   session->csm_state = state;
 
+#ifdef OC_EPOLL
+  session->source.type = IP_EVENT_SOURCE_TCP_SESSION;
+  session->source.sock = sock;
+  session->source.flags = endpoint->flags;
+  session->source.data = session;
+  if (add_source_to_epoll(dev, &session->source) < 0) {
+    oc_memb_free(&tcp_session_s, session);
+    return -1;
+  }
+#endif /* OC_EPOLL */
+
   oc_list_add(session_list, session);
 
   if (!(endpoint->flags & SECURED)) {
@@ -207,15 +322,16 @@ add_new_session(int sock, ip_context_t *dev, oc_endpoint_t *endpoint,
 }
 
 static int
-accept_new_session(ip_context_t *dev, int fd, fd_set *setfds,
-                   oc_endpoint_t *endpoint)
+accept_new_session(ip_context_t *dev, int fd, oc_endpoint_t *endpoint)
 {
   struct sockaddr_storage receive_from;
   socklen_t receive_len = sizeof(receive_from);
 
   int new_socket = accept(fd, (struct sockaddr *)&receive_from, &receive_len);
   if (new_socket < 0) {
-    OC_ERR("failed to accept incoming TCP connection");
+    if (errno != EAGAIN && errno != EWOULDBLOCK) {
+      OC_ERR("failed to accept incoming TCP connection");
+    }
     return -1;
   }
   OC_DBG("accepted incomming TCP connection");
@@ -235,15 +351,15 @@ accept_new_session(ip_context_t *dev, int fd, fd_set *setfds,
 #endif /* !OC_IPV4 */
   }
 
-  FD_CLR(fd, setfds);
-
   if (add_new_session(new_socket, dev, endpoint, CSM_NONE) < 0) {
     OC_ERR("could not record new TCP session");
     close(new_socket);
     return -1;
   }
 
+#ifndef OC_EPOLL
   FD_SET(new_socket, &dev->rfds);
+#endif /* !OC_EPOLL */
 
   return 0;
 }
@@ -273,6 +389,7 @@ find_session_by_endpoint(oc_endpoint_t *endpoint)
   return session;
 }
 
+#ifndef OC_EPOLL
 static tcp_session_t *
 get_ready_to_read_session(fd_set *setfds)
 {
@@ -287,6 +404,7 @@ get_ready_to_read_session(fd_set *setfds)
   }
   return session;
 }
+#endif /* !OC_EPOLL */
 
 static size_t
 get_total_length_from_header(oc_message_t *message, oc_endpoint_t *endpoint)
@@ -303,6 +421,98 @@ get_total_length_from_header(oc_message_t *message, oc_endpoint_t *endpoint)
   return total_length;
 }
 
+/* Reads one complete message off the session socket. recv_flags apply only
+ * to the first read of the message, so MSG_DONTWAIT reports an empty socket
+ * as ADAPTER_STATUS_NONE while the rest of a partially received message is
+ * still read to completion.
+ */
+static adapter_receive_state_t
+receive_session_message(tcp_session_t *session, oc_message_t *message,
+                        int recv_flags)
+{
+  size_t total_length = 0;
+  size_t want_read = DEFAULT_RECEIVE_SIZE;
+  message->length = 0;
+  do {
+    int count = recv(session->sock, message->data + message->length, want_read,
+                     message->length == 0 ? recv_flags : 0);
+    if (count < 0) {
+      if (message->length == 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+        return ADAPTER_STATUS_NONE;
+      }
+      OC_ERR("recv error! %d", errno);
+
+      free_tcp_session(session);
+
+      return ADAPTER_STATUS_ERROR;
+    } else if (count == 0) {
+      OC_DBG("peer closed TCP session\n");
+
+      free_tcp_session(session);
+
+      return ADAPTER_STATUS_NONE;
+    }
+
+    OC_DBG("recv(): %d bytes.", count);
+    message->length += (size_t)count;
+    want_read -= (size_t)count;
+
+    if (total_length == 0) {
+      total_length = get_total_length_from_header(message, &session->endpoint);
+      if (total_length >
+          (unsigned)(OC_MAX_APP_DATA_SIZE + COAP_MAX_HEADER_SIZE)) {
+        OC_ERR("total receive length(%ld) is bigger than max pdu size(%ld)",
+               total_length, (OC_MAX_APP_DATA_SIZE + COAP_MAX_HEADER_SIZE));
+        OC_ERR("It may occur buffer overflow.");
+        /* The rest of the message is never read, and the stream cannot be
+         * resynchronized, so the session is closed.
+         */
+        free_tcp_session(session);
+        return ADAPTER_STATUS_ERROR;
+      }
+      OC_DBG("tcp packet total length : %ld bytes.", total_length);
+
+      want_read = total_length - (size_t)count;
+    }
+  } while (total_length > message->length);
+
+  memcpy(&message->endpoint, &session->endpoint, sizeof(oc_endpoint_t));
+#ifdef OC_SECURITY
+  if (message->endpoint.flags & SECURED) {
+    message->encrypted = 1;
+  }
+#endif /* OC_SECURITY */
+
+  return ADAPTER_STATUS_RECEIVE;
+}
+
+#ifdef OC_EPOLL
+adapter_receive_state_t
+oc_tcp_receive_event(ip_context_t *dev, ip_event_source_t *source,
+                     oc_message_t *message)
+{
+  adapter_receive_state_t ret = ADAPTER_STATUS_NONE;
+
+  pthread_mutex_lock(&dev->tcp.mutex);
+  message->endpoint.device = dev->device;
+
+  if (source->type == IP_EVENT_SOURCE_TCP_LISTEN) {
+    message->endpoint.flags = source->flags;
+    if (accept_new_session(dev, source->sock, &message->endpoint) == 0) {
+      ret = ADAPTER_STATUS_ACCEPT;
+    }
+  } else if (source->type == IP_EVENT_SOURCE_TCP_SESSION) {
+    tcp_session_t *session = (tcp_session_t *)source->data;
+    /* The session may have been closed after epoll_wait() returned */
+    if (session->sock >= 0) {
+      ret = receive_session_message(session, message, MSG_DONTWAIT);
+    }
+  }
+
+  pthread_mutex_unlock(&dev->tcp.mutex);
+  return ret;
+}
+#else  /* OC_EPOLL */
 adapter_receive_state_t
 oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
 {
@@ -317,7 +527,8 @@ oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
 
   if (FD_ISSET(dev->tcp.server_sock, fds)) {
     message->endpoint.flags = IPV6 | TCP;
-    if (accept_new_session(dev, dev->tcp.server_sock, fds, &message->endpoint) <
+    FD_CLR(dev->tcp.server_sock, fds);
+    if (accept_new_session(dev, dev->tcp.server_sock, &message->endpoint) <
         0) {
       OC_ERR("accept new session fail");
       ret_with_code(ADAPTER_STATUS_ERROR);
@@ -326,7 +537,8 @@ oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
 #ifdef OC_SECURITY
   } else if (FD_ISSET(dev->tcp.secure_sock, fds)) {
     message->endpoint.flags = IPV6 | SECURED | TCP;
-    if (accept_new_session(dev, dev->tcp.secure_sock, fds, &message->endpoint) <
+    FD_CLR(dev->tcp.secure_sock, fds);
+    if (accept_new_session(dev, dev->tcp.secure_sock, &message->endpoint) <
         0) {
       OC_ERR("accept new session fail");
       ret_with_code(ADAPTER_STATUS_ERROR);
@@ -336,8 +548,9 @@ oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
 #ifdef OC_IPV4
   } else if (FD_ISSET(dev->tcp.server4_sock, fds)) {
     message->endpoint.flags = IPV4 | TCP;
-    if (accept_new_session(dev, dev->tcp.server4_sock, fds,
-                           &message->endpoint) < 0) {
+    FD_CLR(dev->tcp.server4_sock, fds);
+    if (accept_new_session(dev, dev->tcp.server4_sock, &message->endpoint) <
+        0) {
       OC_ERR("accept new session fail");
       ret_with_code(ADAPTER_STATUS_ERROR);
     }
@@ -345,8 +558,9 @@ oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
 #ifdef OC_SECURITY
   } else if (FD_ISSET(dev->tcp.secure4_sock, fds)) {
     message->endpoint.flags = IPV4 | SECURED | TCP;
-    if (accept_new_session(dev, dev->tcp.secure4_sock, fds,
-                           &message->endpoint) < 0) {
+    FD_CLR(dev->tcp.secure4_sock, fds);
+    if (accept_new_session(dev, dev->tcp.secure4_sock, &message->endpoint) <
+        0) {
       OC_ERR("accept new session fail");
       ret_with_code(ADAPTER_STATUS_ERROR);
     }
@@ -370,61 +584,17 @@ oc_tcp_receive_message(ip_context_t *dev, fd_set *fds, oc_message_t *message)
     ret_with_code(ADAPTER_STATUS_NONE);
   }
 
-  // receive message.
-  size_t total_length = 0;
-  size_t want_read = DEFAULT_RECEIVE_SIZE;
-  message->length = 0;
-  do {
-    int count =
-      recv(session->sock, message->data + message->length, want_read, 0);
-    if (count < 0) {
-      OC_ERR("recv error! %d", errno);
-
-      free_tcp_session(session);
-
-      ret_with_code(ADAPTER_STATUS_ERROR);
-    } else if (count == 0) {
-      OC_DBG("peer closed TCP session\n");
-
-      free_tcp_session(session);
-
-      ret_with_code(ADAPTER_STATUS_NONE);
-    }
-
-    OC_DBG("recv(): %d bytes.", count);
-    message->length += (size_t)count;
-    want_read -= (size_t)count;
-
-    if (total_length == 0) {
-      total_length = get_total_length_from_header(message, &session->endpoint);
-      if (total_length >
-          (unsigned)(OC_MAX_APP_DATA_SIZE + COAP_MAX_HEADER_SIZE)) {
-        OC_ERR("total receive length(%ld) is bigger than max pdu size(%ld)",
-               total_length, (OC_MAX_APP_DATA_SIZE + COAP_MAX_HEADER_SIZE));
-        OC_ERR("It may occur buffer overflow.");
-        ret_with_code(ADAPTER_STATUS_ERROR);
-      }
-      OC_DBG("tcp packet total length : %ld bytes.", total_length);
-
-      want_read = total_length - (size_t)count;
-    }
-  } while (total_length > message->length);
-
-  memcpy(&message->endpoint, &session->endpoint, sizeof(oc_endpoint_t));
-#ifdef OC_SECURITY
-  if (message->endpoint.flags & SECURED) {
-    message->encrypted = 1;
-  }
-#endif /* OC_SECURITY */
-
   FD_CLR(session->sock, fds);
-  ret = ADAPTER_STATUS_RECEIVE;
+
+  // receive message.
+  ret = receive_session_message(session, message, 0);
 
 oc_tcp_receive_message_done:
   pthread_mutex_unlock(&dev->tcp.mutex);
 #undef ret_with_code
   return ret;
 }
+#endif /* !OC_EPOLL */
 
 void
 oc_tcp_end_session(ip_context_t *dev, oc_endpoint_t *endpoint)
@@ -455,8 +625,7 @@ connect_nonb(int sockfd, const struct sockaddr *r, int r_len, int nsec)
 {
   int flags, n, error;
   socklen_t len;
-  fd_set rset, wset;
-  struct timeval tval;
+  struct pollfd pfd;
 
   flags = fcntl(sockfd, F_GETFL, 0);
   if (flags < 0) {
@@ -479,19 +648,20 @@ connect_nonb(int sockfd, const struct sockaddr *r, int r_len, int nsec)
     goto done; /* connect completed immediately */
   }
 
-  FD_ZERO(&rset);
-  FD_SET(sockfd, &rset);
-  wset = rset;
-  tval.tv_sec = nsec;
-  tval.tv_usec = 0;
+  /* poll() rather than select() as session sockets are not bounded by
+   * FD_SETSIZE.
+   */
+  pfd.fd = sockfd;
+  pfd.events = POLLIN | POLLOUT;
+  pfd.revents = 0;
 
-  if ((n = select(sockfd + 1, &rset, &wset, NULL, nsec ? &tval : NULL)) == 0) {
+  if ((n = poll(&pfd, 1, nsec ? nsec * 1000 : -1)) == 0) {
     /* timeout */
     errno = ETIMEDOUT;
     return -1;
   }
 
-  if (FD_ISSET(sockfd, &rset) || FD_ISSET(sockfd, &wset)) {
+  if (n > 0 && pfd.revents) {
     len = sizeof(error);
     if (getsockopt(sockfd, SOL_SOCKET, SO_ERROR, &error, &len) < 0)
       return -1; /* Solaris pending error */
@@ -560,6 +730,7 @@ initiate_new_session(ip_context_t *dev, oc_endpoint_t *endpoint,
     return -1;
   }
 
+#ifndef OC_EPOLL
   FD_SET(sock, &dev->rfds);
 
   ssize_t len = 0;
@@ -569,6 +740,7 @@ initiate_new_session(ip_context_t *dev, oc_endpoint_t *endpoint,
   } while (len == -1 && errno == EINTR);
 
   OC_DBG("signaled network event thread to monitor the newly added session\n");
+#endif /* !OC_EPOLL */
 
   return sock;
 }
@@ -794,6 +966,10 @@ oc_tcp_connectivity_shutdown(ip_context_t *dev)
     session = next;
   }
 
+#ifdef OC_EPOLL
+  oc_tcp_free_closed_sessions(dev);
+#endif /* OC_EPOLL */
+
   pthread_mutex_destroy(&dev->tcp.mutex);
 
   OC_DBG("oc_tcp_connectivity_shutdown for device %d", dev->device);
@@ -0,0 +1,225 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#define _GNU_SOURCE
+#include "oc_config.h"
+
+#ifdef OC_WORKER_THREADS
+#include "oc_buffer.h"
+#include "port/oc_log.h"
+#include "port/oc_worker_pool.h"
+#include "util/oc_list.h"
+#include <pthread.h>
+
+#if OC_WORKER_THREADS < 1
+#error "OC_WORKER_THREADS must be at least 1"
+#endif /* OC_WORKER_THREADS < 1 */
+
+typedef struct
+{
+  pthread_t thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t cv;
+  OC_LIST_STRUCT(queue);
+  OC_LIST_STRUCT(jobs);
+  bool terminate;
+} oc_worker_t;
+
+static oc_worker_t workers[OC_WORKER_THREADS];
+/* Request handlers already running under the stack mutex may call
+ * oc_main_lock() themselves.
+ */
+static pthread_mutex_t stack_mutex = PTHREAD_RECURSIVE_MUTEX_INITIALIZER_NP;
+static bool running, initialized;
+
+void
+oc_stack_mutex_lock(void)
+{
+  pthread_mutex_lock(&stack_mutex);
+}
+
+void
+oc_stack_mutex_unlock(void)
+{
+  pthread_mutex_unlock(&stack_mutex);
+}
+
+static uint32_t
+endpoint_hash(const oc_endpoint_t *endpoint)
+{
+  const uint8_t *address = endpoint->addr.ipv6.address;
+  size_t len = 16;
+  uint16_t port = endpoint->addr.ipv6.port;
+#ifdef OC_IPV4
+  if (endpoint->flags & IPV4) {
+    address = endpoint->addr.ipv4.address;
+    len = 4;
+    port = endpoint->addr.ipv4.port;
+  }
+#endif /* OC_IPV4 */
+
+  /* FNV-1a */
+  uint32_t hash = 2166136261u;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ address[i]) * 16777619u;
+  }
+  hash = (hash ^ (port & 0xff)) * 16777619u;
+  hash = (hash ^ (port >> 8)) * 16777619u;
+  hash = (hash ^ (uint8_t)endpoint->device) * 16777619u;
+  return hash;
+}
+
+static void *
+worker_thread(void *data)
+{
+  oc_worker_t *worker = (oc_worker_t *)data;
+
+  pthread_mutex_lock(&worker->mutex);
+  while (1) {
+    oc_message_t *message = (oc_message_t *)oc_list_pop(worker->queue);
+    oc_worker_job_t *job =
+      message ? NULL : (oc_worker_job_t *)oc_list_pop(worker->jobs);
+    if (!message && !job) {
+      if (worker->terminate) {
+        break;
+      }
+      pthread_cond_wait(&worker->cv, &worker->mutex);
+      continue;
+    }
+    pthread_mutex_unlock(&worker->mutex);
+
+    if (message) {
+      oc_worker_process_message(message);
+    } else {
+      job->run(job);
+    }
+
+    pthread_mutex_lock(&worker->mutex);
+  }
+  pthread_mutex_unlock(&worker->mutex);
+
+  oc_worker_thread_exit();
+  pthread_exit(NULL);
+}
+
+static void
+stop_worker(oc_worker_t *worker)
+{
+  pthread_mutex_lock(&worker->mutex);
+  worker->terminate = true;
+  pthread_cond_signal(&worker->cv);
+  pthread_mutex_unlock(&worker->mutex);
+  pthread_join(worker->thread, NULL);
+}
+
+int
+oc_worker_pool_init(void)
+{
+  int i;
+  /* The queue locks outlive the threads, as adapter threads may still try
+   * to dispatch while the stack shuts down.
+   */
+  if (!initialized) {
+    for (i = 0; i < OC_WORKER_THREADS; i++) {
+      pthread_mutex_init(&workers[i].mutex, NULL);
+      pthread_cond_init(&workers[i].cv, NULL);
+    }
+    initialized = true;
+  }
+
+  for (i = 0; i < OC_WORKER_THREADS; i++) {
+    oc_worker_t *worker = &workers[i];
+    OC_LIST_STRUCT_INIT(worker, queue);
+    OC_LIST_STRUCT_INIT(worker, jobs);
+    worker->terminate = false;
+    if (pthread_create(&worker->thread, NULL, &worker_thread, worker) != 0) {
+      OC_ERR("creating worker thread %d", i);
+      worker->terminate = true;
+      while (i-- > 0) {
+        stop_worker(&workers[i]);
+      }
+      return -1;
+    }
+  }
+
+  running = true;
+  OC_DBG("started %d request worker threads", OC_WORKER_THREADS);
+  return 0;
+}
+
+void
+oc_worker_pool_shutdown(void)
+{
+  if (!running) {
+    return;
+  }
+  running = false;
+
+  int i;
+  for (i = 0; i < OC_WORKER_THREADS; i++) {
+    stop_worker(&workers[i]);
+  }
+}
+
+bool
+oc_worker_pool_dispatch(oc_message_t *message)
+{
+  if (!running) {
+    return false;
+  }
+#ifdef OC_SECURITY
+  /* DTLS records are decrypted by the TLS layer on the event loop. */
+  if (message->encrypted) {
+    return false;
+  }
+#endif /* OC_SECURITY */
+
+  oc_worker_t *worker =
+    &workers[endpoint_hash(&message->endpoint) % OC_WORKER_THREADS];
+  pthread_mutex_lock(&worker->mutex);
+  if (worker->terminate) {
+    pthread_mutex_unlock(&worker->mutex);
+    return false;
+  }
+  oc_list_add(worker->queue, message);
+  pthread_cond_signal(&worker->cv);
+  pthread_mutex_unlock(&worker->mutex);
+  return true;
+}
+
+bool
+oc_worker_pool_dispatch_job(oc_worker_job_t *job,
+                            const oc_endpoint_t *endpoint)
+{
+  if (!running) {
+    return false;
+  }
+
+  oc_worker_t *worker = &workers[endpoint_hash(endpoint) % OC_WORKER_THREADS];
+  pthread_mutex_lock(&worker->mutex);
+  if (worker->terminate) {
+    pthread_mutex_unlock(&worker->mutex);
+    return false;
+  }
+  oc_list_add(worker->jobs, job);
+  pthread_cond_signal(&worker->cv);
+  pthread_mutex_unlock(&worker->mutex);
+  return true;
+}
+#else  /* OC_WORKER_THREADS */
+typedef int dummy_declaration;
+#endif /* !OC_WORKER_THREADS */
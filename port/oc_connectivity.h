@@ -90,6 +90,18 @@ extern "C"
 #define OC_MAX_APP_DATA_SIZE (oc_get_max_app_data_size())
 #endif /* OC_DYNAMIC_ALLOCATION */
 
+#ifdef OC_SHARED_PAYLOADS
+/* Reference counted payload that several outgoing messages send after their
+ * own header bytes.
+ */
+typedef struct oc_message_payload_s
+{
+  size_t ref_count;
+  size_t length;
+  uint8_t data[];
+} oc_message_payload_t;
+#endif /* OC_SHARED_PAYLOADS */
+
 struct oc_message_s
 {
   struct oc_message_s *next;
@@ -108,6 +120,12 @@ struct oc_message_s
 #ifdef OC_SECURITY
   uint8_t encrypted;
 #endif
+#ifdef OC_SHARED_PAYLOADS
+  /* Sent after the length bytes of data, if set. Only used for plaintext
+   * UDP messages.
+   */
+  oc_message_payload_t *payload;
+#endif /* OC_SHARED_PAYLOADS */
 };
 
 int oc_send_buffer(oc_message_t *message);
@@ -118,6 +136,28 @@ void oc_connectivity_shutdown(size_t device);
 
 void oc_send_discovery_request(oc_message_t *message);
 
+#ifdef OC_SEND_BATCHING
+/* Counters for the batched transmit path. The average batch size is
+ * messages / syscalls.
+ */
+typedef struct oc_send_batch_stats_t
+{
+  uint32_t flushes;   /* Number of times the send queue was flushed */
+  uint32_t syscalls;  /* Number of sendmmsg() calls */
+  uint32_t messages;  /* Number of messages sent through the queue */
+  uint32_t segmented; /* Messages coalesced with UDP segmentation offload */
+} oc_send_batch_stats_t;
+
+/* Queues a unicast message until the next oc_send_buffer_flush(), taking a
+ * reference on it. Ports may send the message immediately instead.
+ */
+int oc_send_buffer_batched(oc_message_t *message);
+
+void oc_send_buffer_flush(void);
+
+void oc_send_buffer_batch_stats(oc_send_batch_stats_t *stats);
+#endif /* OC_SEND_BATCHING */
+
 void oc_connectivity_end_session(oc_endpoint_t *endpoint);
 
 #ifdef OC_DNS_LOOKUP
@@ -0,0 +1,83 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef OC_WORKER_POOL_H
+#define OC_WORKER_POOL_H
+
+#include "port/oc_connectivity.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef OC_WORKER_THREADS
+/*
+ * Pool of OC_WORKER_THREADS request worker threads. Inbound plaintext
+ * messages are hashed by their source endpoint onto one of the workers so
+ * that all messages from a peer are processed in arrival order by the same
+ * thread.
+ *
+ * Workers and the thread running oc_main_poll() serialize on the stack
+ * mutex. It is released only while the handler of an OC_CONCURRENT
+ * resource runs, which is where the workers overlap.
+ */
+int oc_worker_pool_init(void);
+
+void oc_worker_pool_shutdown(void);
+
+/*
+ * Queue message on the worker owning its endpoint. Returns false if the
+ * message must instead take the regular path through the event loop.
+ */
+bool oc_worker_pool_dispatch(oc_message_t *message);
+
+void oc_stack_mutex_lock(void);
+
+void oc_stack_mutex_unlock(void);
+
+/* Implemented by the stack; runs a dispatched message on a worker thread. */
+void oc_worker_process_message(oc_message_t *message);
+
+/* Implemented by the stack; releases the state of a worker thread that is
+ * about to exit.
+ */
+void oc_worker_thread_exit(void);
+
+/*
+ * Work other than a message, run by a worker thread without the stack mutex
+ * held. The job is embedded in the object it works on.
+ */
+typedef struct oc_worker_job_s
+{
+  struct oc_worker_job_s *next;
+  void (*run)(struct oc_worker_job_s *job);
+} oc_worker_job_t;
+
+/*
+ * Queue job on the worker owning endpoint. Returns false if the pool is not
+ * running, in which case the caller does the work itself.
+ */
+bool oc_worker_pool_dispatch_job(oc_worker_job_t *job,
+                                 const oc_endpoint_t *endpoint);
+#endif /* OC_WORKER_THREADS */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_WORKER_POOL_H */
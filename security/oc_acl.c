@@ -53,6 +53,57 @@ static const char *wc_public = "-";
 OC_MEMB(ace_l, oc_sec_ace_t, MAX_NUM_RES_PERM_PAIRS);
 OC_MEMB(res_l, oc_ace_res_t, OC_MAX_APP_RESOURCES + OCF_D * OC_MAX_NUM_DEVICES);
 
+#ifdef OC_ACL_CACHE
+#ifdef OC_DYNAMIC_ALLOCATION
+#define OC_ACL_INDEX_MIN_BUCKETS (16)
+#else /* OC_DYNAMIC_ALLOCATION */
+#if (OC_ACL_INDEX_BUCKETS & (OC_ACL_INDEX_BUCKETS - 1)) != 0
+#error "OC_ACL_INDEX_BUCKETS must be a power of two"
+#endif /* OC_ACL_INDEX_BUCKETS & (OC_ACL_INDEX_BUCKETS - 1) */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/* acl_generation moves on whenever the ACEs of any device change, and
+ * decision_generation whenever anything that a decision depends on changes.
+ * Neither is ever 0, which marks unused cache entries.
+ */
+static uint32_t acl_generation = 1;
+static uint32_t decision_generation = 1;
+/* Decisions for requests that did not arrive through a (D)TLS peer, by
+ * whether the endpoint was secured.
+ */
+static oc_sec_acl_cache_t connection_cache[2];
+static oc_sec_acl_cache_stats_t cache_stats;
+
+static void
+next_generation(uint32_t *generation)
+{
+  (*generation)++;
+  if (*generation == 0) {
+    *generation = 1;
+  }
+}
+
+void
+oc_sec_acl_cache_invalidate(void)
+{
+  next_generation(&decision_generation);
+  cache_stats.invalidations++;
+}
+
+void
+oc_sec_acl_cache_stats(oc_sec_acl_cache_stats_t *stats)
+{
+  memcpy(stats, &cache_stats, sizeof(oc_sec_acl_cache_stats_t));
+}
+
+static void
+acl_changed(void)
+{
+  next_generation(&acl_generation);
+  oc_sec_acl_cache_invalidate();
+}
+#endif /* OC_ACL_CACHE */
+
 void
 oc_sec_acl_init(void)
 {
@@ -176,6 +227,33 @@ oc_sec_ace_find_resource(oc_ace_res_t *start, oc_sec_ace_t *ace,
   return res;
 }
 
+static bool
+oc_sec_ace_has_subject(oc_sec_ace_t *ace, oc_ace_subject_type_t type,
+                       oc_ace_subject_t *subject)
+{
+  if (ace->subject_type != type) {
+    return false;
+  }
+  switch (type) {
+  case OC_SUBJECT_UUID:
+    return memcmp(subject->uuid.id, ace->subject.uuid.id, 16) == 0;
+  case OC_SUBJECT_ROLE:
+    return oc_string_len(subject->role.role) ==
+             oc_string_len(ace->subject.role.role) &&
+           memcmp(oc_string(subject->role.role),
+                  oc_string(ace->subject.role.role),
+                  oc_string_len(subject->role.role)) == 0 &&
+           oc_string_len(ace->subject.role.authority) ==
+             oc_string_len(subject->role.authority) &&
+           memcmp(oc_string(subject->role.authority),
+                  oc_string(ace->subject.role.authority),
+                  oc_string_len(subject->role.authority)) == 0;
+  case OC_SUBJECT_CONN:
+    return subject->conn == ace->subject.conn;
+  }
+  return false;
+}
+
 static oc_sec_ace_t *
 oc_sec_acl_find_subject(oc_sec_ace_t *start, oc_ace_subject_type_t type,
                         oc_ace_subject_t *subject, int aceid,
@@ -194,34 +272,8 @@ oc_sec_acl_find_subject(oc_sec_ace_t *start, oc_ace_subject_type_t type,
     if (permission != 0 && ace->permission != permission) {
       goto next_ace;
     }
-    if (ace->subject_type == type) {
-      switch (type) {
-      case OC_SUBJECT_UUID:
-        if (memcmp(subject->uuid.id, ace->subject.uuid.id, 16) == 0) {
-          return ace;
-        }
-        break;
-      case OC_SUBJECT_ROLE:
-        if ((oc_string_len(subject->role.role) ==
-               oc_string_len(ace->subject.role.role) &&
-             memcmp(oc_string(subject->role.role),
-                    oc_string(ace->subject.role.role),
-                    oc_string_len(subject->role.role)) == 0)) {
-          if (oc_string_len(ace->subject.role.authority) ==
-                oc_string_len(subject->role.authority) &&
-              memcmp(oc_string(subject->role.authority),
-                     oc_string(ace->subject.role.authority),
-                     oc_string_len(subject->role.authority)) == 0) {
-            return ace;
-          }
-        }
-        break;
-      case OC_SUBJECT_CONN:
-        if (subject->conn == ace->subject.conn) {
-          return ace;
-        }
-        break;
-      }
+    if (oc_sec_ace_has_subject(ace, type, subject)) {
+      return ace;
     }
   next_ace:
     ace = ace->next;
@@ -229,6 +281,108 @@ oc_sec_acl_find_subject(oc_sec_ace_t *start, oc_ace_subject_type_t type,
   return ace;
 }
 
+#ifdef OC_ACL_CACHE
+static uint32_t
+hash_bytes(uint32_t hash, const uint8_t *data, size_t len)
+{
+  /* FNV-1a */
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ data[i]) * 16777619u;
+  }
+  return hash;
+}
+
+/* Roles that differ only in their authority share a chain. */
+static uint32_t
+subject_hash(oc_ace_subject_type_t type, oc_ace_subject_t *subject)
+{
+  uint32_t hash = (2166136261u ^ (uint32_t)type) * 16777619u;
+  switch (type) {
+  case OC_SUBJECT_UUID:
+    return hash_bytes(hash, subject->uuid.id, 16);
+  case OC_SUBJECT_ROLE:
+    return hash_bytes(hash, (const uint8_t *)oc_string(subject->role.role),
+                      oc_string_len(subject->role.role));
+  case OC_SUBJECT_CONN:
+    return hash_bytes(hash, (const uint8_t *)&subject->conn,
+                      sizeof(subject->conn));
+  }
+  return hash;
+}
+
+static bool
+index_subjects(size_t device)
+{
+  oc_sec_acl_t *acl = &aclist[device];
+  size_t i;
+#ifdef OC_DYNAMIC_ALLOCATION
+  size_t buckets = OC_ACL_INDEX_MIN_BUCKETS;
+  while (buckets < (size_t)oc_list_length(acl->subjects)) {
+    buckets <<= 1;
+  }
+  if (buckets != acl->index_buckets) {
+    free(acl->subject_index);
+    acl->subject_index =
+      (oc_sec_ace_t **)calloc(buckets, sizeof(oc_sec_ace_t *));
+    if (!acl->subject_index) {
+      OC_WRN("insufficient memory to index the ACL");
+      acl->index_buckets = 0;
+      return false;
+    }
+    acl->index_buckets = buckets;
+  }
+#else  /* OC_DYNAMIC_ALLOCATION */
+  acl->index_buckets = OC_ACL_INDEX_BUCKETS;
+#endif /* !OC_DYNAMIC_ALLOCATION */
+  for (i = 0; i < acl->index_buckets; i++) {
+    acl->subject_index[i] = NULL;
+  }
+
+  /* ACEs that share a chain stay in ACL order. */
+  oc_sec_ace_t *ace = (oc_sec_ace_t *)oc_list_head(acl->subjects);
+  while (ace != NULL) {
+    oc_sec_ace_t **link =
+      &acl->subject_index[subject_hash(ace->subject_type, &ace->subject) &
+                          (acl->index_buckets - 1)];
+    while (*link) {
+      link = &(*link)->subject_next;
+    }
+    ace->subject_next = NULL;
+    *link = ace;
+    ace = ace->next;
+  }
+  acl->index_generation = acl_generation;
+  return true;
+}
+#endif /* OC_ACL_CACHE */
+
+/* Iterate over the ACEs of device that name subject, starting with prev set
+ * to NULL.
+ */
+static oc_sec_ace_t *
+oc_sec_acl_next_for_subject(oc_sec_ace_t *prev, oc_ace_subject_type_t type,
+                            oc_ace_subject_t *subject, size_t device)
+{
+#ifdef OC_ACL_CACHE
+  oc_sec_acl_t *acl = &aclist[device];
+  if (!prev && acl->index_generation != acl_generation) {
+    index_subjects(device);
+  }
+  if (acl->index_generation == acl_generation) {
+    oc_sec_ace_t *ace =
+      prev ? prev->subject_next
+           : acl->subject_index[subject_hash(type, subject) &
+                                (acl->index_buckets - 1)];
+    while (ace != NULL && !oc_sec_ace_has_subject(ace, type, subject)) {
+      ace = ace->subject_next;
+    }
+    return ace;
+  }
+#endif /* OC_ACL_CACHE */
+  return oc_sec_acl_find_subject(prev, type, subject, -1, 0, device);
+}
+
 static uint16_t
 oc_ace_get_permission(oc_sec_ace_t *ace, oc_resource_t *resource,
                       oc_interface_mask_t iface_mask, bool is_DCR,
@@ -338,9 +492,8 @@ get_role_permissions(oc_sec_cred_t *role_cred, oc_resource_t *resource,
   uint16_t permission = 0;
   oc_sec_ace_t *match = NULL;
   do {
-    match = oc_sec_acl_find_subject(match, OC_SUBJECT_ROLE,
-                                    (oc_ace_subject_t *)&role_cred->role, -1, 0,
-                                    device);
+    match = oc_sec_acl_next_for_subject(
+      match, OC_SUBJECT_ROLE, (oc_ace_subject_t *)&role_cred->role, device);
 
     if (match) {
       permission |=
@@ -352,64 +505,19 @@ get_role_permissions(oc_sec_cred_t *role_cred, oc_resource_t *resource,
   return permission;
 }
 
-bool
-oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
-                 oc_interface_mask_t iface_mask, oc_endpoint_t *endpoint)
+static uint16_t
+get_permissions(oc_resource_t *resource, oc_interface_mask_t iface_mask,
+                oc_endpoint_t *endpoint, oc_tls_peer_t *peer, bool is_DCR,
+                bool is_public, bool *from_role_certs)
 {
-#ifdef OC_DEBUG
-  dump_acl(endpoint->device);
-#endif /* OC_DEBUG */
-
-  bool is_DCR = oc_core_is_DCR(resource, resource->device);
-  bool is_public = ((resource->properties & OC_SECURE) == 0);
-
-  oc_sec_pstat_t *pstat = oc_sec_get_pstat(endpoint->device);
-  if (!is_DCR && pstat->s != OC_DOS_RFNOP) {
-    return false;
-  }
-
-  oc_uuid_t *uuid = NULL;
-  oc_tls_peer_t *peer = oc_tls_get_peer(endpoint);
-  if (peer) {
-    uuid = &peer->uuid;
-  }
-
-  if (uuid) {
-    oc_sec_doxm_t *doxm = oc_sec_get_doxm(endpoint->device);
-    oc_sec_creds_t *creds = oc_sec_get_creds(endpoint->device);
-    if (memcmp(uuid->id, aclist[endpoint->device].rowneruuid.id, 16) == 0 &&
-        oc_string_len(resource->uri) == 13 &&
-        memcmp(oc_string(resource->uri), "/oic/sec/acl2", 13) == 0) {
-      OC_DBG("oc_acl: peer's UUID matches acl2's rowneruuid");
-      return true;
-    }
-    if (memcmp(uuid->id, doxm->rowneruuid.id, 16) == 0 &&
-        oc_string_len(resource->uri) == 13 &&
-        memcmp(oc_string(resource->uri), "/oic/sec/doxm", 13) == 0) {
-      OC_DBG("oc_acl: peer's UUID matches doxm's rowneruuid");
-      return true;
-    }
-    if (memcmp(uuid->id, pstat->rowneruuid.id, 16) == 0 &&
-        oc_string_len(resource->uri) == 14 &&
-        memcmp(oc_string(resource->uri), "/oic/sec/pstat", 14) == 0) {
-      OC_DBG("oc_acl: peer's UUID matches pstat's rowneruuid");
-      return true;
-    }
-    if (memcmp(uuid->id, creds->rowneruuid.id, 16) == 0 &&
-        oc_string_len(resource->uri) == 13 &&
-        memcmp(oc_string(resource->uri), "/oic/sec/cred", 13) == 0) {
-      OC_DBG("oc_acl: peer's UUID matches cred's rowneruuid");
-      return true;
-    }
-  }
-
+  *from_role_certs = false;
+  oc_uuid_t *uuid = peer ? &peer->uuid : NULL;
   uint16_t permission = 0;
   oc_sec_ace_t *match = NULL;
   if (uuid) {
     do {
-      match = oc_sec_acl_find_subject(match, OC_SUBJECT_UUID,
-                                      (oc_ace_subject_t *)uuid, -1, 0,
-                                      endpoint->device);
+      match = oc_sec_acl_next_for_subject(
+        match, OC_SUBJECT_UUID, (oc_ace_subject_t *)uuid, endpoint->device);
 
       if (match) {
         permission |=
@@ -437,8 +545,12 @@ oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
           role_cred = next;
           continue;
         }
-        permission |= get_role_permissions(role_cred, resource, iface_mask,
-                                           endpoint->device, is_DCR, is_public);
+        uint16_t role_permission = get_role_permissions(
+          role_cred, resource, iface_mask, endpoint->device, is_DCR, is_public);
+        if (role_permission != 0) {
+          permission |= role_permission;
+          *from_role_certs = true;
+        }
         role_cred = role_cred->next;
       }
     }
@@ -450,8 +562,8 @@ oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
     memset(&_auth_crypt, 0, sizeof(oc_ace_subject_t));
     _auth_crypt.conn = OC_CONN_AUTH_CRYPT;
     do {
-      match = oc_sec_acl_find_subject(match, OC_SUBJECT_CONN, &_auth_crypt, -1,
-                                      0, endpoint->device);
+      match = oc_sec_acl_next_for_subject(match, OC_SUBJECT_CONN, &_auth_crypt,
+                                          endpoint->device);
       if (match) {
         permission |=
           oc_ace_get_permission(match, resource, iface_mask, is_DCR, is_public);
@@ -466,8 +578,8 @@ oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
   memset(&_anon_clear, 0, sizeof(oc_ace_subject_t));
   _anon_clear.conn = OC_CONN_ANON_CLEAR;
   do {
-    match = oc_sec_acl_find_subject(match, OC_SUBJECT_CONN, &_anon_clear, -1, 0,
-                                    endpoint->device);
+    match = oc_sec_acl_next_for_subject(match, OC_SUBJECT_CONN, &_anon_clear,
+                                        endpoint->device);
     if (match) {
       permission |=
         oc_ace_get_permission(match, resource, iface_mask, is_DCR, is_public);
@@ -477,6 +589,98 @@ oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
     }
   } while (match);
 
+  return permission;
+}
+
+bool
+oc_sec_check_acl(oc_method_t method, oc_resource_t *resource,
+                 oc_interface_mask_t iface_mask, oc_endpoint_t *endpoint)
+{
+#ifdef OC_DEBUG
+  dump_acl(endpoint->device);
+#endif /* OC_DEBUG */
+
+  bool is_DCR = oc_core_is_DCR(resource, resource->device);
+  bool is_public = ((resource->properties & OC_SECURE) == 0);
+
+  oc_sec_pstat_t *pstat = oc_sec_get_pstat(endpoint->device);
+  if (!is_DCR && pstat->s != OC_DOS_RFNOP) {
+    return false;
+  }
+
+  oc_uuid_t *uuid = NULL;
+  oc_tls_peer_t *peer = oc_tls_get_peer(endpoint);
+  if (peer) {
+    uuid = &peer->uuid;
+  }
+
+  if (uuid) {
+    oc_sec_doxm_t *doxm = oc_sec_get_doxm(endpoint->device);
+    oc_sec_creds_t *creds = oc_sec_get_creds(endpoint->device);
+    if (memcmp(uuid->id, aclist[endpoint->device].rowneruuid.id, 16) == 0 &&
+        oc_string_len(resource->uri) == 13 &&
+        memcmp(oc_string(resource->uri), "/oic/sec/acl2", 13) == 0) {
+      OC_DBG("oc_acl: peer's UUID matches acl2's rowneruuid");
+      return true;
+    }
+    if (memcmp(uuid->id, doxm->rowneruuid.id, 16) == 0 &&
+        oc_string_len(resource->uri) == 13 &&
+        memcmp(oc_string(resource->uri), "/oic/sec/doxm", 13) == 0) {
+      OC_DBG("oc_acl: peer's UUID matches doxm's rowneruuid");
+      return true;
+    }
+    if (memcmp(uuid->id, pstat->rowneruuid.id, 16) == 0 &&
+        oc_string_len(resource->uri) == 14 &&
+        memcmp(oc_string(resource->uri), "/oic/sec/pstat", 14) == 0) {
+      OC_DBG("oc_acl: peer's UUID matches pstat's rowneruuid");
+      return true;
+    }
+    if (memcmp(uuid->id, creds->rowneruuid.id, 16) == 0 &&
+        oc_string_len(resource->uri) == 13 &&
+        memcmp(oc_string(resource->uri), "/oic/sec/cred", 13) == 0) {
+      OC_DBG("oc_acl: peer's UUID matches cred's rowneruuid");
+      return true;
+    }
+  }
+
+  uint16_t permission;
+  bool from_role_certs;
+#ifdef OC_ACL_CACHE
+  oc_sec_acl_cache_t *cache =
+    peer ? &peer->acl_cache
+         : &connection_cache[(endpoint->flags & SECURED) ? 1 : 0];
+  uint32_t key = (uint32_t)((uintptr_t)resource >> 3) * 2654435761u +
+                 (uint32_t)iface_mask;
+  oc_sec_acl_cache_entry_t *entry =
+    &cache->entries[(key ^ (key >> 16)) & (OC_ACL_CACHE_ENTRIES - 1)];
+  if (entry->generation == decision_generation &&
+      entry->resource == resource && entry->iface_mask == iface_mask &&
+      entry->properties == resource->properties &&
+      (entry->expires == 0 || oc_clock_time() < entry->expires)) {
+    cache_stats.hits++;
+    permission = entry->permission;
+  } else {
+    cache_stats.misses++;
+    permission = get_permissions(resource, iface_mask, endpoint, peer, is_DCR,
+                                 is_public, &from_role_certs);
+    /* Read the generation only now, as invalid role certificates are freed
+     * on the way.
+     */
+    entry->generation = decision_generation;
+    entry->resource = resource;
+    entry->iface_mask = iface_mask;
+    entry->properties = resource->properties;
+    entry->permission = permission;
+    entry->expires =
+      from_role_certs
+        ? oc_clock_time() + OC_ACL_CACHE_ROLE_TIMEOUT * OC_CLOCK_SECOND
+        : 0;
+  }
+#else  /* OC_ACL_CACHE */
+  permission = get_permissions(resource, iface_mask, endpoint, peer, is_DCR,
+                               is_public, &from_role_certs);
+#endif /* !OC_ACL_CACHE */
+
   if (permission != 0) {
     switch (method) {
     case OC_GET:
@@ -661,6 +865,9 @@ new_ace:
   oc_list_add(aclist[device].subjects, ace);
 
 new_res:
+#ifdef OC_ACL_CACHE
+  acl_changed();
+#endif /* OC_ACL_CACHE */
   res = oc_memb_alloc(&res_l);
   if (res) {
     res->wildcard = 0;
@@ -722,6 +929,9 @@ oc_sec_ace_update_res(oc_ace_subject_type_t type, oc_ace_subject_t *subject,
 static void
 oc_ace_free_resources(size_t device, oc_sec_ace_t **ace, const char *href)
 {
+#ifdef OC_ACL_CACHE
+  acl_changed();
+#endif /* OC_ACL_CACHE */
   oc_ace_res_t *res = (oc_ace_res_t *)oc_list_head((*ace)->resources),
                *next = NULL;
   while (res != NULL) {
@@ -766,6 +976,9 @@ oc_acl_remove_ace(int aceid, size_t device)
       }
       oc_memb_free(&ace_l, ace);
       removed = true;
+#ifdef OC_ACL_CACHE
+      acl_changed();
+#endif /* OC_ACL_CACHE */
       break;
     }
     ace = next;
@@ -777,6 +990,9 @@ static void
 oc_sec_clear_acl(size_t device)
 {
   oc_sec_acl_t *acl_d = &aclist[device];
+#ifdef OC_ACL_CACHE
+  acl_changed();
+#endif /* OC_ACL_CACHE */
   oc_sec_ace_t *ace = (oc_sec_ace_t *)oc_list_pop(acl_d->subjects);
   while (ace != NULL) {
     oc_ace_free_resources(device, &ace, NULL);
@@ -797,6 +1013,9 @@ oc_sec_acl_free(void)
   size_t device;
   for (device = 0; device < oc_core_get_num_devices(); device++) {
     oc_sec_clear_acl(device);
+#if defined(OC_ACL_CACHE) && defined(OC_DYNAMIC_ALLOCATION)
+    free(aclist[device].subject_index);
+#endif /* OC_ACL_CACHE && OC_DYNAMIC_ALLOCATION */
   }
 #ifdef OC_DYNAMIC_ALLOCATION
   if (aclist) {
@@ -85,12 +85,76 @@ typedef struct oc_sec_ace_s
   int aceid;
   oc_ace_permissions_t permission;
   // TODO: Add "validity" for ACE. It is currently not a mandatory property
+#ifdef OC_ACL_CACHE
+  struct oc_sec_ace_s *subject_next; /* chain of ACEs by subject */
+#endif /* OC_ACL_CACHE */
 } oc_sec_ace_t;
 
+#ifdef OC_ACL_CACHE
+/*
+ * Access decisions are remembered per peer (or per kind of unsecured
+ * connection) for each resource and interface, until an ACE, credential,
+ * role or resource changes. Decisions that were granted through role
+ * certificates are only kept for OC_ACL_CACHE_ROLE_TIMEOUT seconds, so that
+ * an expired certificate is noticed about as soon as it would be without the
+ * cache. The ACEs of each device are also indexed by subject, and the index
+ * is rebuilt on the first check after the ACL changes.
+ */
+#ifndef OC_ACL_CACHE_ENTRIES
+#define OC_ACL_CACHE_ENTRIES (8)
+#endif /* !OC_ACL_CACHE_ENTRIES */
+#if (OC_ACL_CACHE_ENTRIES & (OC_ACL_CACHE_ENTRIES - 1)) != 0
+#error "OC_ACL_CACHE_ENTRIES must be a power of two"
+#endif /* OC_ACL_CACHE_ENTRIES & (OC_ACL_CACHE_ENTRIES - 1) */
+#ifndef OC_ACL_CACHE_ROLE_TIMEOUT
+#define OC_ACL_CACHE_ROLE_TIMEOUT (1)
+#endif /* !OC_ACL_CACHE_ROLE_TIMEOUT */
+#ifndef OC_DYNAMIC_ALLOCATION
+#ifndef OC_ACL_INDEX_BUCKETS
+#define OC_ACL_INDEX_BUCKETS (16)
+#endif /* !OC_ACL_INDEX_BUCKETS */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+typedef struct
+{
+  oc_resource_t *resource;
+  oc_clock_time_t expires; /* 0 if kept until the next change */
+  uint32_t generation;
+  oc_interface_mask_t iface_mask;
+  oc_resource_properties_t properties;
+  uint16_t permission;
+} oc_sec_acl_cache_entry_t;
+
+typedef struct
+{
+  oc_sec_acl_cache_entry_t entries[OC_ACL_CACHE_ENTRIES];
+} oc_sec_acl_cache_t;
+
+typedef struct
+{
+  uint32_t hits;          /* Checks answered from the cache */
+  uint32_t misses;        /* Checks that walked the ACL */
+  uint32_t invalidations; /* Changes that dropped all cached decisions */
+} oc_sec_acl_cache_stats_t;
+
+/* Drop all cached access decisions. */
+void oc_sec_acl_cache_invalidate(void);
+void oc_sec_acl_cache_stats(oc_sec_acl_cache_stats_t *stats);
+#endif /* OC_ACL_CACHE */
+
 typedef struct
 {
   OC_LIST_STRUCT(subjects);
   oc_uuid_t rowneruuid;
+#ifdef OC_ACL_CACHE
+#ifdef OC_DYNAMIC_ALLOCATION
+  oc_sec_ace_t **subject_index;
+#else  /* OC_DYNAMIC_ALLOCATION */
+  oc_sec_ace_t *subject_index[OC_ACL_INDEX_BUCKETS];
+#endif /* !OC_DYNAMIC_ALLOCATION */
+  size_t index_buckets;
+  uint32_t index_generation;
+#endif /* OC_ACL_CACHE */
 } oc_sec_acl_t;
 
 void oc_sec_acl_init(void);
@@ -17,6 +17,7 @@
 #ifdef OC_SECURITY
 
 #include "oc_cred.h"
+#include "oc_acl.h"
 #include "oc_api.h"
 #include "oc_base64.h"
 #include "oc_certs.h"
@@ -170,6 +171,12 @@ oc_sec_remove_cred(oc_sec_cred_t *cred, size_t device)
     }
   }
 #endif /* OC_PKI */
+#ifdef OC_TLS_SESSION_CACHE
+  oc_tls_flush_sessions();
+#endif /* OC_TLS_SESSION_CACHE */
+#ifdef OC_ACL_CACHE
+  oc_sec_acl_cache_invalidate();
+#endif /* OC_ACL_CACHE */
   oc_memb_free(&creds, cred);
 }
 
@@ -288,6 +295,9 @@ oc_sec_allocate_cred(oc_uuid_t *subjectuuid, oc_sec_credtype_t credtype,
 #endif /* OC_PKI */
     memcpy(cred->subjectuuid.id, subjectuuid->id, 16);
     oc_list_add(devices[device].creds, cred);
+#ifdef OC_ACL_CACHE
+    oc_sec_acl_cache_invalidate();
+#endif /* OC_ACL_CACHE */
   } else {
     OC_WRN("insufficient memory to add new credential");
   }
@@ -20,6 +20,7 @@
 #include "oc_roles.h"
 #include "mbedtls/x509_crt.h"
 #include "port/oc_log.h"
+#include "security/oc_acl.h"
 #include "security/oc_tls.h"
 
 #define OC_ROLES_NUM_ROLE_CREDS (2)
@@ -144,6 +145,9 @@ oc_sec_allocate_role(oc_tls_peer_t *client, size_t device)
       if (role->ctx) {
         mbedtls_x509_crt_init(role->ctx);
         oc_list_add(roles->roles, role);
+#ifdef OC_ACL_CACHE
+        oc_sec_acl_cache_invalidate();
+#endif /* OC_ACL_CACHE */
         return role;
       }
       oc_sec_free_role(role, client);
@@ -189,6 +193,9 @@ oc_sec_free_role(oc_sec_cred_t *role, oc_tls_peer_t *client)
         oc_memb_free(&x509_crt_s, r->ctx);
         free_cred_properties(r);
         oc_memb_free(&roles_s, r);
+#ifdef OC_ACL_CACHE
+        oc_sec_acl_cache_invalidate();
+#endif /* OC_ACL_CACHE */
         return;
       }
       r = r->next;
@@ -224,6 +231,9 @@ oc_sec_free_roles(oc_tls_peer_t *client)
     }
     oc_list_remove(clients, roles);
     oc_memb_free(&clients_s, roles);
+#ifdef OC_ACL_CACHE
+    oc_sec_acl_cache_invalidate();
+#endif /* OC_ACL_CACHE */
   }
 }
 
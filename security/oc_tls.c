@@ -17,6 +17,7 @@
 
 #ifdef OC_SECURITY
 #include <stdarg.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <string.h>
 
@@ -26,6 +27,12 @@
 #include "mbedtls/md.h"
 #include "mbedtls/ssl.h"
 #include "mbedtls/ssl_cookie.h"
+#ifdef OC_TLS_SESSION_CACHE
+#include "mbedtls/ssl_cache.h"
+#ifdef OC_TLS_SESSION_TICKETS
+#include "mbedtls/ssl_ticket.h"
+#endif /* OC_TLS_SESSION_TICKETS */
+#endif /* OC_TLS_SESSION_CACHE */
 #include "mbedtls/ssl_internal.h"
 #include "mbedtls/timing.h"
 #include "mbedtls/oid.h"
@@ -46,11 +53,14 @@
 #include "oc_pstat.h"
 #include "oc_roles.h"
 #include "oc_session_events.h"
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+#include "oc_signal_event_loop.h"
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
 #include "oc_svr.h"
 #include "oc_tls.h"
 
 OC_PROCESS(oc_tls_handler, "TLS Process");
-OC_MEMB(tls_peers_s, oc_tls_peer_t, OC_MAX_TLS_PEERS);
+OC_MEMB_CACHED(tls_peers_s, oc_tls_peer_t, OC_MAX_TLS_PEERS);
 OC_LIST(tls_peers);
 
 static mbedtls_entropy_context entropy_ctx;
@@ -158,9 +168,223 @@ oc_mbedtls_debug(void *ctx, int level, const char *file, int line,
 }
 #endif /* OC_DEBUG */
 
+#ifdef OC_TLS_PEER_INDEX
+/* The chains of the peers whose endpoint, and whose address in memory, hash
+ * to a bucket. The latter tells whether a peer handed to a deferred event is
+ * still alive without dereferencing it.
+ */
+typedef struct
+{
+  oc_tls_peer_t *by_endpoint;
+  oc_tls_peer_t *by_handle;
+} oc_tls_peer_bucket_t;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#define OC_TLS_PEER_MIN_BUCKETS (64)
+static oc_tls_peer_bucket_t *peer_buckets;
+static size_t num_peer_buckets;
+#else /* OC_DYNAMIC_ALLOCATION */
+#if (OC_TLS_PEER_BUCKETS & (OC_TLS_PEER_BUCKETS - 1)) != 0
+#error "OC_TLS_PEER_BUCKETS must be a power of two"
+#endif /* OC_TLS_PEER_BUCKETS & (OC_TLS_PEER_BUCKETS - 1) */
+#define num_peer_buckets (OC_TLS_PEER_BUCKETS)
+static oc_tls_peer_bucket_t peer_buckets[OC_TLS_PEER_BUCKETS];
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/* Peers with a pending retransmission timer, earliest deadline first. */
+static oc_tls_peer_t *retr_peers;
+static oc_tls_peer_stats_t peer_stats;
+
+static uint32_t
+hash_bytes(uint32_t hash, const void *data, size_t len)
+{
+  /* FNV-1a */
+  const uint8_t *bytes = (const uint8_t *)data;
+  size_t i;
+  for (i = 0; i < len; i++) {
+    hash = (hash ^ bytes[i]) * 16777619u;
+  }
+  return hash;
+}
+
+/* Covers the fields compared by oc_endpoint_compare(). */
+static uint32_t
+endpoint_hash(const oc_endpoint_t *endpoint)
+{
+  int flags = endpoint->flags & ~MULTICAST;
+  uint32_t hash = hash_bytes(2166136261u, &flags, sizeof(flags));
+  hash = hash_bytes(hash, &endpoint->device, sizeof(endpoint->device));
+  if (endpoint->flags & IPV6) {
+    hash = hash_bytes(hash, endpoint->addr.ipv6.address, 16);
+    hash = hash_bytes(hash, &endpoint->addr.ipv6.port,
+                      sizeof(endpoint->addr.ipv6.port));
+  }
+#ifdef OC_IPV4
+  else if (endpoint->flags & IPV4) {
+    hash = hash_bytes(hash, endpoint->addr.ipv4.address, 4);
+    hash = hash_bytes(hash, &endpoint->addr.ipv4.port,
+                      sizeof(endpoint->addr.ipv4.port));
+  }
+#endif /* OC_IPV4 */
+  return hash;
+}
+
+static uint32_t
+handle_hash(const oc_tls_peer_t *peer)
+{
+  return hash_bytes(2166136261u, &peer, sizeof(peer));
+}
+
+static oc_tls_peer_bucket_t *
+peer_bucket(uint32_t hash)
+{
+  return &peer_buckets[hash & (num_peer_buckets - 1)];
+}
+
+static void
+link_peer(oc_tls_peer_t *peer)
+{
+  oc_tls_peer_bucket_t *bucket = peer_bucket(peer->endpoint_hash);
+  peer->endpoint_next = bucket->by_endpoint;
+  bucket->by_endpoint = peer;
+  bucket = peer_bucket(handle_hash(peer));
+  peer->handle_next = bucket->by_handle;
+  bucket->by_handle = peer;
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+static void
+resize_peer_buckets(size_t new_num_buckets)
+{
+  oc_tls_peer_bucket_t *new_buckets = (oc_tls_peer_bucket_t *)calloc(
+    new_num_buckets, sizeof(oc_tls_peer_bucket_t));
+  if (!new_buckets) {
+    OC_WRN("oc_tls: insufficient memory to grow the peer table");
+    return;
+  }
+  oc_tls_peer_bucket_t *old_buckets = peer_buckets;
+  peer_buckets = new_buckets;
+  num_peer_buckets = new_num_buckets;
+  oc_tls_peer_t *peer = (oc_tls_peer_t *)oc_list_head(tls_peers);
+  while (peer != NULL) {
+    link_peer(peer);
+    peer = peer->next;
+  }
+  free(old_buckets);
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+/* Called with the peer not yet added to tls_peers. */
+static bool
+add_to_peer_index(oc_tls_peer_t *peer)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (peer_stats.peers >= num_peer_buckets) {
+    resize_peer_buckets(num_peer_buckets ? num_peer_buckets * 2
+                                         : OC_TLS_PEER_MIN_BUCKETS);
+    if (!peer_buckets) {
+      return false;
+    }
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+  peer->endpoint_hash = endpoint_hash(&peer->endpoint);
+  peer->retr_pending = false;
+  link_peer(peer);
+  peer_stats.peers++;
+  return true;
+}
+
+static void
+remove_from_peer_index(oc_tls_peer_t *peer)
+{
+  if (peer_stats.peers == 0) {
+    return;
+  }
+  oc_tls_peer_t **p = &peer_bucket(peer->endpoint_hash)->by_endpoint;
+  while (*p && *p != peer) {
+    p = &(*p)->endpoint_next;
+  }
+  if (!*p) {
+    return;
+  }
+  *p = peer->endpoint_next;
+  p = &peer_bucket(handle_hash(peer))->by_handle;
+  while (*p && *p != peer) {
+    p = &(*p)->handle_next;
+  }
+  if (*p) {
+    *p = peer->handle_next;
+  }
+  peer_stats.peers--;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  if (peer_stats.peers == 0) {
+    free(peer_buckets);
+    peer_buckets = NULL;
+    num_peer_buckets = 0;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+static oc_clock_time_t
+retr_deadline(oc_tls_peer_t *peer)
+{
+  return peer->timer.fin_timer.timer.start +
+         peer->timer.fin_timer.timer.interval;
+}
+
+static void
+remove_retr_timer(oc_tls_peer_t *peer)
+{
+  if (!peer->retr_pending) {
+    return;
+  }
+  oc_tls_peer_t **p = &retr_peers;
+  while (*p && *p != peer) {
+    p = &(*p)->retr_next;
+  }
+  if (*p) {
+    *p = peer->retr_next;
+  }
+  peer->retr_pending = false;
+}
+
+static void
+add_retr_timer(oc_tls_peer_t *peer)
+{
+  remove_retr_timer(peer);
+  oc_clock_time_t deadline = retr_deadline(peer);
+  oc_tls_peer_t **p = &retr_peers;
+  while (*p && retr_deadline(*p) <= deadline) {
+    p = &(*p)->retr_next;
+  }
+  peer->retr_next = *p;
+  *p = peer;
+  peer->retr_pending = true;
+}
+
+void
+oc_tls_peer_stats(oc_tls_peer_stats_t *stats)
+{
+  if (stats) {
+    memcpy(stats, &peer_stats, sizeof(oc_tls_peer_stats_t));
+  }
+}
+#endif /* OC_TLS_PEER_INDEX */
+
 static bool
 is_peer_active(oc_tls_peer_t *peer)
 {
+#ifdef OC_TLS_PEER_INDEX
+  oc_tls_peer_t *p =
+    peer_stats.peers ? peer_bucket(handle_hash(peer))->by_handle : NULL;
+  while (p != NULL) {
+    if (p == peer) {
+      return true;
+    }
+    p = p->handle_next;
+  }
+#else  /* OC_TLS_PEER_INDEX */
   oc_tls_peer_t *p = (oc_tls_peer_t *)oc_list_head(tls_peers);
   while (p != NULL) {
     if (p == peer) {
@@ -168,14 +392,435 @@ is_peer_active(oc_tls_peer_t *peer)
     }
     p = p->next;
   }
+#endif /* !OC_TLS_PEER_INDEX */
   return false;
 }
 
+static bool
+is_peer_busy(oc_tls_peer_t *peer)
+{
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  return peer->busy;
+#else  /* OC_TLS_HANDSHAKE_OFFLOAD */
+  (void)peer;
+  return false;
+#endif /* !OC_TLS_HANDSHAKE_OFFLOAD */
+}
+
+#ifdef OC_TLS_SESSION_CACHE
+/* Identities of the peers of resumable sessions, keyed by master secret and
+ * by the device that authenticated them. An abbreviated handshake skips the
+ * PSK callback and certificate verification that establish who the peer is,
+ * so its identity is restored from here. Cached sessions and tickets whose
+ * identity is no longer known, or was established with another device, are
+ * refused.
+ */
+typedef struct oc_tls_session_identity_t
+{
+  struct oc_tls_session_identity_t *next;
+  uint8_t master_secret[48];
+  size_t device;
+  oc_uuid_t uuid;
+#ifdef OC_PKI
+  uint8_t public_key[OC_KEYPAIR_PUBKEY_SIZE];
+#endif /* OC_PKI */
+} oc_tls_session_identity_t;
+OC_MEMB(session_identities_s, oc_tls_session_identity_t,
+        OC_TLS_SESSION_CACHE_ENTRIES);
+OC_LIST(session_identities);
+
+static mbedtls_ssl_cache_context session_cache;
+#ifdef OC_TLS_SESSION_TICKETS
+static mbedtls_ssl_ticket_context ticket_ctx;
+static bool tickets_ready;
+#endif /* OC_TLS_SESSION_TICKETS */
+
+#ifdef OC_CLIENT
+/* The last session established with each server, most recent first. */
+typedef struct oc_tls_client_session_t
+{
+  struct oc_tls_client_session_t *next;
+  oc_endpoint_t endpoint;
+  mbedtls_ssl_session session;
+  oc_uuid_t uuid;
+#ifdef OC_PKI
+  uint8_t public_key[OC_KEYPAIR_PUBKEY_SIZE];
+#endif /* OC_PKI */
+} oc_tls_client_session_t;
+OC_MEMB(client_sessions_s, oc_tls_client_session_t,
+        OC_TLS_SESSION_CACHE_ENTRIES);
+OC_LIST(client_sessions);
+#endif /* OC_CLIENT */
+
+static oc_tls_handshake_stats_t handshake_stats;
+
+static oc_tls_session_identity_t *
+find_session_identity(const unsigned char *master_secret, size_t device)
+{
+  oc_tls_session_identity_t *id =
+    (oc_tls_session_identity_t *)oc_list_head(session_identities);
+  while (id != NULL &&
+         (id->device != device ||
+          memcmp(id->master_secret, master_secret,
+                 sizeof(id->master_secret)) != 0)) {
+    id = id->next;
+  }
+  return id;
+}
+
+static void
+free_session_identity(oc_tls_session_identity_t *id)
+{
+  memset(id->master_secret, 0, sizeof(id->master_secret));
+  oc_memb_free(&session_identities_s, id);
+}
+
+static bool
+is_resumable(oc_tls_peer_t *peer)
+{
+  /* Anonymous sessions only serve ownership transfer, and are never resumed */
+  return peer->ssl_ctx.session->ciphersuite !=
+         MBEDTLS_TLS_ECDH_ANON_WITH_AES_128_CBC_SHA256;
+}
+
+/* The session cache and ticket callbacks are passed the peer, so that only
+ * sessions established with the peer's own device are resumed.
+ */
+static int
+get_cached_session(void *data, mbedtls_ssl_session *session)
+{
+  oc_tls_peer_t *peer = (oc_tls_peer_t *)data;
+  /* Look the session up on the side, so that session is left untouched
+   * unless it is resumed.
+   */
+  mbedtls_ssl_session cached;
+  mbedtls_ssl_session_init(&cached);
+  cached.ciphersuite = session->ciphersuite;
+  cached.compression = session->compression;
+  cached.id_len = session->id_len;
+  memcpy(cached.id, session->id, session->id_len);
+  if (mbedtls_ssl_cache_get(&session_cache, &cached) != 0 ||
+      !find_session_identity(cached.master, peer->endpoint.device)) {
+    mbedtls_ssl_session_free(&cached);
+    return 1;
+  }
+  mbedtls_ssl_session_free(session);
+  memcpy(session, &cached, sizeof(mbedtls_ssl_session));
+  return 0;
+}
+
+#ifdef OC_TLS_SESSION_TICKETS
+static int
+parse_ticket(void *data, mbedtls_ssl_session *session, unsigned char *buf,
+             size_t len)
+{
+  oc_tls_peer_t *peer = (oc_tls_peer_t *)data;
+  int ret = mbedtls_ssl_ticket_parse(&ticket_ctx, session, buf, len);
+  if (ret == 0 &&
+      !find_session_identity(session->master, peer->endpoint.device)) {
+    ret = MBEDTLS_ERR_SSL_SESSION_TICKET_EXPIRED;
+  }
+  return ret;
+}
+#endif /* OC_TLS_SESSION_TICKETS */
+
+/* Sessions are cached and tickets issued in the last steps of a handshake,
+ * which may run on a worker with OC_TLS_HANDSHAKE_OFFLOAD.
+ */
+static int
+set_cached_session(void *data, const mbedtls_ssl_session *session)
+{
+  (void)data;
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  oc_stack_mutex_lock();
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  int ret = mbedtls_ssl_cache_set(&session_cache, session);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  oc_stack_mutex_unlock();
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  return ret;
+}
+
+#ifdef OC_TLS_SESSION_TICKETS
+static int
+write_ticket(void *data, const mbedtls_ssl_session *session,
+             unsigned char *start, const unsigned char *end, size_t *tlen,
+             uint32_t *lifetime)
+{
+  (void)data;
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  oc_stack_mutex_lock();
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  int ret = mbedtls_ssl_ticket_write(&ticket_ctx, session, start, end, tlen,
+                                     lifetime);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  oc_stack_mutex_unlock();
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  return ret;
+}
+#endif /* OC_TLS_SESSION_TICKETS */
+
+static void
+store_session_identity(oc_tls_peer_t *peer)
+{
+  oc_tls_session_identity_t *id = find_session_identity(
+    peer->ssl_ctx.session->master, peer->endpoint.device);
+  if (id) {
+    oc_list_remove(session_identities, id);
+  } else {
+    if (oc_list_length(session_identities) >= OC_TLS_SESSION_CACHE_ENTRIES) {
+      free_session_identity(
+        (oc_tls_session_identity_t *)oc_list_chop(session_identities));
+    }
+    id = (oc_tls_session_identity_t *)oc_memb_alloc(&session_identities_s);
+    if (!id) {
+      OC_WRN("oc_tls: insufficient memory to cache session");
+      return;
+    }
+    memcpy(id->master_secret, peer->ssl_ctx.session->master,
+           sizeof(id->master_secret));
+    id->device = peer->endpoint.device;
+    memcpy(&id->uuid, &peer->uuid, sizeof(oc_uuid_t));
+#ifdef OC_PKI
+    memcpy(id->public_key, peer->public_key, sizeof(id->public_key));
+#endif /* OC_PKI */
+  }
+  oc_list_push(session_identities, id);
+}
+
+static bool
+restore_session_identity(oc_tls_peer_t *peer)
+{
+  oc_tls_session_identity_t *id = find_session_identity(
+    peer->ssl_ctx.session->master, peer->endpoint.device);
+  if (!id) {
+    return false;
+  }
+  memcpy(&peer->uuid, &id->uuid, sizeof(oc_uuid_t));
+#ifdef OC_PKI
+  memcpy(peer->public_key, id->public_key, sizeof(peer->public_key));
+#endif /* OC_PKI */
+  return true;
+}
+
+#ifdef OC_CLIENT
+static oc_tls_client_session_t *
+find_client_session(oc_endpoint_t *endpoint)
+{
+  oc_tls_client_session_t *s =
+    (oc_tls_client_session_t *)oc_list_head(client_sessions);
+  while (s != NULL && oc_endpoint_compare(&s->endpoint, endpoint) != 0) {
+    s = s->next;
+  }
+  return s;
+}
+
+static void
+free_client_session(oc_tls_client_session_t *s)
+{
+  mbedtls_ssl_session_free(&s->session);
+  oc_memb_free(&client_sessions_s, s);
+}
+
+static void
+forget_client_session(oc_endpoint_t *endpoint)
+{
+  oc_tls_client_session_t *s = find_client_session(endpoint);
+  if (s) {
+    oc_list_remove(client_sessions, s);
+    free_client_session(s);
+  }
+}
+
+static void
+resume_client_session(oc_tls_peer_t *peer)
+{
+  oc_tls_client_session_t *s = find_client_session(&peer->endpoint);
+  if (s && mbedtls_ssl_set_session(&peer->ssl_ctx, &s->session) == 0) {
+    OC_DBG("oc_tls: attempting to resume session");
+  }
+}
+
+static void
+store_client_session(oc_tls_peer_t *peer)
+{
+  oc_tls_client_session_t *s = find_client_session(&peer->endpoint);
+  if (s) {
+    oc_list_remove(client_sessions, s);
+    mbedtls_ssl_session_free(&s->session);
+  } else {
+    if (oc_list_length(client_sessions) >= OC_TLS_SESSION_CACHE_ENTRIES) {
+      free_client_session(
+        (oc_tls_client_session_t *)oc_list_chop(client_sessions));
+    }
+    s = (oc_tls_client_session_t *)oc_memb_alloc(&client_sessions_s);
+    if (!s) {
+      OC_WRN("oc_tls: insufficient memory to cache session");
+      return;
+    }
+    memcpy(&s->endpoint, &peer->endpoint, sizeof(oc_endpoint_t));
+  }
+  mbedtls_ssl_session_init(&s->session);
+  if (mbedtls_ssl_get_session(&peer->ssl_ctx, &s->session) != 0) {
+    free_client_session(s);
+    return;
+  }
+  memcpy(&s->uuid, &peer->uuid, sizeof(oc_uuid_t));
+#ifdef OC_PKI
+  memcpy(s->public_key, peer->public_key, sizeof(s->public_key));
+#endif /* OC_PKI */
+  oc_list_push(client_sessions, s);
+}
+
+static bool
+restore_client_identity(oc_tls_peer_t *peer)
+{
+  oc_tls_client_session_t *s = find_client_session(&peer->endpoint);
+  if (!s) {
+    return false;
+  }
+  memcpy(&peer->uuid, &s->uuid, sizeof(oc_uuid_t));
+#ifdef OC_PKI
+  memcpy(peer->public_key, s->public_key, sizeof(peer->public_key));
+#endif /* OC_PKI */
+  return true;
+}
+#endif /* OC_CLIENT */
+
+/* Called once the handshake with peer completes. Returns false if the
+ * identity of a peer that resumed a session could not be restored.
+ */
+static bool
+session_established(oc_tls_peer_t *peer)
+{
+  if (peer->resumed) {
+    handshake_stats.abbreviated++;
+#ifdef OC_CLIENT
+    if (peer->role == MBEDTLS_SSL_IS_CLIENT) {
+      if (!restore_client_identity(peer)) {
+        return false;
+      }
+    } else
+#endif /* OC_CLIENT */
+    {
+      if (!restore_session_identity(peer)) {
+        return false;
+      }
+    }
+  } else {
+    handshake_stats.full++;
+  }
+  if (!is_resumable(peer)) {
+    return true;
+  }
+#ifdef OC_CLIENT
+  if (peer->role == MBEDTLS_SSL_IS_CLIENT) {
+    store_client_session(peer);
+    return true;
+  }
+#endif /* OC_CLIENT */
+  store_session_identity(peer);
+  return true;
+}
+
+static void
+configure_session_cache(oc_tls_peer_t *peer)
+{
+  mbedtls_ssl_config *conf = &peer->ssl_conf;
+  if (peer->role == MBEDTLS_SSL_IS_SERVER) {
+    mbedtls_ssl_conf_session_cache(conf, peer, get_cached_session,
+                                   set_cached_session);
+#ifdef OC_TLS_SESSION_TICKETS
+    if (tickets_ready) {
+      mbedtls_ssl_conf_session_tickets_cb(conf, write_ticket, parse_ticket,
+                                          peer);
+    }
+#endif /* OC_TLS_SESSION_TICKETS */
+  }
+#ifdef OC_TLS_SESSION_TICKETS
+  mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_ENABLED);
+#else  /* OC_TLS_SESSION_TICKETS */
+  mbedtls_ssl_conf_session_tickets(conf, MBEDTLS_SSL_SESSION_TICKETS_DISABLED);
+#endif /* !OC_TLS_SESSION_TICKETS */
+}
+
+static void
+init_session_cache(void)
+{
+  mbedtls_ssl_cache_init(&session_cache);
+  mbedtls_ssl_cache_set_max_entries(&session_cache,
+                                    OC_TLS_SESSION_CACHE_ENTRIES);
+#ifdef MBEDTLS_HAVE_TIME
+  mbedtls_ssl_cache_set_timeout(&session_cache, OC_TLS_SESSION_CACHE_TIMEOUT);
+#endif /* MBEDTLS_HAVE_TIME */
+#ifdef OC_TLS_SESSION_TICKETS
+  mbedtls_ssl_ticket_init(&ticket_ctx);
+  tickets_ready =
+    (mbedtls_ssl_ticket_setup(&ticket_ctx, mbedtls_ctr_drbg_random,
+                              &ctr_drbg_ctx, MBEDTLS_CIPHER_AES_128_GCM,
+                              OC_TLS_SESSION_CACHE_TIMEOUT) == 0);
+  if (!tickets_ready) {
+    OC_WRN("oc_tls: could not set up session tickets");
+  }
+#endif /* OC_TLS_SESSION_TICKETS */
+}
+
+void
+oc_tls_flush_sessions(void)
+{
+  /* Entries left in the session cache and outstanding tickets are refused
+   * once their identity is gone.
+   */
+  oc_tls_session_identity_t *id =
+    (oc_tls_session_identity_t *)oc_list_pop(session_identities);
+  while (id != NULL) {
+    free_session_identity(id);
+    id = (oc_tls_session_identity_t *)oc_list_pop(session_identities);
+  }
+#ifdef OC_CLIENT
+  oc_tls_client_session_t *s =
+    (oc_tls_client_session_t *)oc_list_pop(client_sessions);
+  while (s != NULL) {
+    free_client_session(s);
+    s = (oc_tls_client_session_t *)oc_list_pop(client_sessions);
+  }
+#endif /* OC_CLIENT */
+}
+
+static void
+free_session_cache(void)
+{
+  oc_tls_flush_sessions();
+  mbedtls_ssl_cache_free(&session_cache);
+#ifdef OC_TLS_SESSION_TICKETS
+  mbedtls_ssl_ticket_free(&ticket_ctx);
+  tickets_ready = false;
+#endif /* OC_TLS_SESSION_TICKETS */
+}
+
+void
+oc_tls_handshake_stats(oc_tls_handshake_stats_t *stats)
+{
+  memcpy(stats, &handshake_stats, sizeof(oc_tls_handshake_stats_t));
+}
+#endif /* OC_TLS_SESSION_CACHE */
+
 static oc_event_callback_retval_t oc_tls_inactive(void *data);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+static void run_handshake_job(oc_worker_job_t *job);
+static bool offload_handshake(oc_tls_peer_t *peer);
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
 
 static void
 oc_tls_free_peer(oc_tls_peer_t *peer, bool inactivity_cb)
 {
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  if (peer->busy) {
+    /* Freed once the worker returns it */
+    peer->free_pending = true;
+    return;
+  }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
   OC_DBG("\noc_tls: removing peer");
 
 #ifdef OC_PKI
@@ -195,6 +840,13 @@ oc_tls_free_peer(oc_tls_peer_t *peer, bool inactivity_cb)
   if (!inactivity_cb) {
     oc_ri_remove_timed_event_callback(peer, oc_tls_inactive);
   }
+#if defined(OC_TLS_SESSION_CACHE) && defined(OC_CLIENT)
+  /* Do not offer a session again that the server failed to resume */
+  if (peer->role == MBEDTLS_SSL_IS_CLIENT && peer->resumed &&
+      peer->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+    forget_client_session(&peer->endpoint);
+  }
+#endif /* OC_TLS_SESSION_CACHE && OC_CLIENT */
   mbedtls_ssl_free(&peer->ssl_ctx);
   oc_message_t *message = (oc_message_t *)oc_list_pop(peer->send_q);
   while (message != NULL) {
@@ -207,7 +859,14 @@ oc_tls_free_peer(oc_tls_peer_t *peer, bool inactivity_cb)
     message = (oc_message_t *)oc_list_pop(peer->recv_q);
   }
   mbedtls_ssl_config_free(&peer->ssl_conf);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  mbedtls_ctr_drbg_free(&peer->drbg);
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
   oc_etimer_stop(&peer->timer.fin_timer);
+#ifdef OC_TLS_PEER_INDEX
+  remove_retr_timer(peer);
+  remove_from_peer_index(peer);
+#endif /* OC_TLS_PEER_INDEX */
   oc_list_remove(tls_peers, peer);
   oc_memb_free(&tls_peers_s, peer);
 }
@@ -215,6 +874,28 @@ oc_tls_free_peer(oc_tls_peer_t *peer, bool inactivity_cb)
 oc_tls_peer_t *
 oc_tls_get_peer(oc_endpoint_t *endpoint)
 {
+#ifdef OC_TLS_PEER_INDEX
+  peer_stats.lookups++;
+  if (peer_stats.peers == 0) {
+    return NULL;
+  }
+  uint32_t hash = endpoint_hash(endpoint), probes = 0;
+  oc_tls_peer_t *peer = peer_bucket(hash)->by_endpoint;
+  while (peer != NULL) {
+    if (peer->endpoint_hash == hash) {
+      probes++;
+      if (oc_endpoint_compare(&peer->endpoint, endpoint) == 0) {
+        break;
+      }
+    }
+    peer = peer->endpoint_next;
+  }
+  peer_stats.probes += probes;
+  if (probes > peer_stats.max_probes) {
+    peer_stats.max_probes = probes;
+  }
+  return peer;
+#else  /* OC_TLS_PEER_INDEX */
   oc_tls_peer_t *peer = oc_list_head(tls_peers);
   while (peer != NULL) {
     if (oc_endpoint_compare(&peer->endpoint, endpoint) == 0) {
@@ -223,6 +904,7 @@ oc_tls_get_peer(oc_endpoint_t *endpoint)
     peer = peer->next;
   }
   return NULL;
+#endif /* !OC_TLS_PEER_INDEX */
 }
 
 void
@@ -261,7 +943,9 @@ oc_tls_inactive(void *data)
       OC_DBG("oc_tls: Resetting DTLS inactivity callback");
       return OC_EVENT_CONTINUE;
     }
-    mbedtls_ssl_close_notify(&peer->ssl_ctx);
+    if (!is_peer_busy(peer)) {
+      mbedtls_ssl_close_notify(&peer->ssl_ctx);
+    }
     oc_tls_free_peer(peer, true);
   }
   OC_DBG("oc_tls: Terminating DTLS inactivity callback");
@@ -272,7 +956,13 @@ static int
 ssl_recv(void *ctx, unsigned char *buf, size_t len)
 {
   oc_tls_peer_t *peer = (oc_tls_peer_t *)ctx;
-  oc_message_t *message = (oc_message_t *)oc_list_head(peer->recv_q);
+  oc_list_t recv_q = peer->recv_q;
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  if (peer->busy) {
+    recv_q = peer->job_q;
+  }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  oc_message_t *message = (oc_message_t *)oc_list_head(recv_q);
   if (message) {
     size_t recv_len = 0;
 #ifdef OC_TCP
@@ -282,7 +972,7 @@ ssl_recv(void *ctx, unsigned char *buf, size_t len)
       memcpy(buf, message->data + message->read_offset, recv_len);
       message->read_offset += recv_len;
       if (message->read_offset == message->length) {
-        oc_list_remove(peer->recv_q, message);
+        oc_list_remove(recv_q, message);
         oc_message_unref(message);
       }
     } else
@@ -290,7 +980,7 @@ ssl_recv(void *ctx, unsigned char *buf, size_t len)
     {
       recv_len = (message->length < len) ? message->length : len;
       memcpy(buf, message->data, recv_len);
-      oc_list_remove(peer->recv_q, message);
+      oc_list_remove(recv_q, message);
       oc_message_unref(message);
     }
     return (int)recv_len;
@@ -303,72 +993,140 @@ ssl_send(void *ctx, const unsigned char *buf, size_t len)
 {
   oc_tls_peer_t *peer = (oc_tls_peer_t *)ctx;
   peer->timestamp = oc_clock_time();
-  oc_message_t message;
 #ifdef OC_DYNAMIC_ALLOCATION
-  message.data = malloc(OC_PDU_SIZE);
-  if (!message.data)
-    return 0;
-#endif /* OC_DYNAMIC_ALLOCATION */
+  /* oc_send_buffer() is done with the record when it returns, so it is sent
+   * straight out of mbedTLS's output buffer.
+   */
+  oc_message_t *message = &peer->record;
+  message->data = (uint8_t *)buf;
+  message->length = len;
+  int ret = oc_send_buffer(message);
+  message->data = NULL;
+  return ret;
+#else  /* OC_DYNAMIC_ALLOCATION */
+  oc_message_t message;
   memcpy(&message.endpoint, &peer->endpoint, sizeof(oc_endpoint_t));
   size_t send_len = (len < (unsigned)OC_PDU_SIZE) ? len : (unsigned)OC_PDU_SIZE;
   memcpy(message.data, buf, send_len);
   message.length = send_len;
   message.encrypted = 1;
-  int ret = oc_send_buffer(&message);
-#ifdef OC_DYNAMIC_ALLOCATION
-  free(message.data);
-#endif /* OC_DYNAMIC_ALLOCATION */
-  return ret;
+#ifdef OC_SHARED_PAYLOADS
+  message.payload = NULL;
+#endif /* OC_SHARED_PAYLOADS */
+  return oc_send_buffer(&message);
+#endif /* !OC_DYNAMIC_ALLOCATION */
+}
+
+static void
+retransmit_handshake(oc_tls_peer_t *peer)
+{
+  if (is_peer_busy(peer) ||
+      peer->ssl_ctx.state == MBEDTLS_SSL_HANDSHAKE_OVER) {
+    return;
+  }
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  if (offload_handshake(peer)) {
+    return;
+  }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  int ret = mbedtls_ssl_handshake(&peer->ssl_ctx);
+  if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+    mbedtls_ssl_session_reset(&peer->ssl_ctx);
+    if (peer->role == MBEDTLS_SSL_IS_SERVER &&
+        mbedtls_ssl_set_client_transport_id(
+            &peer->ssl_ctx, (const unsigned char *)&peer->endpoint.addr,
+            sizeof(peer->endpoint.addr)) != 0) {
+      oc_tls_free_peer(peer, false);
+      return;
+    }
+  }
+  if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
+      ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+#ifdef OC_DEBUG
+    char buf[256];
+    mbedtls_strerror(ret, buf, 256);
+    OC_ERR("oc_tls: mbedtls_error: %s", buf);
+#endif /* OC_DEBUG */
+    oc_tls_free_peer(peer, false);
+  }
 }
 
 static void
 check_retr_timers(void)
 {
+#ifdef OC_TLS_PEER_INDEX
+  /* Only peers with an armed timer are kept in retr_peers, ordered by their
+   * deadlines, so the expired ones are at its front. They are taken off first
+   * since a retransmission arms the timer again.
+   */
+  oc_tls_peer_t *expired = NULL, **tail = &expired;
+  while (retr_peers && oc_etimer_expired(&retr_peers->timer.fin_timer)) {
+    oc_tls_peer_t *peer = retr_peers;
+    retr_peers = peer->retr_next;
+    peer->retr_pending = false;
+    peer->retr_next = NULL;
+    *tail = peer;
+    tail = &peer->retr_next;
+    peer_stats.retr_checks++;
+  }
+  while (expired != NULL) {
+    oc_tls_peer_t *peer = expired;
+    expired = peer->retr_next;
+    retransmit_handshake(peer);
+  }
+#else  /* OC_TLS_PEER_INDEX */
   oc_tls_peer_t *peer = (oc_tls_peer_t *)oc_list_head(tls_peers), *next;
   while (peer != NULL) {
     next = peer->next;
-    if (peer->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
-      if (oc_etimer_expired(&peer->timer.fin_timer)) {
-        int ret = mbedtls_ssl_handshake(&peer->ssl_ctx);
-        if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
-          mbedtls_ssl_session_reset(&peer->ssl_ctx);
-          if (peer->role == MBEDTLS_SSL_IS_SERVER &&
-              mbedtls_ssl_set_client_transport_id(
-                  &peer->ssl_ctx, (const unsigned char *)&peer->endpoint.addr,
-                  sizeof(peer->endpoint.addr)) != 0) {
-            oc_tls_free_peer(peer, false);
-            peer = next;
-            continue;
-          }
-        }
-        if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
-            ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-#ifdef OC_DEBUG
-          char buf[256];
-          mbedtls_strerror(ret, buf, 256);
-          OC_ERR("oc_tls: mbedtls_error: %s", buf);
-#endif /* OC_DEBUG */
-          oc_tls_free_peer(peer, false);
-        }
-      }
+    if (oc_etimer_expired(&peer->timer.fin_timer)) {
+      retransmit_handshake(peer);
     }
     peer = next;
   }
+#endif /* !OC_TLS_PEER_INDEX */
 }
 
 static void
-ssl_set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+set_retr_timer(oc_tls_peer_t *peer, oc_clock_time_t int_ticks,
+               oc_clock_time_t fin_ticks)
 {
-  if (fin_ms != 0) {
-    oc_tls_retr_timer_t *timer = (oc_tls_retr_timer_t *)ctx;
-    timer->int_ticks = (oc_clock_time_t)((int_ms * OC_CLOCK_SECOND) / 1.e03);
+  if (fin_ticks != 0) {
+    oc_tls_retr_timer_t *timer = &peer->timer;
+    timer->int_ticks = int_ticks;
     oc_etimer_stop(&timer->fin_timer);
-    timer->fin_timer.timer.interval =
-        (oc_clock_time_t)((fin_ms * OC_CLOCK_SECOND) / 1.e03);
+    timer->fin_timer.timer.interval = fin_ticks;
     OC_PROCESS_CONTEXT_BEGIN(&oc_tls_handler);
     oc_etimer_restart(&timer->fin_timer);
     OC_PROCESS_CONTEXT_END(&oc_tls_handler);
+#ifdef OC_TLS_PEER_INDEX
+    add_retr_timer(peer);
+  } else {
+    /* The handshake cancelled its timer, so it does not need a
+       retransmission when the timer fires. */
+    remove_retr_timer(peer);
+#endif /* OC_TLS_PEER_INDEX */
+  }
+}
+
+static void
+ssl_set_timer(void *ctx, uint32_t int_ms, uint32_t fin_ms)
+{
+  oc_tls_peer_t *peer =
+    (oc_tls_peer_t *)((char *)ctx - offsetof(oc_tls_peer_t, timer));
+  oc_clock_time_t int_ticks =
+    (oc_clock_time_t)((int_ms * OC_CLOCK_SECOND) / 1.e03);
+  oc_clock_time_t fin_ticks =
+    (oc_clock_time_t)((fin_ms * OC_CLOCK_SECOND) / 1.e03);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  if (peer->busy) {
+    peer->job_timer.start = oc_clock_time();
+    peer->job_timer.int_ticks = int_ticks;
+    peer->job_timer.fin_ticks = fin_ticks;
+    peer->job_timer.changed = true;
+    return;
   }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+  set_retr_timer(peer, int_ticks, fin_ticks);
 }
 
 static int
@@ -378,6 +1136,13 @@ get_psk_cb(void *data, mbedtls_ssl_context *ssl, const unsigned char *identity,
   (void)data;
   (void)identity_len;
   OC_DBG("oc_tls: In PSK callback");
+#ifdef OC_TLS_PEER_INDEX
+  oc_tls_peer_t *peer =
+    (oc_tls_peer_t *)((char *)ssl - offsetof(oc_tls_peer_t, ssl_ctx));
+  if (!is_peer_active(peer)) {
+    peer = NULL;
+  }
+#else  /* OC_TLS_PEER_INDEX */
   oc_tls_peer_t *peer = oc_list_head(tls_peers);
   while (peer != NULL) {
     if (&peer->ssl_ctx == ssl) {
@@ -385,6 +1150,7 @@ get_psk_cb(void *data, mbedtls_ssl_context *ssl, const unsigned char *identity,
     }
     peer = peer->next;
   }
+#endif /* !OC_TLS_PEER_INDEX */
   if (peer) {
     OC_DBG("oc_tls: Found peer object");
     oc_sec_cred_t *cred =
@@ -406,10 +1172,46 @@ get_psk_cb(void *data, mbedtls_ssl_context *ssl, const unsigned char *identity,
   return -1;
 }
 
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+/* Callbacks that look into the stack may be called from handshake steps
+ * running on a worker, so they take the stack mutex. It is recursive, so this
+ * is harmless on the event loop thread.
+ */
+static int
+get_psk_cb_locked(void *data, mbedtls_ssl_context *ssl,
+                  const unsigned char *identity, size_t identity_len)
+{
+  oc_stack_mutex_lock();
+  int ret = get_psk_cb(data, ssl, identity, identity_len);
+  oc_stack_mutex_unlock();
+  return ret;
+}
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+
 static int
 ssl_get_timer(void *ctx)
 {
   oc_tls_retr_timer_t *timer = (oc_tls_retr_timer_t *)ctx;
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  oc_tls_peer_t *peer =
+    (oc_tls_peer_t *)((char *)ctx - offsetof(oc_tls_peer_t, timer));
+  if (peer->busy) {
+    oc_tls_job_timer_t *job_timer = &peer->job_timer;
+    if (job_timer->fin_ticks == 0) {
+      return -1;
+    }
+    oc_clock_time_t elapsed = oc_clock_time() - job_timer->start;
+    if (elapsed >= job_timer->fin_ticks) {
+      job_timer->fin_ticks = 0;
+      job_timer->int_ticks = 0;
+      job_timer->changed = true;
+      return 2;
+    } else if (elapsed > job_timer->int_ticks) {
+      return 1;
+    }
+    return 0;
+  }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
   if (timer->fin_timer.timer.interval == 0)
     return -1;
   if (oc_etimer_expired(&timer->fin_timer)) {
@@ -903,6 +1705,18 @@ verify_certificate(void *opq, mbedtls_x509_crt *crt, int depth, uint32_t *flags)
   OC_DBG("verified certificate at depth %d", depth);
   return 0;
 }
+
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+static int
+verify_certificate_locked(void *opq, mbedtls_x509_crt *crt, int depth,
+                          uint32_t *flags)
+{
+  oc_stack_mutex_lock();
+  int ret = verify_certificate(opq, crt, depth, flags);
+  oc_stack_mutex_unlock();
+  return ret;
+}
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
 #endif /* OC_PKI */
 
 static int
@@ -929,7 +1743,11 @@ oc_tls_populate_ssl_config(mbedtls_ssl_config *conf, size_t device, int role,
   mbedtls_ssl_conf_min_version(conf, MBEDTLS_SSL_MAJOR_VERSION_3,
                                MBEDTLS_SSL_MINOR_VERSION_3);
   mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  mbedtls_ssl_conf_psk_cb(conf, get_psk_cb_locked, NULL);
+#else  /* OC_TLS_HANDSHAKE_OFFLOAD */
   mbedtls_ssl_conf_psk_cb(conf, get_psk_cb, NULL);
+#endif /* !OC_TLS_HANDSHAKE_OFFLOAD */
   if (transport_type == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
     mbedtls_ssl_conf_dtls_cookies(conf, mbedtls_ssl_cookie_write,
                                   mbedtls_ssl_cookie_check, &cookie_ctx);
@@ -967,7 +1785,19 @@ oc_tls_add_peer(oc_endpoint_t *endpoint, int role)
       OC_LIST_STRUCT_INIT(peer, send_q);
       peer->next = 0;
       peer->role = role;
+#ifdef OC_TLS_SESSION_CACHE
+      peer->resumed = false;
+#endif /* OC_TLS_SESSION_CACHE */
       memset(&peer->timer, 0, sizeof(oc_tls_retr_timer_t));
+#ifdef OC_ACL_CACHE
+      memset(&peer->acl_cache, 0, sizeof(oc_sec_acl_cache_t));
+#endif /* OC_ACL_CACHE */
+#ifdef OC_DYNAMIC_ALLOCATION
+      memset(&peer->record, 0, sizeof(oc_message_t));
+      memcpy(&peer->record.endpoint, endpoint, sizeof(oc_endpoint_t));
+      peer->record.ref_count = 1;
+      peer->record.encrypted = 1;
+#endif /* OC_DYNAMIC_ALLOCATION */
       mbedtls_ssl_init(&peer->ssl_ctx);
 
       int transport_type = (endpoint->flags & TCP)
@@ -977,11 +1807,38 @@ oc_tls_add_peer(oc_endpoint_t *endpoint, int role)
       oc_tls_populate_ssl_config(&peer->ssl_conf, endpoint->device, role,
                                  transport_type);
 
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+      peer->handshake_job.run = run_handshake_job;
+      OC_LIST_STRUCT_INIT(peer, job_q);
+      peer->busy = false;
+      peer->free_pending = false;
+      /* Handshake steps on workers draw from a generator of their own,
+       * seeded from the shared one.
+       */
+      mbedtls_ctr_drbg_init(&peer->drbg);
+      peer->can_offload =
+        transport_type == MBEDTLS_SSL_TRANSPORT_DATAGRAM &&
+        mbedtls_ctr_drbg_seed(&peer->drbg, mbedtls_ctr_drbg_random,
+                              &ctr_drbg_ctx, NULL, 0) == 0;
+      if (peer->can_offload) {
+        mbedtls_ssl_conf_rng(&peer->ssl_conf, mbedtls_ctr_drbg_random,
+                             &peer->drbg);
+      }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+
 #ifdef OC_PKI
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+      mbedtls_ssl_conf_verify(&peer->ssl_conf, verify_certificate_locked,
+                              peer);
+#else  /* OC_TLS_HANDSHAKE_OFFLOAD */
       mbedtls_ssl_conf_verify(&peer->ssl_conf, verify_certificate, peer);
+#endif /* !OC_TLS_HANDSHAKE_OFFLOAD */
 #endif /* OC_PKI */
 
       oc_tls_set_ciphersuites(&peer->ssl_conf, endpoint);
+#ifdef OC_TLS_SESSION_CACHE
+      configure_session_cache(peer);
+#endif /* OC_TLS_SESSION_CACHE */
 
       int err = mbedtls_ssl_setup(&peer->ssl_ctx, &peer->ssl_conf);
 
@@ -1000,6 +1857,17 @@ oc_tls_add_peer(oc_endpoint_t *endpoint, int role)
         oc_memb_free(&tls_peers_s, peer);
         return NULL;
       }
+#ifdef OC_TLS_PEER_INDEX
+      if (!add_to_peer_index(peer)) {
+        mbedtls_ssl_free(&peer->ssl_ctx);
+        mbedtls_ssl_config_free(&peer->ssl_conf);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+        mbedtls_ctr_drbg_free(&peer->drbg);
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+        oc_memb_free(&tls_peers_s, peer);
+        return NULL;
+      }
+#endif /* OC_TLS_PEER_INDEX */
       oc_list_add(tls_peers, peer);
 
       if (!(endpoint->flags & TCP)) {
@@ -1038,6 +1906,9 @@ oc_tls_shutdown(void)
   }
   mbedtls_x509_crt_free(&trust_anchors);
 #endif /* OC_PKI */
+#ifdef OC_TLS_SESSION_CACHE
+  free_session_cache();
+#endif /* OC_TLS_SESSION_CACHE */
   mbedtls_ctr_drbg_free(&ctr_drbg_ctx);
   mbedtls_ssl_cookie_free(&cookie_ctx);
   mbedtls_entropy_free(&entropy_ctx);
@@ -1070,6 +1941,9 @@ oc_tls_init_context(void)
 #ifdef OC_PKI
   mbedtls_x509_crt_init(&trust_anchors);
 #endif /* OC_PKI */
+#ifdef OC_TLS_SESSION_CACHE
+  init_session_cache();
+#endif /* OC_TLS_SESSION_CACHE */
 
   return 0;
 dtls_init_err:
@@ -1083,7 +1957,9 @@ oc_tls_close_connection(oc_endpoint_t *endpoint)
 {
   oc_tls_peer_t *peer = oc_tls_get_peer(endpoint);
   if (peer) {
-    mbedtls_ssl_close_notify(&peer->ssl_ctx);
+    if (!is_peer_busy(peer)) {
+      mbedtls_ssl_close_notify(&peer->ssl_ctx);
+    }
     oc_tls_free_peer(peer, false);
   }
 }
@@ -1255,7 +2131,9 @@ oc_tls_send_message(oc_message_t *message)
 {
   size_t length = 0;
   oc_tls_peer_t *peer = oc_tls_get_peer(&message->endpoint);
-  if (peer) {
+  if (peer && is_peer_busy(peer)) {
+    OC_WRN("oc_tls: dropping message to peer in handshake");
+  } else if (peer) {
     int ret = mbedtls_ssl_write(&peer->ssl_ctx, (unsigned char *)message->data,
                                 message->length);
     if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
@@ -1282,6 +2160,9 @@ write_application_data(oc_tls_peer_t *peer)
     OC_DBG("oc_tls: write_application_data: Peer not active");
     return;
   }
+  if (is_peer_busy(peer)) {
+    return;
+  }
   oc_message_t *message = (oc_message_t *)oc_list_pop(peer->send_q);
   while (message != NULL) {
     int ret = mbedtls_ssl_write(&peer->ssl_ctx, (unsigned char *)message->data,
@@ -1318,6 +2199,16 @@ oc_tls_init_connection(oc_message_t *message)
       oc_message_add_ref(message);
       oc_list_add(peer->send_q, message);
     }
+    if (is_peer_busy(peer)) {
+      /* Written once the worker is done with the handshake */
+      oc_message_unref(message);
+      return;
+    }
+#ifdef OC_TLS_SESSION_CACHE
+    if (peer->ssl_ctx.state == MBEDTLS_SSL_HELLO_REQUEST) {
+      resume_client_session(peer);
+    }
+#endif /* OC_TLS_SESSION_CACHE */
     int ret = mbedtls_ssl_handshake(&peer->ssl_ctx);
     if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
         ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
@@ -1360,12 +2251,179 @@ bool
 oc_tls_connected(oc_endpoint_t *endpoint)
 {
   oc_tls_peer_t *peer = oc_tls_get_peer(endpoint);
-  if (peer) {
+  if (peer && !is_peer_busy(peer)) {
     return (peer->ssl_ctx.state == MBEDTLS_SSL_HANDSHAKE_OVER);
   }
   return false;
 }
 
+/* Runs the next step of the handshake with peer. */
+static int
+step_handshake(oc_tls_peer_t *peer)
+{
+  int ret = mbedtls_ssl_handshake_step(&peer->ssl_ctx);
+#ifdef OC_TLS_SESSION_CACHE
+  if (peer->ssl_ctx.handshake && peer->ssl_ctx.handshake->resume) {
+    peer->resumed = true;
+  }
+#endif /* OC_TLS_SESSION_CACHE */
+  if (peer->ssl_ctx.state == MBEDTLS_SSL_CLIENT_CHANGE_CIPHER_SPEC ||
+      peer->ssl_ctx.state == MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC) {
+    memcpy(peer->master_secret, peer->ssl_ctx.session_negotiate->master,
+           sizeof(peer->master_secret));
+    OC_DBG("oc_tls: Got master secret");
+    OC_LOGbytes(peer->master_secret, 48);
+  }
+  if (peer->ssl_ctx.state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE ||
+      peer->ssl_ctx.state == MBEDTLS_SSL_SERVER_KEY_EXCHANGE) {
+    memcpy(peer->client_server_random, peer->ssl_ctx.handshake->randbytes,
+           sizeof(peer->client_server_random));
+    OC_DBG("oc_tls: Got nonce");
+    OC_LOGbytes(peer->client_server_random, 64);
+  }
+  if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+    mbedtls_ssl_session_reset(&peer->ssl_ctx);
+    /* For HelloVerifyRequest cookies */
+    if (peer->role == MBEDTLS_SSL_IS_SERVER) {
+      int err = mbedtls_ssl_set_client_transport_id(
+        &peer->ssl_ctx, (const unsigned char *)&peer->endpoint.addr,
+        sizeof(peer->endpoint.addr));
+      if (err != 0) {
+        return err;
+      }
+    }
+  }
+  return ret;
+}
+
+/* Acts on the outcome of the last handshake step. Returns false if peer was
+ * freed.
+ */
+static bool
+finish_handshake_steps(oc_tls_peer_t *peer, int ret)
+{
+  if (ret < 0 && ret != MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED &&
+      ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+#ifdef OC_DEBUG
+    char buf[256];
+    mbedtls_strerror(ret, buf, 256);
+    OC_ERR("oc_tls: mbedtls_error: %s", buf);
+#endif /* OC_DEBUG */
+    oc_tls_free_peer(peer, false);
+    return false;
+  }
+  if (peer->ssl_ctx.state == MBEDTLS_SSL_HANDSHAKE_OVER) {
+    OC_DBG("oc_tls: (D)TLS Session is connected via ciphersuite [0x%x]",
+           peer->ssl_ctx.session->ciphersuite);
+#ifdef OC_TLS_SESSION_CACHE
+    if (!session_established(peer)) {
+      OC_ERR("oc_tls: could not restore the identity of a resumed session");
+      mbedtls_ssl_close_notify(&peer->ssl_ctx);
+      oc_tls_free_peer(peer, false);
+      return false;
+    }
+#endif /* OC_TLS_SESSION_CACHE */
+    oc_handle_session(&peer->endpoint, OC_SESSION_CONNECTED);
+  }
+#ifdef OC_CLIENT
+  if (ret == 0) {
+    oc_tls_handler_schedule_write(peer);
+  }
+#endif /* OC_CLIENT */
+  return true;
+}
+
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+static void
+return_records(oc_tls_peer_t *peer)
+{
+  /* Records the worker left over precede those that arrived meanwhile */
+  oc_message_t *message = (oc_message_t *)oc_list_pop(peer->recv_q);
+  while (message != NULL) {
+    oc_list_add(peer->job_q, message);
+    message = (oc_message_t *)oc_list_pop(peer->recv_q);
+  }
+  message = (oc_message_t *)oc_list_pop(peer->job_q);
+  while (message != NULL) {
+    oc_list_add(peer->recv_q, message);
+    message = (oc_message_t *)oc_list_pop(peer->job_q);
+  }
+}
+
+/* Hands the remaining steps of a DTLS handshake to a worker once the hellos
+ * are through, which is where the key exchange and certificate checks begin.
+ * Cookie checks and session cache lookups thus stay on the event loop.
+ */
+static bool
+offload_handshake(oc_tls_peer_t *peer)
+{
+  if (!peer->can_offload || peer->ssl_ctx.state <= MBEDTLS_SSL_SERVER_HELLO) {
+    return false;
+  }
+  oc_tls_job_timer_t *job_timer = &peer->job_timer;
+  job_timer->start = peer->timer.fin_timer.timer.start;
+  job_timer->int_ticks = peer->timer.int_ticks;
+  job_timer->fin_ticks = peer->timer.fin_timer.timer.interval;
+  job_timer->changed = false;
+  peer->busy = true;
+  oc_list_copy(peer->job_q, peer->recv_q);
+  oc_list_init(peer->recv_q);
+  if (!oc_worker_pool_dispatch_job(&peer->handshake_job, &peer->endpoint)) {
+    peer->busy = false;
+    return_records(peer);
+    return false;
+  }
+  return true;
+}
+
+static void
+complete_handshake_job(oc_tls_peer_t *peer, int ret)
+{
+  peer->busy = false;
+  return_records(peer);
+
+  oc_tls_job_timer_t *job_timer = &peer->job_timer;
+  if (job_timer->changed) {
+    /* Armed from now on, late by the time the steps took */
+    set_retr_timer(peer, job_timer->int_ticks, job_timer->fin_ticks);
+    if (job_timer->fin_ticks == 0) {
+      oc_etimer_stop(&peer->timer.fin_timer);
+      peer->timer.fin_timer.timer.interval = 0;
+      peer->timer.int_ticks = 0;
+    }
+  } else if (peer->timer.fin_timer.timer.interval != 0 &&
+             oc_etimer_expired(&peer->timer.fin_timer)) {
+    /* Its expiry was passed over while the peer was busy */
+    set_retr_timer(peer, peer->timer.int_ticks,
+                   peer->timer.fin_timer.timer.interval);
+  }
+
+  if (peer->free_pending) {
+    oc_tls_free_peer(peer, false);
+    return;
+  }
+  if (finish_handshake_steps(peer, ret) && oc_list_head(peer->recv_q)) {
+    oc_tls_handler_schedule_read(peer);
+  }
+}
+
+static void
+run_handshake_job(oc_worker_job_t *job)
+{
+  oc_tls_peer_t *peer =
+    (oc_tls_peer_t *)((char *)job - offsetof(oc_tls_peer_t, handshake_job));
+  int ret;
+  do {
+    ret = step_handshake(peer);
+  } while (ret == 0 && peer->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER);
+
+  oc_stack_mutex_lock();
+  complete_handshake_job(peer, ret);
+  oc_stack_mutex_unlock();
+  _oc_signal_event_loop();
+}
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+
 static void
 read_application_data(oc_tls_peer_t *peer)
 {
@@ -1374,56 +2432,22 @@ read_application_data(oc_tls_peer_t *peer)
     OC_DBG("oc_tls: read_application_data: Peer not active");
     return;
   }
+  if (is_peer_busy(peer)) {
+    /* Read once the worker hands the peer back */
+    return;
+  }
 
   if (peer->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
     int ret = 0;
     do {
-      ret = mbedtls_ssl_handshake_step(&peer->ssl_ctx);
-      if (peer->ssl_ctx.state == MBEDTLS_SSL_CLIENT_CHANGE_CIPHER_SPEC ||
-          peer->ssl_ctx.state == MBEDTLS_SSL_SERVER_CHANGE_CIPHER_SPEC) {
-        memcpy(peer->master_secret, peer->ssl_ctx.session_negotiate->master,
-               sizeof(peer->master_secret));
-        OC_DBG("oc_tls: Got master secret");
-        OC_LOGbytes(peer->master_secret, 48);
-      }
-      if (peer->ssl_ctx.state == MBEDTLS_SSL_CLIENT_KEY_EXCHANGE ||
-          peer->ssl_ctx.state == MBEDTLS_SSL_SERVER_KEY_EXCHANGE) {
-        memcpy(peer->client_server_random, peer->ssl_ctx.handshake->randbytes,
-               sizeof(peer->client_server_random));
-        OC_DBG("oc_tls: Got nonce");
-        OC_LOGbytes(peer->client_server_random, 64);
-      }
-      if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
-        mbedtls_ssl_session_reset(&peer->ssl_ctx);
-        /* For HelloVerifyRequest cookies */
-        if (peer->role == MBEDTLS_SSL_IS_SERVER &&
-            mbedtls_ssl_set_client_transport_id(
-                &peer->ssl_ctx, (const unsigned char *)&peer->endpoint.addr,
-                sizeof(peer->endpoint.addr)) != 0) {
-          oc_tls_free_peer(peer, false);
-          return;
-        }
-      } else if (ret < 0 && ret != MBEDTLS_ERR_SSL_WANT_READ &&
-                 ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
-#ifdef OC_DEBUG
-        char buf[256];
-        mbedtls_strerror(ret, buf, 256);
-        OC_ERR("oc_tls: mbedtls_error: %s", buf);
-#endif /* OC_DEBUG */
-        oc_tls_free_peer(peer, false);
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+      if (offload_handshake(peer)) {
         return;
       }
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+      ret = step_handshake(peer);
     } while (ret == 0 && peer->ssl_ctx.state != MBEDTLS_SSL_HANDSHAKE_OVER);
-    if (peer->ssl_ctx.state == MBEDTLS_SSL_HANDSHAKE_OVER) {
-      OC_DBG("oc_tls: (D)TLS Session is connected via ciphersuite [0x%x]",
-             peer->ssl_ctx.session->ciphersuite);
-      oc_handle_session(&peer->endpoint, OC_SESSION_CONNECTED);
-    }
-#ifdef OC_CLIENT
-    if (ret == 0) {
-      oc_tls_handler_schedule_write(peer);
-    }
-#endif /* OC_CLIENT */
+    finish_handshake_steps(peer, ret);
   } else {
     oc_message_t *message = oc_allocate_message();
     if (message) {
@@ -18,8 +18,15 @@
 #define OC_TLS_H
 
 #include "mbedtls/ssl.h"
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+#include "mbedtls/ctr_drbg.h"
+#include "port/oc_worker_pool.h"
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
 #include "oc_uuid.h"
 #include "port/oc_connectivity.h"
+#ifdef OC_ACL_CACHE
+#include "security/oc_acl.h"
+#endif /* OC_ACL_CACHE */
 #include "security/oc_cred.h"
 #include "security/oc_keypair.h"
 #include "util/oc_etimer.h"
@@ -40,14 +47,52 @@ typedef struct
   oc_clock_time_t int_ticks;
 } oc_tls_retr_timer_t;
 
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+/* The retransmission timer as seen by handshake steps running on a worker,
+ * applied to the real timer once they are done.
+ */
+typedef struct
+{
+  oc_clock_time_t start;
+  oc_clock_time_t int_ticks;
+  oc_clock_time_t fin_ticks;
+  bool changed;
+} oc_tls_job_timer_t;
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
+
 typedef struct oc_tls_peer_t
 {
   struct oc_tls_peer_t *next;
+#ifdef OC_TLS_PEER_INDEX
+  struct oc_tls_peer_t *endpoint_next; /* chain of peers by endpoint */
+  struct oc_tls_peer_t *handle_next;   /* chain of peers by address */
+  struct oc_tls_peer_t *retr_next;     /* pending retransmission timers */
+  uint32_t endpoint_hash;
+  bool retr_pending;
+#endif /* OC_TLS_PEER_INDEX */
+#ifdef OC_TLS_SESSION_CACHE
+  bool resumed; /* handshake resumed a cached session */
+#endif /* OC_TLS_SESSION_CACHE */
+#ifdef OC_TLS_HANDSHAKE_OFFLOAD
+  /* While busy, a worker owns ssl_ctx, job_q and job_timer, and nothing else
+   * may touch them.
+   */
+  oc_worker_job_t handshake_job;
+  OC_LIST_STRUCT(job_q); /* records handed to the worker */
+  oc_tls_job_timer_t job_timer;
+  mbedtls_ctr_drbg_context drbg; /* steps of peers run in parallel */
+  bool can_offload;
+  bool busy;
+  bool free_pending; /* freed while busy */
+#endif /* OC_TLS_HANDSHAKE_OFFLOAD */
   OC_LIST_STRUCT(recv_q);
   OC_LIST_STRUCT(send_q);
   mbedtls_ssl_context ssl_ctx;
   mbedtls_ssl_config ssl_conf;
   oc_endpoint_t endpoint;
+#ifdef OC_DYNAMIC_ALLOCATION
+  oc_message_t record; /* describes the record being sent */
+#endif /* OC_DYNAMIC_ALLOCATION */
   int role;
   oc_tls_retr_timer_t timer;
   uint8_t master_secret[48];
@@ -57,8 +102,66 @@ typedef struct oc_tls_peer_t
 #ifdef OC_PKI
   uint8_t public_key[OC_KEYPAIR_PUBKEY_SIZE];
 #endif /* OC_PKI */
+#ifdef OC_ACL_CACHE
+  oc_sec_acl_cache_t acl_cache; /* access decisions for this peer */
+#endif /* OC_ACL_CACHE */
 } oc_tls_peer_t;
 
+#ifdef OC_TLS_PEER_INDEX
+#ifndef OC_DYNAMIC_ALLOCATION
+#ifndef OC_TLS_PEER_BUCKETS
+#define OC_TLS_PEER_BUCKETS (8)
+#endif /* !OC_TLS_PEER_BUCKETS */
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+/* Counters for the peer table. The average cost of a lookup is
+ * probes / lookups.
+ */
+typedef struct oc_tls_peer_stats_t
+{
+  uint32_t peers;       /* Number of peers in the table */
+  uint32_t lookups;     /* Number of peer lookups by endpoint */
+  uint32_t probes;      /* Peers compared to the endpoint in all lookups */
+  uint32_t max_probes;  /* Most peers compared in a single lookup */
+  uint32_t retr_checks; /* Peers examined for expired retransmission timers */
+} oc_tls_peer_stats_t;
+
+void oc_tls_peer_stats(oc_tls_peer_stats_t *stats);
+#endif /* OC_TLS_PEER_INDEX */
+
+#ifdef OC_TLS_SESSION_CACHE
+/* Servers keep up to OC_TLS_SESSION_CACHE_ENTRIES sessions (and with
+ * OC_TLS_SESSION_TICKETS also hand them to clients as tickets) for
+ * OC_TLS_SESSION_CACHE_TIMEOUT seconds, and clients keep the last session
+ * with up to as many servers, so that reconnecting peers can resume them with
+ * an abbreviated handshake. The cache and tickets are compiled into mbedTLS
+ * by patches/optional/mbedtls_session_cache.patch (SESSION_CACHE=1 on Linux).
+ * Cached sessions only expire in builds with MBEDTLS_HAVE_TIME.
+ */
+#ifndef OC_TLS_SESSION_CACHE_ENTRIES
+#define OC_TLS_SESSION_CACHE_ENTRIES (8)
+#endif /* !OC_TLS_SESSION_CACHE_ENTRIES */
+#ifndef OC_TLS_SESSION_CACHE_TIMEOUT
+#define OC_TLS_SESSION_CACHE_TIMEOUT (86400)
+#endif /* !OC_TLS_SESSION_CACHE_TIMEOUT */
+
+typedef struct oc_tls_handshake_stats_t
+{
+  uint32_t full;        /* Handshakes that ran a full key exchange */
+  uint32_t abbreviated; /* Handshakes that resumed a cached session */
+} oc_tls_handshake_stats_t;
+
+void oc_tls_handshake_stats(oc_tls_handshake_stats_t *stats);
+
+/* Forget all sessions that could be resumed. Called whenever a credential is
+ * removed, so that no session outlives the credential it was established
+ * with.
+ */
+void oc_tls_flush_sessions(void);
+#elif defined(OC_TLS_SESSION_TICKETS)
+#error "OC_TLS_SESSION_TICKETS requires OC_TLS_SESSION_CACHE"
+#endif /* !OC_TLS_SESSION_CACHE */
+
 int oc_tls_init_context(void);
 void oc_tls_shutdown(void);
 
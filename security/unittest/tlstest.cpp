@@ -19,12 +19,21 @@
  ******************************************************************/
 
 #include <cstdlib>
+#include <cstring>
+#include <unistd.h>
 #include "gtest/gtest.h"
 
 #include "oc_tls.h"
+#include "oc_acl.h"
+#include "oc_cred.h"
+#include "oc_doxm.h"
+#include "oc_pstat.h"
 #include "oc_api.h"
 #include "oc_endpoint.h"
+#include "api/oc_events.h"
 #include "oc_signal_event_loop.h"
+#include "oc_svr.h"
+#include "port/oc_connectivity.h"
 #define delete pseudo_delete
 #include "oc_core_res.h"
 #undef delete
@@ -94,3 +103,426 @@ TEST_F(TestTlsConnection, TlsConnectionTest_N)
 }
 
 #endif
+
+#if defined(OC_SECURITY) && defined(OC_TLS_PEER_INDEX) && defined(OC_CLIENT)
+#define NUM_COLLIDING_PEERS (5)
+/* Peers collide in any table of up to 256 buckets */
+#define PEER_BUCKET_MASK (0xff)
+
+/* Same as the endpoint hash of the peer table */
+static uint32_t
+hashBytes(uint32_t hash, const void *data, size_t len)
+{
+    const uint8_t *bytes = (const uint8_t *)data;
+    for (size_t i = 0; i < len; i++) {
+        hash = (hash ^ bytes[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint32_t
+endpointHash(const oc_endpoint_t *endpoint)
+{
+    int flags = endpoint->flags & ~MULTICAST;
+    uint32_t hash = hashBytes(2166136261u, &flags, sizeof(flags));
+    hash = hashBytes(hash, &endpoint->device, sizeof(endpoint->device));
+    hash = hashBytes(hash, endpoint->addr.ipv6.address, 16);
+    return hashBytes(hash, &endpoint->addr.ipv6.port,
+                     sizeof(endpoint->addr.ipv6.port));
+}
+
+static void
+loopbackEndpoint(oc_endpoint_t *endpoint, uint16_t port)
+{
+    memset(endpoint, 0, sizeof(oc_endpoint_t));
+    endpoint->flags = (transport_flags)(IPV6 | SECURED);
+    endpoint->addr.ipv6.address[15] = 1;
+    endpoint->addr.ipv6.port = port;
+}
+
+static void
+runEvents(void)
+{
+    while (oc_process_run()) {
+    }
+}
+
+TEST_F(TestTlsConnection, CollidingPeers_P)
+{
+
+    int errorCode = oc_tls_init_context();
+    ASSERT_EQ(0, errorCode) << "Failed to init TLS Connection";
+    oc_sec_create_svr();
+    ASSERT_EQ(0, oc_connectivity_init(0));
+
+    oc_endpoint_t endpoints[NUM_COLLIDING_PEERS];
+    loopbackEndpoint(&endpoints[0], 20000);
+    uint32_t bucket = endpointHash(&endpoints[0]) & PEER_BUCKET_MASK;
+    int n = 1;
+    for (uint16_t port = 20001; n < NUM_COLLIDING_PEERS && port != 0; port++) {
+        loopbackEndpoint(&endpoints[n], port);
+        if ((endpointHash(&endpoints[n]) & PEER_BUCKET_MASK) == bucket) {
+            n++;
+        }
+    }
+    ASSERT_EQ(NUM_COLLIDING_PEERS, n);
+
+    /* Each connection attempt leaves a client peer waiting for the
+     * ServerHello.
+     */
+    for (int i = 0; i < NUM_COLLIDING_PEERS; i++) {
+        oc_message_t *message = oc_allocate_message();
+        ASSERT_NE(nullptr, message);
+        memcpy(&message->endpoint, &endpoints[i], sizeof(oc_endpoint_t));
+        oc_process_post(&oc_tls_handler, oc_events[INIT_TLS_CONN_EVENT],
+                        message);
+        runEvents();
+    }
+
+    oc_tls_peer_stats_t stats;
+    oc_tls_peer_stats(&stats);
+    EXPECT_EQ((uint32_t)NUM_COLLIDING_PEERS, stats.peers);
+    for (int i = 0; i < NUM_COLLIDING_PEERS; i++) {
+        oc_tls_peer_t *peer = oc_tls_get_peer(&endpoints[i]);
+        ASSERT_NE(nullptr, peer);
+        EXPECT_EQ(0, oc_endpoint_compare(&peer->endpoint, &endpoints[i]));
+    }
+
+    /* Unlink from the middle, the head and the tail of the chain */
+    const int order[NUM_COLLIDING_PEERS] = { 2, 0, 4, 1, 3 };
+    for (int i = 0; i < NUM_COLLIDING_PEERS; i++) {
+        oc_tls_remove_peer(&endpoints[order[i]]);
+        EXPECT_EQ(nullptr, oc_tls_get_peer(&endpoints[order[i]]));
+        for (int j = i + 1; j < NUM_COLLIDING_PEERS; j++) {
+            EXPECT_NE(nullptr, oc_tls_get_peer(&endpoints[order[j]]));
+        }
+    }
+    oc_tls_peer_stats(&stats);
+    EXPECT_EQ(0u, stats.peers);
+
+    oc_sec_acl_free();
+    oc_sec_cred_free();
+    oc_sec_doxm_free();
+    oc_sec_pstat_free();
+}
+#endif
+
+#if defined(OC_SECURITY) && defined(OC_TLS_SESSION_CACHE)
+/* Device 0 serves, device 1 connects to it over DTLS with a pairwise PSK */
+#define SERVER_DEVICE (0)
+#define CLIENT_DEVICE (1)
+
+class TestTlsSessionResumption: public testing::Test
+{
+    protected:
+        static bool s_isResponseReceived;
+        static oc_endpoint_t s_serverEndpoint;
+        static oc_endpoint_t s_clientEndpoint;
+
+        static int appInit(void)
+        {
+            int result = oc_init_platform(MANUFACTURER_NAME, NULL, NULL);
+            result |= oc_add_device(DEVICE_URI, DEVICE_TYPE, DEVICE_NAME,
+                                    OCF_SPEC_VERSION, OCF_DATA_MODEL_VERSION,
+                                    NULL, NULL);
+            result |= oc_add_device(DEVICE_URI, DEVICE_TYPE, DEVICE_NAME,
+                                    OCF_SPEC_VERSION, OCF_DATA_MODEL_VERSION,
+                                    NULL, NULL);
+            return result;
+        }
+
+        static void signalEventLoop(void)
+        {
+        }
+
+        static void registerResources(void)
+        {
+        }
+
+        static void requestsEntry(void)
+        {
+        }
+
+        static void onResponse(oc_client_response_t *response)
+        {
+            (void)response;
+            s_isResponseReceived = true;
+        }
+
+        static bool isResponseReceived(void)
+        {
+            return s_isResponseReceived;
+        }
+
+        static bool isServerPeerClosed(void)
+        {
+            return oc_tls_get_peer(&s_clientEndpoint) == NULL;
+        }
+
+        static bool pollUntil(bool (*done)(void))
+        {
+            for (int i = 0; i < MAX_WAIT_TIME * 100 && !done(); i++) {
+                oc_main_poll();
+                usleep(10000);
+            }
+            return done();
+        }
+
+        /* The secure IPv6 endpoint of the server as the client sees it,
+         * and that of the client as the server sees it
+         */
+        static bool findEndpoints(void)
+        {
+            oc_endpoint_t *ep = oc_connectivity_get_endpoints(SERVER_DEVICE);
+            while (ep && !((ep->flags & SECURED) && (ep->flags & IPV6))) {
+                ep = ep->next;
+            }
+            if (!ep) {
+                return false;
+            }
+            memcpy(&s_serverEndpoint, ep, sizeof(oc_endpoint_t));
+            s_serverEndpoint.next = NULL;
+            s_serverEndpoint.device = CLIENT_DEVICE;
+            memcpy(&s_serverEndpoint.di, oc_core_get_device_id(SERVER_DEVICE),
+                   sizeof(oc_uuid_t));
+
+            ep = oc_connectivity_get_endpoints(CLIENT_DEVICE);
+            while (ep && !((ep->flags & SECURED) &&
+                           oc_endpoint_compare_address(ep,
+                                                       &s_serverEndpoint) == 0)) {
+                ep = ep->next;
+            }
+            if (!ep) {
+                return false;
+            }
+            memcpy(&s_clientEndpoint, ep, sizeof(oc_endpoint_t));
+            s_clientEndpoint.next = NULL;
+            s_clientEndpoint.device = SERVER_DEVICE;
+            return true;
+        }
+
+        static bool addPairwiseCred(size_t device, size_t peer)
+        {
+            static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8,
+                                             9, 10, 11, 12, 13, 14, 15, 16 };
+            char uuid[OC_UUID_LEN];
+            oc_uuid_to_str(oc_core_get_device_id(peer), uuid, OC_UUID_LEN);
+            return oc_sec_add_new_cred(device, false, NULL, -1,
+                                       OC_CREDTYPE_PSK, OC_CREDUSAGE_NULL,
+                                       uuid, OC_ENCODING_RAW, sizeof(key),
+                                       key, OC_ENCODING_UNSUPPORTED, 0, NULL,
+                                       NULL, NULL) >= 0;
+        }
+
+        static bool getDevice(void)
+        {
+            s_isResponseReceived = false;
+            return oc_do_get(DEVICE_URI, &s_serverEndpoint, NULL, onResponse,
+                             HIGH_QOS, NULL) &&
+                   pollUntil(isResponseReceived);
+        }
+
+        virtual void SetUp()
+        {
+            static const oc_handler_t handler = {
+                .init = appInit,
+                .signal_event_loop = signalEventLoop,
+                .register_resources = registerResources,
+                .requests_entry = requestsEntry
+            };
+            ASSERT_EQ(0, oc_main_init(&handler));
+            ASSERT_TRUE(addPairwiseCred(SERVER_DEVICE, CLIENT_DEVICE));
+            ASSERT_TRUE(addPairwiseCred(CLIENT_DEVICE, SERVER_DEVICE));
+            ASSERT_TRUE(findEndpoints());
+        }
+
+        virtual void TearDown()
+        {
+            oc_main_shutdown();
+        }
+};
+
+bool TestTlsSessionResumption::s_isResponseReceived = false;
+oc_endpoint_t TestTlsSessionResumption::s_serverEndpoint;
+oc_endpoint_t TestTlsSessionResumption::s_clientEndpoint;
+
+TEST_F(TestTlsSessionResumption, ReconnectResumesSession_P)
+{
+    oc_tls_handshake_stats_t before, after;
+    oc_tls_handshake_stats(&before);
+    ASSERT_TRUE(getDevice());
+    oc_tls_handshake_stats(&after);
+    EXPECT_LT(before.full, after.full);
+    EXPECT_EQ(before.abbreviated, after.abbreviated);
+
+    /* The close_notify also drops the session on the server side */
+    oc_tls_close_connection(&s_serverEndpoint);
+    ASSERT_TRUE(pollUntil(isServerPeerClosed));
+
+    oc_tls_handshake_stats(&before);
+    ASSERT_TRUE(getDevice());
+    oc_tls_handshake_stats(&after);
+    EXPECT_EQ(before.full, after.full);
+    EXPECT_LT(before.abbreviated, after.abbreviated);
+}
+#endif
+
+#if defined(OC_SECURITY) && defined(OC_ACL_CACHE)
+/* The device sends requests to itself over its unsecured IPv6 endpoint */
+#define ACL_URI "/oic/sec/acl2"
+
+class TestAclCache: public testing::Test
+{
+    protected:
+        static bool s_isResponseReceived;
+        static oc_status_t s_responseCode;
+        static oc_endpoint_t s_endpoint;
+
+        static int appInit(void)
+        {
+            int result = oc_init_platform(MANUFACTURER_NAME, NULL, NULL);
+            result |= oc_add_device(DEVICE_URI, DEVICE_TYPE, DEVICE_NAME,
+                                    OCF_SPEC_VERSION, OCF_DATA_MODEL_VERSION,
+                                    NULL, NULL);
+            return result;
+        }
+
+        static void signalEventLoop(void)
+        {
+        }
+
+        static void registerResources(void)
+        {
+        }
+
+        static void requestsEntry(void)
+        {
+        }
+
+        static void onResponse(oc_client_response_t *response)
+        {
+            s_responseCode = response->code;
+            s_isResponseReceived = true;
+        }
+
+        static bool findEndpoint(void)
+        {
+            oc_endpoint_t *ep = oc_connectivity_get_endpoints(0);
+            while (ep && ((ep->flags & SECURED) || !(ep->flags & IPV6))) {
+                ep = ep->next;
+            }
+            if (!ep) {
+                return false;
+            }
+            memcpy(&s_endpoint, ep, sizeof(oc_endpoint_t));
+            s_endpoint.next = NULL;
+            return true;
+        }
+
+        /* Returns the response code, or -1 if no response arrived */
+        static int getAcl(void)
+        {
+            s_isResponseReceived = false;
+            if (!oc_do_get(ACL_URI, &s_endpoint, NULL, onResponse, HIGH_QOS,
+                           NULL)) {
+                return -1;
+            }
+            for (int i = 0; i < MAX_WAIT_TIME * 100 && !s_isResponseReceived;
+                 i++) {
+                oc_main_poll();
+                usleep(10000);
+            }
+            return s_isResponseReceived ? (int)s_responseCode : -1;
+        }
+
+        virtual void SetUp()
+        {
+            static const oc_handler_t handler = {
+                .init = appInit,
+                .signal_event_loop = signalEventLoop,
+                .register_resources = registerResources,
+                .requests_entry = requestsEntry
+            };
+            ASSERT_EQ(0, oc_main_init(&handler));
+            ASSERT_TRUE(findEndpoint());
+        }
+
+        virtual void TearDown()
+        {
+            oc_main_shutdown();
+        }
+};
+
+bool TestAclCache::s_isResponseReceived = false;
+oc_status_t TestAclCache::s_responseCode = OC_STATUS_OK;
+oc_endpoint_t TestAclCache::s_endpoint;
+
+TEST_F(TestAclCache, RepeatedRequestHitsCache_P)
+{
+    oc_sec_acl_cache_stats_t before, after;
+    /* Before ownership transfer, anon-clear may retrieve acl2 */
+    oc_sec_acl_cache_stats(&before);
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_EQ(before.misses + 1, after.misses);
+    EXPECT_EQ(before.hits, after.hits);
+
+    oc_sec_acl_cache_stats(&before);
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_EQ(before.misses, after.misses);
+    EXPECT_EQ(before.hits + 1, after.hits);
+}
+
+TEST_F(TestAclCache, AclChangeForcesReevaluation_P)
+{
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+
+    /* Takes away anon-clear access to acl2 */
+    oc_sec_acl_cache_stats_t before, after;
+    oc_sec_acl_cache_stats(&before);
+    oc_sec_set_post_otm_acl(0);
+    EXPECT_EQ(OC_STATUS_UNAUTHORIZED, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_LT(before.invalidations, after.invalidations);
+    EXPECT_EQ(before.misses + 1, after.misses);
+    EXPECT_EQ(before.hits, after.hits);
+
+    /* Restores it */
+    oc_sec_acl_cache_stats(&before);
+    oc_sec_acl_default(0);
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_LT(before.invalidations, after.invalidations);
+    EXPECT_EQ(before.misses + 1, after.misses);
+}
+
+TEST_F(TestAclCache, CredChangeForcesReevaluation_P)
+{
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+
+    static const uint8_t key[16] = { 1, 2, 3, 4, 5, 6, 7, 8,
+                                     9, 10, 11, 12, 13, 14, 15, 16 };
+    oc_sec_acl_cache_stats_t before, after;
+    oc_sec_acl_cache_stats(&before);
+    int credid = oc_sec_add_new_cred(0, false, NULL, -1, OC_CREDTYPE_PSK,
+                                     OC_CREDUSAGE_NULL,
+                                     "11111111-2222-3333-4444-555555555555",
+                                     OC_ENCODING_RAW, sizeof(key), key,
+                                     OC_ENCODING_UNSUPPORTED, 0, NULL, NULL,
+                                     NULL);
+    ASSERT_LE(0, credid);
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_LT(before.invalidations, after.invalidations);
+    EXPECT_EQ(before.misses + 1, after.misses);
+    EXPECT_EQ(before.hits, after.hits);
+
+    oc_sec_acl_cache_stats(&before);
+    oc_sec_remove_cred(oc_sec_get_cred_by_credid(credid, 0), 0);
+    EXPECT_EQ(OC_STATUS_OK, getAcl());
+    oc_sec_acl_cache_stats(&after);
+    EXPECT_LT(before.invalidations, after.invalidations);
+    EXPECT_EQ(before.misses + 1, after.misses);
+}
+#endif
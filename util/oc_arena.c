@@ -0,0 +1,133 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include "oc_arena.h"
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#include "port/oc_log.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+struct oc_arena_block_s
+{
+  struct oc_arena_block_s *next;
+  size_t size;
+  size_t used;
+};
+
+#define ARENA_ALIGN(n) (((n) + sizeof(double) - 1) & ~(sizeof(double) - 1))
+#define ARENA_BLOCK_DATA(block)                                                \
+  ((uint8_t *)(block) + ARENA_ALIGN(sizeof(struct oc_arena_block_s)))
+
+static bool
+arena_grow(oc_arena_t *arena, size_t size)
+{
+  /* Each block is at least twice as large as the one before it. */
+  size_t block_size = arena->blocks ? arena->blocks->size * 2 : 0;
+  if (block_size < size) {
+    block_size = size;
+  }
+  struct oc_arena_block_s *block = (struct oc_arena_block_s *)malloc(
+    ARENA_ALIGN(sizeof(struct oc_arena_block_s)) + block_size);
+  if (!block) {
+    OC_WRN("insufficient memory to grow the arena");
+    return false;
+  }
+  block->next = arena->blocks;
+  block->size = block_size;
+  block->used = 0;
+  arena->blocks = block;
+  return true;
+}
+
+bool
+oc_arena_reserve(oc_arena_t *arena, size_t size)
+{
+  struct oc_arena_block_s *block = arena->blocks;
+  size = ARENA_ALIGN(size);
+  if (block && block->size - block->used >= size) {
+    return true;
+  }
+  return arena_grow(arena, size);
+}
+
+void *
+oc_arena_alloc(oc_arena_t *arena, size_t size)
+{
+  size = ARENA_ALIGN(size);
+  if (!oc_arena_reserve(arena, size)) {
+    return NULL;
+  }
+  struct oc_arena_block_s *block = arena->blocks;
+  void *ptr = ARENA_BLOCK_DATA(block) + block->used;
+  block->used += size;
+  return ptr;
+}
+
+bool
+oc_arena_new_string(oc_arena_t *arena, struct oc_mmem *ostr, const char *str,
+                    size_t len)
+{
+  ostr->next = NULL;
+  ostr->ptr = oc_arena_alloc(arena, len + 1);
+  if (!ostr->ptr) {
+    ostr->size = 0;
+    return false;
+  }
+  ostr->size = len + 1;
+  memcpy(ostr->ptr, str, len);
+  ((char *)ostr->ptr)[len] = '\0';
+  return true;
+}
+
+void
+oc_arena_reset(oc_arena_t *arena)
+{
+  struct oc_arena_block_s *block = arena->blocks, *next;
+  if (!block) {
+    return;
+  }
+  /* The newest block is also the largest, and the only one worth keeping. */
+  if (block->size <= OC_ARENA_MAX_RETAINED_SIZE) {
+    block->used = 0;
+    next = block->next;
+    block->next = NULL;
+    block = next;
+  } else {
+    arena->blocks = NULL;
+  }
+  while (block) {
+    next = block->next;
+    free(block);
+    block = next;
+  }
+}
+
+void
+oc_arena_free(oc_arena_t *arena)
+{
+  struct oc_arena_block_s *block = arena->blocks, *next;
+  while (block) {
+    next = block->next;
+    free(block);
+    block = next;
+  }
+  arena->blocks = NULL;
+}
+#else  /* OC_DYNAMIC_ALLOCATION */
+typedef int dummy_declaration;
+#endif /* !OC_DYNAMIC_ALLOCATION */
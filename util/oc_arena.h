@@ -0,0 +1,69 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#ifndef OC_ARENA_H
+#define OC_ARENA_H
+
+#include "oc_config.h"
+#include "util/oc_mmem.h"
+#include <stdbool.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef OC_DYNAMIC_ALLOCATION
+/*
+ * A bump allocator over a chain of malloc()ed blocks, each at least twice as
+ * large as the one before it. Memory taken from an arena is never freed on
+ * its own, but all at once with oc_arena_reset() or oc_arena_free(). An arena
+ * must be zero initialized before its first use.
+ */
+#ifndef OC_ARENA_MAX_RETAINED_SIZE
+/* The largest block that oc_arena_reset() keeps around for reuse. */
+#define OC_ARENA_MAX_RETAINED_SIZE (65536)
+#endif /* !OC_ARENA_MAX_RETAINED_SIZE */
+
+typedef struct
+{
+  struct oc_arena_block_s *blocks;
+} oc_arena_t;
+
+void *oc_arena_alloc(oc_arena_t *arena, size_t size);
+
+/* Make sure that the next size bytes can be carved out of a single block. */
+bool oc_arena_reserve(oc_arena_t *arena, size_t size);
+
+/* Release everything taken from arena, but keep its last block for reuse. */
+void oc_arena_reset(oc_arena_t *arena);
+
+void oc_arena_free(oc_arena_t *arena);
+
+/*
+ * Copy len bytes of str into an oc_string_t in arena, with a terminating NUL.
+ * The result must not be passed to oc_free_string().
+ */
+bool oc_arena_new_string(oc_arena_t *arena, struct oc_mmem *ostr,
+                         const char *str, size_t len);
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OC_ARENA_H */
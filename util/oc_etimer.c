@@ -37,59 +37,245 @@
 #include "oc_etimer.h"
 #include "oc_process.h"
 
-static struct oc_etimer *timerlist;
-static oc_clock_time_t next_expiration;
-
 OC_PROCESS(oc_etimer_process, "Event timer");
 /*---------------------------------------------------------------------------*/
+/* Distinct processes notified by a single pass over the due timers. */
+#define MAX_NOTIFIED_PROCESSES (8)
+
+static struct oc_etimer *due_timer(oc_clock_time_t now);
+static void remove_timer(struct oc_etimer *t);
+
+/* The processes that own timers rescan them all on OC_PROCESS_EVENT_TIMER,
+ * so a single event per process covers all of its due timers.
+ */
 static void
-update_time(void)
+notify_due_timers(oc_clock_time_t now)
 {
-  oc_clock_time_t tdist;
-  oc_clock_time_t now;
+  struct oc_process *notified[MAX_NOTIFIED_PROCESSES];
+  int num_notified = 0, i;
   struct oc_etimer *t;
 
-  if (timerlist == NULL) {
-    next_expiration = 0;
+  while ((t = due_timer(now)) != NULL) {
+    for (i = 0; i < num_notified && notified[i] != t->p; i++)
+      ;
+    if (i == num_notified) {
+      if (oc_process_post(t->p, OC_PROCESS_EVENT_TIMER, t) !=
+          OC_PROCESS_ERR_OK) {
+        oc_etimer_request_poll();
+        break;
+      }
+      if (num_notified < MAX_NOTIFIED_PROCESSES) {
+        notified[num_notified++] = t->p;
+      }
+    }
+    /* Reset the process ID of the event timer, to signal that the
+       etimer has expired. This is later checked in the
+       oc_etimer_expired() function. */
+    remove_timer(t);
+  }
+}
+
+#ifdef OC_ETIMER_WHEEL
+#if OC_ETIMER_WHEEL_LEVELS < 1 || OC_ETIMER_WHEEL_LEVELS > 9
+#error "OC_ETIMER_WHEEL_LEVELS must be between 1 and 9"
+#endif /* OC_ETIMER_WHEEL_LEVELS */
+
+#define WHEEL_BITS (6)
+#define WHEEL_SLOTS (1 << WHEEL_BITS)
+#define WHEEL_MASK (WHEEL_SLOTS - 1)
+/* Timers that are due but whose process has not been notified yet. */
+#define DUE_SLOT (OC_ETIMER_WHEEL_LEVELS * WHEEL_SLOTS)
+/* Timers beyond the range of the top level. */
+#define OVERFLOW_SLOT (DUE_SLOT + 1)
+static struct oc_etimer *wheel[OVERFLOW_SLOT + 1];
+static uint64_t occupied[OC_ETIMER_WHEEL_LEVELS];
+/* The wheel tick up to which all slots have been processed. */
+static oc_clock_time_t wheel_time;
+static size_t num_timers;
+/*---------------------------------------------------------------------------*/
+static int
+lowest_bit(uint64_t bits)
+{
+#ifdef __GNUC__
+  return __builtin_ctzll(bits);
+#else  /* __GNUC__ */
+  int i = 0;
+  while (!(bits & 1)) {
+    bits >>= 1;
+    i++;
+  }
+  return i;
+#endif /* !__GNUC__ */
+}
+/*---------------------------------------------------------------------------*/
+static oc_clock_time_t
+expiry_tick(struct oc_etimer *t)
+{
+  /* Rounded up, so that a timer never fires early. */
+  return (t->timer.start + t->timer.interval + OC_ETIMER_WHEEL_GRANULARITY -
+          1) /
+         OC_ETIMER_WHEEL_GRANULARITY;
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_link(struct oc_etimer *t, uint16_t slot)
+{
+  t->slot = slot;
+  t->prev = NULL;
+  t->next = wheel[slot];
+  if (t->next) {
+    t->next->prev = t;
+  }
+  wheel[slot] = t;
+  if (slot < DUE_SLOT) {
+    occupied[slot / WHEEL_SLOTS] |= (uint64_t)1 << (slot & WHEEL_MASK);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+wheel_unlink(struct oc_etimer *t)
+{
+  if (t->prev) {
+    t->prev->next = t->next;
   } else {
-    now = oc_clock_time();
-    t = timerlist;
-    /* Must calculate distance to next time into account due to wraps */
-    tdist = t->timer.start + t->timer.interval - now;
-    for (t = t->next; t != NULL; t = t->next) {
-      if (t->timer.start + t->timer.interval - now < tdist) {
-        tdist = t->timer.start + t->timer.interval - now;
+    wheel[t->slot] = t->next;
+  }
+  if (t->next) {
+    t->next->prev = t->prev;
+  }
+  if (t->slot < DUE_SLOT && !wheel[t->slot]) {
+    occupied[t->slot / WHEEL_SLOTS] &= ~((uint64_t)1 << (t->slot & WHEEL_MASK));
+  }
+  t->next = t->prev = NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* A timer goes to the lowest level whose slots, read from wheel_time, reach
+ * its expiry tick without wrapping. Every occupied slot of a level is thus
+ * ahead of the current position of that level.
+ */
+static void
+wheel_place(struct oc_etimer *t)
+{
+  oc_clock_time_t expires = expiry_tick(t);
+  if (expires <= wheel_time) {
+    wheel_link(t, DUE_SLOT);
+    return;
+  }
+
+  oc_clock_time_t diff = expires ^ wheel_time;
+  int level = 0;
+  while (level < OC_ETIMER_WHEEL_LEVELS &&
+         (diff >> (WHEEL_BITS * (level + 1))) != 0) {
+    level++;
+  }
+  if (level == OC_ETIMER_WHEEL_LEVELS) {
+    wheel_link(t, OVERFLOW_SLOT);
+    return;
+  }
+  wheel_link(t, (uint16_t)(level * WHEEL_SLOTS +
+                           ((expires >> (WHEEL_BITS * level)) & WHEEL_MASK)));
+}
+/*---------------------------------------------------------------------------*/
+/* Finds the next wheel tick at which a slot has to be processed. */
+static int
+next_wheel_tick(oc_clock_time_t *tick)
+{
+  int level;
+  for (level = 0; level < OC_ETIMER_WHEEL_LEVELS; level++) {
+    int shift = WHEEL_BITS * level;
+    int pos = (int)((wheel_time >> shift) & WHEEL_MASK);
+    uint64_t ahead = 0;
+    if (pos < WHEEL_MASK) {
+      ahead = occupied[level] & (~(uint64_t)0 << (pos + 1));
+    }
+    if (ahead) {
+      *tick = ((wheel_time >> shift) - pos + lowest_bit(ahead)) << shift;
+      return 1;
+    }
+  }
+  if (wheel[OVERFLOW_SLOT]) {
+    int shift = WHEEL_BITS * OC_ETIMER_WHEEL_LEVELS;
+    *tick = ((wheel_time >> shift) + 1) << shift;
+    return 1;
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+static void
+replace_slot(uint16_t slot)
+{
+  struct oc_etimer *t = wheel[slot];
+  wheel[slot] = NULL;
+  if (slot < DUE_SLOT) {
+    occupied[slot / WHEEL_SLOTS] &= ~((uint64_t)1 << (slot & WHEEL_MASK));
+  }
+  while (t != NULL) {
+    struct oc_etimer *next = t->next;
+    wheel_place(t);
+    t = next;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Moves wheel_time up to now, cascading the timers of each slot that is
+ * reached into the lower levels, or into the due list once they expire.
+ */
+static void
+wheel_advance(oc_clock_time_t now)
+{
+  oc_clock_time_t tick;
+  while (next_wheel_tick(&tick) && tick <= now) {
+    wheel_time = tick;
+    int level = OC_ETIMER_WHEEL_LEVELS;
+    if ((tick & ((((oc_clock_time_t)1) << (WHEEL_BITS * level)) - 1)) == 0) {
+      replace_slot(OVERFLOW_SLOT);
+    }
+    for (level = level - 1; level >= 0; level--) {
+      int shift = WHEEL_BITS * level;
+      if ((tick & ((((oc_clock_time_t)1) << shift) - 1)) == 0) {
+        replace_slot(
+          (uint16_t)(level * WHEEL_SLOTS + ((tick >> shift) & WHEEL_MASK)));
       }
     }
-    next_expiration = now + tdist;
   }
+  if (now > wheel_time) {
+    wheel_time = now;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_timer(struct oc_etimer *t)
+{
+  wheel_unlink(t);
+  t->p = OC_PROCESS_NONE;
+  num_timers--;
+}
+/*---------------------------------------------------------------------------*/
+/* Returns a timer of the due list once the wheel has caught up with now. */
+static struct oc_etimer *
+due_timer(oc_clock_time_t now)
+{
+  wheel_advance(now / OC_ETIMER_WHEEL_GRANULARITY);
+  return wheel[DUE_SLOT];
 }
 /*---------------------------------------------------------------------------*/
 OC_PROCESS_THREAD(oc_etimer_process, ev, data)
 {
-  struct oc_etimer *t, *u;
-
   OC_PROCESS_BEGIN();
 
-  timerlist = NULL;
-
   while (1) {
     OC_PROCESS_YIELD();
 
     if (ev == OC_PROCESS_EVENT_EXITED) {
-      struct oc_process *p = data;
-
-      while (timerlist != NULL && timerlist->p == p) {
-        timerlist = timerlist->next;
-      }
-
-      if (timerlist != NULL) {
-        t = timerlist;
-        while (t->next != NULL) {
-          if (t->next->p == p) {
-            t->next = t->next->next;
-          } else
-            t = t->next;
+      struct oc_process *p = (struct oc_process *)data;
+      uint16_t slot;
+      for (slot = 0; slot <= OVERFLOW_SLOT; slot++) {
+        struct oc_etimer *t = wheel[slot], *next;
+        while (t != NULL) {
+          next = t->next;
+          if (t->p == p) {
+            remove_timer(t);
+          }
+          t = next;
         }
       }
       continue;
@@ -97,37 +283,214 @@ OC_PROCESS_THREAD(oc_etimer_process, ev, data)
       continue;
     }
 
-  again:
+    if (num_timers > 0) {
+      notify_due_timers(oc_clock_time());
+    }
+  }
+
+  OC_PROCESS_END();
+}
+#else  /* OC_ETIMER_WHEEL */
+/* Pending timers form a binary min-heap on their expiry time. The heap is
+ * linked through the timers themselves, and the node at 1-based position n is
+ * reached from the root by following the bits of n below its leading one, so
+ * the heap needs no storage of its own.
+ */
+static struct oc_etimer *heap_root;
+static size_t num_timers;
+/*---------------------------------------------------------------------------*/
+static oc_clock_time_t
+expiry_time(struct oc_etimer *t)
+{
+  return t->timer.start + t->timer.interval;
+}
+/*---------------------------------------------------------------------------*/
+static struct oc_etimer *
+heap_node(size_t pos)
+{
+  struct oc_etimer *t = heap_root;
+  int bit = 0;
+  while ((pos >> bit) > 1) {
+    bit++;
+  }
+  while (t != NULL && bit-- > 0) {
+    t = ((pos >> bit) & 1) ? t->right : t->left;
+  }
+  return t;
+}
+/*---------------------------------------------------------------------------*/
+/* Swaps child c with its parent p. */
+static void
+heap_swap(struct oc_etimer *p, struct oc_etimer *c)
+{
+  struct oc_etimer *gp = p->parent, *left = c->left, *right = c->right;
+
+  if (p->left == c) {
+    c->left = p;
+    c->right = p->right;
+    if (c->right) {
+      c->right->parent = c;
+    }
+  } else {
+    c->right = p;
+    c->left = p->left;
+    if (c->left) {
+      c->left->parent = c;
+    }
+  }
+  p->left = left;
+  p->right = right;
+  if (left) {
+    left->parent = p;
+  }
+  if (right) {
+    right->parent = p;
+  }
+  p->parent = c;
+  c->parent = gp;
+  if (!gp) {
+    heap_root = c;
+  } else if (gp->left == p) {
+    gp->left = c;
+  } else {
+    gp->right = c;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Restores the heap order around t after its expiry time has changed. */
+static void
+heap_update(struct oc_etimer *t)
+{
+  while (t->parent && expiry_time(t) < expiry_time(t->parent)) {
+    heap_swap(t->parent, t);
+  }
+  while (t->left) {
+    struct oc_etimer *c = t->left;
+    if (t->right && expiry_time(t->right) < expiry_time(c)) {
+      c = t->right;
+    }
+    if (expiry_time(c) >= expiry_time(t)) {
+      break;
+    }
+    heap_swap(t, c);
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_insert(struct oc_etimer *t)
+{
+  t->left = t->right = NULL;
+  num_timers++;
+  if (num_timers == 1) {
+    t->parent = NULL;
+    heap_root = t;
+    return;
+  }
+  t->parent = heap_node(num_timers / 2);
+  if (num_timers & 1) {
+    t->parent->right = t;
+  } else {
+    t->parent->left = t;
+  }
+  heap_update(t);
+}
+/*---------------------------------------------------------------------------*/
+static void
+heap_remove(struct oc_etimer *t)
+{
+  /* Detach the last node, and move it into the place of t. */
+  struct oc_etimer *last = heap_node(num_timers);
+  if (!last->parent) {
+    heap_root = NULL;
+  } else if (last->parent->right == last) {
+    last->parent->right = NULL;
+  } else {
+    last->parent->left = NULL;
+  }
+  num_timers--;
+
+  if (last != t) {
+    last->parent = t->parent;
+    last->left = t->left;
+    last->right = t->right;
+    if (last->left) {
+      last->left->parent = last;
+    }
+    if (last->right) {
+      last->right->parent = last;
+    }
+    if (!last->parent) {
+      heap_root = last;
+    } else if (last->parent->left == t) {
+      last->parent->left = last;
+    } else {
+      last->parent->right = last;
+    }
+    heap_update(last);
+  }
+  t->parent = t->left = t->right = NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_timer(struct oc_etimer *t)
+{
+  heap_remove(t);
+  t->p = OC_PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+static struct oc_etimer *
+due_timer(oc_clock_time_t now)
+{
+  if (heap_root && expiry_time(heap_root) <= now) {
+    return heap_root;
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static struct oc_etimer *
+find_process_timer(struct oc_etimer *t, struct oc_process *p)
+{
+  struct oc_etimer *found = NULL;
+  if (t != NULL) {
+    if (t->p == p) {
+      return t;
+    }
+    found = find_process_timer(t->left, p);
+    if (!found) {
+      found = find_process_timer(t->right, p);
+    }
+  }
+  return found;
+}
+/*---------------------------------------------------------------------------*/
+OC_PROCESS_THREAD(oc_etimer_process, ev, data)
+{
+  struct oc_etimer *t;
 
-    u = NULL;
+  OC_PROCESS_BEGIN();
 
-    for (t = timerlist; t != NULL; t = t->next) {
-      if (oc_timer_expired(&t->timer)) {
-        if (oc_process_post(t->p, OC_PROCESS_EVENT_TIMER, t) ==
-            OC_PROCESS_ERR_OK) {
+  while (1) {
+    OC_PROCESS_YIELD();
 
-          /* Reset the process ID of the event timer, to signal that the
-             etimer has expired. This is later checked in the
-             oc_etimer_expired() function. */
-          t->p = OC_PROCESS_NONE;
-          if (u != NULL) {
-            u->next = t->next;
-          } else {
-            timerlist = t->next;
-          }
-          t->next = NULL;
-          update_time();
-          goto again;
-        } else {
-          oc_etimer_request_poll();
-        }
+    if (ev == OC_PROCESS_EVENT_EXITED) {
+      struct oc_process *p = (struct oc_process *)data;
+      /* Removing a timer reshapes the heap, so search again from the root. */
+      while ((t = find_process_timer(heap_root, p)) != NULL) {
+        remove_timer(t);
       }
-      u = t;
+      continue;
+    } else if (ev != OC_PROCESS_EVENT_POLL) {
+      continue;
+    }
+
+    if (heap_root) {
+      notify_due_timers(oc_clock_time());
     }
   }
 
   OC_PROCESS_END();
 }
+#endif /* !OC_ETIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 oc_clock_time_t
 oc_etimer_request_poll(void)
@@ -135,32 +498,42 @@ oc_etimer_request_poll(void)
   oc_process_poll(&oc_etimer_process);
   return oc_etimer_next_expiration_time();
 }
+#ifdef OC_ETIMER_WHEEL
 /*---------------------------------------------------------------------------*/
 static void
 add_timer(struct oc_etimer *timer)
 {
-  struct oc_etimer *t;
-
   oc_etimer_request_poll();
 
   if (timer->p != OC_PROCESS_NONE) {
-    for (t = timerlist; t != NULL; t = t->next) {
-      if (t == timer) {
-        /* Timer already on list, bail out. */
-        timer->p = OC_PROCESS_CURRENT();
-        update_time();
-        return;
-      }
+    /* Timer already in the wheel; its expiry time may have changed. */
+    wheel_unlink(timer);
+  } else {
+    if (num_timers == 0) {
+      wheel_time = oc_clock_time() / OC_ETIMER_WHEEL_GRANULARITY;
     }
+    num_timers++;
   }
-
-  /* Timer not on list. */
   timer->p = OC_PROCESS_CURRENT();
-  timer->next = timerlist;
-  timerlist = timer;
+  wheel_place(timer);
+}
+#else  /* OC_ETIMER_WHEEL */
+/*---------------------------------------------------------------------------*/
+static void
+add_timer(struct oc_etimer *timer)
+{
+  oc_etimer_request_poll();
 
-  update_time();
+  if (timer->p != OC_PROCESS_NONE) {
+    /* Timer already in the heap; its expiry time may have changed. */
+    timer->p = OC_PROCESS_CURRENT();
+    heap_update(timer);
+    return;
+  }
+  timer->p = OC_PROCESS_CURRENT();
+  heap_insert(timer);
 }
+#endif /* !OC_ETIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 void
 oc_etimer_set(struct oc_etimer *et, oc_clock_time_t interval)
@@ -191,13 +564,28 @@ oc_etimer_restart(struct oc_etimer *et)
   oc_timer_restart(&et->timer);
   add_timer(et);
 }
+#ifdef OC_ETIMER_WHEEL
 /*---------------------------------------------------------------------------*/
 void
 oc_etimer_adjust(struct oc_etimer *et, int timediff)
 {
   et->timer.start += timediff;
-  update_time();
+  if (et->p != OC_PROCESS_NONE) {
+    wheel_unlink(et);
+    wheel_place(et);
+  }
 }
+#else  /* OC_ETIMER_WHEEL */
+/*---------------------------------------------------------------------------*/
+void
+oc_etimer_adjust(struct oc_etimer *et, int timediff)
+{
+  et->timer.start += timediff;
+  if (et->p != OC_PROCESS_NONE) {
+    heap_update(et);
+  }
+}
+#endif /* !OC_ETIMER_WHEEL */
 /*---------------------------------------------------------------------------*/
 int
 oc_etimer_expired(struct oc_etimer *et)
@@ -216,48 +604,59 @@ oc_etimer_start_time(struct oc_etimer *et)
 {
   return et->timer.start;
 }
+#ifdef OC_ETIMER_WHEEL
 /*---------------------------------------------------------------------------*/
 int
 oc_etimer_pending(void)
 {
-  return timerlist != NULL;
+  return num_timers > 0;
 }
 /*---------------------------------------------------------------------------*/
 oc_clock_time_t
 oc_etimer_next_expiration_time(void)
 {
-  return oc_etimer_pending() ? next_expiration : 0;
+  oc_clock_time_t tick;
+  if (num_timers == 0) {
+    return 0;
+  }
+  if (wheel[DUE_SLOT] || !next_wheel_tick(&tick)) {
+    tick = wheel_time;
+  }
+  /* This may be a cascade point of an upper level rather than an expiry,
+     but it is never later than the earliest expiry. */
+  return tick * OC_ETIMER_WHEEL_GRANULARITY;
 }
 /*---------------------------------------------------------------------------*/
 void
 oc_etimer_stop(struct oc_etimer *et)
 {
-  struct oc_etimer *t;
-
-  /* First check if et is the first event timer on the list. */
-  if (et == timerlist) {
-    timerlist = timerlist->next;
-    update_time();
-  } else {
-    /* Else walk through the list and try to find the item before the
-       et timer. */
-    for (t = timerlist; t != NULL && t->next != et; t = t->next)
-      ;
-
-    if (t != NULL) {
-      /* We've found the item before the event timer that we are about
-   to remove. We point the items next pointer to the event after
-   the removed item. */
-      t->next = et->next;
-
-      update_time();
-    }
+  if (et->p != OC_PROCESS_NONE) {
+    remove_timer(et);
   }
-
-  /* Remove the next pointer from the item to be removed. */
   et->next = NULL;
-  /* Set the timer as expired */
-  et->p = OC_PROCESS_NONE;
 }
 /*---------------------------------------------------------------------------*/
+#else  /* OC_ETIMER_WHEEL */
+/*---------------------------------------------------------------------------*/
+int
+oc_etimer_pending(void)
+{
+  return heap_root != NULL;
+}
+/*---------------------------------------------------------------------------*/
+oc_clock_time_t
+oc_etimer_next_expiration_time(void)
+{
+  return heap_root ? expiry_time(heap_root) : 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+oc_etimer_stop(struct oc_etimer *et)
+{
+  if (et->p != OC_PROCESS_NONE) {
+    remove_timer(et);
+  }
+}
+#endif /* !OC_ETIMER_WHEEL */
+/*---------------------------------------------------------------------------*/
 /** @} */
@@ -75,8 +75,37 @@ struct oc_etimer
   struct oc_timer timer;
   struct oc_etimer *next;
   struct oc_process *p;
+#ifdef OC_ETIMER_WHEEL
+  struct oc_etimer *prev;
+  uint16_t slot;
+#else  /* OC_ETIMER_WHEEL */
+  struct oc_etimer *parent, *left, *right;
+#endif /* !OC_ETIMER_WHEEL */
 };
 
+/*
+ * With OC_ETIMER_WHEEL, pending timers are kept in a hierarchical timing
+ * wheel of OC_ETIMER_WHEEL_LEVELS levels with 64 slots each, so that setting
+ * and stopping a timer takes constant time. Expiry times are rounded up to
+ * OC_ETIMER_WHEEL_GRANULARITY clock ticks, and timers further out than the
+ * top level wait in an overflow list that is rescanned once per rotation of
+ * the top level. The clock is assumed not to wrap.
+ *
+ * Otherwise, pending timers are kept in a binary min-heap on their expiry
+ * time, so that setting and stopping a timer takes O(log n) time and the next
+ * expiry is read off the root.
+ */
+#ifdef OC_ETIMER_WHEEL
+#ifndef OC_ETIMER_WHEEL_LEVELS
+#define OC_ETIMER_WHEEL_LEVELS (4)
+#endif /* OC_ETIMER_WHEEL_LEVELS */
+
+#ifndef OC_ETIMER_WHEEL_GRANULARITY
+#define OC_ETIMER_WHEEL_GRANULARITY                                            \
+  ((OC_CLOCK_SECOND >= 1000) ? (OC_CLOCK_SECOND / 1000) : 1)
+#endif /* OC_ETIMER_WHEEL_GRANULARITY */
+#endif /* OC_ETIMER_WHEEL */
+
 /**
  * \name Functions called from application programs
  * @{
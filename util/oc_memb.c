@@ -34,26 +34,132 @@
 
 #include "oc_memb.h"
 #include "port/oc_log.h"
+#include <stdbool.h>
 #include <string.h>
 
 #ifdef OC_MEMORY_TRACE
 #include "oc_mem_trace.h"
 #endif
 
+/*---------------------------------------------------------------------------*/
+/* Freed blocks are linked through their first bytes, which blocks smaller
+ * than a pointer cannot hold. Fixed pools of such blocks fall back to
+ * looking up a free block in the count array.
+ */
+static bool
+can_link(struct oc_memb *m)
+{
+  return m->size >= sizeof(void *);
+}
+/*---------------------------------------------------------------------------*/
+static void
+push_free(struct oc_memb *m, void *ptr)
+{
+  memcpy(ptr, &m->free_list, sizeof(void *));
+  m->free_list = ptr;
+  m->num_free++;
+}
+/*---------------------------------------------------------------------------*/
+static void *
+pop_free(struct oc_memb *m)
+{
+  void *ptr = m->free_list;
+  memcpy(&m->free_list, ptr, sizeof(void *));
+  m->num_free--;
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
+#ifdef OC_DYNAMIC_ALLOCATION
+/* Heap pools holding freed blocks, ended by cached_pools_end so that a pool
+ * on the list never has a NULL next_pool. Frees into one pool are
+ * serialized by its callers, but different pools may join from different
+ * threads.
+ */
+static struct oc_memb cached_pools_end;
+static struct oc_memb *cached_pools = &cached_pools_end;
+
+static void
+track_pool(struct oc_memb *m)
+{
+  if (m->next_pool) {
+    return;
+  }
+#ifdef __GNUC__
+  struct oc_memb *head = __atomic_load_n(&cached_pools, __ATOMIC_RELAXED);
+  do {
+    m->next_pool = head;
+  } while (!__atomic_compare_exchange_n(&cached_pools, &head, m, true,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+#else  /* __GNUC__ */
+  m->next_pool = cached_pools;
+  cached_pools = m;
+#endif /* !__GNUC__ */
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+/*---------------------------------------------------------------------------*/
+static void *
+block(struct oc_memb *m, int i)
+{
+  return (void *)((char *)m->mem + (i * m->size));
+}
+/*---------------------------------------------------------------------------*/
+static int
+block_index(struct oc_memb *m, void *ptr)
+{
+  if (!oc_memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  size_t offset = (size_t)((char *)ptr - (char *)m->mem);
+  if (offset % m->size != 0) {
+    return -1;
+  }
+  return (int)(offset / m->size);
+}
 /*---------------------------------------------------------------------------*/
 void
 oc_memb_init(struct oc_memb *m)
 {
-  if (m->num > 0) {
+#ifdef OC_DYNAMIC_ALLOCATION
+  while (!m->count && m->free_list) {
+    free(pop_free(m));
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+  m->free_list = NULL;
+  m->next = 0;
+  m->num_free = 0;
+  if (m->count && m->num > 0) {
     memset(m->count, 0, m->num);
-#ifndef OC_DYNAMIC_ALLOCATION
     memset(m->mem, 0, (unsigned)m->size * (unsigned)m->num);
-#else  /* !OC_DYNAMIC_ALLOCATION */
-    memset(m->mem, 0, (unsigned)m->num * sizeof(char *));
-#endif /* OC_DYNAMIC_ALLOCATION */
   }
 }
 /*---------------------------------------------------------------------------*/
+static void *
+alloc_fixed(struct oc_memb *m)
+{
+  int i;
+  if (m->free_list) {
+    i = block_index(m, pop_free(m));
+  } else if (m->next < m->num) {
+    i = m->next++;
+  } else if (!can_link(m)) {
+    i = 0;
+    while (i < m->num && m->count[i] != 0) {
+      i++;
+    }
+    if (i == m->num) {
+      return NULL;
+    }
+  } else {
+    return NULL;
+  }
+  /* Increase the reference count of the block to indicate that it now is
+     used. */
+  ++(m->count[i]);
+  void *ptr = block(m, i);
+  memset(ptr, 0, m->size);
+  return ptr;
+}
+/*---------------------------------------------------------------------------*/
 void *
 _oc_memb_alloc(
 #ifdef OC_MEMORY_TRACE
@@ -66,33 +172,16 @@ _oc_memb_alloc(
     return NULL;
   }
 
-  int i = m->num;
   void *ptr = NULL;
-  if (m->num > 0) {
-    for (i = 0; i < m->num; i++) {
-      if (m->count[i] == 0) {
-        /* If this block was unused, we increase the reference count to
-     indicate that it now is used and return a pointer to the
-     memory block. */
-        ++(m->count[i]);
-        break;
-      }
-    }
-
-    if (i < m->num) {
-#ifdef OC_DYNAMIC_ALLOCATION
-      ptr = calloc(1, m->size);
-      void *slot = (void *)((char *)m->mem + (i * sizeof(void *)));
-      memcpy(slot, &ptr, sizeof(void *));
-#else  /* OC_DYNAMIC_ALLOCATION */
-      ptr = (void *)((char *)m->mem + (i * m->size));
-      memset(ptr, 0, m->size);
-#endif /* !OC_DYNAMIC_ALLOCATION */
-    }
+  if (m->count) {
+    ptr = alloc_fixed(m);
   }
 #ifdef OC_DYNAMIC_ALLOCATION
-  else {
-    ptr = calloc(1, m->size);
+  else if (m->free_list) {
+    ptr = pop_free(m);
+    memset(ptr, 0, m->size);
+  } else {
+    ptr = calloc(1, can_link(m) ? m->size : sizeof(void *));
   }
 #endif /* OC_DYNAMIC_ALLOCATION */
 
@@ -120,43 +209,31 @@ _oc_memb_free(
     OC_ERR("oc_memb is NULL");
     return -1;
   }
+  if (!ptr) {
+    return -1;
+  }
 
 #ifdef OC_MEMORY_TRACE
   oc_mem_trace_add_pace(func, m->size, MEM_TRACE_FREE, ptr);
 #endif
 
-  int i = m->num;
-  char *ptr2 = NULL;
-  if (m->num > 0) {
-    /* Walk through the list of blocks and try to find the block to
-       which the pointer "ptr" points to. */
-    ptr2 = (char *)m->mem;
-    for (i = 0; i < m->num; ++i) {
-#ifdef OC_DYNAMIC_ALLOCATION
-      if (memcmp(ptr2, &ptr, sizeof(void *)) == 0) {
-#else  /* OC_DYNAMIC_ALLOCATION */
-      if (ptr2 == (char *)ptr) {
-#endif /* !OC_DYNAMIC_ALLOCATION */
-        /* We've found to block to which "ptr" points so we decrease the
-           reference count and return the new value of it. */
-        if (m->count[i] > 0) {
-          /* Make sure that we don't deallocate free memory. */
-          --(m->count[i]);
-        }
-        break;
-      }
-#ifdef OC_DYNAMIC_ALLOCATION
-      ptr2 += sizeof(void *);
-#else  /* OC_DYNAMIC_ALLOCATION */
-      ptr2 += m->size;
-#endif /* !OC_DYNAMIC_ALLOCATION */
+  if (m->count) {
+    int i = block_index(m, ptr);
+    if (i < 0) {
+      return -1;
+    }
+    /* Make sure that we don't deallocate free memory. */
+    if (m->count[i] > 0 && --(m->count[i]) == 0 && can_link(m)) {
+      push_free(m, ptr);
     }
   }
 #ifdef OC_DYNAMIC_ALLOCATION
-  if (i < m->num) {
-    memset(&ptr2, 0, sizeof(void *));
+  else if (m->num_free < m->num) {
+    track_pool(m);
+    push_free(m, ptr);
+  } else {
+    free(ptr);
   }
-  free(ptr);
 #endif /* OC_DYNAMIC_ALLOCATION */
   if (m->buffers_avail_cb) {
     m->buffers_avail_cb(oc_memb_numfree(m));
@@ -166,23 +243,27 @@ _oc_memb_free(
 /*---------------------------------------------------------------------------*/
 int oc_memb_inmemb(struct oc_memb * m, void *ptr)
 {
-  return (char *)ptr >= (char *)m->mem &&
+  return m->count && (char *)ptr >= (char *)m->mem &&
          (char *)ptr < (char *)m->mem + (m->num * m->size);
 }
 /*---------------------------------------------------------------------------*/
 int
 oc_memb_numfree(struct oc_memb *m)
 {
-  int i;
-  int num_free = 0;
-
-  for (i = 0; i < m->num; ++i) {
-    if (m->count[i] == 0) {
-      ++num_free;
+  if (!m->count) {
+    return 0;
+  }
+  if (!can_link(m)) {
+    int i;
+    int num_free = 0;
+    for (i = 0; i < m->num; ++i) {
+      if (m->count[i] == 0) {
+        ++num_free;
+      }
     }
+    return num_free;
   }
-
-  return num_free;
+  return m->num - m->next + m->num_free;
 }
 /*---------------------------------------------------------------------------*/
 void oc_memb_set_buffers_avail_cb(struct oc_memb * m,
@@ -191,3 +272,20 @@ void oc_memb_set_buffers_avail_cb(struct oc_memb * m,
   m->buffers_avail_cb = cb;
 }
 /*---------------------------------------------------------------------------*/
+void
+oc_memb_free_cached(void)
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  struct oc_memb *m = cached_pools;
+  cached_pools = &cached_pools_end;
+  while (m != &cached_pools_end) {
+    struct oc_memb *next = m->next_pool;
+    while (m->free_list) {
+      free(pop_free(m));
+    }
+    m->next_pool = NULL;
+    m = next;
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+/*---------------------------------------------------------------------------*/
@@ -93,25 +93,57 @@ extern "C"
 extern "C"
 {
 #endif
+/* Number of freed blocks that a pool declared with OC_MEMB_CACHED() keeps
+ * for reuse before it returns them to the heap.
+ */
+#ifndef OC_MEMB_MAX_FREE_BLOCKS
+#define OC_MEMB_MAX_FREE_BLOCKS (8)
+#endif /* !OC_MEMB_MAX_FREE_BLOCKS */
 #define OC_MEMB(name, structure, num)                                          \
-  static struct oc_memb name = { sizeof(structure), 0, 0, 0, 0 }
+  static struct oc_memb name = { sizeof(structure), 0, 0, 0, 0, 0, 0, 0, 0 }
+#define OC_MEMB_CACHED(name, structure, num)                                   \
+  static struct oc_memb name = {                                              \
+    sizeof(structure), OC_MEMB_MAX_FREE_BLOCKS, 0, 0, 0, 0, 0, 0, 0            \
+  }
+#endif /* OC_DYNAMIC_ALLOCATION */
 #define OC_MEMB_FIXED(name, structure, num)                                    \
-  static char CC_CONCAT(name, _memb_count)[num];                               \
-  static void *CC_CONCAT(name, _memb_mem)[num];                                \
-  static struct oc_memb name = { sizeof(structure), num,                       \
-                                 CC_CONCAT(name, _memb_count),                 \
-                                 (void *)CC_CONCAT(name, _memb_mem), 0 }
-#else /* OC_DYNAMIC_ALLOCATION */
-#define OC_MEMB(name, structure, num)                                          \
   static char CC_CONCAT(name, _memb_count)[num];                               \
   static structure CC_CONCAT(name, _memb_mem)[num];                            \
-  static struct oc_memb name = { sizeof(structure), num,                       \
+  static struct oc_memb name = { sizeof(structure),                            \
+                                 num,                                          \
                                  CC_CONCAT(name, _memb_count),                 \
-                                 (void *)CC_CONCAT(name, _memb_mem), 0 }
+                                 (void *)CC_CONCAT(name, _memb_mem),           \
+                                 0,                                            \
+                                 0,                                            \
+                                 0,                                            \
+                                 0,                                            \
+                                 0 }
+#ifndef OC_DYNAMIC_ALLOCATION
+#define OC_MEMB(name, structure, num) OC_MEMB_FIXED(name, structure, num)
+#define OC_MEMB_CACHED(name, structure, num)                                   \
+  OC_MEMB_FIXED(name, structure, num)
 #endif /* !OC_DYNAMIC_ALLOCATION */
 
 typedef void (*oc_memb_buffers_avail_callback_t)(int);
 
+/*
+ * Pools with a count array (those declared with OC_MEMB_FIXED(), and all
+ * pools in static builds) hand out the num blocks in mem. The others
+ * allocate each block from the heap and keep up to num freed blocks for
+ * reuse. Only pools declared with OC_MEMB_CACHED() set num, so the other
+ * heap pools, and those declared on the stack with num set to 0, simply
+ * call calloc() and free().
+ *
+ * Freed blocks are linked into free_list through their first bytes. Fixed
+ * pools hand out the blocks below next before those on free_list, so that
+ * a zeroed pool needs no further initialization. Heap pools that keep freed
+ * blocks are linked through next_pool, so that oc_memb_free_cached() can
+ * return those blocks at shutdown.
+ *
+ * The free list is not locked. OC_MEMB_CACHED() is only for pools that are
+ * used from a single thread, or whose callers serialize every allocation
+ * and free under one lock.
+ */
 struct oc_memb
 {
   unsigned short size;
@@ -119,6 +151,10 @@ struct oc_memb
   char *count;
   void *mem;
   oc_memb_buffers_avail_callback_t buffers_avail_cb;
+  void *free_list;
+  unsigned short next;     /* fixed pools: blocks that were handed out */
+  unsigned short num_free; /* blocks on free_list */
+  struct oc_memb *next_pool;
 };
 
 /**
@@ -172,6 +208,13 @@ int oc_memb_inmemb(struct oc_memb *m, void *ptr);
 
 int oc_memb_numfree(struct oc_memb *m);
 
+/**
+ * Return the freed blocks that heap pools keep for reuse to the heap.
+ *
+ * No pool may be in use by another thread while this runs.
+ */
+void oc_memb_free_cached(void);
+
 #ifdef __cplusplus
 }
 #endif
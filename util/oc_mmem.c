@@ -36,11 +36,11 @@
 #include "oc_config.h"
 #include "oc_list.h"
 #include "port/oc_log.h"
+#include <stdbool.h>
 #include <stdint.h>
 #include <string.h>
 #ifdef OC_MEMORY_TRACE
 #include "oc_mem_trace.h"
-#include <stdbool.h>
 #endif
 
 #ifndef OC_DYNAMIC_ALLOCATION
@@ -52,16 +52,189 @@
 static double doubles[OC_DOUBLES_POOL_SIZE];
 static int ints[OC_INTS_POOL_SIZE];
 static unsigned char bytes[OC_BYTES_POOL_SIZE];
+
+static oc_mmem_stats_t stats[DOUBLE_POOL + 1];
+
+#ifdef OC_MMEM_SIZE_CLASSES
+#define GRANULE (8)
+#define NUM_ORDERS (16)
+#define NO_BLOCK (0xffff)
+
+#if OC_BYTES_POOL_SIZE / GRANULE >= NO_BLOCK ||                                \
+  OC_INTS_POOL_SIZE >= NO_BLOCK || OC_DOUBLES_POOL_SIZE >= NO_BLOCK
+#error "OC_MMEM_SIZE_CLASSES supports pools of up to 65534 granules"
+#endif /* ...POOL_SIZE >= NO_BLOCK */
+
+/* Kept in the first granule of a free block. */
+typedef struct
+{
+  uint16_t next;
+  uint16_t prev;
+  uint8_t order;
+} free_block_t;
+
+typedef struct
+{
+  unsigned char *mem;
+  uint16_t num_granules;
+  uint8_t *free_map; /* one bit per granule that starts a free block */
+  uint16_t free_lists[NUM_ORDERS];
+} size_class_pool_t;
+
+#define MAP_SIZE(pool_bytes) (((pool_bytes) / GRANULE + 7) / 8)
+
+static uint8_t doubles_map[MAP_SIZE(sizeof(doubles))];
+static uint8_t ints_map[MAP_SIZE(sizeof(ints))];
+static uint8_t bytes_map[MAP_SIZE(sizeof(bytes))];
+
+static size_class_pool_t pools[DOUBLE_POOL + 1] = {
+  { bytes, sizeof(bytes) / GRANULE, bytes_map, { 0 } },
+  { (unsigned char *)ints, sizeof(ints) / GRANULE, ints_map, { 0 } },
+  { (unsigned char *)doubles, sizeof(doubles) / GRANULE, doubles_map, { 0 } }
+};
+#else  /* OC_MMEM_SIZE_CLASSES */
 static unsigned int avail_bytes, avail_ints, avail_doubles;
 
 OC_LIST(bytes_list);
 OC_LIST(ints_list);
 OC_LIST(doubles_list);
-#else /* !OC_DYNAMIC_ALLOCATION */
+#endif /* !OC_MMEM_SIZE_CLASSES */
+#else  /* !OC_DYNAMIC_ALLOCATION */
 #include <stdlib.h>
 #endif /* OC_DYNAMIC_ALLOCATION */
 /*---------------------------------------------------------------------------*/
 
+#if !defined(OC_DYNAMIC_ALLOCATION) && defined(OC_MMEM_SIZE_CLASSES)
+static const size_t unit_sizes[DOUBLE_POOL + 1] = { sizeof(uint8_t),
+                                                    sizeof(int),
+                                                    sizeof(double) };
+
+static bool
+is_free(size_class_pool_t *p, uint16_t i)
+{
+  return (p->free_map[i / 8] & (1 << (i % 8))) != 0;
+}
+
+static free_block_t
+read_block(size_class_pool_t *p, uint16_t i)
+{
+  free_block_t block;
+  memcpy(&block, p->mem + (size_t)i * GRANULE, sizeof(block));
+  return block;
+}
+
+static void
+write_block(size_class_pool_t *p, uint16_t i, const free_block_t *block)
+{
+  memcpy(p->mem + (size_t)i * GRANULE, block, sizeof(*block));
+}
+
+static void
+push_block(size_class_pool_t *p, uint16_t i, uint8_t order)
+{
+  free_block_t block = { p->free_lists[order], NO_BLOCK, order };
+  if (block.next != NO_BLOCK) {
+    free_block_t next = read_block(p, block.next);
+    next.prev = i;
+    write_block(p, block.next, &next);
+  }
+  write_block(p, i, &block);
+  p->free_lists[order] = i;
+  p->free_map[i / 8] |= (uint8_t)(1 << (i % 8));
+}
+
+static void
+remove_block(size_class_pool_t *p, uint16_t i, const free_block_t *block)
+{
+  if (block->prev != NO_BLOCK) {
+    free_block_t prev = read_block(p, block->prev);
+    prev.next = block->next;
+    write_block(p, block->prev, &prev);
+  } else {
+    p->free_lists[block->order] = block->next;
+  }
+  if (block->next != NO_BLOCK) {
+    free_block_t next = read_block(p, block->next);
+    next.prev = block->prev;
+    write_block(p, block->next, &next);
+  }
+  p->free_map[i / 8] &= (uint8_t)~(1 << (i % 8));
+}
+
+static uint8_t
+block_order(size_t size)
+{
+  size_t granules = (size + GRANULE - 1) / GRANULE;
+  uint8_t order = 0;
+  while (((size_t)1 << order) < granules) {
+    order++;
+  }
+  return order;
+}
+
+static void
+init_pool(size_class_pool_t *p)
+{
+  memset(p->free_map, 0, MAP_SIZE((size_t)p->num_granules * GRANULE));
+  int order;
+  for (order = 0; order < NUM_ORDERS; order++) {
+    p->free_lists[order] = NO_BLOCK;
+  }
+  /* Split the pool into the largest blocks that are aligned to their size,
+   * so that each block has a buddy or lies at the end of the pool.
+   */
+  uint16_t i = 0;
+  for (order = NUM_ORDERS - 1; order >= 0; order--) {
+    if (p->num_granules - i >= (1 << order)) {
+      push_block(p, i, (uint8_t)order);
+      i = (uint16_t)(i + (1 << order));
+    }
+  }
+}
+
+static void *
+pool_alloc(size_class_pool_t *p, size_t size)
+{
+  uint8_t order = block_order(size), i = order;
+  while (i < NUM_ORDERS && p->free_lists[i] == NO_BLOCK) {
+    i++;
+  }
+  if (size == 0 || i == NUM_ORDERS) {
+    return NULL;
+  }
+  uint16_t block = p->free_lists[i];
+  free_block_t free_block = read_block(p, block);
+  remove_block(p, block, &free_block);
+  /* Return the upper halves of a larger block to the pool. */
+  while (i > order) {
+    i--;
+    push_block(p, (uint16_t)(block + (1 << i)), i);
+  }
+  return p->mem + (size_t)block * GRANULE;
+}
+
+static void
+pool_free(size_class_pool_t *p, void *ptr, size_t size)
+{
+  uint16_t block = (uint16_t)(((unsigned char *)ptr - p->mem) / GRANULE);
+  uint8_t order = block_order(size);
+  while (order < NUM_ORDERS - 1) {
+    uint16_t buddy = (uint16_t)(block ^ (1 << order));
+    if (buddy + (1 << order) > p->num_granules || !is_free(p, buddy)) {
+      break;
+    }
+    free_block_t free_buddy = read_block(p, buddy);
+    if (free_buddy.order != order) {
+      break;
+    }
+    remove_block(p, buddy, &free_buddy);
+    block = (uint16_t)(block & ~(1 << order));
+    order++;
+  }
+  push_block(p, block, order);
+}
+#endif /* !OC_DYNAMIC_ALLOCATION && OC_MMEM_SIZE_CLASSES */
+
 size_t
 _oc_mmem_alloc(
 #ifdef OC_MEMORY_TRACE
@@ -76,6 +249,24 @@ _oc_mmem_alloc(
 
   size_t bytes_allocated = 0;
 
+#if !defined(OC_DYNAMIC_ALLOCATION) && defined(OC_MMEM_SIZE_CLASSES)
+  if (pool_type > DOUBLE_POOL) {
+    return 0;
+  }
+  bytes_allocated = size * unit_sizes[pool_type];
+  stats[pool_type].allocs++;
+  m->ptr = pool_alloc(&pools[pool_type], bytes_allocated);
+  if (!m->ptr) {
+    OC_WRN("%s pool exhausted",
+           pool_type == BYTE_POOL ? "byte"
+                                  : (pool_type == INT_POOL ? "int" : "double"));
+    stats[pool_type].failures++;
+    return 0;
+  }
+  m->size = size;
+  stats[pool_type].requested += bytes_allocated;
+  stats[pool_type].used += (size_t)GRANULE << block_order(bytes_allocated);
+#else /* !OC_DYNAMIC_ALLOCATION && OC_MMEM_SIZE_CLASSES */
   switch (pool_type) {
   case BYTE_POOL:
     bytes_allocated += size * sizeof(uint8_t);
@@ -83,8 +274,10 @@ _oc_mmem_alloc(
     m->ptr = malloc(size);
     m->size = size;
 #else  /* OC_DYNAMIC_ALLOCATION */
+    stats[BYTE_POOL].allocs++;
     if (avail_bytes < size) {
       OC_WRN("byte pool exhausted");
+      stats[BYTE_POOL].failures++;
       return 0;
     }
     oc_list_add(bytes_list, m);
@@ -99,8 +292,10 @@ _oc_mmem_alloc(
     m->ptr = malloc(size * sizeof(int));
     m->size = size;
 #else  /* OC_DYNAMIC_ALLOCATION */
+    stats[INT_POOL].allocs++;
     if (avail_ints < size) {
       OC_WRN("int pool exhausted");
+      stats[INT_POOL].failures++;
       return 0;
     }
     oc_list_add(ints_list, m);
@@ -115,8 +310,10 @@ _oc_mmem_alloc(
     m->ptr = malloc(size * sizeof(double));
     m->size = size;
 #else  /* OC_DYNAMIC_ALLOCATION */
+    stats[DOUBLE_POOL].allocs++;
     if (avail_doubles < size) {
       OC_WRN("double pool exhausted");
+      stats[DOUBLE_POOL].failures++;
       return 0;
     }
     oc_list_add(doubles_list, m);
@@ -128,6 +325,7 @@ _oc_mmem_alloc(
   default:
     break;
   }
+#endif /* OC_DYNAMIC_ALLOCATION || !OC_MMEM_SIZE_CLASSES */
 
 #ifdef OC_MEMORY_TRACE
   oc_mem_trace_add_pace(func, bytes_allocated, MEM_TRACE_ALLOC, m->ptr);
@@ -164,30 +362,46 @@ _oc_mmem_free(
 #endif /* OC_MEMORY_TRACE */
 
 #ifndef OC_DYNAMIC_ALLOCATION
+#ifdef OC_MMEM_SIZE_CLASSES
+  if (pool_type > DOUBLE_POOL || !m->ptr || m->size == 0) {
+    return;
+  }
+  size_t block_size = m->size * unit_sizes[pool_type];
+  pool_free(&pools[pool_type], m->ptr, block_size);
+  stats[pool_type].requested -= block_size;
+  stats[pool_type].used -= (size_t)GRANULE << block_order(block_size);
+#else  /* OC_MMEM_SIZE_CLASSES */
   struct oc_mmem *n;
+  size_t unit_size;
 
   if (m->next != NULL) {
     switch (pool_type) {
     case BYTE_POOL:
+      unit_size = sizeof(uint8_t);
       memmove(m->ptr, m->next->ptr, &bytes[OC_BYTES_POOL_SIZE - avail_bytes] -
                                       (unsigned char *)m->next->ptr);
 
       break;
     case INT_POOL:
+      unit_size = sizeof(int);
       memmove(m->ptr, m->next->ptr,
-              &ints[OC_INTS_POOL_SIZE - avail_ints] - (int *)m->next->ptr);
+              (size_t)(&ints[OC_INTS_POOL_SIZE - avail_ints] -
+                       (int *)m->next->ptr) *
+                sizeof(int));
       break;
     case DOUBLE_POOL:
+      unit_size = sizeof(double);
       memmove(m->ptr, m->next->ptr,
-              &doubles[OC_DOUBLES_POOL_SIZE - avail_doubles] -
-                (double *)m->next->ptr);
+              (size_t)(&doubles[OC_DOUBLES_POOL_SIZE - avail_doubles] -
+                       (double *)m->next->ptr) *
+                sizeof(double));
       break;
     default:
       return;
       break;
     }
     for (n = m->next; n != NULL; n = n->next) {
-      n->ptr = (void *)((char *)n->ptr - m->size);
+      n->ptr = (void *)((char *)n->ptr - m->size * unit_size);
     }
   }
 
@@ -205,6 +419,7 @@ _oc_mmem_free(
     oc_list_remove(doubles_list, m);
     break;
   }
+#endif /* !OC_MMEM_SIZE_CLASSES */
 #else /* !OC_DYNAMIC_ALLOCATION */
   (void)pool_type;
   free(m->ptr);
@@ -220,13 +435,53 @@ oc_mmem_init(void)
   if (inited) {
     return;
   }
+  memset(stats, 0, sizeof(stats));
+  stats[BYTE_POOL].size = sizeof(bytes);
+  stats[INT_POOL].size = sizeof(ints);
+  stats[DOUBLE_POOL].size = sizeof(doubles);
+#ifdef OC_MMEM_SIZE_CLASSES
+  int i;
+  for (i = BYTE_POOL; i <= DOUBLE_POOL; i++) {
+    init_pool(&pools[i]);
+  }
+#else  /* OC_MMEM_SIZE_CLASSES */
   oc_list_init(bytes_list);
   oc_list_init(ints_list);
   oc_list_init(doubles_list);
   avail_bytes = OC_BYTES_POOL_SIZE;
   avail_ints = OC_INTS_POOL_SIZE;
   avail_doubles = OC_DOUBLES_POOL_SIZE;
+#endif /* !OC_MMEM_SIZE_CLASSES */
   inited = 1;
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
+
+#ifndef OC_DYNAMIC_ALLOCATION
+void
+oc_mmem_stats(pool pool_type, oc_mmem_stats_t *stats_out)
+{
+  if (pool_type > DOUBLE_POOL) {
+    memset(stats_out, 0, sizeof(*stats_out));
+    return;
+  }
+  memcpy(stats_out, &stats[pool_type], sizeof(*stats_out));
+#ifdef OC_MMEM_SIZE_CLASSES
+  size_class_pool_t *p = &pools[pool_type];
+  int order;
+  for (order = NUM_ORDERS - 1; order >= 0; order--) {
+    if (p->free_lists[order] != NO_BLOCK) {
+      stats_out->largest_free = (size_t)GRANULE << order;
+      break;
+    }
+  }
+#else  /* OC_MMEM_SIZE_CLASSES */
+  size_t avail = pool_type == BYTE_POOL
+                   ? avail_bytes
+                   : pool_type == INT_POOL ? avail_ints * sizeof(int)
+                                           : avail_doubles * sizeof(double);
+  stats_out->requested = stats_out->used = stats_out->size - avail;
+  stats_out->largest_free = avail;
+#endif /* !OC_MMEM_SIZE_CLASSES */
+}
+#endif /* !OC_DYNAMIC_ALLOCATION */
 /*---------------------------------------------------------------------------*/
@@ -36,6 +36,7 @@
 #define OC_MMEM_H
 
 #include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C"
@@ -81,6 +82,31 @@ void _oc_mmem_free(
 #endif
   struct oc_mmem *m, pool pool_type);
 
+#ifndef OC_DYNAMIC_ALLOCATION
+/*
+ * By default the pools are compacted on every free, which moves all blocks
+ * allocated after the freed one. With OC_MMEM_SIZE_CLASSES, blocks stay in
+ * place: the pools are split into power-of-two sized blocks of 8 byte
+ * granules, and freed blocks are merged with their free buddies. Blocks are
+ * then up to twice the size asked for, which the pool sizes must allow for.
+ */
+typedef struct
+{
+  size_t size;         /* bytes in the pool */
+  size_t requested;    /* bytes asked for by allocated blocks */
+  size_t used;         /* bytes in allocated blocks */
+  size_t largest_free; /* bytes in the largest block that can be allocated */
+  uint32_t allocs;     /* allocations */
+  uint32_t failures;   /* allocations that did not fit in the pool */
+} oc_mmem_stats_t;
+
+/*
+ * Usage of a pool. Of the size - used bytes that are free, those beyond
+ * largest_free are lost to fragmentation.
+ */
+void oc_mmem_stats(pool pool_type, oc_mmem_stats_t *stats);
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
 #ifdef __cplusplus
 }
 #endif
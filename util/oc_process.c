@@ -35,6 +35,11 @@
 #include "oc_process.h"
 #include "oc_buffer.h"
 #include <stdio.h>
+#ifdef OC_PROCESS_PRIORITIES
+#include "port/oc_clock.h"
+#include <stdbool.h>
+#include <string.h>
+#endif /* OC_PROCESS_PRIORITIES */
 #ifdef OC_DYNAMIC_ALLOCATION
 #include "port/oc_assert.h"
 #include <stdlib.h>
@@ -65,12 +70,37 @@ static unsigned long OC_PROCESS_NUMEVENTS = 10;
 #define OC_PROCESS_NUMEVENTS 10
 #endif /* !OC_DYNAMIC_ALLOCATION */
 
-static oc_process_num_events_t nevents, fevent;
+static oc_process_num_events_t nevents;
+#ifdef OC_PROCESS_PRIORITIES
+typedef struct
+{
+#ifdef OC_DYNAMIC_ALLOCATION
+  struct event_data *events;
+  oc_process_num_events_t size;
+#else  /* OC_DYNAMIC_ALLOCATION */
+  struct event_data events[OC_PROCESS_NUMEVENTS];
+#endif /* !OC_DYNAMIC_ALLOCATION */
+  oc_process_num_events_t first, num;
+} event_queue_t;
+
+#ifdef OC_DYNAMIC_ALLOCATION
+#define queue_size(q) ((q)->size)
+#else /* OC_DYNAMIC_ALLOCATION */
+#define queue_size(q) (OC_PROCESS_NUMEVENTS)
+#endif /* !OC_DYNAMIC_ALLOCATION */
+
+static event_queue_t queues[OC_PROCESS_NUM_CLASSES];
+static unsigned char event_classes[1 << (8 * sizeof(oc_process_event_t))];
+static oc_clock_time_t class_budgets[OC_PROCESS_NUM_CLASSES];
+static oc_process_stats_t stats;
+#else /* OC_PROCESS_PRIORITIES */
+static oc_process_num_events_t fevent;
 #ifdef OC_DYNAMIC_ALLOCATION
 static struct event_data *events;
 #else  /* OC_DYNAMIC_ALLOCATION */
 static struct event_data events[OC_PROCESS_NUMEVENTS];
 #endif /* !OC_DYNAMIC_ALLOCATION */
+#endif /* !OC_PROCESS_PRIORITIES */
 
 #if OC_PROCESS_CONF_STATS
 oc_process_num_events_t process_maxevents;
@@ -194,14 +224,39 @@ void
 oc_process_shutdown(void)
 {
 #ifdef OC_DYNAMIC_ALLOCATION
+#ifdef OC_PROCESS_PRIORITIES
+  int cls;
+  for (cls = 0; cls < OC_PROCESS_NUM_CLASSES; cls++) {
+    free(queues[cls].events);
+    queues[cls].events = NULL;
+  }
+#else  /* OC_PROCESS_PRIORITIES */
   free(events);
+#endif /* !OC_PROCESS_PRIORITIES */
 #endif /* OC_DYNAMIC_ALLOCATION */
 }
 
 void
 oc_process_init(void)
 {
+#ifdef OC_PROCESS_PRIORITIES
+  int cls;
+  for (cls = 0; cls < OC_PROCESS_NUM_CLASSES; cls++) {
 #ifdef OC_DYNAMIC_ALLOCATION
+    queues[cls].size = OC_PROCESS_NUMEVENTS;
+    queues[cls].events = (struct event_data *)calloc(
+      queues[cls].size, sizeof(struct event_data));
+    if (!queues[cls].events) {
+      oc_abort("Insufficient memory");
+    }
+#endif /* OC_DYNAMIC_ALLOCATION */
+    queues[cls].first = queues[cls].num = 0;
+    class_budgets[cls] = OC_PROCESS_CLASS_BUDGET;
+  }
+  memset(event_classes, OC_PROCESS_CLASS_APP, sizeof(event_classes));
+  event_classes[OC_PROCESS_EVENT_TIMER] = OC_PROCESS_CLASS_TIMER;
+  memset(&stats, 0, sizeof(stats));
+#elif defined(OC_DYNAMIC_ALLOCATION)
   events = (struct event_data *)calloc(OC_PROCESS_NUMEVENTS,
                                        sizeof(struct event_data));
   if (!events) {
@@ -211,7 +266,10 @@ oc_process_init(void)
 
   lastevent = OC_PROCESS_EVENT_MAX;
 
-  nevents = fevent = 0;
+  nevents = 0;
+#ifndef OC_PROCESS_PRIORITIES
+  fevent = 0;
+#endif /* !OC_PROCESS_PRIORITIES */
 #if OC_PROCESS_CONF_STATS
   process_maxevents = 0;
 #endif /* OC_PROCESS_CONF_STATS */
@@ -239,6 +297,93 @@ do_poll(void)
   }
 }
 /*---------------------------------------------------------------------------*/
+/*
+ * Deliver an event that was taken off the queue to listening processes.
+ */
+/*---------------------------------------------------------------------------*/
+static void
+deliver_event(oc_process_event_t ev, oc_process_data_t data,
+              struct oc_process *receiver)
+{
+  static struct oc_process *p;
+
+  /* If this is a broadcast event, we deliver it to all events, in
+     order of their priority. */
+  if (receiver == OC_PROCESS_BROADCAST) {
+    for (p = oc_process_list; p != NULL; p = p->next) {
+
+      /* If we have been requested to poll a process, we do this in
+         between processing the broadcast event. */
+      if (poll_requested) {
+        do_poll();
+      }
+      call_process(p, ev, data);
+    }
+  } else {
+    /* This is not a broadcast event, so we deliver it to the
+ specified process. */
+    /* If the event was an INIT event, we should also update the
+ state of the process. */
+    if (ev == OC_PROCESS_EVENT_INIT) {
+      receiver->state = OC_PROCESS_STATE_RUNNING;
+    }
+
+    /* Make sure that the process actually is running. */
+    call_process(receiver, ev, data);
+  }
+}
+#ifdef OC_PROCESS_PRIORITIES
+/*---------------------------------------------------------------------------*/
+/*
+ * Dispatch the events that class cls holds now, but no more than its budget
+ * allows. Events that get posted meanwhile wait for the next pass, so that a
+ * class cannot keep the others from running by feeding itself.
+ */
+/*---------------------------------------------------------------------------*/
+static void
+drain_queue(int cls)
+{
+  event_queue_t *q = &queues[cls];
+  oc_process_num_events_t n = q->num;
+  if (n == 0) {
+    return;
+  }
+  oc_clock_time_t budget = class_budgets[cls];
+  oc_clock_time_t start = budget ? oc_clock_time() : 0;
+
+  while (n-- > 0 && q->num > 0) {
+    struct event_data e = q->events[q->first];
+    q->first = (q->first + 1) % queue_size(q);
+    --q->num;
+    --nevents;
+    stats.dispatched[cls]++;
+    deliver_event(e.ev, e.data, e.p);
+
+    if (poll_requested) {
+      do_poll();
+    }
+    if (budget && n > 0 && oc_clock_time() - start >= budget) {
+      stats.over_budget[cls]++;
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+oc_process_run(void)
+{
+  int cls;
+  for (cls = 0; cls < OC_PROCESS_NUM_CLASSES; cls++) {
+    if (poll_requested) {
+      do_poll();
+    }
+    drain_queue(cls);
+  }
+
+  return nevents + poll_requested;
+}
+#else /* OC_PROCESS_PRIORITIES */
+/*---------------------------------------------------------------------------*/
 /*
  * Process the next event in the event queue and deliver it to
  * listening processes.
@@ -250,7 +395,6 @@ do_event(void)
   static oc_process_event_t ev;
   static oc_process_data_t data;
   static struct oc_process *receiver;
-  static struct oc_process *p;
 
   /*
    * If there are any events in the queue, take the first one and walk
@@ -273,30 +417,7 @@ do_event(void)
     fevent = (fevent + 1) % OC_PROCESS_NUMEVENTS;
     --nevents;
 
-    /* If this is a broadcast event, we deliver it to all events, in
-       order of their priority. */
-    if (receiver == OC_PROCESS_BROADCAST) {
-      for (p = oc_process_list; p != NULL; p = p->next) {
-
-        /* If we have been requested to poll a process, we do this in
-           between processing the broadcast event. */
-        if (poll_requested) {
-          do_poll();
-        }
-        call_process(p, ev, data);
-      }
-    } else {
-      /* This is not a broadcast event, so we deliver it to the
-   specified process. */
-      /* If the event was an INIT event, we should also update the
-   state of the process. */
-      if (ev == OC_PROCESS_EVENT_INIT) {
-        receiver->state = OC_PROCESS_STATE_RUNNING;
-      }
-
-      /* Make sure that the process actually is running. */
-      call_process(receiver, ev, data);
-    }
+    deliver_event(ev, data, receiver);
   }
 }
 /*---------------------------------------------------------------------------*/
@@ -313,6 +434,7 @@ oc_process_run(void)
 
   return nevents + poll_requested;
 }
+#endif /* !OC_PROCESS_PRIORITIES */
 /*---------------------------------------------------------------------------*/
 int
 oc_process_nevents(void)
@@ -320,6 +442,88 @@ oc_process_nevents(void)
   return nevents + poll_requested;
 }
 /*---------------------------------------------------------------------------*/
+#ifdef OC_PROCESS_PRIORITIES
+#ifdef OC_DYNAMIC_ALLOCATION
+static bool
+grow_queue(event_queue_t *q)
+{
+  oc_process_num_events_t size = q->size << 1, i;
+  struct event_data *events =
+    (struct event_data *)calloc(size, sizeof(struct event_data));
+  if (!events) {
+    return false;
+  }
+  /* Unwrap the queue into the front of the new array. */
+  for (i = 0; i < q->num; i++) {
+    events[i] = q->events[(q->first + i) % q->size];
+  }
+  free(q->events);
+  q->events = events;
+  q->size = size;
+  q->first = 0;
+  return true;
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+/*---------------------------------------------------------------------------*/
+int
+oc_process_post(struct oc_process *p, oc_process_event_t ev,
+                oc_process_data_t data)
+{
+  int cls = event_classes[ev];
+  event_queue_t *q = &queues[cls];
+
+  if (q->num == queue_size(q)) {
+#ifdef OC_DYNAMIC_ALLOCATION
+    if (!grow_queue(q)) {
+      oc_abort("Insufficient memory");
+    }
+#else  /* OC_DYNAMIC_ALLOCATION */
+    return OC_PROCESS_ERR_FULL;
+#endif /* !OC_DYNAMIC_ALLOCATION */
+  }
+
+  struct event_data *e = &q->events[(q->first + q->num) % queue_size(q)];
+  e->ev = ev;
+  e->data = data;
+  e->p = p;
+  ++q->num;
+  ++nevents;
+  if (q->num > stats.max_queued[cls]) {
+    stats.max_queued[cls] = q->num;
+  }
+
+#if OC_PROCESS_CONF_STATS
+  if (nevents > process_maxevents) {
+    process_maxevents = nevents;
+  }
+#endif /* OC_PROCESS_CONF_STATS */
+
+  return OC_PROCESS_ERR_OK;
+}
+/*---------------------------------------------------------------------------*/
+void
+oc_process_set_event_class(oc_process_event_t ev, oc_process_class_t cls)
+{
+  /* Events already queued stay in their class. */
+  event_classes[ev] = (unsigned char)cls;
+}
+/*---------------------------------------------------------------------------*/
+void
+oc_process_set_class_budget(oc_process_class_t cls, oc_clock_time_t ticks)
+{
+  class_budgets[cls] = ticks;
+}
+/*---------------------------------------------------------------------------*/
+void
+oc_process_stats(oc_process_stats_t *process_stats)
+{
+  int cls;
+  memcpy(process_stats, &stats, sizeof(oc_process_stats_t));
+  for (cls = 0; cls < OC_PROCESS_NUM_CLASSES; cls++) {
+    process_stats->queued[cls] = queues[cls].num;
+  }
+}
+#else /* OC_PROCESS_PRIORITIES */
 int
 oc_process_post(struct oc_process *p, oc_process_event_t ev,
                 oc_process_data_t data)
@@ -364,6 +568,7 @@ oc_process_post(struct oc_process *p, oc_process_event_t ev,
 
   return OC_PROCESS_ERR_OK;
 }
+#endif /* !OC_PROCESS_PRIORITIES */
 /*---------------------------------------------------------------------------*/
 void
 oc_process_post_synch(struct oc_process *p, oc_process_event_t ev,
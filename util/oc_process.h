@@ -42,6 +42,7 @@
 
 #ifndef OC_PROCESS_H
 #define OC_PROCESS_H
+#include "oc_config.h"
 #include "util/pt/pt.h"
 
 #ifdef __cplusplus
@@ -501,6 +502,9 @@ void oc_process_shutdown(void);
  * may choose to put the CPU to sleep when there are no pending
  * events.
  *
+ * With OC_PROCESS_PRIORITIES, a call drains each event class in turn,
+ * as described with oc_process_class_t.
+ *
  * \return The number of events that are currently waiting in the
  * event queue.
  */
@@ -525,6 +529,49 @@ int oc_process_is_running(struct oc_process *p);
  */
 int oc_process_nevents(void);
 
+#ifdef OC_PROCESS_PRIORITIES
+/*
+ * With OC_PROCESS_PRIORITIES, posted events wait in one queue per class
+ * rather than in a single FIFO. Each call to oc_process_run() drains the
+ * classes in the order below, dispatching the events that each class held
+ * when its turn came, until the class runs out of events or out of its time
+ * budget. Events keep their order within a class. Poll handlers still run
+ * ahead of any queued event.
+ */
+typedef enum {
+  OC_PROCESS_CLASS_NETWORK_RX = 0,
+  OC_PROCESS_CLASS_TIMER,
+  OC_PROCESS_CLASS_NETWORK_TX,
+  OC_PROCESS_CLASS_APP,
+  OC_PROCESS_NUM_CLASSES
+} oc_process_class_t;
+
+#ifndef OC_PROCESS_CLASS_BUDGET
+/* Default clock ticks that a class may take per oc_process_run() */
+#define OC_PROCESS_CLASS_BUDGET (OC_CLOCK_CONF_TICKS_PER_SECOND / 100)
+#endif /* !OC_PROCESS_CLASS_BUDGET */
+
+typedef struct
+{
+  unsigned long queued[OC_PROCESS_NUM_CLASSES];     /* events waiting now */
+  unsigned long max_queued[OC_PROCESS_NUM_CLASSES]; /* high-water mark */
+  unsigned long dispatched[OC_PROCESS_NUM_CLASSES];
+  /* oc_process_run() calls that left events behind for lack of budget */
+  unsigned long over_budget[OC_PROCESS_NUM_CLASSES];
+} oc_process_stats_t;
+
+/*
+ * Queue ev in class cls. Events default to OC_PROCESS_CLASS_APP, apart from
+ * OC_PROCESS_EVENT_TIMER, which is in OC_PROCESS_CLASS_TIMER.
+ */
+void oc_process_set_event_class(oc_process_event_t ev, oc_process_class_t cls);
+
+/* A budget of 0 lets the class drain all of its events. */
+void oc_process_set_class_budget(oc_process_class_t cls, oc_clock_time_t ticks);
+
+void oc_process_stats(oc_process_stats_t *stats);
+#endif /* OC_PROCESS_PRIORITIES */
+
 /** @} */
 
 extern struct oc_process *oc_process_list;
@@ -0,0 +1,79 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <cstdint>
+#include <cstring>
+#include <gtest/gtest.h>
+
+#include "port/linux/oc_config.h"
+#include "util/oc_arena.h"
+
+#ifdef OC_DYNAMIC_ALLOCATION
+TEST(TestArena, AllocationsAreAligned_P)
+{
+  oc_arena_t arena = { NULL };
+  size_t size;
+  for (size = 1; size < 64; size++) {
+    void *ptr = oc_arena_alloc(&arena, size);
+    ASSERT_NE(nullptr, ptr);
+    EXPECT_EQ(0u, (uintptr_t)ptr % sizeof(double));
+    memset(ptr, 0xff, size);
+  }
+  oc_arena_free(&arena);
+  EXPECT_EQ(nullptr, arena.blocks);
+}
+
+TEST(TestArena, ReserveKeepsAllocationsInOneBlock_P)
+{
+  oc_arena_t arena = { NULL };
+  ASSERT_TRUE(oc_arena_reserve(&arena, 1024));
+  uint8_t *first = (uint8_t *)oc_arena_alloc(&arena, 512);
+  uint8_t *second = (uint8_t *)oc_arena_alloc(&arena, 512);
+  ASSERT_NE(nullptr, first);
+  EXPECT_EQ(first + 512, second);
+  oc_arena_free(&arena);
+}
+
+TEST(TestArena, ResetReusesLastBlock_P)
+{
+  oc_arena_t arena = { NULL };
+  void *first = oc_arena_alloc(&arena, 256);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, oc_arena_alloc(&arena, 1024));
+  void *last = oc_arena_alloc(&arena, 16);
+  oc_arena_reset(&arena);
+  EXPECT_EQ(last, oc_arena_alloc(&arena, 16));
+  oc_arena_free(&arena);
+}
+
+TEST(TestArena, ResetDropsOversizedBlocks_P)
+{
+  oc_arena_t arena = { NULL };
+  ASSERT_NE(nullptr, oc_arena_alloc(&arena, OC_ARENA_MAX_RETAINED_SIZE + 1));
+  oc_arena_reset(&arena);
+  EXPECT_EQ(nullptr, arena.blocks);
+}
+
+TEST(TestArena, NewString_P)
+{
+  oc_arena_t arena = { NULL };
+  struct oc_mmem str;
+  ASSERT_TRUE(oc_arena_new_string(&arena, &str, "/a/light?x=1", 8));
+  EXPECT_EQ(9u, str.size);
+  EXPECT_STREQ("/a/light", (const char *)str.ptr);
+  oc_arena_free(&arena);
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
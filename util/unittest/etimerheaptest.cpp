@@ -0,0 +1,289 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <gtest/gtest.h>
+#include <vector>
+
+/* Builds the min-heap event timers into this test, whatever the
+ * configuration of the library. The timer struct, the timer process and the
+ * functions are renamed so that they do not clash with those of the library.
+ */
+#include "port/linux/oc_config.h"
+#undef OC_ETIMER_WHEEL
+#define oc_etimer heap_etimer
+#define oc_etimer_process heap_etimer_process
+#define process_thread_oc_etimer_process process_thread_heap_etimer_process
+#define oc_etimer_request_poll heap_etimer_request_poll
+#define oc_etimer_set heap_etimer_set
+#define oc_etimer_reset_with_new_interval heap_etimer_reset_with_new_interval
+#define oc_etimer_reset heap_etimer_reset
+#define oc_etimer_restart heap_etimer_restart
+#define oc_etimer_adjust heap_etimer_adjust
+#define oc_etimer_expired heap_etimer_expired
+#define oc_etimer_expiration_time heap_etimer_expiration_time
+#define oc_etimer_start_time heap_etimer_start_time
+#define oc_etimer_pending heap_etimer_pending
+#define oc_etimer_next_expiration_time heap_etimer_next_expiration_time
+#define oc_etimer_stop heap_etimer_stop
+#include "util/oc_etimer.c"
+
+#define NUM_TIMERS (100)
+/* Far enough out that no timer expires while a test runs */
+#define INTERVAL(i) ((oc_clock_time_t)(((i)*7919) % 1000 + 100) *            \
+                     (OC_CLOCK_SECOND / 10))
+#define FAR_FUTURE ((oc_clock_time_t)-1)
+
+static std::vector<void *> notified;
+
+OC_PROCESS(owner_a, "Timer owner A");
+OC_PROCESS_THREAD(owner_a, ev, data)
+{
+  OC_PROCESS_BEGIN();
+  while (1) {
+    OC_PROCESS_YIELD();
+    if (ev == OC_PROCESS_EVENT_TIMER) {
+      notified.push_back(data);
+    }
+  }
+  OC_PROCESS_END();
+}
+
+OC_PROCESS(owner_b, "Timer owner B");
+OC_PROCESS_THREAD(owner_b, ev, data)
+{
+  (void)ev;
+  (void)data;
+  OC_PROCESS_BEGIN();
+  while (1) {
+    OC_PROCESS_YIELD();
+  }
+  OC_PROCESS_END();
+}
+
+class TestEtimerHeap : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    notified.clear();
+    oc_process_init();
+    oc_process_start(&oc_etimer_process, NULL);
+    oc_process_start(&owner_a, NULL);
+    oc_process_start(&owner_b, NULL);
+  }
+
+  /* The timers live on the stack of each test, which takes them all off
+   * the heap before it returns.
+   */
+  virtual void TearDown()
+  {
+    EXPECT_EQ(nullptr, heap_root);
+    EXPECT_EQ(0u, num_timers);
+    oc_process_exit(&owner_a);
+    oc_process_exit(&owner_b);
+    oc_process_exit(&oc_etimer_process);
+    oc_process_shutdown();
+  }
+
+  static void setTimer(struct oc_etimer *t, struct oc_process *owner,
+                       oc_clock_time_t interval)
+  {
+    OC_PROCESS_CONTEXT_BEGIN(owner);
+    oc_etimer_set(t, interval);
+    OC_PROCESS_CONTEXT_END(owner);
+  }
+
+  /* Checks the links and order below t, and returns the number of timers */
+  static size_t checkSubtree(struct oc_etimer *t, struct oc_etimer *parent)
+  {
+    if (!t) {
+      return 0;
+    }
+    EXPECT_EQ(parent, t->parent);
+    if (parent) {
+      EXPECT_LE(expiry_time(parent), expiry_time(t));
+    }
+    EXPECT_NE(OC_PROCESS_NONE, t->p);
+    return 1 + checkSubtree(t->left, t) + checkSubtree(t->right, t);
+  }
+
+  /* The heap holds num_timers timers in order, and is complete */
+  static void checkHeap(void)
+  {
+    EXPECT_EQ(num_timers, checkSubtree(heap_root, NULL));
+    size_t pos;
+    for (pos = 1; pos <= num_timers; pos++) {
+      EXPECT_NE(nullptr, heap_node(pos));
+    }
+    if (heap_root) {
+      EXPECT_EQ(expiry_time(heap_root), oc_etimer_next_expiration_time());
+    } else {
+      EXPECT_EQ(0u, oc_etimer_next_expiration_time());
+    }
+  }
+
+  /* Takes all timers off the heap, earliest first */
+  static std::vector<struct oc_etimer *> drain(void)
+  {
+    std::vector<struct oc_etimer *> order;
+    struct oc_etimer *t;
+    while ((t = due_timer(FAR_FUTURE)) != NULL) {
+      remove_timer(t);
+      order.push_back(t);
+    }
+    return order;
+  }
+
+  static void expectSorted(const std::vector<struct oc_etimer *> &order)
+  {
+    size_t i;
+    for (i = 1; i < order.size(); i++) {
+      EXPECT_LE(expiry_time(order[i - 1]), expiry_time(order[i]));
+    }
+  }
+};
+
+TEST_F(TestEtimerHeap, ExpireInOrder_P)
+{
+  struct oc_etimer timers[NUM_TIMERS];
+  memset(timers, 0, sizeof(timers));
+  int i;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    setTimer(&timers[i], &owner_a, INTERVAL(i));
+  }
+  EXPECT_TRUE(oc_etimer_pending());
+  checkHeap();
+
+  std::vector<struct oc_etimer *> order = drain();
+  EXPECT_EQ((size_t)NUM_TIMERS, order.size());
+  expectSorted(order);
+  for (i = 0; i < NUM_TIMERS; i++) {
+    EXPECT_TRUE(oc_etimer_expired(&timers[i]));
+  }
+  EXPECT_FALSE(oc_etimer_pending());
+  checkHeap();
+}
+
+TEST_F(TestEtimerHeap, StopNonRootTimer_P)
+{
+  struct oc_etimer timers[NUM_TIMERS];
+  memset(timers, 0, sizeof(timers));
+  int i;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    setTimer(&timers[i], &owner_a, INTERVAL(i));
+  }
+
+  /* An inner node, the last leaf and a leaf on the other side */
+  struct oc_etimer *stopped[] = { heap_root->left->right, heap_node(num_timers),
+                                  heap_root->right->right->right };
+  for (i = 0; i < 3; i++) {
+    ASSERT_NE(heap_root, stopped[i]);
+    oc_etimer_stop(stopped[i]);
+    EXPECT_TRUE(oc_etimer_expired(stopped[i]));
+    checkHeap();
+  }
+  EXPECT_EQ((size_t)NUM_TIMERS - 3, num_timers);
+  /* Stopping a timer that is not pending leaves the heap alone */
+  oc_etimer_stop(stopped[0]);
+  EXPECT_EQ((size_t)NUM_TIMERS - 3, num_timers);
+
+  std::vector<struct oc_etimer *> order = drain();
+  EXPECT_EQ((size_t)NUM_TIMERS - 3, order.size());
+  expectSorted(order);
+  for (i = 0; i < 3; i++) {
+    EXPECT_EQ(order.end(), std::find(order.begin(), order.end(), stopped[i]));
+  }
+}
+
+TEST_F(TestEtimerHeap, AdjustMovesTimer_P)
+{
+  struct oc_etimer timers[NUM_TIMERS];
+  memset(timers, 0, sizeof(timers));
+  int i;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    setTimer(&timers[i], &owner_a, INTERVAL(i));
+  }
+
+  /* A leaf moved ahead of all others becomes the root */
+  struct oc_etimer *t = heap_node(num_timers);
+  oc_clock_time_t earliest = expiry_time(heap_root);
+  oc_etimer_adjust(t, -(int)(expiry_time(t) - earliest + 1));
+  EXPECT_EQ(t, heap_root);
+  EXPECT_EQ(earliest - 1, oc_etimer_next_expiration_time());
+  checkHeap();
+
+  /* The root moved behind all others sinks to the bottom */
+  oc_etimer_adjust(t, (int)(INTERVAL(0) * 20));
+  EXPECT_NE(t, heap_root);
+  EXPECT_EQ(nullptr, t->left);
+  checkHeap();
+
+  /* Adjusting a stopped timer does not put it back */
+  oc_etimer_stop(t);
+  oc_etimer_adjust(t, -(int)OC_CLOCK_SECOND);
+  EXPECT_TRUE(oc_etimer_expired(t));
+  checkHeap();
+
+  std::vector<struct oc_etimer *> order = drain();
+  EXPECT_EQ((size_t)NUM_TIMERS - 1, order.size());
+  expectSorted(order);
+}
+
+TEST_F(TestEtimerHeap, ProcessExitRemovesItsTimers_P)
+{
+  struct oc_etimer timers[NUM_TIMERS];
+  memset(timers, 0, sizeof(timers));
+  int i;
+  for (i = 0; i < NUM_TIMERS; i++) {
+    setTimer(&timers[i], (i & 1) ? &owner_b : &owner_a, INTERVAL(i));
+  }
+
+  oc_process_exit(&owner_b);
+  for (i = 0; i < NUM_TIMERS; i++) {
+    EXPECT_EQ((i & 1) != 0, oc_etimer_expired(&timers[i]) != 0);
+  }
+  EXPECT_EQ((size_t)NUM_TIMERS / 2, num_timers);
+  checkHeap();
+
+  oc_process_exit(&owner_a);
+  for (i = 0; i < NUM_TIMERS; i++) {
+    EXPECT_TRUE(oc_etimer_expired(&timers[i]));
+  }
+  checkHeap();
+}
+
+TEST_F(TestEtimerHeap, DueTimerNotifiesOwner_P)
+{
+  struct oc_etimer due, later;
+  memset(&due, 0, sizeof(due));
+  memset(&later, 0, sizeof(later));
+  setTimer(&later, &owner_a, INTERVAL(1));
+  setTimer(&due, &owner_a, INTERVAL(2));
+  oc_etimer_adjust(&due, -(int)(INTERVAL(2) + 1));
+
+  oc_etimer_request_poll();
+  while (oc_process_run())
+    ;
+  ASSERT_EQ(1u, notified.size());
+  EXPECT_EQ(&due, notified[0]);
+  EXPECT_TRUE(oc_etimer_expired(&due));
+  EXPECT_FALSE(oc_etimer_expired(&later));
+  EXPECT_EQ(&later, heap_root);
+  checkHeap();
+  oc_etimer_stop(&later);
+}
@@ -0,0 +1,237 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <chrono>
+#include <cstdio>
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "port/linux/oc_config.h"
+#include "util/oc_memb.h"
+
+#define NUM_BLOCKS (64)
+#define NUM_ROUNDS (100000)
+
+struct block_t
+{
+  int value;
+  char payload[60];
+};
+
+OC_MEMB_FIXED(fixed_pool, block_t, NUM_BLOCKS);
+OC_MEMB_FIXED(tiny_pool, char, 4);
+
+class TestMemb : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    oc_memb_init(&fixed_pool);
+    oc_memb_init(&tiny_pool);
+  }
+};
+
+TEST_F(TestMemb, AllocUntilExhausted_P)
+{
+  std::vector<block_t *> blocks;
+  block_t *block;
+  while ((block = (block_t *)oc_memb_alloc(&fixed_pool)) != NULL) {
+    EXPECT_TRUE(oc_memb_inmemb(&fixed_pool, block));
+    EXPECT_EQ(0, block->value);
+    block->value = (int)blocks.size() + 1;
+    blocks.push_back(block);
+  }
+  ASSERT_EQ((size_t)NUM_BLOCKS, blocks.size());
+  EXPECT_EQ(0, oc_memb_numfree(&fixed_pool));
+
+  size_t i;
+  for (i = 0; i < blocks.size(); i++) {
+    EXPECT_EQ((int)i + 1, blocks[i]->value);
+    EXPECT_EQ(0, oc_memb_free(&fixed_pool, blocks[i]));
+  }
+  EXPECT_EQ(NUM_BLOCKS, oc_memb_numfree(&fixed_pool));
+}
+
+TEST_F(TestMemb, FreedBlockIsReusedCleared_P)
+{
+  block_t *first = (block_t *)oc_memb_alloc(&fixed_pool);
+  block_t *second = (block_t *)oc_memb_alloc(&fixed_pool);
+  ASSERT_NE(nullptr, first);
+  ASSERT_NE(nullptr, second);
+  first->value = 42;
+  oc_memb_free(&fixed_pool, first);
+  EXPECT_EQ(NUM_BLOCKS - 1, oc_memb_numfree(&fixed_pool));
+
+  block_t *third = (block_t *)oc_memb_alloc(&fixed_pool);
+  EXPECT_EQ(first, third);
+  EXPECT_EQ(0, third->value);
+  oc_memb_free(&fixed_pool, second);
+  oc_memb_free(&fixed_pool, third);
+}
+
+TEST_F(TestMemb, DoubleFreeIsIgnored_N)
+{
+  block_t *block = (block_t *)oc_memb_alloc(&fixed_pool);
+  ASSERT_NE(nullptr, block);
+  oc_memb_free(&fixed_pool, block);
+  oc_memb_free(&fixed_pool, block);
+  EXPECT_EQ(NUM_BLOCKS, oc_memb_numfree(&fixed_pool));
+
+  EXPECT_EQ(block, oc_memb_alloc(&fixed_pool));
+  EXPECT_NE(block, oc_memb_alloc(&fixed_pool));
+}
+
+TEST_F(TestMemb, ForeignPointerIsRejected_N)
+{
+  block_t block;
+  EXPECT_EQ(-1, oc_memb_free(&fixed_pool, &block));
+  EXPECT_EQ(NUM_BLOCKS, oc_memb_numfree(&fixed_pool));
+}
+
+TEST_F(TestMemb, BlocksSmallerThanAPointer_P)
+{
+  char *blocks[4];
+  int i;
+  for (i = 0; i < 4; i++) {
+    blocks[i] = (char *)oc_memb_alloc(&tiny_pool);
+    ASSERT_NE(nullptr, blocks[i]);
+  }
+  EXPECT_EQ(nullptr, oc_memb_alloc(&tiny_pool));
+  oc_memb_free(&tiny_pool, blocks[2]);
+  EXPECT_EQ(1, oc_memb_numfree(&tiny_pool));
+  EXPECT_EQ(blocks[2], oc_memb_alloc(&tiny_pool));
+}
+
+#ifdef OC_DYNAMIC_ALLOCATION
+OC_MEMB_CACHED(dynamic_pool, block_t, NUM_BLOCKS);
+OC_MEMB(shared_pool, block_t, NUM_BLOCKS);
+
+TEST_F(TestMemb, DynamicPoolKeepsFreedBlocks_P)
+{
+  std::vector<block_t *> blocks(2 * OC_MEMB_MAX_FREE_BLOCKS);
+  size_t i;
+  for (i = 0; i < blocks.size(); i++) {
+    blocks[i] = (block_t *)oc_memb_alloc(&dynamic_pool);
+    ASSERT_NE(nullptr, blocks[i]);
+    blocks[i]->value = 1;
+  }
+  for (i = 0; i < blocks.size(); i++) {
+    oc_memb_free(&dynamic_pool, blocks[i]);
+  }
+  block_t *block = (block_t *)oc_memb_alloc(&dynamic_pool);
+  ASSERT_NE(nullptr, block);
+  EXPECT_EQ(0, block->value);
+  oc_memb_free(&dynamic_pool, block);
+  oc_memb_init(&dynamic_pool);
+}
+
+TEST_F(TestMemb, StackPoolKeepsNothing_P)
+{
+  struct oc_memb pool = { sizeof(block_t), 0, 0, 0, 0, 0, 0, 0, 0 };
+  void *block = oc_memb_alloc(&pool);
+  ASSERT_NE(nullptr, block);
+  oc_memb_free(&pool, block);
+  EXPECT_EQ(nullptr, pool.free_list);
+}
+
+TEST_F(TestMemb, SharedPoolKeepsNothing_P)
+{
+  void *block = oc_memb_alloc(&shared_pool);
+  ASSERT_NE(nullptr, block);
+  oc_memb_free(&shared_pool, block);
+  EXPECT_EQ(nullptr, shared_pool.free_list);
+  EXPECT_EQ(nullptr, shared_pool.next_pool);
+}
+
+TEST_F(TestMemb, FreeCachedReturnsBlocks_P)
+{
+  void *block = oc_memb_alloc(&dynamic_pool);
+  ASSERT_NE(nullptr, block);
+  oc_memb_free(&dynamic_pool, block);
+  EXPECT_NE(nullptr, dynamic_pool.free_list);
+  oc_memb_free_cached();
+  EXPECT_EQ(nullptr, dynamic_pool.free_list);
+  EXPECT_EQ(nullptr, dynamic_pool.next_pool);
+}
+#endif /* OC_DYNAMIC_ALLOCATION */
+
+TEST_F(TestMemb, FreeNull_N)
+{
+  EXPECT_EQ(-1, oc_memb_free(&fixed_pool, NULL));
+  EXPECT_EQ(-1, oc_memb_free(&tiny_pool, NULL));
+#ifdef OC_DYNAMIC_ALLOCATION
+  EXPECT_EQ(-1, oc_memb_free(&dynamic_pool, NULL));
+#endif /* OC_DYNAMIC_ALLOCATION */
+}
+
+TEST_F(TestMemb, AllocFreeBenchmark)
+{
+  std::vector<block_t *> blocks(NUM_BLOCKS);
+  int i, j;
+
+  /* Keep the pool nearly full, so that a lookup for a free block would need
+   * to walk most of it.
+   */
+  for (j = 0; j < NUM_BLOCKS; j++) {
+    blocks[j] = (block_t *)oc_memb_alloc(&fixed_pool);
+  }
+  auto start = std::chrono::steady_clock::now();
+  for (i = 0; i < NUM_ROUNDS; i++) {
+    j = (i * 7919) % NUM_BLOCKS;
+    oc_memb_free(&fixed_pool, blocks[j]);
+    blocks[j] = (block_t *)oc_memb_alloc(&fixed_pool);
+    ASSERT_NE(nullptr, blocks[j]);
+  }
+  auto fixed = std::chrono::steady_clock::now();
+  for (j = 0; j < NUM_BLOCKS; j++) {
+    oc_memb_free(&fixed_pool, blocks[j]);
+  }
+
+#ifdef OC_DYNAMIC_ALLOCATION
+  for (j = 0; j < NUM_BLOCKS; j++) {
+    blocks[j] = (block_t *)oc_memb_alloc(&dynamic_pool);
+  }
+  auto dynamic_start = std::chrono::steady_clock::now();
+  for (i = 0; i < NUM_ROUNDS; i++) {
+    j = (i * 7919) % NUM_BLOCKS;
+    oc_memb_free(&dynamic_pool, blocks[j]);
+    blocks[j] = (block_t *)oc_memb_alloc(&dynamic_pool);
+    ASSERT_NE(nullptr, blocks[j]);
+  }
+  auto dynamic = std::chrono::steady_clock::now();
+  for (j = 0; j < NUM_BLOCKS; j++) {
+    oc_memb_free(&dynamic_pool, blocks[j]);
+  }
+  oc_memb_init(&dynamic_pool);
+  printf("%d free/alloc pairs: %lld us in a fixed pool of %d blocks, %lld us "
+         "in a dynamic pool\n",
+         NUM_ROUNDS,
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+           fixed - start)
+           .count(),
+         NUM_BLOCKS,
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+           dynamic - dynamic_start)
+           .count());
+#else  /* OC_DYNAMIC_ALLOCATION */
+  printf("%d free/alloc pairs: %lld us in a fixed pool of %d blocks\n",
+         NUM_ROUNDS,
+         (long long)std::chrono::duration_cast<std::chrono::microseconds>(
+           fixed - start)
+           .count(),
+         NUM_BLOCKS);
+#endif /* !OC_DYNAMIC_ALLOCATION */
+}
@@ -0,0 +1,166 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+/* Builds the static, compacting pools into this test, whatever the
+ * configuration of the library. The functions are renamed so that they do
+ * not clash with those of the library.
+ */
+#undef OC_DYNAMIC_ALLOCATION
+#include "port/linux/oc_config.h"
+#undef OC_BYTES_POOL_SIZE
+#undef OC_INTS_POOL_SIZE
+#undef OC_DOUBLES_POOL_SIZE
+#define OC_BYTES_POOL_SIZE (64)
+#define OC_INTS_POOL_SIZE (16)
+#define OC_DOUBLES_POOL_SIZE (16)
+#undef OC_MMEM_SIZE_CLASSES
+#define oc_mmem_init compact_mmem_init
+#define _oc_mmem_alloc compact_mmem_alloc
+#define _oc_mmem_free compact_mmem_free
+#define oc_mmem_stats compact_mmem_stats
+#include "util/oc_mmem.c"
+
+class TestMmemCompaction : public testing::Test
+{
+protected:
+  virtual void SetUp() { oc_mmem_init(); }
+
+  virtual void TearDown()
+  {
+    oc_mmem_stats_t stats;
+    int i;
+    for (i = BYTE_POOL; i <= DOUBLE_POOL; i++) {
+      oc_mmem_stats((pool)i, &stats);
+      EXPECT_EQ(0u, stats.used);
+      EXPECT_EQ(stats.size, stats.largest_free);
+    }
+  }
+};
+
+TEST_F(TestMmemCompaction, BytesMoveDown_P)
+{
+  struct oc_mmem a, b, c;
+  ASSERT_EQ(3u, oc_mmem_alloc(&a, 3, BYTE_POOL));
+  ASSERT_EQ(5u, oc_mmem_alloc(&b, 5, BYTE_POOL));
+  ASSERT_EQ(7u, oc_mmem_alloc(&c, 7, BYTE_POOL));
+  memcpy(b.ptr, "abcde", 5);
+  memcpy(c.ptr, "0123456", 7);
+
+  oc_mmem_free(&a, BYTE_POOL);
+  EXPECT_EQ(bytes, b.ptr);
+  EXPECT_EQ(bytes + 5, c.ptr);
+  EXPECT_EQ(0, memcmp(b.ptr, "abcde", 5));
+  EXPECT_EQ(0, memcmp(c.ptr, "0123456", 7));
+
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ(12u, stats.used);
+  EXPECT_EQ(stats.used, stats.requested);
+  EXPECT_EQ(stats.size - 12, stats.largest_free);
+
+  oc_mmem_free(&b, BYTE_POOL);
+  oc_mmem_free(&c, BYTE_POOL);
+}
+
+TEST_F(TestMmemCompaction, IntsMoveDown_P)
+{
+  struct oc_mmem a, b, c;
+  ASSERT_EQ(2 * sizeof(int), oc_mmem_alloc(&a, 2, INT_POOL));
+  ASSERT_EQ(3 * sizeof(int), oc_mmem_alloc(&b, 3, INT_POOL));
+  ASSERT_EQ(4 * sizeof(int), oc_mmem_alloc(&c, 4, INT_POOL));
+  int i;
+  for (i = 0; i < 3; i++) {
+    ((int *)b.ptr)[i] = 10 + i;
+  }
+  for (i = 0; i < 4; i++) {
+    ((int *)c.ptr)[i] = 20 + i;
+  }
+
+  /* Both blocks after the freed one move down by 2 ints, with all of
+   * their elements.
+   */
+  oc_mmem_free(&a, INT_POOL);
+  EXPECT_EQ(ints, b.ptr);
+  EXPECT_EQ(ints + 3, c.ptr);
+  for (i = 0; i < 3; i++) {
+    EXPECT_EQ(10 + i, ((int *)b.ptr)[i]);
+  }
+  for (i = 0; i < 4; i++) {
+    EXPECT_EQ(20 + i, ((int *)c.ptr)[i]);
+  }
+
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(INT_POOL, &stats);
+  EXPECT_EQ(7 * sizeof(int), stats.used);
+  EXPECT_EQ(stats.size - 7 * sizeof(int), stats.largest_free);
+
+  oc_mmem_free(&b, INT_POOL);
+  EXPECT_EQ(ints, c.ptr);
+  EXPECT_EQ(23, ((int *)c.ptr)[3]);
+  oc_mmem_free(&c, INT_POOL);
+}
+
+TEST_F(TestMmemCompaction, DoublesMoveDown_P)
+{
+  struct oc_mmem a, b, c;
+  ASSERT_EQ(2 * sizeof(double), oc_mmem_alloc(&a, 2, DOUBLE_POOL));
+  ASSERT_EQ(3 * sizeof(double), oc_mmem_alloc(&b, 3, DOUBLE_POOL));
+  ASSERT_EQ(4 * sizeof(double), oc_mmem_alloc(&c, 4, DOUBLE_POOL));
+  int i;
+  for (i = 0; i < 3; i++) {
+    ((double *)b.ptr)[i] = 1.5 + i;
+  }
+  for (i = 0; i < 4; i++) {
+    ((double *)c.ptr)[i] = 2.5 + i;
+  }
+
+  oc_mmem_free(&a, DOUBLE_POOL);
+  EXPECT_EQ(doubles, b.ptr);
+  EXPECT_EQ(doubles + 3, c.ptr);
+  for (i = 0; i < 3; i++) {
+    EXPECT_EQ(1.5 + i, ((double *)b.ptr)[i]);
+  }
+  for (i = 0; i < 4; i++) {
+    EXPECT_EQ(2.5 + i, ((double *)c.ptr)[i]);
+  }
+
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(DOUBLE_POOL, &stats);
+  EXPECT_EQ(7 * sizeof(double), stats.used);
+
+  oc_mmem_free(&b, DOUBLE_POOL);
+  EXPECT_EQ(doubles, c.ptr);
+  EXPECT_EQ(5.5, ((double *)c.ptr)[3]);
+  oc_mmem_free(&c, DOUBLE_POOL);
+}
+
+TEST_F(TestMmemCompaction, Exhaustion_N)
+{
+  struct oc_mmem a, m;
+  oc_mmem_stats_t before, after;
+  oc_mmem_stats(INT_POOL, &before);
+  ASSERT_EQ(OC_INTS_POOL_SIZE * sizeof(int),
+            oc_mmem_alloc(&a, OC_INTS_POOL_SIZE, INT_POOL));
+  EXPECT_EQ(0u, oc_mmem_alloc(&m, 1, INT_POOL));
+  oc_mmem_stats(INT_POOL, &after);
+  EXPECT_EQ(0u, after.largest_free);
+  EXPECT_EQ(before.allocs + 2, after.allocs);
+  EXPECT_EQ(before.failures + 1, after.failures);
+  oc_mmem_free(&a, INT_POOL);
+}
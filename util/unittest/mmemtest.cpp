@@ -0,0 +1,205 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <cstring>
+#include <gtest/gtest.h>
+
+/* Builds the static pools with OC_MMEM_SIZE_CLASSES into this test, whatever
+ * the configuration of the library. The functions are renamed so that they
+ * do not clash with those of the library.
+ */
+#undef OC_DYNAMIC_ALLOCATION
+#include "port/linux/oc_config.h"
+#undef OC_BYTES_POOL_SIZE
+#undef OC_INTS_POOL_SIZE
+#undef OC_DOUBLES_POOL_SIZE
+#define OC_BYTES_POOL_SIZE (384)
+#define OC_INTS_POOL_SIZE (64)
+#define OC_DOUBLES_POOL_SIZE (32)
+#define OC_MMEM_SIZE_CLASSES
+#define oc_mmem_init size_class_mmem_init
+#define _oc_mmem_alloc size_class_mmem_alloc
+#define _oc_mmem_free size_class_mmem_free
+#define oc_mmem_stats size_class_mmem_stats
+#include "util/oc_mmem.c"
+
+/* The byte pool holds 48 granules of 8 bytes, split into blocks of 32 and
+ * 16 granules.
+ */
+#define GRANULE_SIZE (8)
+#define LARGEST_BLOCK (256)
+
+class TestMmemSizeClasses : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    oc_mmem_init();
+    oc_mmem_stats(BYTE_POOL, &before);
+  }
+
+  virtual void TearDown()
+  {
+    /* Every test frees its blocks, which merges the pool back whole */
+    oc_mmem_stats_t after;
+    oc_mmem_stats(BYTE_POOL, &after);
+    EXPECT_EQ(0u, after.requested);
+    EXPECT_EQ(0u, after.used);
+    EXPECT_EQ((size_t)LARGEST_BLOCK, after.largest_free);
+  }
+
+  oc_mmem_stats_t before;
+};
+
+TEST_F(TestMmemSizeClasses, Stats_P)
+{
+  EXPECT_EQ((size_t)OC_BYTES_POOL_SIZE, before.size);
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(INT_POOL, &stats);
+  EXPECT_EQ(OC_INTS_POOL_SIZE * sizeof(int), stats.size);
+  oc_mmem_stats(DOUBLE_POOL, &stats);
+  EXPECT_EQ(OC_DOUBLES_POOL_SIZE * sizeof(double), stats.size);
+
+  struct oc_mmem a, b;
+  EXPECT_EQ(5u, oc_mmem_alloc(&a, 5, BYTE_POOL));
+  EXPECT_EQ(100u, oc_mmem_alloc(&b, 100, BYTE_POOL));
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ(105u, stats.requested);
+  /* Rounded up to 1 and 16 granules */
+  EXPECT_EQ((size_t)(GRANULE_SIZE + 128), stats.used);
+  EXPECT_EQ(before.allocs + 2, stats.allocs);
+  EXPECT_EQ(before.failures, stats.failures);
+
+  oc_mmem_free(&b, BYTE_POOL);
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ(5u, stats.requested);
+  EXPECT_EQ((size_t)GRANULE_SIZE, stats.used);
+  oc_mmem_free(&a, BYTE_POOL);
+}
+
+TEST_F(TestMmemSizeClasses, IntsAndDoublesUseGranules_P)
+{
+  struct oc_mmem i, d;
+  EXPECT_EQ(3 * sizeof(int), oc_mmem_alloc(&i, 3, INT_POOL));
+  EXPECT_EQ(3 * sizeof(double), oc_mmem_alloc(&d, 3, DOUBLE_POOL));
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(INT_POOL, &stats);
+  EXPECT_EQ(3 * sizeof(int), stats.requested);
+  EXPECT_EQ((size_t)2 * GRANULE_SIZE, stats.used);
+  oc_mmem_stats(DOUBLE_POOL, &stats);
+  EXPECT_EQ(3 * sizeof(double), stats.requested);
+  EXPECT_EQ((size_t)4 * GRANULE_SIZE, stats.used);
+  oc_mmem_free(&i, INT_POOL);
+  oc_mmem_free(&d, DOUBLE_POOL);
+  oc_mmem_stats(INT_POOL, &stats);
+  EXPECT_EQ(0u, stats.used);
+  oc_mmem_stats(DOUBLE_POOL, &stats);
+  EXPECT_EQ(0u, stats.used);
+}
+
+TEST_F(TestMmemSizeClasses, SplitAndMerge_P)
+{
+  struct oc_mmem small, large;
+  oc_mmem_stats_t stats;
+
+  /* The smallest block is split from the 16 granule block */
+  ASSERT_EQ(1u, oc_mmem_alloc(&small, 1, BYTE_POOL));
+  EXPECT_EQ(bytes + LARGEST_BLOCK, small.ptr);
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ((size_t)LARGEST_BLOCK, stats.largest_free);
+
+  ASSERT_EQ((size_t)LARGEST_BLOCK,
+            oc_mmem_alloc(&large, LARGEST_BLOCK, BYTE_POOL));
+  EXPECT_EQ(bytes, large.ptr);
+  /* What is left of the 16 granule block: 8 + 4 + 2 + 1 granules */
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ((size_t)8 * GRANULE_SIZE, stats.largest_free);
+
+  /* Freeing the small block merges its buddies back into 16 granules */
+  oc_mmem_free(&small, BYTE_POOL);
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ((size_t)16 * GRANULE_SIZE, stats.largest_free);
+  struct oc_mmem half;
+  ASSERT_EQ((size_t)16 * GRANULE_SIZE,
+            oc_mmem_alloc(&half, 16 * GRANULE_SIZE, BYTE_POOL));
+  EXPECT_EQ(bytes + LARGEST_BLOCK, half.ptr);
+  oc_mmem_free(&half, BYTE_POOL);
+  oc_mmem_free(&large, BYTE_POOL);
+}
+
+TEST_F(TestMmemSizeClasses, BlocksDoNotMove_P)
+{
+  struct oc_mmem a, b, c;
+  ASSERT_EQ(10u, oc_mmem_alloc(&a, 10, BYTE_POOL));
+  ASSERT_EQ(10u, oc_mmem_alloc(&b, 10, BYTE_POOL));
+  ASSERT_EQ(10u, oc_mmem_alloc(&c, 10, BYTE_POOL));
+  memcpy(c.ptr, "0123456789", 10);
+  void *ptr = c.ptr;
+  oc_mmem_free(&a, BYTE_POOL);
+  oc_mmem_free(&b, BYTE_POOL);
+  EXPECT_EQ(ptr, c.ptr);
+  EXPECT_EQ(0, memcmp(c.ptr, "0123456789", 10));
+  oc_mmem_free(&c, BYTE_POOL);
+}
+
+TEST_F(TestMmemSizeClasses, Fragmentation_P)
+{
+  struct oc_mmem blocks[OC_BYTES_POOL_SIZE / GRANULE_SIZE];
+  size_t i;
+  for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i++) {
+    ASSERT_EQ(1u, oc_mmem_alloc(&blocks[i], 1, BYTE_POOL));
+  }
+  for (i = 0; i < sizeof(blocks) / sizeof(blocks[0]); i += 2) {
+    oc_mmem_free(&blocks[i], BYTE_POOL);
+  }
+  /* Half of the pool is free, but only in single granules */
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ((size_t)OC_BYTES_POOL_SIZE / 2, stats.size - stats.used);
+  EXPECT_EQ((size_t)GRANULE_SIZE, stats.largest_free);
+  struct oc_mmem m;
+  EXPECT_EQ(0u, oc_mmem_alloc(&m, 2 * GRANULE_SIZE, BYTE_POOL));
+
+  for (i = 1; i < sizeof(blocks) / sizeof(blocks[0]); i += 2) {
+    oc_mmem_free(&blocks[i], BYTE_POOL);
+  }
+}
+
+TEST_F(TestMmemSizeClasses, Exhaustion_N)
+{
+  struct oc_mmem large, half, m;
+  ASSERT_EQ((size_t)LARGEST_BLOCK,
+            oc_mmem_alloc(&large, LARGEST_BLOCK, BYTE_POOL));
+  ASSERT_EQ((size_t)16 * GRANULE_SIZE,
+            oc_mmem_alloc(&half, 16 * GRANULE_SIZE, BYTE_POOL));
+
+  oc_mmem_stats_t stats;
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ(stats.size, stats.used);
+  EXPECT_EQ(0u, stats.largest_free);
+  EXPECT_EQ(0u, oc_mmem_alloc(&m, 1, BYTE_POOL));
+  EXPECT_EQ(nullptr, m.ptr);
+  /* Larger than any block the pool can hold */
+  EXPECT_EQ(0u, oc_mmem_alloc(&m, OC_BYTES_POOL_SIZE, BYTE_POOL));
+  oc_mmem_stats(BYTE_POOL, &stats);
+  EXPECT_EQ(before.allocs + 4, stats.allocs);
+  EXPECT_EQ(before.failures + 2, stats.failures);
+
+  oc_mmem_free(&half, BYTE_POOL);
+  ASSERT_EQ(1u, oc_mmem_alloc(&m, 1, BYTE_POOL));
+  oc_mmem_free(&m, BYTE_POOL);
+  oc_mmem_free(&large, BYTE_POOL);
+}
@@ -0,0 +1,122 @@
+/*
+// Copyright (c) 2018 Intel Corporation
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+*/
+
+#include <gtest/gtest.h>
+#include <vector>
+
+#include "port/linux/oc_config.h"
+#include "util/oc_process.h"
+
+#ifdef OC_PROCESS_PRIORITIES
+#define NUM_FLOOD_EVENTS (10000)
+
+static std::vector<int> delivered;
+
+OC_PROCESS(test_process, "Test process");
+OC_PROCESS_THREAD(test_process, ev, data)
+{
+  OC_PROCESS_BEGIN();
+  while (1) {
+    OC_PROCESS_YIELD();
+    if (ev == OC_PROCESS_EVENT_CONTINUE || ev == OC_PROCESS_EVENT_TIMER ||
+        ev == OC_PROCESS_EVENT_MSG) {
+      delivered.push_back((int)(intptr_t)data);
+    }
+  }
+  OC_PROCESS_END();
+}
+
+class TestProcess : public testing::Test
+{
+protected:
+  virtual void SetUp()
+  {
+    delivered.clear();
+    oc_process_init();
+    oc_process_start(&test_process, NULL);
+  }
+  virtual void TearDown()
+  {
+    oc_process_exit(&test_process);
+    oc_process_shutdown();
+  }
+};
+
+TEST_F(TestProcess, EventsKeepOrderWithinClass_P)
+{
+  int i;
+  for (i = 0; i < 100; i++) {
+    ASSERT_EQ(OC_PROCESS_ERR_OK,
+              oc_process_post(&test_process, OC_PROCESS_EVENT_CONTINUE,
+                              (void *)(intptr_t)i));
+  }
+  while (oc_process_run())
+    ;
+  ASSERT_EQ(100u, delivered.size());
+  for (i = 0; i < 100; i++) {
+    EXPECT_EQ(i, delivered[i]);
+  }
+
+  oc_process_stats_t stats;
+  oc_process_stats(&stats);
+  EXPECT_EQ(0u, stats.queued[OC_PROCESS_CLASS_APP]);
+  EXPECT_EQ(100u, stats.max_queued[OC_PROCESS_CLASS_APP]);
+  EXPECT_EQ(100u, stats.dispatched[OC_PROCESS_CLASS_APP]);
+}
+
+TEST_F(TestProcess, HigherClassRunsFirst_P)
+{
+  oc_process_set_event_class(OC_PROCESS_EVENT_MSG,
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_post(&test_process, OC_PROCESS_EVENT_CONTINUE, (void *)3);
+  oc_process_post(&test_process, OC_PROCESS_EVENT_TIMER, (void *)2);
+  oc_process_post(&test_process, OC_PROCESS_EVENT_MSG, (void *)1);
+  EXPECT_EQ(0, oc_process_run());
+  ASSERT_EQ(3u, delivered.size());
+  EXPECT_EQ(1, delivered[0]);
+  EXPECT_EQ(2, delivered[1]);
+  EXPECT_EQ(3, delivered[2]);
+}
+
+TEST_F(TestProcess, TimersAreNotStarvedByFlood_P)
+{
+  int i;
+  oc_process_set_event_class(OC_PROCESS_EVENT_MSG,
+                             OC_PROCESS_CLASS_NETWORK_RX);
+  oc_process_set_class_budget(OC_PROCESS_CLASS_NETWORK_RX, 1);
+  for (i = 0; i < NUM_FLOOD_EVENTS; i++) {
+    oc_process_post(&test_process, OC_PROCESS_EVENT_MSG, (void *)1);
+  }
+  oc_process_post(&test_process, OC_PROCESS_EVENT_TIMER, (void *)-1);
+
+  /* The flood runs out of its budget, and the timer event is handed over
+   * in the same pass, ahead of the rest of the flood.
+   */
+  ASSERT_NE(0, oc_process_run());
+  ASSERT_FALSE(delivered.empty());
+  EXPECT_EQ(-1, delivered.back());
+  EXPECT_LT(delivered.size() - 1, (size_t)NUM_FLOOD_EVENTS);
+  while (oc_process_run())
+    ;
+
+  oc_process_stats_t stats;
+  oc_process_stats(&stats);
+  EXPECT_EQ((unsigned long)NUM_FLOOD_EVENTS,
+            stats.dispatched[OC_PROCESS_CLASS_NETWORK_RX]);
+  EXPECT_EQ(1u, stats.dispatched[OC_PROCESS_CLASS_TIMER]);
+  EXPECT_LE(1u, stats.over_budget[OC_PROCESS_CLASS_NETWORK_RX]);
+}
+#endif /* OC_PROCESS_PRIORITIES */